@@ -0,0 +1,553 @@
+/*------------------------------------------------------------------------------
+ *
+ * aocs_blockminmax.c
+ *	  Block-level min/max summaries of AOCS columns, remembered from earlier
+ *	  scans.
+ *
+ * A sequential scan that has range quals on a column, like "ts >= '2019-01-01'",
+ * can skip every block of that column whose values all fall outside the
+ * range, together with the same rows of the other columns.  To know the
+ * range of a block, the scan has to have seen its values before: the minimum,
+ * maximum and null count of each block a scan decodes in full are remembered
+ * in a backend-local cache, and later scans in the same session consult it
+ * before decoding a block.  Blocks are immutable once written, so the cache
+ * only needs to recognise a block, which it does by its segment file, column,
+ * file offset, first row number and row count.
+ *
+ * Nothing is stored on disk, so unlike zone maps written at load time, this
+ * never helps the first scan of a block in a session.  It is also only used
+ * by batched scans (gp_aocs_scan_batch_size > 0), and not for AO row tables,
+ * which interleave all columns in one varblock.
+ *
+ * Only pass-by-value types with a default btree opclass are summarised, and
+ * only top-level quals of the form "column op constant" are used, with op
+ * one of the btree operators of the column's type.
+ *
+ * Quals on variable-length columns are also used for blocks that store the
+ * distinct values of the block in a dictionary (see gp_aocs_dictionary_encoding):
+ * the quals are evaluated once per dictionary entry, and if no entry passes,
+ * the rest of the block is skipped like a block whose min/max rules it out.
+ *
+ * Copyright (c) 2013-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/access/aocs/aocs_blockminmax.c
+ *
+ *------------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/aocs_blockminmax.h"
+#include "access/nbtree.h"
+#include "access/stratnum.h"
+#include "cdb/cdbappendonlyblockdirectory.h"
+#include "cdb/cdbappendonlystorageread.h"
+#include "cdb/cdbappendonlystoragewrite.h"
+#include "nodes/nodeFuncs.h"
+#include "nodes/primnodes.h"
+#include "optimizer/clauses.h"
+#include "storage/relfilenode.h"
+#include "utils/datumstream.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/typcache.h"
+
+/* Identifies a block of a column */
+typedef struct AOCSBlockMinMaxTag
+{
+	RelFileNode node;
+	int32		segno;
+	int32		attno;
+	int64		fileOffset;
+} AOCSBlockMinMaxTag;
+
+typedef struct AOCSBlockMinMaxEntry
+{
+	AOCSBlockMinMaxTag tag;			/* hash key, must be first */
+	int64		firstRowNum;
+	int32		rowCount;
+	int32		nullCount;
+	bool		hasValues;		/* false if all values are NULL */
+	Datum		min;
+	Datum		max;
+} AOCSBlockMinMaxEntry;
+
+/* A "column op constant" qual */
+typedef struct AOCSBlockMinMaxKey
+{
+	int			attno;			/* 0-based column number */
+	StrategyNumber strategy;	/* btree strategy of the operator */
+	Datum		value;
+} AOCSBlockMinMaxKey;
+
+/* Per-column state of a scan */
+typedef struct AOCSBlockMinMaxColumn
+{
+	int			nkeys;
+	AOCSBlockMinMaxKey *keys;
+	FmgrInfo	cmp;			/* btree comparison function of the type */
+	Oid			collation;
+	bool		summarise;		/* keep min/max, false for by-ref types */
+
+	/* Summary of the current block, while it's being decoded */
+	bool		building;
+	int32		seen;			/* values of the block seen so far */
+	AOCSBlockMinMaxEntry block;
+} AOCSBlockMinMaxColumn;
+
+typedef struct AOCSBlockMinMaxScan
+{
+	RelFileNode node;
+	int			natts;
+	AOCSBlockMinMaxColumn *columns;	/* indexed by attno, NULL if no keys */
+} AOCSBlockMinMaxScan;
+
+static HTAB *AOCSBlockMinMaxCache = NULL;
+
+static void
+initBlockMinMaxCache(void)
+{
+	HASHCTL		ctl;
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(AOCSBlockMinMaxTag);
+	ctl.entrysize = sizeof(AOCSBlockMinMaxEntry);
+	ctl.hcxt = TopMemoryContext;
+
+	AOCSBlockMinMaxCache = hash_create("AOCS block min/max cache",
+									   Min(gp_aocs_block_minmax_cache_size, 1024),
+									   &ctl,
+									   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+}
+
+/*
+ * If 'node' is a column, possibly relabeled to a binary compatible type like
+ * varchar to text, return it.
+ */
+static Var *
+keyColumn(Node *node, bool *relabeled)
+{
+	*relabeled = false;
+	if (IsA(node, RelabelType))
+	{
+		node = (Node *) ((RelabelType *) node)->arg;
+		*relabeled = true;
+	}
+
+	return IsA(node, Var) ? (Var *) node : NULL;
+}
+
+/*
+ * If 'expr' is "column op constant", or "constant op column", on a column
+ * that can be summarised, add it to the keys of the scan.
+ */
+static void
+addBlockMinMaxKey(AOCSBlockMinMaxScan *mmscan, Relation rel, Expr *expr)
+{
+	OpExpr	   *op;
+	Node	   *left;
+	Node	   *right;
+	Var		   *var;
+	Const	   *con;
+	bool		commuted;
+	bool		relabeled;
+	int			attno;
+	Oid			atttype;
+	Oid			keytype;
+	TypeCacheEntry *typentry;
+	int			strategy;
+	Oid			lefttype;
+	Oid			righttype;
+	AOCSBlockMinMaxColumn *col;
+
+	if (and_clause((Node *) expr))
+	{
+		ListCell   *lc;
+
+		foreach(lc, ((BoolExpr *) expr)->args)
+			addBlockMinMaxKey(mmscan, rel, (Expr *) lfirst(lc));
+		return;
+	}
+
+	if (!IsA(expr, OpExpr))
+		return;
+	op = (OpExpr *) expr;
+	if (list_length(op->args) != 2)
+		return;
+
+	left = (Node *) linitial(op->args);
+	right = (Node *) lsecond(op->args);
+	if (IsA(right, Const) && (var = keyColumn(left, &relabeled)) != NULL)
+	{
+		keytype = exprType(left);
+		con = (Const *) right;
+		commuted = false;
+	}
+	else if (IsA(left, Const) && (var = keyColumn(right, &relabeled)) != NULL)
+	{
+		keytype = exprType(right);
+		con = (Const *) left;
+		commuted = true;
+	}
+	else
+		return;
+
+	if (var->varattno <= 0 || var->varattno > mmscan->natts || con->constisnull)
+		return;
+	attno = var->varattno - 1;
+	atttype = rel->rd_att->attrs[attno]->atttypid;
+	if (var->vartype != atttype || con->consttype != keytype)
+		return;
+
+	/*
+	 * Summaries hold values of the column's own type, so a relabeled column
+	 * is only of use for dictionary encoded blocks.
+	 */
+	if (relabeled && get_typbyval(atttype))
+		return;
+
+	typentry = lookup_type_cache(keytype, TYPECACHE_BTREE_OPFAMILY | TYPECACHE_CMP_PROC_FINFO);
+	if (!OidIsValid(typentry->btree_opf) || !OidIsValid(typentry->cmp_proc))
+		return;
+
+	op_input_types(op->opno, &lefttype, &righttype);
+	if (lefttype != keytype || righttype != keytype)
+		return;
+	strategy = get_op_opfamily_strategy(op->opno, typentry->btree_opf);
+	if (strategy == 0)
+		return;
+	if (commuted)
+		strategy = BTCommuteStrategyNumber(strategy);
+
+	col = &mmscan->columns[attno];
+	if (col->nkeys == 0)
+	{
+		col->keys = palloc(sizeof(AOCSBlockMinMaxKey));
+		fmgr_info_copy(&col->cmp, &typentry->cmp_proc_finfo, CurrentMemoryContext);
+		col->collation = op->inputcollid;
+		col->summarise = get_typbyval(keytype);
+	}
+	else
+	{
+		/* All keys of a column must compare the same way */
+		if (col->collation != op->inputcollid ||
+			col->cmp.fn_oid != typentry->cmp_proc)
+			return;
+		col->keys = repalloc(col->keys, (col->nkeys + 1) * sizeof(AOCSBlockMinMaxKey));
+	}
+
+	col->keys[col->nkeys].attno = attno;
+	col->keys[col->nkeys].strategy = strategy;
+	col->keys[col->nkeys].value = con->constvalue;
+	col->nkeys++;
+}
+
+/*
+ * Set up a scan of 'rel' to use and maintain block min/max for the columns
+ * constrained by 'qual', an implicitly AND'ed list of qual clauses.  Returns
+ * NULL if none of the quals can be used.
+ */
+AOCSBlockMinMaxScan *
+AOCSBlockMinMaxBeginScan(Relation rel, List *qual)
+{
+	AOCSBlockMinMaxScan *mmscan;
+	ListCell   *lc;
+	int			i;
+	bool		found = false;
+
+	if (gp_aocs_block_minmax_cache_size <= 0 || qual == NIL)
+		return NULL;
+
+	mmscan = palloc0(sizeof(AOCSBlockMinMaxScan));
+	mmscan->node = rel->rd_node;
+	mmscan->natts = rel->rd_att->natts;
+	mmscan->columns = palloc0(mmscan->natts * sizeof(AOCSBlockMinMaxColumn));
+
+	foreach(lc, qual)
+		addBlockMinMaxKey(mmscan, rel, (Expr *) lfirst(lc));
+
+	for (i = 0; i < mmscan->natts; i++)
+	{
+		if (mmscan->columns[i].nkeys > 0)
+			found = true;
+	}
+
+	if (!found)
+	{
+		AOCSBlockMinMaxEndScan(mmscan);
+		return NULL;
+	}
+
+	if (AOCSBlockMinMaxCache == NULL)
+		initBlockMinMaxCache();
+
+	return mmscan;
+}
+
+void
+AOCSBlockMinMaxEndScan(AOCSBlockMinMaxScan *mmscan)
+{
+	int			i;
+
+	for (i = 0; i < mmscan->natts; i++)
+	{
+		if (mmscan->columns[i].keys)
+			pfree(mmscan->columns[i].keys);
+	}
+	pfree(mmscan->columns);
+	pfree(mmscan);
+}
+
+bool
+AOCSBlockMinMaxHasKeys(AOCSBlockMinMaxScan *mmscan, int attno)
+{
+	return mmscan->columns[attno].nkeys > 0;
+}
+
+/*
+ * Stop summarising the current block of a column, because some of its values
+ * are being skipped.
+ */
+void
+AOCSBlockMinMaxAbandonBlock(AOCSBlockMinMaxScan *mmscan, int attno)
+{
+	mmscan->columns[attno].building = false;
+}
+
+static inline int32
+blockMinMaxCompare(AOCSBlockMinMaxColumn *col, Datum a, Datum b)
+{
+	return DatumGetInt32(FunctionCall2Coll(&col->cmp, col->collation, a, b));
+}
+
+/*
+ * Can the keys of a column be true for any value of the block?
+ */
+static bool
+blockMayMatch(AOCSBlockMinMaxColumn *col, AOCSBlockMinMaxEntry *entry)
+{
+	int			i;
+
+	/* The operators are strict, so they're never true for NULLs. */
+	if (!entry->hasValues)
+		return false;
+
+	for (i = 0; i < col->nkeys; i++)
+	{
+		AOCSBlockMinMaxKey *key = &col->keys[i];
+
+		switch (key->strategy)
+		{
+			case BTLessStrategyNumber:
+				if (blockMinMaxCompare(col, entry->min, key->value) >= 0)
+					return false;
+				break;
+			case BTLessEqualStrategyNumber:
+				if (blockMinMaxCompare(col, entry->min, key->value) > 0)
+					return false;
+				break;
+			case BTEqualStrategyNumber:
+				if (blockMinMaxCompare(col, entry->min, key->value) > 0 ||
+					blockMinMaxCompare(col, entry->max, key->value) < 0)
+					return false;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				if (blockMinMaxCompare(col, entry->max, key->value) < 0)
+					return false;
+				break;
+			case BTGreaterStrategyNumber:
+				if (blockMinMaxCompare(col, entry->max, key->value) <= 0)
+					return false;
+				break;
+			default:
+				break;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Called when the header of the next block of a column with keys has been
+ * read, before its content.  Returns true if the min/max of the block shows
+ * that none of its rows can satisfy the keys, in which case the caller skips
+ * the block.  Otherwise, if the block hasn't been summarised yet, start
+ * summarising it as it's decoded.
+ */
+bool
+AOCSBlockMinMaxSkipBlock(AOCSBlockMinMaxScan *mmscan, int segno, int attno,
+						 DatumStreamRead *ds)
+{
+	AOCSBlockMinMaxColumn *col = &mmscan->columns[attno];
+	AOCSBlockMinMaxTag tag;
+	AOCSBlockMinMaxEntry *entry;
+
+	Assert(col->nkeys > 0);
+
+	col->building = false;
+
+	/* Pre-4.0 blocks don't record their first row number */
+	if (!col->summarise || ds->getBlockInfo.firstRow < 0)
+		return false;
+
+	MemSet(&tag, 0, sizeof(tag));
+	tag.node = mmscan->node;
+	tag.segno = segno;
+	tag.attno = attno;
+	tag.fileOffset = ds->blockFileOffset;
+
+	entry = (AOCSBlockMinMaxEntry *) hash_search(AOCSBlockMinMaxCache, &tag, HASH_FIND, NULL);
+	if (entry != NULL &&
+		entry->firstRowNum == ds->blockFirstRowNum &&
+		entry->rowCount == ds->blockRowCount)
+		return !blockMayMatch(col, entry);
+
+	col->building = true;
+	col->seen = 0;
+	col->block.tag = tag;
+	col->block.firstRowNum = ds->blockFirstRowNum;
+	col->block.rowCount = ds->blockRowCount;
+	col->block.nullCount = 0;
+	col->block.hasValues = false;
+
+	return false;
+}
+
+/*
+ * Is every key of a column true for 'value'?
+ */
+static bool
+valueMatches(AOCSBlockMinMaxColumn *col, Datum value)
+{
+	int			i;
+
+	for (i = 0; i < col->nkeys; i++)
+	{
+		AOCSBlockMinMaxKey *key = &col->keys[i];
+		int32		cmp = blockMinMaxCompare(col, value, key->value);
+
+		switch (key->strategy)
+		{
+			case BTLessStrategyNumber:
+				if (cmp >= 0)
+					return false;
+				break;
+			case BTLessEqualStrategyNumber:
+				if (cmp > 0)
+					return false;
+				break;
+			case BTEqualStrategyNumber:
+				if (cmp != 0)
+					return false;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				if (cmp < 0)
+					return false;
+				break;
+			case BTGreaterStrategyNumber:
+				if (cmp <= 0)
+					return false;
+				break;
+			default:
+				break;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Called when the content of the next block of a column with keys has been
+ * read.  If the block is dictionary encoded, evaluate the keys on each
+ * distinct value of the block, and return true if none of them passes, in
+ * which case the caller skips the rest of the block.
+ */
+bool
+AOCSBlockMinMaxSkipDictionary(AOCSBlockMinMaxScan *mmscan, int attno,
+							  DatumStreamRead *ds)
+{
+	AOCSBlockMinMaxColumn *col = &mmscan->columns[attno];
+	DatumStreamBlockRead *dsr = &ds->blockRead;
+	int			i;
+
+	Assert(col->nkeys > 0);
+
+	if (!dsr->dictionary_block_was_compressed)
+		return false;
+
+	/* The operators are strict, so NULLs never pass. */
+	for (i = 0; i < dsr->dictionary_entry_count; i++)
+	{
+		if (valueMatches(col, PointerGetDatum(dsr->dictionary_entries[i])))
+			return false;
+	}
+
+	col->building = false;
+	return true;
+}
+
+/*
+ * Fold the next 'n' values of a column into the summary of its current
+ * block.  'blockDone' says that these were the last values of the block; if
+ * the whole block was seen, its summary is added to the cache.
+ */
+void
+AOCSBlockMinMaxAccumulate(AOCSBlockMinMaxScan *mmscan, int attno,
+						  Datum *values, bool *nulls, int n, bool blockDone)
+{
+	AOCSBlockMinMaxColumn *col = &mmscan->columns[attno];
+	AOCSBlockMinMaxEntry *block = &col->block;
+	AOCSBlockMinMaxEntry *entry;
+	bool		found;
+	int			i;
+
+	if (!col->building)
+		return;
+
+	for (i = 0; i < n; i++)
+	{
+		if (nulls[i])
+		{
+			block->nullCount++;
+			continue;
+		}
+
+		if (!block->hasValues)
+		{
+			block->min = block->max = values[i];
+			block->hasValues = true;
+		}
+		else if (blockMinMaxCompare(col, values[i], block->min) < 0)
+			block->min = values[i];
+		else if (blockMinMaxCompare(col, values[i], block->max) > 0)
+			block->max = values[i];
+	}
+	col->seen += n;
+
+	if (!blockDone)
+		return;
+
+	col->building = false;
+
+	/*
+	 * The caller skips as many rows of the other columns as the header says
+	 * the block has, so only remember blocks whose content agrees.
+	 */
+	if (col->seen != block->rowCount)
+		return;
+
+	/* Start over when the cache is full, rather than tracking usage. */
+	if (hash_get_num_entries(AOCSBlockMinMaxCache) >= gp_aocs_block_minmax_cache_size)
+	{
+		hash_destroy(AOCSBlockMinMaxCache);
+		initBlockMinMaxCache();
+	}
+
+	entry = (AOCSBlockMinMaxEntry *) hash_search(AOCSBlockMinMaxCache, &block->tag,
+											 HASH_ENTER, &found);
+	memcpy(entry, block, sizeof(AOCSBlockMinMaxEntry));
+}
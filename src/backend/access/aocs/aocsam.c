@@ -16,6 +16,7 @@
 #include "postgres.h"
 
 #include "common/relpath.h"
+#include "access/aocs_blockminmax.h"
 #include "access/aocssegfiles.h"
 #include "access/aomd.h"
 #include "access/appendonlytid.h"
@@ -536,6 +537,9 @@ aocs_endscan(AOCSScanDesc scan)
 
 	AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
 
+	if (scan->blockminmax)
+		AOCSBlockMinMaxEndScan(scan->blockminmax);
+
 	pfree(scan);
 }
 
@@ -684,7 +688,7 @@ ReadNext:
 			/*
 			 * Perform any required upgrades on the Datum we just fetched.
 			 */
-			if (curseginfo->formatversion < AORelationVersion_GetLatest())
+			if (PG82NumericConversionNeeded(curseginfo->formatversion))
 			{
 				upgrade_datum_scan(scan, attno, d, null,
 								   curseginfo->formatversion);
@@ -725,6 +729,460 @@ ReadNext:
 	return false;
 }
 
+/*
+ * Allocate a batch for aocs_getnext_batch(), with room for 'maxrows' rows of
+ * the scan's projected columns.
+ */
+AOCSBatch
+aocs_create_batch(AOCSScanDesc scan, int maxrows)
+{
+	AOCSBatch	batch;
+	int			natts = scan->relationTupleDesc->natts;
+	int			i;
+
+	Assert(maxrows > 0);
+
+	batch = palloc0(sizeof(AOCSBatchData));
+	batch->maxrows = maxrows;
+	batch->nrows = 0;
+	batch->natts = natts;
+	batch->values = palloc0(natts * sizeof(Datum *));
+	batch->nulls = palloc0(natts * sizeof(bool *));
+	batch->tids = palloc(maxrows * sizeof(AOTupleId));
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		batch->values[attno] = palloc(maxrows * sizeof(Datum));
+		batch->nulls[attno] = palloc(maxrows * sizeof(bool));
+	}
+
+	return batch;
+}
+
+void
+aocs_free_batch(AOCSBatch batch)
+{
+	int			i;
+
+	for (i = 0; i < batch->natts; i++)
+	{
+		if (batch->values[i])
+			pfree(batch->values[i]);
+		if (batch->nulls[i])
+			pfree(batch->nulls[i]);
+	}
+	pfree(batch->values);
+	pfree(batch->nulls);
+	pfree(batch->tids);
+	if (batch->late)
+	{
+		pfree(batch->late);
+		pfree(batch->offsets);
+	}
+	pfree(batch);
+}
+
+/*
+ * Mark the projected columns for which late[attno] is set as late: batches
+ * are returned without them, for the caller to filter the rows on the other
+ * columns first.  See aocs_batch_read_late().
+ */
+void
+aocs_batch_set_late_columns(AOCSScanDesc scan, AOCSBatch batch, bool *late)
+{
+	int			nlate = 0;
+	int			i;
+
+	Assert(batch->late == NULL);
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		if (late[scan->proj_atts[i]])
+			nlate++;
+	}
+
+	/* Some column must be left to filter on */
+	if (nlate == 0 || nlate == scan->num_proj_atts)
+		return;
+
+	batch->late = palloc0(batch->natts * sizeof(bool));
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		batch->late[attno] = late[attno];
+	}
+	batch->offsets = palloc(batch->maxrows * sizeof(int));
+}
+
+/*
+ * Use block min/max to skip blocks of the columns that 'qual' constrains, in
+ * aocs_getnext_batch().  'qual' is an implicitly AND'ed list of clauses that
+ * the caller will still check on every row returned.
+ */
+void
+aocs_enable_block_minmax(AOCSScanDesc scan, List *qual)
+{
+	Assert(scan->blockminmax == NULL);
+
+	scan->blockminmax = AOCSBlockMinMaxBeginScan(scan->aos_rel, qual);
+}
+
+/*
+ * Skip the same rows of the other projected columns as the block of column
+ * 'skipattno' that is being skipped; the caller takes care of that block.
+ * Blocks of the other columns that lie entirely within the skipped rows are
+ * skipped without decompressing them.
+ */
+static void
+skip_rows(AOCSScanDesc scan, int skipattno, int64 nrows)
+{
+	int			i;
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+		DatumStreamRead *ds = scan->ds[attno];
+		int64		left = nrows;
+
+		if (attno == skipattno)
+			continue;
+
+		/* Part of its current block is skipped, so don't summarise it */
+		if (AOCSBlockMinMaxHasKeys(scan->blockminmax, attno))
+			AOCSBlockMinMaxAbandonBlock(scan->blockminmax, attno);
+
+		while (left > 0)
+		{
+			int			n;
+
+			if (datumstreamread_remaining(ds) == 0)
+			{
+				if (datumstreamread_block_header(ds) < 0)
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_CORRUPTED),
+							 errmsg("column %d of append-only column-oriented relation \"%s\" has fewer rows than column %d in segment file %d",
+									attno + 1,
+									RelationGetRelationName(scan->aos_rel),
+									skipattno + 1,
+									scan->seginfo[scan->cur_seg]->segno)));
+
+				if (ds->blockRowCount <= left)
+				{
+					datumstreamread_block_skip(ds);
+					left -= ds->blockRowCount;
+					continue;
+				}
+				datumstreamread_block_content(ds);
+			}
+
+			n = (int) Min(left, (int64) datumstreamread_remaining(ds));
+			datumstreamread_skip(ds, n);
+			left -= n;
+		}
+	}
+
+	scan->cur_seg_row += nrows;
+}
+
+/*
+ * Read the next batch of visible rows, in the same order as aocs_getnext()
+ * would return them.  Returns false at the end of the scan.
+ *
+ * A batch never extends past the current block of any projected column, so
+ * that each column is decoded with one tight loop over its block, and the
+ * values can point into the blocks.  Batches are therefore often shorter
+ * than maxrows, and may even be empty if none of the rows read are visible;
+ * callers just ask for the next one.
+ */
+bool
+aocs_getnext_batch(AOCSScanDesc scan, AOCSBatch batch)
+{
+	AOCSFileSegInfo *curseginfo;
+	int64		rowNum;
+	int			nrows;
+	int			nvisible;
+	int			err = 0;
+	int			i;
+	int			row;
+	bool		isSnapshotAny = (scan->snapshot == SnapshotAny);
+	bool		use_block_minmax;
+	bool		late;
+
+	Assert(!batch->late_pending);
+	batch->nrows = 0;
+
+ReadNext:
+	/* If necessary, open next seg */
+	if (scan->cur_seg < 0 || err < 0)
+	{
+		err = open_next_scan_seg(scan);
+		if (err < 0)
+		{
+			/* No more seg, we are at the end */
+			scan->cur_seg = -1;
+			return false;
+		}
+		scan->cur_seg_row = 0;
+	}
+
+	curseginfo = scan->seginfo[scan->cur_seg];
+
+	/*
+	 * Block min/max is not kept for older format versions, and while
+	 * building the block directory every block has to be read anyway.
+	 */
+	use_block_minmax = (scan->blockminmax != NULL &&
+						scan->blockDirectory == NULL &&
+						!PG82NumericConversionNeeded(curseginfo->formatversion));
+
+	/*
+	 * Make sure every projected column is positioned in a block with rows
+	 * left, and size the batch to fit in all of them.
+	 */
+	nrows = batch->maxrows;
+	rowNum = INT64CONST(-1);
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+		DatumStreamRead *ds = scan->ds[attno];
+		int			remaining;
+
+		remaining = datumstreamread_remaining(ds);
+		if (remaining == 0)
+		{
+			if (use_block_minmax && AOCSBlockMinMaxHasKeys(scan->blockminmax, attno))
+			{
+				err = datumstreamread_block_header(ds);
+				if (err == 0 &&
+					AOCSBlockMinMaxSkipBlock(scan->blockminmax, curseginfo->segno,
+											 attno, ds))
+				{
+					/* No row of the block can pass the quals */
+					skip_rows(scan, attno, ds->blockRowCount);
+					datumstreamread_block_skip(ds);
+					goto ReadNext;
+				}
+				if (err == 0)
+				{
+					datumstreamread_block_content(ds);
+					if (AOCSBlockMinMaxSkipDictionary(scan->blockminmax, attno, ds))
+					{
+						/* No distinct value of the block passes the quals */
+						skip_rows(scan, attno, ds->blockRowCount);
+						datumstreamread_block_discard(ds);
+						goto ReadNext;
+					}
+				}
+			}
+			else
+				err = datumstreamread_block(ds, scan->blockDirectory, attno);
+			if (err < 0)
+			{
+				/* No more blocks in this seg, go to the next one */
+				close_cur_scan_seg(scan);
+				goto ReadNext;
+			}
+			remaining = datumstreamread_remaining(ds);
+			Assert(remaining > 0);
+		}
+
+		nrows = Min(nrows, remaining);
+
+		if (rowNum == INT64CONST(-1) && ds->blockFirstRowNum != INT64CONST(-1))
+		{
+			Assert(ds->blockFirstRowNum > 0);
+			rowNum = ds->blockFirstRowNum + datumstreamread_nth(ds) + 1;
+		}
+	}
+
+	/*
+	 * Datums from an older format version may need an upgrade, which uses
+	 * space that holds only one value per column at a time.
+	 */
+	if (PG82NumericConversionNeeded(curseginfo->formatversion))
+		nrows = 1;
+
+	/* Leave the late columns for aocs_batch_read_late(), if there are any */
+	late = (batch->late != NULL &&
+			!PG82NumericConversionNeeded(curseginfo->formatversion));
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+		int			nread PG_USED_FOR_ASSERTS_ONLY;
+
+		if (late && batch->late[attno])
+			continue;
+
+		nread = datumstreamread_get_batch(scan->ds[attno], nrows,
+										  batch->values[attno],
+										  batch->nulls[attno]);
+		Assert(nread == nrows);
+
+		if (use_block_minmax && AOCSBlockMinMaxHasKeys(scan->blockminmax, attno))
+			AOCSBlockMinMaxAccumulate(scan->blockminmax, attno,
+									  batch->values[attno], batch->nulls[attno],
+									  nrows,
+									  datumstreamread_remaining(scan->ds[attno]) == 0);
+
+		if (PG82NumericConversionNeeded(curseginfo->formatversion))
+			upgrade_datum_impl(scan->ds[attno], 0,
+							   batch->values[attno], batch->nulls[attno],
+							   curseginfo->formatversion);
+	}
+
+	/* Assign TIDs, and squeeze out the rows that aren't visible. */
+	nvisible = 0;
+	for (row = 0; row < nrows; row++)
+	{
+		AOTupleId  *tid = &batch->tids[nvisible];
+
+		scan->cur_seg_row++;
+		if (rowNum == INT64CONST(-1))
+			AOTupleIdInit(tid, curseginfo->segno, scan->cur_seg_row);
+		else
+			AOTupleIdInit(tid, curseginfo->segno, rowNum + row);
+
+		if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, tid))
+			continue;
+
+		if (late)
+			batch->offsets[nvisible] = row;
+
+		if (nvisible != row)
+		{
+			for (i = 0; i < scan->num_proj_atts; i++)
+			{
+				int			attno = scan->proj_atts[i];
+
+				if (late && batch->late[attno])
+					continue;
+
+				batch->values[attno][nvisible] = batch->values[attno][row];
+				batch->nulls[attno][nvisible] = batch->nulls[attno][row];
+			}
+		}
+		nvisible++;
+	}
+
+	batch->nrows = nvisible;
+	batch->nread = nrows;
+	batch->late_pending = late;
+	return true;
+}
+
+/*
+ * Read the late columns of a batch that aocs_getnext_batch() returned
+ * without them, for just the rows sel[0 .. nsel - 1], in ascending order.
+ * The batch is reduced to those rows.  The values of the other rows are
+ * stepped over within the blocks without being decoded into the batch.
+ */
+void
+aocs_batch_read_late(AOCSScanDesc scan, AOCSBatch batch, int *sel, int nsel)
+{
+	int			i;
+	int			k;
+
+	Assert(batch->late_pending);
+	Assert(nsel <= batch->nrows);
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+		DatumStreamRead *ds = scan->ds[attno];
+		int			base;
+
+		if (!batch->late[attno])
+			continue;
+
+		if (ds->largeObjectState != DatumStreamLargeObjectState_None)
+		{
+			/* A large object is the only datum of its block. */
+			Assert(batch->nread == 1);
+			if (nsel > 0)
+				datumstreamread_get_batch(ds, 1, batch->values[attno],
+										  batch->nulls[attno]);
+			else
+				datumstreamread_skip(ds, 1);
+			continue;
+		}
+
+		/* The block position just before the first row of the batch */
+		base = datumstreamread_nth(ds);
+		for (k = 0; k < nsel; k++)
+		{
+			datumstreamread_find(ds, base + 1 + batch->offsets[sel[k]]);
+			datumstreamread_get(ds, &batch->values[attno][k],
+								&batch->nulls[attno][k]);
+		}
+		datumstreamread_find(ds, base + batch->nread);
+	}
+
+	/* Squeeze the rows that were filtered out of the other columns */
+	for (k = 0; k < nsel; k++)
+	{
+		int			row = sel[k];
+
+		Assert(row >= k && (k == 0 || row > sel[k - 1]));
+		if (row == k)
+			continue;
+
+		for (i = 0; i < scan->num_proj_atts; i++)
+		{
+			int			attno = scan->proj_atts[i];
+
+			if (batch->late[attno])
+				continue;
+
+			batch->values[attno][k] = batch->values[attno][row];
+			batch->nulls[attno][k] = batch->nulls[attno][row];
+		}
+		batch->tids[k] = batch->tids[row];
+	}
+
+	batch->nrows = nsel;
+	batch->late_pending = false;
+}
+
+/*
+ * Store row 'row' of a batch in a virtual tuple slot, the way aocs_getnext()
+ * would have.
+ */
+void
+aocs_batch_store_row(AOCSScanDesc scan, AOCSBatch batch, int row,
+					 TupleTableSlot *slot)
+{
+	Datum	   *d = slot_get_values(slot);
+	bool	   *null = slot_get_isnull(slot);
+	int			i;
+
+	Assert(row >= 0 && row < batch->nrows);
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		if (batch->late_pending && batch->late[attno])
+		{
+			/* not read yet; the caller is only filtering on the others */
+			d[attno] = (Datum) 0;
+			null[attno] = true;
+			continue;
+		}
+
+		d[attno] = batch->values[attno][row];
+		null[attno] = batch->nulls[attno][row];
+	}
+
+	scan->cdb_fake_ctid = *((ItemPointer) &batch->tids[row]);
+
+	TupSetVirtualTupleNValid(slot, slot->tts_tupleDescriptor->natts);
+	slot_set_ctid(slot, &(scan->cdb_fake_ctid));
+}
+
 
 /* Open next file segment for write.  See SetCurrentFileSegForWrite */
 /* XXX Right now, we put each column to different files */
@@ -1086,7 +1544,7 @@ fetchFromCurrentBlock(AOCSFetchDesc aocsFetchDesc,
 		/*
 		 * Perform any required upgrades on the Datum we just fetched.
 		 */
-		if (formatversion < AORelationVersion_GetLatest())
+		if (PG82NumericConversionNeeded(formatversion))
 		{
 			upgrade_datum_fetch(aocsFetchDesc, colno, values, nulls,
 								formatversion);
@@ -1873,6 +2331,13 @@ aocs_addcol_newsegfile(AOCSAddColumnDesc desc,
 								   0 /* eof */ , 0 /* eof_uncompressed */ ,
 								   &relfilenode, fileSegNo,
 								   version);
+
+		/*
+		 * The segfile keeps its own format version, which readers of the
+		 * new column's blocks go by.
+		 */
+		desc->dsw[i]->blockWrite.dictionary_can_have_compression =
+			DatumStreamDictionaryAllowed(seginfo->formatversion);
 		desc->dsw[i]->blockFirstRowNum = 1;
 	}
 	desc->cur_segno = seginfo->segno;
@@ -46,6 +46,7 @@
 #include "utils/datumstream.h"
 #include "utils/int8.h"
 #include "utils/fmgroids.h"
+#include "utils/guc.h"
 #include "access/aocssegfiles.h"
 #include "access/aosegfiles.h"
 #include "access/appendonlywriter.h"
@@ -67,6 +68,19 @@ static AOCSFileSegInfo **GetAllAOCSFileSegInfo_pg_aocsseg_rel(
 									 Snapshot appendOnlyMetaDataSnapshot,
 									 int32 *totalseg);
 
+/*
+ * New segments are always created in the latest format, unless their datum
+ * stream blocks may be dictionary encoded, which needs a newer one.
+ */
+static int16
+AOCSNewSegfileFormatVersion(void)
+{
+	if (gp_aocs_dictionary_encoding)
+		return AORelationVersion_GP7;
+
+	return AORelationVersion_GetLatest();
+}
+
 AOCSFileSegInfo *
 NewAOCSFileSegInfo(int32 segno, int32 nvp)
 {
@@ -77,8 +91,7 @@ NewAOCSFileSegInfo(int32 segno, int32 nvp)
 	seginfo   ->vpinfo.nEntry = nvp;
 	seginfo   ->state = AOSEG_STATE_DEFAULT;
 
-	/* New segments are always created in the latest format */
-	seginfo   ->formatversion = AORelationVersion_GetLatest();
+	seginfo   ->formatversion = AOCSNewSegfileFormatVersion();
 
 	return seginfo;
 }
@@ -95,8 +108,7 @@ InsertInitialAOCSFileSegInfo(Relation prel, int32 segno, int32 nvp)
 
 	ValidateAppendonlySegmentDataBeforeStorage(segno);
 
-	/* New segments are always created in the latest format */
-	formatVersion = AORelationVersion_GetLatest();
+	formatVersion = AOCSNewSegfileFormatVersion();
 
 	segrel = heap_open(prel->rd_appendonly->segrelid, RowExclusiveLock);
 
@@ -657,7 +669,7 @@ ClearAOCSFileSegInfo(Relation prel, int segno, FileSegInfoState newState)
 	repl[Anum_pg_aocs_varblockcount - 1] = true;
 
 	/* When the segment is later recreated, it will be in new format */
-	d[Anum_pg_aocs_formatversion - 1] = Int16GetDatum(AORelationVersion_GetLatest());
+	d[Anum_pg_aocs_formatversion - 1] = Int16GetDatum(AOCSNewSegfileFormatVersion());
 	repl[Anum_pg_aocs_formatversion - 1] = true;
 
 	/* We do not reset the modcount here */
@@ -1028,7 +1028,7 @@ SetSegnoForCompactionInsert(Relation rel,
 
 		if (segfilestat->total_tupcount < min_tupcount &&
 			segfilestat->state == AVAILABLE &&
-			segfilestat->formatversion == AORelationVersion_GetLatest() &&
+			AORelationVersion_IsWritable(segfilestat->formatversion) &&
 			!usedByConcurrentTransaction(segfilestat, i) &&
 			!in_compaction_list)
 		{
@@ -1176,7 +1176,7 @@ SetSegnoForWrite(Relation rel, int existingsegno)
 				if (!segfilestat->isfull)
 				{
 					if (segfilestat->state == AVAILABLE &&
-						segfilestat->formatversion == AORelationVersion_GetLatest() &&
+						AORelationVersion_IsWritable(segfilestat->formatversion) &&
 						!segno_chosen &&
 						!usedByConcurrentTransaction(segfilestat, i))
 					{
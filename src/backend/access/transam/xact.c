@@ -2250,6 +2250,14 @@ StartTransaction(void)
 		SIMPLE_FAULT_INJECTOR("transaction_start_under_entry_db_singleton");
 	}
 
+	/*
+	 * The previous transaction of this session may have left its 'Commit
+	 * Prepared' broadcast in flight; it must be finished before we can see
+	 * our own changes, or dispatch anything else.
+	 */
+	if (Gp_role == GP_ROLE_DISPATCH)
+		finishAsyncCommitPrepared();
+
 	/*
 	 * Let's just make sure the state stack is empty
 	 */
@@ -20,15 +20,35 @@
 #endif
 #include <sys/file.h>
 #include <unistd.h>
+#include <limits.h>
+#include <pthread.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 #include "catalog/pg_compression.h"
 #include "cdb/cdbappendonlystorage.h"
 #include "cdb/cdbappendonlystoragelayer.h"
 #include "cdb/cdbappendonlystorageformat.h"
 #include "cdb/cdbappendonlystorageread.h"
+#include "cdb/cdbutil.h"
 #include "storage/gp_compress.h"
 #include "utils/guc.h"
 
+/*
+ * When gp_appendonly_decompress_threads > 1, each thread is given up to this
+ * many blocks per batch, within the memory bound below.
+ */
+#define AO_DECOMPRESS_BLOCKS_PER_THREAD 4
+#define AO_DECOMPRESS_MAX_AHEAD_BYTES (8 * 1024 * 1024)
+
+static struct AppendOnlyDecompressAhead *AppendOnlyStorageRead_CreateDecompressAhead(
+								AppendOnlyStorageRead *storageRead);
+static void AppendOnlyStorageRead_FreeDecompressAhead(
+								AppendOnlyStorageRead *storageRead);
+static void AppendOnlyStorageRead_ForgetDecompressAhead(
+								AppendOnlyStorageRead *storageRead);
+
 
 /*----------------------------------------------------------------
  * Initialization
@@ -100,9 +120,26 @@ AppendOnlyStorageRead_Init(AppendOnlyStorageRead *storageRead,
 													   storageRead->storageAttributes.checksum);
 
 	/*
-	 * Initialize BufferedRead.
+	 * Set up decompressing ahead, if enabled and possible for this
+	 * compression.
+	 */
+	storageRead->decompressAhead =
+		AppendOnlyStorageRead_CreateDecompressAhead(storageRead);
+
+	/*
+	 * Initialize BufferedRead.  When decompressing ahead, read enough at a
+	 * time for each thread to find blocks to work on.
 	 */
 	storageRead->largeReadLen = 2 * storageRead->maxBufferLen;
+	if (storageRead->decompressAhead != NULL)
+	{
+		int			aheadBlocks;
+
+		aheadBlocks = Min(gp_appendonly_decompress_threads * AO_DECOMPRESS_BLOCKS_PER_THREAD,
+						  AO_DECOMPRESS_MAX_AHEAD_BYTES / storageRead->maxBufferLen);
+		if (aheadBlocks > 2)
+			storageRead->largeReadLen = aheadBlocks * storageRead->maxBufferLen;
+	}
 
 	memoryLen = BufferedReadMemoryLen(storageRead->maxBufferLen,
 									  storageRead->largeReadLen);
@@ -189,6 +226,8 @@ AppendOnlyStorageRead_FinishSession(AppendOnlyStorageRead *storageRead)
 		storageRead->segmentFileName = NULL;
 	}
 
+	AppendOnlyStorageRead_FreeDecompressAhead(storageRead);
+
 	if (storageRead->compression_functions != NULL)
 	{
 		callCompressionDestructor(storageRead->compression_functions[COMPRESSION_DESTRUCTOR], storageRead->compressionState);
@@ -456,6 +495,9 @@ AppendOnlyStorageRead_CloseFile(AppendOnlyStorageRead *storageRead)
 
 	if (storageRead->bufferedRead.file >= 0)
 		BufferedReadCompleteFile(&storageRead->bufferedRead);
+
+	/* Blocks of the next file have the same offsets. */
+	AppendOnlyStorageRead_ForgetDecompressAhead(storageRead);
 }
 
 
@@ -1219,6 +1261,460 @@ AppendOnlyStorageRead_GetBuffer(AppendOnlyStorageRead *storageRead)
 	return content;
 }
 
+/*----------------------------------------------------------------
+ * Decompressing ahead
+ *----------------------------------------------------------------
+ */
+
+/*
+ * When gp_appendonly_decompress_threads > 1, a compressed block that wasn't
+ * decompressed ahead of time is decompressed in one batch together with the
+ * compressed blocks that follow it in the current large read.  The batch is
+ * spread over short-lived threads, and the scanning backend waits for all
+ * of them before going on.  The contents of the following blocks are kept
+ * in buffers allocated in the read's memory context, and are handed out in
+ * order as the scan reaches those blocks.
+ *
+ * The threads call the zlib or zstd library directly, never the
+ * pg_compression decompressor, which may palloc or ereport.  A block that
+ * fails to decompress in a thread is decompressed again the regular way,
+ * which reports the error.
+ */
+typedef enum AppendOnlyDecompressLib
+{
+	AoDecompressLib_Zlib,
+	AoDecompressLib_Zstd
+} AppendOnlyDecompressLib;
+
+typedef struct AppendOnlyDecompressBlock
+{
+	int64		headerOffsetInFile;
+	uint8	   *compressed;		/* points into the BufferedRead memory */
+	int32		compressedLen;
+	uint8	   *uncompressed;	/* caller's buffer, or buffer below */
+	int32		uncompressedLen;
+	bool		ok;
+
+	uint8	   *buffer;			/* maxBufferLen bytes, allocated on first use */
+} AppendOnlyDecompressBlock;
+
+typedef struct AppendOnlyDecompressWorker
+{
+	struct AppendOnlyDecompressAhead *ahead;
+	int			workerno;
+	pthread_t	thread;
+	bool		started;
+#ifdef HAVE_LIBZSTD
+	zstd_context *zstd;
+#endif
+} AppendOnlyDecompressWorker;
+
+typedef struct AppendOnlyDecompressAhead
+{
+	AppendOnlyDecompressLib lib;
+
+	int			maxWorkers;
+	AppendOnlyDecompressWorker *workers;
+	int			nworkers;		/* workers in the current batch */
+
+	int			maxBlocks;
+	AppendOnlyDecompressBlock *blocks;
+	int			nblocks;		/* blocks in the current batch */
+	int			nextBlock;		/* next block to hand out */
+} AppendOnlyDecompressAhead;
+
+/*
+ * Set up decompressing ahead for a read session, or return NULL when it is
+ * disabled or not possible for the table's compression.
+ */
+static AppendOnlyDecompressAhead *
+AppendOnlyStorageRead_CreateDecompressAhead(AppendOnlyStorageRead *storageRead)
+{
+	AppendOnlyStorageAttributes *attr = &storageRead->storageAttributes;
+	AppendOnlyDecompressAhead *ahead;
+	AppendOnlyDecompressLib lib;
+	int			maxBlocks;
+	int			i;
+
+	if (gp_appendonly_decompress_threads <= 1 ||
+		!attr->compress || attr->compressType == NULL)
+		return NULL;
+
+	/*
+	 * Blocks are found by walking the block headers in the large read.
+	 * Don't bother with the zero padding of tables that have it.
+	 */
+	if (attr->safeFSWriteSize != 0)
+		return NULL;
+
+#ifdef HAVE_LIBZ
+	if (pg_strcasecmp(attr->compressType, "zlib") == 0)
+		lib = AoDecompressLib_Zlib;
+	else
+#endif
+#ifdef HAVE_LIBZSTD
+	if (pg_strcasecmp(attr->compressType, "zstd") == 0)
+		lib = AoDecompressLib_Zstd;
+	else
+#endif
+		return NULL;
+
+	maxBlocks = Min(gp_appendonly_decompress_threads * AO_DECOMPRESS_BLOCKS_PER_THREAD,
+					AO_DECOMPRESS_MAX_AHEAD_BYTES / storageRead->maxBufferLen);
+	if (maxBlocks < 2)
+		return NULL;
+
+	ahead = (AppendOnlyDecompressAhead *) palloc0(sizeof(AppendOnlyDecompressAhead));
+	ahead->lib = lib;
+	ahead->maxWorkers = Min(gp_appendonly_decompress_threads, maxBlocks);
+	ahead->workers = (AppendOnlyDecompressWorker *)
+		palloc0(ahead->maxWorkers * sizeof(AppendOnlyDecompressWorker));
+	ahead->maxBlocks = maxBlocks;
+	ahead->blocks = (AppendOnlyDecompressBlock *)
+		palloc0(maxBlocks * sizeof(AppendOnlyDecompressBlock));
+
+	for (i = 0; i < ahead->maxWorkers; i++)
+	{
+		AppendOnlyDecompressWorker *worker = &ahead->workers[i];
+
+		worker->ahead = ahead;
+		worker->workerno = i;
+#ifdef HAVE_LIBZSTD
+		if (lib == AoDecompressLib_Zstd)
+		{
+			worker->zstd = zstd_alloc_context();
+			worker->zstd->dctx = ZSTD_createDCtx();
+			if (!worker->zstd->dctx)
+				elog(ERROR, "out of memory");
+		}
+#endif
+	}
+
+	return ahead;
+}
+
+static void
+AppendOnlyStorageRead_FreeDecompressAhead(AppendOnlyStorageRead *storageRead)
+{
+	AppendOnlyDecompressAhead *ahead = storageRead->decompressAhead;
+	int			i;
+
+	if (ahead == NULL)
+		return;
+
+#ifdef HAVE_LIBZSTD
+	for (i = 0; i < ahead->maxWorkers; i++)
+	{
+		if (ahead->workers[i].zstd != NULL)
+			zstd_free_context(ahead->workers[i].zstd);
+	}
+#endif
+	for (i = 0; i < ahead->maxBlocks; i++)
+	{
+		if (ahead->blocks[i].buffer != NULL)
+			pfree(ahead->blocks[i].buffer);
+	}
+	pfree(ahead->blocks);
+	pfree(ahead->workers);
+	pfree(ahead);
+
+	storageRead->decompressAhead = NULL;
+}
+
+static void
+AppendOnlyStorageRead_ForgetDecompressAhead(AppendOnlyStorageRead *storageRead)
+{
+	if (storageRead->decompressAhead != NULL)
+	{
+		storageRead->decompressAhead->nblocks = 0;
+		storageRead->decompressAhead->nextBlock = 0;
+	}
+}
+
+/*
+ * Thread body: decompress every nworkers'th block of the batch.
+ *
+ * Runs outside the backend proper, so it must not palloc, ereport or touch
+ * any other backend state.
+ */
+static void *
+appendonly_decompress_worker(void *arg)
+{
+	AppendOnlyDecompressWorker *me = (AppendOnlyDecompressWorker *) arg;
+	AppendOnlyDecompressAhead *ahead = me->ahead;
+	int			i;
+
+	for (i = me->workerno; i < ahead->nblocks; i += ahead->nworkers)
+	{
+		AppendOnlyDecompressBlock *block = &ahead->blocks[i];
+
+		block->ok = false;
+		switch (ahead->lib)
+		{
+#ifdef HAVE_LIBZ
+			case AoDecompressLib_Zlib:
+				{
+					uLongf		destLen = (uLongf) block->uncompressedLen;
+
+					if (uncompress(block->uncompressed, &destLen,
+								   block->compressed,
+								   (uLong) block->compressedLen) == Z_OK &&
+						destLen == (uLongf) block->uncompressedLen)
+						block->ok = true;
+				}
+				break;
+#endif
+#ifdef HAVE_LIBZSTD
+			case AoDecompressLib_Zstd:
+				{
+					size_t		destLen;
+
+					destLen = ZSTD_decompressDCtx(me->zstd->dctx,
+												  block->uncompressed,
+												  block->uncompressedLen,
+												  block->compressed,
+												  block->compressedLen);
+					if (!ZSTD_isError(destLen) &&
+						destLen == (size_t) block->uncompressedLen)
+						block->ok = true;
+				}
+				break;
+#endif
+			default:
+				break;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Decompress the blocks of the current batch, in this thread and
+ * nworkers - 1 others.
+ */
+static void
+AppendOnlyStorageRead_RunDecompressBatch(AppendOnlyDecompressAhead *ahead)
+{
+	sigset_t	old_sigs;
+	pthread_attr_t t_atts;
+	int			i;
+
+	ahead->nworkers = Min(ahead->maxWorkers, ahead->nblocks);
+
+	pthread_attr_init(&t_atts);
+	pthread_attr_setstacksize(&t_atts, Max(PTHREAD_STACK_MIN, (128 * 1024)));
+
+	/* leave the signals to be handled by the main thread */
+	gp_set_thread_sigmasks(&old_sigs);
+	for (i = 1; i < ahead->nworkers; i++)
+		ahead->workers[i].started =
+			(pthread_create(&ahead->workers[i].thread, &t_atts,
+							appendonly_decompress_worker,
+							&ahead->workers[i]) == 0);
+	gp_reset_thread_sigmasks(&old_sigs);
+	pthread_attr_destroy(&t_atts);
+
+	appendonly_decompress_worker(&ahead->workers[0]);
+	for (i = 1; i < ahead->nworkers; i++)
+	{
+		if (ahead->workers[i].started)
+			pthread_join(ahead->workers[i].thread, NULL);
+		else
+			appendonly_decompress_worker(&ahead->workers[i]);
+	}
+}
+
+/*
+ * Add the compressed blocks that follow the current one in the current large
+ * read to the batch, stopping at the first block that isn't entirely there.
+ *
+ * The headers are only looked at here; the scan checks them again, as well
+ * as the block checksums, when it reaches the blocks.
+ */
+static void
+AppendOnlyStorageRead_CollectAheadBlocks(AppendOnlyStorageRead *storageRead)
+{
+	AppendOnlyDecompressAhead *ahead = storageRead->decompressAhead;
+	bool		usingChecksums = storageRead->storageAttributes.checksum;
+	int64		position;
+	uint8	   *header;
+	int32		availableLen;
+
+	position = BufferedReadNextBufferPosition(&storageRead->bufferedRead);
+	header = BufferedReadPeekAhead(&storageRead->bufferedRead, &availableLen);
+
+	while (ahead->nblocks < ahead->maxBlocks &&
+		   header != NULL &&
+		   availableLen >= storageRead->minimumHeaderLen)
+	{
+		AoHeaderKind headerKind;
+		int32		actualHeaderLen;
+		int32		overallBlockLen;
+		int32		contentOffset;
+		int32		uncompressedLen;
+		int			executorBlockKind;
+		bool		hasFirstRowNum;
+		int64		firstRowNum;
+		int			rowCount;
+		bool		isCompressed;
+		int32		compressedLen;
+		int32		blockLimitLen;
+		pg_crc32	storedChecksum;
+		pg_crc32	computedChecksum;
+		AOHeaderCheckError checkError;
+
+		if (usingChecksums &&
+			!AppendOnlyStorageFormat_VerifyHeaderChecksum(header,
+														  &storedChecksum,
+														  &computedChecksum))
+			break;
+
+		if (AppendOnlyStorageFormat_GetHeaderInfo(header,
+												  usingChecksums,
+												  &headerKind,
+												  &actualHeaderLen) != AOHeaderCheckOk ||
+			actualHeaderLen > availableLen)
+			break;
+
+		blockLimitLen = Min(availableLen, storageRead->maxBufferLen);
+		if (headerKind == AoHeaderKind_SmallContent)
+			checkError = AppendOnlyStorageFormat_GetSmallContentHeaderInfo(header,
+																		   actualHeaderLen,
+																		   usingChecksums,
+																		   blockLimitLen,
+																		   &overallBlockLen,
+																		   &contentOffset,
+																		   &uncompressedLen,
+																		   &executorBlockKind,
+																		   &hasFirstRowNum,
+																		   storageRead->formatVersion,
+																		   &firstRowNum,
+																		   &rowCount,
+																		   &isCompressed,
+																		   &compressedLen);
+		else if (headerKind == AoHeaderKind_BulkDenseContent)
+			checkError = AppendOnlyStorageFormat_GetBulkDenseContentHeaderInfo(header,
+																			   actualHeaderLen,
+																			   usingChecksums,
+																			   blockLimitLen,
+																			   &overallBlockLen,
+																			   &contentOffset,
+																			   &uncompressedLen,
+																			   &executorBlockKind,
+																			   &hasFirstRowNum,
+																			   storageRead->formatVersion,
+																			   &firstRowNum,
+																			   &rowCount,
+																			   &isCompressed,
+																			   &compressedLen);
+		else
+			break;
+
+		if (checkError != AOHeaderCheckOk ||
+			overallBlockLen <= 0 || overallBlockLen > availableLen)
+			break;
+
+		if (isCompressed)
+		{
+			AppendOnlyDecompressBlock *block;
+
+			if (uncompressedLen <= 0 ||
+				uncompressedLen > storageRead->maxBufferLen)
+				break;
+
+			block = &ahead->blocks[ahead->nblocks++];
+			if (block->buffer == NULL)
+				block->buffer = MemoryContextAlloc(storageRead->memoryContext,
+												   storageRead->maxBufferLen);
+			block->headerOffsetInFile = position;
+			block->compressed = &header[contentOffset];
+			block->compressedLen = compressedLen;
+			block->uncompressed = block->buffer;
+			block->uncompressedLen = uncompressedLen;
+		}
+
+		position += overallBlockLen;
+		header += overallBlockLen;
+		availableLen -= overallBlockLen;
+	}
+}
+
+/*
+ * Try to decompress the current block into contentOut by decompressing
+ * ahead.  Returns false if the caller must decompress it the regular way.
+ *
+ * content points to the compressed content of the current block.
+ */
+static bool
+AppendOnlyStorageRead_DecompressAhead(AppendOnlyStorageRead *storageRead,
+									  uint8 *content,
+									  uint8 *contentOut)
+{
+	AppendOnlyDecompressAhead *ahead = storageRead->decompressAhead;
+	AppendOnlyStorageReadCurrent *current = &storageRead->current;
+	AppendOnlyDecompressBlock *block;
+
+	if (ahead == NULL)
+		return false;
+
+	/*
+	 * Hand out the block if it was decompressed by an earlier batch.  Blocks
+	 * the scan skipped over are passed by.
+	 */
+	while (ahead->nextBlock < ahead->nblocks)
+	{
+		block = &ahead->blocks[ahead->nextBlock];
+		if (block->headerOffsetInFile > current->headerOffsetInFile)
+			break;
+
+		ahead->nextBlock++;
+		if (block->headerOffsetInFile == current->headerOffsetInFile)
+		{
+			if (!block->ok ||
+				block->compressedLen != current->compressedLen ||
+				block->uncompressedLen != current->uncompressedLen)
+				return false;
+
+			memcpy(contentOut, block->uncompressed, block->uncompressedLen);
+			return true;
+		}
+	}
+
+	/*
+	 * Start a new batch with the current block, decompressed straight into
+	 * the caller's buffer.
+	 */
+	block = &ahead->blocks[0];
+	block->headerOffsetInFile = current->headerOffsetInFile;
+	block->compressed = content;
+	block->compressedLen = current->compressedLen;
+	block->uncompressed = contentOut;
+	block->uncompressedLen = current->uncompressedLen;
+	ahead->nblocks = 1;
+	ahead->nextBlock = 1;
+
+	AppendOnlyStorageRead_CollectAheadBlocks(storageRead);
+	if (ahead->nblocks == 1)
+	{
+		/* Nothing to do ahead. */
+		AppendOnlyStorageRead_ForgetDecompressAhead(storageRead);
+		return false;
+	}
+
+	AppendOnlyStorageRead_RunDecompressBatch(ahead);
+
+	elogif(Debug_appendonly_print_scan, LOG,
+		   "Append-only Storage Read decompressed %d blocks with %d threads for table '%s' "
+		   "(segment file '%s', header offset in file = " INT64_FORMAT ")",
+		   ahead->nblocks,
+		   ahead->nworkers,
+		   storageRead->relationName,
+		   storageRead->segmentFileName,
+		   current->headerOffsetInFile);
+
+	return ahead->blocks[0].ok;
+}
+
 /*
  * Copy the large and/or decompressed content out.
  *
@@ -1401,13 +1897,16 @@ AppendOnlyStorageRead_Content(AppendOnlyStorageRead *storageRead,
 
 			decompressor = cfns[COMPRESSION_DECOMPRESS];
 
-			gp_decompress(content,    /* Compressed data in block. */
-						  storageRead->current.compressedLen,
-						  contentOut,
-						  storageRead->current.uncompressedLen,
-						  decompressor,
-						  storageRead->compressionState,
-						  storageRead->bufferCount);
+			if (!AppendOnlyStorageRead_DecompressAhead(storageRead,
+													   content,
+													   contentOut))
+				gp_decompress(content,    /* Compressed data in block. */
+							  storageRead->current.compressedLen,
+							  contentOut,
+							  storageRead->current.uncompressedLen,
+							  decompressor,
+							  storageRead->compressionState,
+							  storageRead->bufferCount);
 
 			if (Debug_appendonly_print_scan)
 				elog(LOG,
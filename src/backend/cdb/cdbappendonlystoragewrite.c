@@ -307,10 +307,10 @@ AppendOnlyStorageWrite_OpenFile(AppendOnlyStorageWrite *storageWrite,
 	Assert(filePathName != NULL);
 
 	/*
-	 * Assume that we only write in the current latest format. (it's redundant
-	 * to pass the version number as argument, currently)
+	 * Assume that we only write in the current latest format, or in the
+	 * version that allows dictionary encoded datum stream blocks.
 	 */
-	if (version != AORelationVersion_GetLatest())
+	if (!AORelationVersion_IsWritable(version))
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 				 errmsg("cannot write append-only table version %d", version)));
@@ -22,6 +22,8 @@
 
 static void BufferedReadIo(
 			   BufferedRead *bufferedRead);
+static void BufferedReadPrefetch(
+					 BufferedRead *bufferedRead);
 static uint8 *BufferedReadUseBeforeBuffer(
 							BufferedRead *bufferedRead,
 							int32 maxReadAheadLen,
@@ -106,6 +108,8 @@ BufferedReadInit(
 	 */
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
+
+	bufferedRead->prefetchedUpTo = 0;
 }
 
 /*
@@ -139,6 +143,8 @@ BufferedReadSetFile(
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
 
+	bufferedRead->prefetchedUpTo = 0;
+
 	if (fileLen > 0)
 	{
 		/*
@@ -239,6 +245,75 @@ BufferedReadIo(
 
 	if (VacuumCostActive)
 		VacuumCostBalance += VacuumCostPageMiss;
+
+	BufferedReadPrefetch(bufferedRead);
+}
+
+/*
+ * Ask the kernel to start reading the large reads that follow the one just
+ * completed, so the next physical read overlaps the caller's processing
+ * (typically decompression) of the current one.
+ *
+ * This is only advice; failures are ignored and the data is still read
+ * synchronously by BufferedReadIo when it is needed.
+ */
+static void
+BufferedReadPrefetch(
+					 BufferedRead *bufferedRead)
+{
+	int64		inEffectFileLen;
+	int64		prefetchBegin;
+	int64		prefetchEnd;
+
+	if (gp_appendonly_read_ahead <= 0)
+		return;
+
+	if (bufferedRead->haveTemporaryLimitInEffect)
+		inEffectFileLen = bufferedRead->temporaryLimitFileLen;
+	else
+		inEffectFileLen = bufferedRead->fileLen;
+
+	prefetchBegin = bufferedRead->largeReadPosition +
+		bufferedRead->largeReadLen;
+	prefetchEnd = prefetchBegin +
+		(int64) bufferedRead->maxLargeReadLen * gp_appendonly_read_ahead;
+	if (prefetchEnd > inEffectFileLen)
+		prefetchEnd = inEffectFileLen;
+
+	/*
+	 * Don't advise again what an earlier call already covered.  After a
+	 * backward seek the remembered position lies past the window, and the
+	 * whole window is advised again.
+	 */
+	if (bufferedRead->prefetchedUpTo > prefetchBegin &&
+		bufferedRead->prefetchedUpTo <= prefetchEnd)
+		prefetchBegin = bufferedRead->prefetchedUpTo;
+
+	if (prefetchBegin >= prefetchEnd)
+		return;
+
+	elogif(Debug_appendonly_print_read_block, LOG,
+		   "Append-Only storage read-ahead: table \"%s\", segment file \"%s\", "
+		   "position " INT64_FORMAT ", length " INT64_FORMAT,
+		   bufferedRead->relationName,
+		   bufferedRead->filePathName,
+		   prefetchBegin,
+		   prefetchEnd - prefetchBegin);
+
+	while (prefetchBegin < prefetchEnd)
+	{
+		int			amount;
+
+		if (prefetchEnd - prefetchBegin > bufferedRead->maxLargeReadLen)
+			amount = bufferedRead->maxLargeReadLen;
+		else
+			amount = (int) (prefetchEnd - prefetchBegin);
+
+		(void) FilePrefetch(bufferedRead->file, prefetchBegin, amount);
+		prefetchBegin += amount;
+	}
+
+	bufferedRead->prefetchedUpTo = prefetchEnd;
 }
 
 static uint8 *
@@ -410,6 +485,13 @@ BufferedReadSetTemporaryRange(
 		}
 	}
 
+	/*
+	 * Install the temporary limit before any new read, so that read-ahead
+	 * doesn't go past it.
+	 */
+	bufferedRead->haveTemporaryLimitInEffect = true;
+	bufferedRead->temporaryLimitFileLen = afterFileOffset;
+
 	if (newReadNeeded)
 	{
 		int64		remainingFileLen;
@@ -443,10 +525,6 @@ BufferedReadSetTemporaryRange(
 		if (bufferedRead->largeReadLen > 0)
 			BufferedReadIo(bufferedRead);
 	}
-
-	bufferedRead->haveTemporaryLimitInEffect = true;
-	bufferedRead->temporaryLimitFileLen = afterFileOffset;
-
 }
 
 /*
@@ -655,6 +733,42 @@ BufferedReadCurrentPosition(
 	return bufferedRead->largeReadPosition + bufferedRead->bufferOffset;
 }
 
+/*
+ * Return the data following the current buffer that is already in the
+ * large-read memory, starting at BufferedReadNextBufferPosition.
+ *
+ * The data is not consumed and stays valid only until the next call that
+ * reads or grows a buffer.  Returns NULL when the current large read holds
+ * nothing more.
+ */
+uint8 *
+BufferedReadPeekAhead(
+					  BufferedRead *bufferedRead,
+					  int32 *peekLen)
+{
+	int32		nextOffset;
+
+	Assert(bufferedRead != NULL);
+	Assert(bufferedRead->file >= 0);
+	Assert(peekLen != NULL);
+
+	/*
+	 * Even when the current buffer starts in the before memory, it ends in
+	 * the large-read memory.
+	 */
+	nextOffset = bufferedRead->bufferOffset + bufferedRead->bufferLen;
+	Assert(nextOffset >= 0);
+
+	*peekLen = bufferedRead->largeReadLen - nextOffset;
+	if (*peekLen <= 0)
+	{
+		*peekLen = 0;
+		return NULL;
+	}
+
+	return &bufferedRead->largeReadMemory[nextOffset];
+}
+
 /*
  * Flushes the current file for append.  Caller is responsible for closing
  * the file afterwards.
@@ -675,6 +789,8 @@ BufferedReadCompleteFile(
 
 	bufferedRead->largeReadPosition = 0;
 	bufferedRead->largeReadLen = 0;
+
+	bufferedRead->prefetchedUpTo = 0;
 }
 
 
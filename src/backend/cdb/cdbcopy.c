@@ -41,6 +41,13 @@
  *
  * When you're done, call cdbCopyEnd().
  *
+ * With gp_copy_dispatch_batch_size set, COPY FROM data is not handed to
+ * libpq right away.  cdbCopySendData() collects it into a batch per segment,
+ * and a sender thread makes the PQputCopyData() calls for full batches, so
+ * that the backend goes on parsing the next rows meanwhile.  From
+ * cdbCopyStart() to cdbCopyEnd() or cdbCopyAbort(), only the sender thread
+ * touches the connections.
+ *
  * Portions Copyright (c) 2005-2008, Greenplum inc
  * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
  *
@@ -62,17 +69,82 @@
 #include "cdb/cdbfts.h"
 #include "cdb/cdbgang.h"
 #include "cdb/cdbtm.h"
+#include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
 #include "commands/copy.h"
 #include "commands/defrem.h"
 #include "mb/pg_wchar.h"
 #include "nodes/makefuncs.h"
+#include "storage/ipc.h"
 #include "storage/pmsignal.h"
 #include "tcop/tcopprot.h"
 #include "utils/faultinjector.h"
+#include "utils/guc.h"
 #include "utils/memutils.h"
 
 #include <poll.h>
+#include <pthread.h>
+#include <limits.h>
+#include <sys/socket.h>
+
+/*
+ * A full batch of COPY FROM data, waiting for the sender thread.
+ */
+typedef struct CdbCopySendBatch
+{
+	PGconn	   *conn;
+	int			segindex;
+	char	   *data;
+	int			len;
+} CdbCopySendBatch;
+
+/*
+ * The state shared by the backend and the sender thread.
+ *
+ * Each segment has a batch being filled by the backend.  There are twice as
+ * many buffers as segments; the ones not being filled are either queued for
+ * the sender or free.  Everything below the mutex is protected by it.
+ */
+typedef struct CdbCopySender
+{
+	pthread_t	thread;
+	int			batch_size;
+	int			nsegs;			/* entries in the arrays below */
+	char	  **fill;			/* batch being filled, per segindex */
+	int		   *fill_len;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;		/* signalled whenever the below changes */
+	char	  **free_bufs;
+	int			nfree;
+	CdbCopySendBatch *queue;	/* ring of batches for the sender */
+	int			queue_head;
+	int			queue_len;
+	int			queue_size;
+	bool		sending;		/* the sender is in PQputCopyData() */
+	PGconn	   *sending_conn;	/* ... on this connection */
+	bool		shutdown;		/* no more batches are coming */
+	bool		discard;		/* drop the batches still queued */
+	bool		failed;
+	int			failed_seg;
+	char		failed_msg[256];
+} CdbCopySender;
+
+static void cdbCopyStartSender(CdbCopy *c);
+static void cdbCopyStopSender(CdbCopy *c, bool flush);
+static void cdbCopySenderSubmit(CdbCopySender *sender, Gang *gp, int target_seg,
+					bool refill);
+static void cdbCopySenderWaitIdle(CdbCopySender *sender);
+static void *cdbCopySenderMain(void *arg);
+static void cdbCopySenderAtExit(int code, Datum arg);
+
+/*
+ * The running sender thread, if any.  A FATAL error doesn't go through
+ * cdbCopyAbort(), so it is stopped by cdbCopySenderAtExit() instead, before
+ * the gangs are torn down.
+ */
+static CdbCopySender *activeCopySender = NULL;
+static bool copySenderExitRegistered = false;
 
 static void cdbCopyEndInternal(CdbCopy *c, char *abort_msg,
 				   int64 *total_rows_completed_p,
@@ -87,6 +159,310 @@ getCdbCopyPrimaryGang(CdbCopy *c)
 	return (Gang *)linitial(c->dispatcherState->allocatedGangs);
 }
 
+/*
+ * Start the thread that sends COPY FROM batches to the segments.  If it
+ * can't be started, rows are sent as they come.
+ */
+static void
+cdbCopyStartSender(CdbCopy *c)
+{
+	CdbCopySender *sender;
+	Gang	   *gp = getCdbCopyPrimaryGang(c);
+	sigset_t	old_sigs;
+	pthread_attr_t t_atts;
+	int			nbufs;
+	int			i;
+	int			err;
+
+	Assert(gp);
+
+	sender = palloc0(sizeof(CdbCopySender));
+	sender->batch_size = gp_copy_dispatch_batch_size * 1024;
+	sender->nsegs = getgpsegmentCount();
+	sender->fill = palloc0(sender->nsegs * sizeof(char *));
+	sender->fill_len = palloc0(sender->nsegs * sizeof(int));
+
+	nbufs = 2 * gp->size;
+	sender->free_bufs = palloc(nbufs * sizeof(char *));
+	for (i = 0; i < nbufs; i++)
+		sender->free_bufs[sender->nfree++] = palloc(sender->batch_size);
+	sender->queue_size = nbufs;
+	sender->queue = palloc(nbufs * sizeof(CdbCopySendBatch));
+
+	pthread_mutex_init(&sender->mutex, NULL);
+	pthread_cond_init(&sender->cond, NULL);
+
+	pthread_attr_init(&t_atts);
+	pthread_attr_setstacksize(&t_atts, Max(PTHREAD_STACK_MIN, (128 * 1024)));
+
+	/* leave the signals to be handled by the main thread */
+	gp_set_thread_sigmasks(&old_sigs);
+	err = pthread_create(&sender->thread, &t_atts, cdbCopySenderMain, sender);
+	gp_reset_thread_sigmasks(&old_sigs);
+	pthread_attr_destroy(&t_atts);
+
+	if (err != 0)
+	{
+		elog(DEBUG1, "could not start COPY sender thread: %s", strerror(err));
+		pthread_cond_destroy(&sender->cond);
+		pthread_mutex_destroy(&sender->mutex);
+		return;
+	}
+
+	c->sender = sender;
+	activeCopySender = sender;
+
+	if (!copySenderExitRegistered)
+	{
+		before_shmem_exit(cdbCopySenderAtExit, 0);
+		copySenderExitRegistered = true;
+	}
+}
+
+/*
+ * Stop the sender thread.  With flush, the partly filled batches are sent
+ * first; otherwise whatever is not sent yet is dropped, as we are aborting.
+ *
+ * Raises the error the sender ran into, if flushing.
+ */
+static void
+cdbCopyStopSender(CdbCopy *c, bool flush)
+{
+	CdbCopySender *sender;
+	Gang	   *gp = getCdbCopyPrimaryGang(c);
+	int			seg;
+
+	if (c == NULL || c->sender == NULL)
+		return;
+	sender = c->sender;
+
+	if (flush && gp)
+	{
+		for (seg = 0; seg < sender->nsegs; seg++)
+			cdbCopySenderSubmit(sender, gp, seg, false);
+	}
+
+	pthread_mutex_lock(&sender->mutex);
+	sender->shutdown = true;
+	if (!flush)
+		sender->discard = true;
+	pthread_cond_broadcast(&sender->cond);
+	pthread_mutex_unlock(&sender->mutex);
+
+	pthread_join(sender->thread, NULL);
+	pthread_cond_destroy(&sender->cond);
+	pthread_mutex_destroy(&sender->mutex);
+
+	c->sender = NULL;
+	activeCopySender = NULL;
+
+	if (flush && sender->failed)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_ERROR),
+				 errmsg("could not send COPY data to segment %d: %s",
+						sender->failed_seg, sender->failed_msg)));
+}
+
+/*
+ * Queue the batch being filled for the given segment, if it holds anything,
+ * and with refill get an empty one in its place.
+ */
+static void
+cdbCopySenderSubmit(CdbCopySender *sender, Gang *gp, int target_seg,
+					bool refill)
+{
+	CdbCopySendBatch *batch;
+	char	   *buf = NULL;
+
+	if (sender->fill_len[target_seg] == 0 &&
+		(sender->fill[target_seg] != NULL || !refill))
+		return;
+
+	pthread_mutex_lock(&sender->mutex);
+
+	if (sender->failed)
+	{
+		pthread_mutex_unlock(&sender->mutex);
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_ERROR),
+				 errmsg("could not send COPY data to segment %d: %s",
+						sender->failed_seg, sender->failed_msg)));
+	}
+
+	if (sender->fill_len[target_seg] > 0)
+	{
+		/* there are as many queue slots as buffers, so there is always room */
+		Assert(sender->queue_len < sender->queue_size);
+		batch = &sender->queue[(sender->queue_head + sender->queue_len) % sender->queue_size];
+		batch->conn = getSegmentDescriptorFromGang(gp, target_seg)->conn;
+		batch->segindex = target_seg;
+		batch->data = sender->fill[target_seg];
+		batch->len = sender->fill_len[target_seg];
+		sender->queue_len++;
+		sender->fill[target_seg] = NULL;
+		sender->fill_len[target_seg] = 0;
+		pthread_cond_broadcast(&sender->cond);
+	}
+
+	if (!refill)
+	{
+		pthread_mutex_unlock(&sender->mutex);
+		return;
+	}
+
+	/*
+	 * Wait for a free buffer.  Wake up now and then to check for
+	 * interrupts; the sender may be stuck on a segment that doesn't read.
+	 */
+	for (;;)
+	{
+		struct timespec ts;
+
+		if (sender->nfree > 0)
+		{
+			buf = sender->free_bufs[--sender->nfree];
+			break;
+		}
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += 100 * 1000 * 1000;
+		if (ts.tv_nsec >= 1000 * 1000 * 1000)
+		{
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000 * 1000 * 1000;
+		}
+		pthread_cond_timedwait(&sender->cond, &sender->mutex, &ts);
+
+		if (InterruptPending)
+		{
+			pthread_mutex_unlock(&sender->mutex);
+			CHECK_FOR_INTERRUPTS();
+			pthread_mutex_lock(&sender->mutex);
+		}
+	}
+
+	pthread_mutex_unlock(&sender->mutex);
+
+	sender->fill[target_seg] = buf;
+}
+
+/*
+ * Wait until the sender has sent everything queued so far.
+ */
+static void
+cdbCopySenderWaitIdle(CdbCopySender *sender)
+{
+	pthread_mutex_lock(&sender->mutex);
+	while (sender->queue_len > 0 || sender->sending)
+	{
+		struct timespec ts;
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += 100 * 1000 * 1000;
+		if (ts.tv_nsec >= 1000 * 1000 * 1000)
+		{
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000 * 1000 * 1000;
+		}
+		pthread_cond_timedwait(&sender->cond, &sender->mutex, &ts);
+
+		if (InterruptPending)
+		{
+			pthread_mutex_unlock(&sender->mutex);
+			CHECK_FOR_INTERRUPTS();
+			pthread_mutex_lock(&sender->mutex);
+		}
+	}
+	pthread_mutex_unlock(&sender->mutex);
+}
+
+/*
+ * The sender thread.  It must not palloc, ereport or otherwise call into
+ * the backend; libpq is fine, as the backend leaves the connections alone
+ * while the thread runs.  PQputCopyData() may hand QE notices to
+ * MPPnoticeReceiver(), which only malloc()s them onto the notice queue; the
+ * backend doesn't forward that queue until the sender has been stopped.
+ */
+static void *
+cdbCopySenderMain(void *arg)
+{
+	CdbCopySender *sender = (CdbCopySender *) arg;
+
+	pthread_mutex_lock(&sender->mutex);
+	for (;;)
+	{
+		CdbCopySendBatch batch;
+		int			result;
+
+		while (sender->queue_len == 0 && !sender->shutdown)
+			pthread_cond_wait(&sender->cond, &sender->mutex);
+
+		if (sender->queue_len == 0 || sender->discard)
+			break;
+
+		batch = sender->queue[sender->queue_head];
+		sender->queue_head = (sender->queue_head + 1) % sender->queue_size;
+		sender->queue_len--;
+
+		if (!sender->failed)
+		{
+			sender->sending = true;
+			sender->sending_conn = batch.conn;
+			pthread_mutex_unlock(&sender->mutex);
+
+			result = PQputCopyData(batch.conn, batch.data, batch.len);
+
+			pthread_mutex_lock(&sender->mutex);
+			sender->sending = false;
+			sender->sending_conn = NULL;
+			if (result != 1 && !sender->failed)
+			{
+				sender->failed = true;
+				sender->failed_seg = batch.segindex;
+				if (result == 0)
+					strlcpy(sender->failed_msg, "attempt blocked",
+							sizeof(sender->failed_msg));
+				else
+					strlcpy(sender->failed_msg, PQerrorMessage(batch.conn),
+							sizeof(sender->failed_msg));
+			}
+		}
+
+		sender->free_bufs[sender->nfree++] = batch.data;
+		pthread_cond_broadcast(&sender->cond);
+	}
+	pthread_mutex_unlock(&sender->mutex);
+
+	return NULL;
+}
+
+/*
+ * Stop the sender thread when the backend exits in the middle of a COPY,
+ * e.g. on FATAL, so that it doesn't race the gang teardown.  The process is
+ * dying, so the queued batches are dropped, and if the thread is blocked
+ * sending to a segment that doesn't read, its socket is shut down to get it
+ * out of PQputCopyData().
+ */
+static void
+cdbCopySenderAtExit(int code, Datum arg)
+{
+	CdbCopySender *sender = activeCopySender;
+
+	if (sender == NULL)
+		return;
+
+	pthread_mutex_lock(&sender->mutex);
+	sender->shutdown = true;
+	sender->discard = true;
+	if (sender->sending && sender->sending_conn != NULL)
+		shutdown(PQsocket(sender->sending_conn), SHUT_RDWR);
+	pthread_cond_broadcast(&sender->cond);
+	pthread_mutex_unlock(&sender->mutex);
+
+	pthread_join(sender->thread, NULL);
+	activeCopySender = NULL;
+}
+
 /*
  * Create a cdbCopy object that includes all the cdb
  * information and state needed by the backend COPY.
@@ -210,6 +586,9 @@ cdbCopyStart(CdbCopy *c, CopyStmt *stmt,
 	CdbDispatchCopyStart(c, (Node *) stmt, flags);
 
 	SIMPLE_FAULT_INJECTOR("cdb_copy_start_after_dispatch");
+
+	if (c->copy_in && gp_copy_dispatch_batch_size > 0)
+		cdbCopyStartSender(c);
 }
 
 /*
@@ -249,6 +628,32 @@ cdbCopySendData(CdbCopy *c, int target_seg, const char *buffer,
 
 	gp = getCdbCopyPrimaryGang(c);
 	Assert(gp);
+
+	if (c->sender)
+	{
+		CdbCopySender *sender = c->sender;
+
+		Assert(target_seg >= 0 && target_seg < sender->nsegs);
+
+		if (nbytes <= sender->batch_size)
+		{
+			if (sender->fill[target_seg] == NULL ||
+				sender->fill_len[target_seg] + nbytes > sender->batch_size)
+				cdbCopySenderSubmit(sender, gp, target_seg, true);
+			memcpy(sender->fill[target_seg] + sender->fill_len[target_seg],
+				   buffer, nbytes);
+			sender->fill_len[target_seg] += nbytes;
+			return;
+		}
+
+		/*
+		 * Too big for a batch.  Send it ourselves, once the sender is done
+		 * with everything queued before it.
+		 */
+		cdbCopySenderSubmit(sender, gp, target_seg, false);
+		cdbCopySenderWaitIdle(sender);
+	}
+
 	q = getSegmentDescriptorFromGang(gp, target_seg);
 
 	/* transmit the COPY data */
@@ -449,6 +854,13 @@ cdbCopyEndInternal(CdbCopy *c, char *abort_msg,
 
 	initStringInfo(&io_err_msg);
 
+	/*
+	 * Get the sender thread out of the way first.  When ending normally,
+	 * it sends what is left; an error it ran into is raised here, and
+	 * the caller aborts the COPY in turn.
+	 */
+	cdbCopyStopSender(c, abort_msg == NULL);
+
 	/*
 	 * Don't try to end a copy that already ended with the destruction of the
 	 * writer gang. We know that this has happened if the CdbCopy's
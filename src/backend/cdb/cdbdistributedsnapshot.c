@@ -23,6 +23,9 @@
 #include "utils/snapmgr.h"
 #include "storage/procarray.h"
 
+static int	LocalXidsSearch(TransactionId *xids, int count, TransactionId xid,
+							bool *found);
+
 /*
  * DistributedSnapshotWithLocalMapping_CommittedTest
  *		Is the given XID still-in-progress according to the
@@ -36,7 +39,9 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 												  bool isVacuumCheck)
 {
 	DistributedSnapshot *ds = &dslm->ds;
-	uint32		i;
+	int32		low;
+	int32		high;
+	bool		found;
 	DistributedTransactionId distribXid = InvalidDistributedTransactionId;
 
 	Assert(!IS_QUERY_DISPATCHER());
@@ -67,14 +72,13 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 		if (TransactionIdFollows(localXid, dslm->minCachedLocalXid) &&
 			TransactionIdPrecedes(localXid, dslm->maxCachedLocalXid))
 		{
-			for (i = 0; i < dslm->currentLocalXidsCount; i++)
-			{
-				Assert(dslm->inProgressMappedLocalXids != NULL);
-				Assert(TransactionIdIsValid(dslm->inProgressMappedLocalXids[i]));
+			Assert(dslm->inProgressMappedLocalXids != NULL);
 
-				if (TransactionIdEquals(localXid, dslm->inProgressMappedLocalXids[i]))
-					return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
-			}
+			(void) LocalXidsSearch(dslm->inProgressMappedLocalXids,
+								   dslm->currentLocalXidsCount,
+								   localXid, &found);
+			if (found)
+				return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 		}
 	}
 
@@ -181,45 +185,51 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 		return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 	}
 
-	for (i = 0; i < ds->count; i++)
+	/*
+	 * ds->inProgressXidArray is sorted in ascending order by
+	 * CreateDistributedSnapshot(), so binary search it.
+	 */
+	low = 0;
+	high = ds->count - 1;
+	while (low <= high)
 	{
-		if (distribXid == ds->inProgressXidArray[i])
+		int32		mid = low + (high - low) / 2;
+		DistributedTransactionId midXid = ds->inProgressXidArray[mid];
+
+		if (distribXid < midXid)
+			high = mid - 1;
+		else if (distribXid > midXid)
+			low = mid + 1;
+		else
 		{
 			/*
 			 * Save the relationship to the local xid so we may avoid checking
 			 * the distributed committed log in a subsequent check. We can
-			 * only record local xids till cache size permits.
+			 * only record local xids till cache size permits.  The cache is
+			 * kept sorted, for binary searching it above.
 			 */
 			if (dslm->currentLocalXidsCount < ds->count)
 			{
-				Assert(dslm->inProgressMappedLocalXids != NULL);
-				dslm->inProgressMappedLocalXids[dslm->currentLocalXidsCount++] =
-					localXid;
+				TransactionId *xids = dslm->inProgressMappedLocalXids;
+				int			pos;
 
-				if (!TransactionIdIsValid(dslm->minCachedLocalXid) ||
-					TransactionIdPrecedes(localXid, dslm->minCachedLocalXid))
+				Assert(xids != NULL);
+				pos = LocalXidsSearch(xids, dslm->currentLocalXidsCount,
+									  localXid, &found);
+				if (!found)
 				{
-					dslm->minCachedLocalXid = localXid;
-				}
+					memmove(&xids[pos + 1], &xids[pos],
+							(dslm->currentLocalXidsCount - pos) * sizeof(TransactionId));
+					xids[pos] = localXid;
+					dslm->currentLocalXidsCount++;
 
-				if (!TransactionIdIsValid(dslm->maxCachedLocalXid) ||
-					TransactionIdFollows(localXid, dslm->maxCachedLocalXid))
-				{
-					dslm->maxCachedLocalXid = localXid;
+					dslm->minCachedLocalXid = xids[0];
+					dslm->maxCachedLocalXid = xids[dslm->currentLocalXidsCount - 1];
 				}
 			}
 
 			return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 		}
-
-		/*
-		 * Leverage the fact that ds->inProgressXidArray is sorted in
-		 * ascending order based on distribXid while creating the snapshot in
-		 * CreateDistributedSnapshot(). So, can fail fast once known are
-		 * lower than rest of them.
-		 */
-		if (distribXid < ds->inProgressXidArray[i])
-			break;
 	}
 
 	/*
@@ -228,6 +238,30 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 	return DISTRIBUTEDSNAPSHOT_COMMITTED_VISIBLE;
 }
 
+/*
+ * Binary search the sorted array xids[0 .. count - 1] for 'xid'.  Returns
+ * its position, or if it isn't there, the position to insert it at.
+ */
+static int
+LocalXidsSearch(TransactionId *xids, int count, TransactionId xid, bool *found)
+{
+	int			low = 0;
+	int			high = count;
+
+	while (low < high)
+	{
+		int			mid = low + (high - low) / 2;
+
+		if (TransactionIdPrecedes(xids[mid], xid))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	*found = (low < count && TransactionIdEquals(xids[low], xid));
+	return low;
+}
+
 /*
  * Reset all fields except maxCount and the malloc'd pointer for
  * inProgressXidArray.
@@ -52,6 +52,7 @@ bool gp_use_legacy_hashops = false;
 /* local function declarations */
 static int	ispowof2(int numsegs);
 static inline int32 jump_consistent_hash(uint64 key, int32 num_segments);
+static inline uint32 cdbhashdatum(CdbHash *h, int attno, Datum datum);
 
 /*================================================================
  *
@@ -93,6 +94,7 @@ makeCdbHash(int numsegs, int natts, Oid *hashfuncs)
 
 	/* Load hash function info */
 	h->hashfuncs = (FmgrInfo *) palloc(natts * sizeof(FmgrInfo));
+	h->fastfuncs = (CdbHashFastFunc *) palloc(natts * sizeof(CdbHashFastFunc));
 	for (i = 0; i < natts; i++)
 	{
 		Oid			funcid = hashfuncs[i];
@@ -101,6 +103,27 @@ makeCdbHash(int numsegs, int natts, Oid *hashfuncs)
 			is_legacy_hash = true;
 
 		fmgr_info(funcid, &h->hashfuncs[i]);
+
+		/*
+		 * Redistributing on an int or text column is by far the most common
+		 * case, so compute those hashes inline.  The results must be
+		 * identical to what the real hash functions return.
+		 */
+		switch (funcid)
+		{
+			case F_HASHINT4:
+				h->fastfuncs[i] = CDBHASH_FAST_INT4;
+				break;
+			case F_HASHINT8:
+				h->fastfuncs[i] = CDBHASH_FAST_INT8;
+				break;
+			case F_HASHTEXT:
+				h->fastfuncs[i] = CDBHASH_FAST_TEXT;
+				break;
+			default:
+				h->fastfuncs[i] = CDBHASH_FAST_NONE;
+				break;
+		}
 	}
 	h->natts = natts;
 	h->is_legacy_hash = is_legacy_hash;
@@ -148,6 +171,69 @@ makeCdbHashForRelation(Relation rel)
 	return makeCdbHash(policy->numsegments, policy->nattrs, hashfuncs);
 }
 
+/*
+ * Compute the hash of a single non-null datum, using the hash function of
+ * the given attribute.
+ */
+static inline uint32
+cdbhashdatum(CdbHash *h, int attno, Datum datum)
+{
+	FunctionCallInfoData fcinfo;
+	uint32		hkey;
+
+	switch (h->fastfuncs[attno - 1])
+	{
+		case CDBHASH_FAST_INT4:
+			/* same as hashint4() */
+			return DatumGetUInt32(hash_uint32(DatumGetInt32(datum)));
+
+		case CDBHASH_FAST_INT8:
+			{
+				/* same as hashint8() */
+				int64		val = DatumGetInt64(datum);
+				uint32		lohalf = (uint32) val;
+				uint32		hihalf = (uint32) (val >> 32);
+
+				lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+
+				return DatumGetUInt32(hash_uint32(lohalf));
+			}
+
+		case CDBHASH_FAST_TEXT:
+			{
+				/* same as hashtext() */
+				text	   *key = DatumGetTextPP(datum);
+
+				hkey = DatumGetUInt32(hash_any((unsigned char *) VARDATA_ANY(key),
+											   VARSIZE_ANY_EXHDR(key)));
+
+				/* Avoid leaking memory for toasted inputs */
+				if ((Pointer) key != DatumGetPointer(datum))
+					pfree(key);
+
+				return hkey;
+			}
+
+		case CDBHASH_FAST_NONE:
+			break;
+	}
+
+	InitFunctionCallInfoData(fcinfo, &h->hashfuncs[attno - 1], 1,
+							 InvalidOid,
+							 NULL, NULL);
+
+	fcinfo.arg[0] = datum;
+	fcinfo.argnull[0] = false;
+
+	hkey = DatumGetUInt32(FunctionCallInvoke(&fcinfo));
+
+	/* Check for null result, since caller is clearly not expecting one */
+	if (fcinfo.isnull)
+		elog(ERROR, "function %u returned NULL", fcinfo.flinfo->fn_oid);
+
+	return hkey;
+}
+
 /*
  * Initialize CdbHash for hashing the next tuple values.
  */
@@ -180,49 +266,13 @@ cdbhash(CdbHash *h, int attno, Datum datum, bool isnull)
 		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
 
 		if (!isnull)
-		{
-			FunctionCallInfoData fcinfo;
-			uint32		hkey;
-
-			InitFunctionCallInfoData(fcinfo, &h->hashfuncs[attno - 1], 1,
-									 InvalidOid,
-									 NULL, NULL);
-
-			fcinfo.arg[0] = datum;
-			fcinfo.argnull[0] = false;
-
-			hkey = DatumGetUInt32(FunctionCallInvoke(&fcinfo));
-
-			/* Check for null result, since caller is clearly not expecting one */
-			if (fcinfo.isnull)
-				elog(ERROR, "function %u returned NULL", fcinfo.flinfo->fn_oid);
-
-			hashkey ^= hkey;
-		}
+			hashkey ^= cdbhashdatum(h, attno, datum);
 	}
 	else
 	{
 		magic_hash_stash = hashkey;
 		if (!isnull)
-		{
-			FunctionCallInfoData fcinfo;
-			uint32		hkey;
-
-			InitFunctionCallInfoData(fcinfo, &h->hashfuncs[attno - 1], 1,
-									 InvalidOid,
-									 NULL, NULL);
-
-			fcinfo.arg[0] = datum;
-			fcinfo.argnull[0] = false;
-
-			hkey = DatumGetUInt32(FunctionCallInvoke(&fcinfo));
-
-			/* Check for null result, since caller is clearly not expecting one */
-			if (fcinfo.isnull)
-				elog(ERROR, "function %u returned NULL", fcinfo.flinfo->fn_oid);
-
-			hashkey = hkey;
-		}
+			hashkey = cdbhashdatum(h, attno, datum);
 		else
 			hashkey = cdblegacyhash_null();
 		magic_hash_stash = FNV1_32_INIT;
@@ -226,12 +226,11 @@ LocalDistribXactCache_CommittedFind(
 		MemSet(&hash_ctl, 0, sizeof(hash_ctl));
 		hash_ctl.keysize = sizeof(TransactionId);
 		hash_ctl.entrysize = sizeof(LocalDistribXactCacheEntry);
-		hash_ctl.hash = tag_hash;
 		hash_ctl.hcxt = LocalDistribCacheMemCxt;
 		LocalDistribCacheHtab = hash_create("Local-distributed commit cache",
 											25, /* start small and extend */
 											&hash_ctl,
-											HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+											HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
 
 		MemSet(&LocalDistribXactCache, 0, sizeof(LocalDistribXactCache));
 		dlist_init(&LocalDistribXactCache.lruDoublyLinkedHead);
@@ -52,14 +52,9 @@ serializeNode(Node *node, int *size, int *uncompressed_size_out)
 		pszNode = nodeToBinaryStringFast(node, &uncompressed_size);
 		Assert(pszNode != NULL);
 
-		/* If we have been compiled with libzstd, use it to compress it */
-#ifdef HAVE_LIBZSTD
-		sNode = compress_string(pszNode, uncompressed_size, size);
-		pfree(pszNode);
-#else
-		sNode = pszNode;
-		*size = uncompressed_size;
-#endif
+		sNode = compressSerializedNode(pszNode, uncompressed_size, size);
+		if (sNode != pszNode)
+			pfree(pszNode);
 	}
 	END_MEMORY_ACCOUNT();
 
@@ -68,6 +63,24 @@ serializeNode(Node *node, int *size, int *uncompressed_size_out)
 	return sNode;
 }
 
+/*
+ * Compress the output of nodeToBinaryStringFast() into the form that
+ * serializeNode() returns.  Without libzstd, that is the input itself;
+ * otherwise the result is palloc'ed in the current memory context, and the
+ * input is left alone.
+ */
+char *
+compressSerializedNode(char *pszNode, int uncompressed_size, int *size)
+{
+	/* If we have been compiled with libzstd, use it to compress it */
+#ifdef HAVE_LIBZSTD
+	return compress_string(pszNode, uncompressed_size, size);
+#else
+	*size = uncompressed_size;
+	return pszNode;
+#endif
+}
+
 /*
  * This is used on the qExecs to deserialize serialized Plan and Query Trees
  * received from the dispatcher.
@@ -83,6 +83,18 @@ slock_t *shmGxidGenLock;
 
 int	max_tm_gxacts = 100;
 
+/*
+ * The 'Commit Prepared' broadcast that the last commit of this session left
+ * in flight under gp_dtx_async_commit_prepared.  MyTmGxact keeps its gxid
+ * (and includeInCkpt) until finishAsyncCommitPrepared() has collected the
+ * acknowledgements and written the forget record.
+ */
+static bool asyncCommitPreparedPending = false;
+static struct CdbDispatcherState *asyncCommitPreparedDs = NULL;
+static TMGXACT_LOG asyncCommitPreparedLog;
+static List *asyncCommitPreparedSegments = NIL;
+static bool asyncCommitPreparedExitRegistered = false;
+
 
 #define TM_ERRDETAIL (errdetail("gid=%u-%.10u, state=%s", \
 		getDistributedTransactionTimestamp(), getDistributedTransactionId(),\
@@ -115,6 +127,12 @@ static void doPrepareTransaction(void);
 static void doInsertForgetCommitted(void);
 static void doNotifyingOnePhaseCommit(void);
 static void doNotifyingCommitPrepared(void);
+static bool canAsyncCommitPrepared(void);
+static void startAsyncCommitPrepared(void);
+static void AtProcExit_AsyncCommitPrepared(int code, Datum arg);
+static bool checkDtxProtocolResults(char *dtxProtocolCommandStr,
+						struct pg_result **results, int resultCount,
+						ErrorData *qeError, bool raiseError);
 static void doNotifyingAbort(void);
 static void retryAbortPrepared(void);
 static void doQEDistributedExplicitBegin();
@@ -528,6 +546,12 @@ doNotifyingCommitPrepared(void)
 
 	SIMPLE_FAULT_INJECTOR("dtm_broadcast_commit_prepared");
 
+	if (canAsyncCommitPrepared())
+	{
+		startAsyncCommitPrepared();
+		return;
+	}
+
 	/*
 	 * Acquire TwophaseCommitLock in shared mode to block any GPDB restore
 	 * points from being created while commit prepared messages are being
@@ -625,6 +649,233 @@ doNotifyingCommitPrepared(void)
 	LWLockRelease(TwophaseCommitLock);
 }
 
+/*
+ * Can the 'Commit Prepared' acknowledgements of the committing transaction
+ * be collected after the client has been told about the commit?
+ *
+ * Only if the QD itself wrote nothing: the QD's own changes become visible
+ * as soon as its local XID leaves the proc array, which would expose them
+ * before the segments' changes.
+ */
+static bool
+canAsyncCommitPrepared(void)
+{
+	if (!gp_dtx_async_commit_prepared)
+		return false;
+
+	if (TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		return false;
+
+	if (currentGxactWriterGangLost())
+		return false;
+
+	return true;
+}
+
+/*
+ * Send 'Commit Prepared' to the segments and leave the acknowledgements to
+ * finishAsyncCommitPrepared().
+ *
+ * The distributed commit record is already flushed, so the transaction is
+ * committed whatever happens to the broadcast; if we crash before the forget
+ * record, DTX recovery finishes it (see cdbdtxrecovery.c).  Until then the
+ * gxid stays in the proc array, so concurrent distributed snapshots keep
+ * treating the transaction as in progress on every segment alike.
+ */
+static void
+startAsyncCommitPrepared(void)
+{
+	MemoryContext oldcontext = CurrentMemoryContext;
+	ResourceOwner oldowner = CurrentResourceOwner;
+	volatile int savedInterruptHoldoffCount;
+
+	Assert(!asyncCommitPreparedPending);
+	Assert(MyTmGxactLocal->twophaseSegments != NIL);
+
+	dtxFormGID(asyncCommitPreparedLog.gid,
+			   getDistributedTransactionTimestamp(), getDistributedTransactionId());
+	asyncCommitPreparedLog.gxid = getDistributedTransactionId();
+
+	MemoryContextSwitchTo(TopMemoryContext);
+	asyncCommitPreparedSegments = list_copy(MyTmGxactLocal->twophaseSegments);
+	MemoryContextSwitchTo(oldcontext);
+
+	if (!asyncCommitPreparedExitRegistered)
+	{
+		before_shmem_exit(AtProcExit_AsyncCommitPrepared, 0);
+		asyncCommitPreparedExitRegistered = true;
+	}
+
+	/*
+	 * The dispatcher state outlives the transaction, so it must not belong
+	 * to the transaction's resource owner.
+	 */
+	CurrentResourceOwner = NULL;
+
+	savedInterruptHoldoffCount = InterruptHoldoffCount;
+	PG_TRY();
+	{
+		asyncCommitPreparedDs =
+			CdbDispatchDtxProtocolCommandStart(DTX_PROTOCOL_COMMAND_COMMIT_PREPARED,
+											   DtxProtocolCommandToString(DTX_PROTOCOL_COMMAND_COMMIT_PREPARED),
+											   asyncCommitPreparedLog.gid,
+											   asyncCommitPreparedSegments,
+											   NULL, 0);
+	}
+	PG_CATCH();
+	{
+		/*
+		 * restore the previous value, which is reset to 0 in errfinish.
+		 * finishAsyncCommitPrepared() goes straight to the retries.
+		 */
+		MemoryContextSwitchTo(oldcontext);
+		InterruptHoldoffCount = savedInterruptHoldoffCount;
+		asyncCommitPreparedDs = NULL;
+		FlushErrorState();
+	}
+	PG_END_TRY();
+
+	CurrentResourceOwner = oldowner;
+
+	asyncCommitPreparedPending = true;
+
+	ereport(DTM_DEBUG5,
+			(errmsg("the distributed transaction 'Commit Prepared' broadcast was sent, "
+					"acknowledgements are collected later"),
+			TM_ERRDETAIL));
+}
+
+bool
+isAsyncCommitPreparedPending(void)
+{
+	return asyncCommitPreparedPending;
+}
+
+/*
+ * Collect the acknowledgements of the 'Commit Prepared' broadcast left in
+ * flight by startAsyncCommitPrepared(), retrying as doNotifyingCommitPrepared()
+ * does, then write the forget record and end the gxid.
+ *
+ * Called once the client has been answered, and in any case before this
+ * session starts another transaction or exits.
+ */
+void
+finishAsyncCommitPrepared(void)
+{
+	struct CdbDispatcherState *ds;
+	bool		succeeded = false;
+	int			retry = 0;
+	volatile int savedInterruptHoldoffCount;
+	MemoryContext oldcontext = CurrentMemoryContext;
+
+	if (!asyncCommitPreparedPending)
+		return;
+
+	HOLD_INTERRUPTS();
+
+	ds = asyncCommitPreparedDs;
+	asyncCommitPreparedDs = NULL;
+
+	savedInterruptHoldoffCount = InterruptHoldoffCount;
+	if (ds != NULL)
+	{
+		PG_TRY();
+		{
+			struct pg_result **results;
+			int			resultCount = 0;
+			ErrorData  *qeError;
+
+			results = CdbDispatchDtxProtocolCommandFinish(ds, &qeError, &resultCount);
+			succeeded = checkDtxProtocolResults(DtxProtocolCommandToString(DTX_PROTOCOL_COMMAND_COMMIT_PREPARED),
+												results, resultCount, qeError,
+												/* raiseError */ false);
+		}
+		PG_CATCH();
+		{
+			/*
+			 * restore the previous value, which is reset to 0 in errfinish.
+			 */
+			MemoryContextSwitchTo(oldcontext);
+			InterruptHoldoffCount = savedInterruptHoldoffCount;
+			succeeded = false;
+			FlushErrorState();
+		}
+		PG_END_TRY();
+	}
+
+	while (!succeeded && dtx_phase2_retry_count > retry++)
+	{
+		pg_usleep(DTX_PHASE2_SLEEP_TIME_BETWEEN_RETRIES_MSECS * 1000);
+
+		ereport(WARNING,
+				(errmsg("the distributed transaction 'Commit Prepared' broadcast "
+						"failed to one or more segments. Retrying ... try %d", retry),
+				 errdetail("gid=%s", asyncCommitPreparedLog.gid)));
+
+		ResetAllGangs();
+
+		savedInterruptHoldoffCount = InterruptHoldoffCount;
+		PG_TRY();
+		{
+			succeeded = doDispatchDtxProtocolCommand(DTX_PROTOCOL_COMMAND_RETRY_COMMIT_PREPARED,
+													 asyncCommitPreparedLog.gid,
+													 /* raiseError */ true,
+													 asyncCommitPreparedSegments,
+													 NULL, 0);
+		}
+		PG_CATCH();
+		{
+			/*
+			 * restore the previous value, which is reset to 0 in errfinish.
+			 */
+			MemoryContextSwitchTo(oldcontext);
+			InterruptHoldoffCount = savedInterruptHoldoffCount;
+			succeeded = false;
+			FlushErrorState();
+		}
+		PG_END_TRY();
+	}
+
+	if (!succeeded)
+		ereport(PANIC,
+				(errmsg("unable to complete 'Commit Prepared' broadcast"),
+				 errdetail("gid=%s", asyncCommitPreparedLog.gid)));
+
+	/*
+	 * A restore point must not fall between a segment's commit prepared
+	 * record and our forget record, or restoring to it would abort the
+	 * segment's prepared transaction instead of committing it.  Unlike the
+	 * synchronous path we cannot hold TwophaseCommitLock across the
+	 * broadcast, which spans the reply to the client, but holding it over
+	 * the forget record is enough: a restore point taken while the
+	 * broadcast is in flight sees the commit record without the forget
+	 * record, and DTX recovery commits whatever is still prepared.
+	 */
+	LWLockAcquire(TwophaseCommitLock, LW_SHARED);
+	RecordDistributedForgetCommitted(&asyncCommitPreparedLog);
+	LWLockRelease(TwophaseCommitLock);
+
+	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+	ProcArrayEndGxact(MyTmGxact);
+	LWLockRelease(ProcArrayLock);
+
+	list_free(asyncCommitPreparedSegments);
+	asyncCommitPreparedSegments = NIL;
+	asyncCommitPreparedPending = false;
+
+	RESUME_INTERRUPTS();
+}
+
+/*
+ * Don't leave the segments' prepared transactions behind when the session
+ * goes away; nothing else would finish them before the next restart.
+ */
+static void
+AtProcExit_AsyncCommitPrepared(int code, Datum arg)
+{
+	finishAsyncCommitPrepared();
+}
+
 static void
 retryAbortPrepared(void)
 {
@@ -1144,9 +1395,7 @@ doDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 							 char *serializedDtxContextInfo,
 							 int serializedDtxContextInfoLen)
 {
-	int			i,
-				resultCount,
-				numOfFailed = 0;
+	int			resultCount;
 
 	char	   *dtxProtocolCommandStr = 0;
 
@@ -1174,6 +1423,21 @@ doDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 											&qeError, &resultCount, twophaseSegments,
 											serializedDtxContextInfo, serializedDtxContextInfoLen);
 
+	return checkDtxProtocolResults(dtxProtocolCommandStr, results, resultCount,
+								   qeError, raiseError);
+}
+
+/*
+ * Check the results of a DTX protocol command, and free them.
+ */
+static bool
+checkDtxProtocolResults(char *dtxProtocolCommandStr,
+						struct pg_result **results, int resultCount,
+						ErrorData *qeError, bool raiseError)
+{
+	int			i,
+				numOfFailed = 0;
+
 	if (qeError)
 	{
 		if (!raiseError)
@@ -1306,15 +1570,23 @@ dispatchDtxCommand(const char *cmd)
 	return (numOfFailed == 0);
 }
 
-/* reset global transaction context */
+/*
+ * reset global transaction context
+ *
+ * While a 'Commit Prepared' broadcast is in flight the shared part still
+ * describes that transaction; finishAsyncCommitPrepared() resets it.
+ */
 void
 resetGxact(void)
 {
-	Assert(MyTmGxact->gxid == InvalidDistributedTransactionId);
-	MyTmGxact->distribTimeStamp = 0;
-	MyTmGxact->xminDistributedSnapshot = InvalidDistributedTransactionId;
-	MyTmGxact->includeInCkpt = false;
-	MyTmGxact->sessionId = 0;
+	if (!asyncCommitPreparedPending)
+	{
+		Assert(MyTmGxact->gxid == InvalidDistributedTransactionId);
+		MyTmGxact->distribTimeStamp = 0;
+		MyTmGxact->xminDistributedSnapshot = InvalidDistributedTransactionId;
+		MyTmGxact->includeInCkpt = false;
+		MyTmGxact->sessionId = 0;
+	}
 
 	MyTmGxactLocal->explicitBeginRemembered = false;
 	MyTmGxactLocal->writerGangLost = false;
@@ -23,6 +23,7 @@
 #include "postgres.h"
 
 #include <sys/param.h>			/* for MAXHOSTNAMELEN */
+#include <pthread.h>
 #include "access/genam.h"
 #include "catalog/gp_segment_config.h"
 #include "nodes/makefuncs.h"
@@ -1720,3 +1721,49 @@ IsOnConflictUpdate(PlannedStmt *ps)
 
 	return ((ModifyTable *)plan)->onConflictAction == ONCONFLICT_UPDATE;
 }
+
+/*
+ * Set up the signal mask for a thread the backend is about to start: block
+ * the signals the backend handles, so that they are delivered to the main
+ * thread, and return the old mask for gp_reset_thread_sigmasks().
+ */
+void
+gp_set_thread_sigmasks(sigset_t *old_sigs)
+{
+#ifndef WIN32
+	sigset_t sigs;
+	int		 err;
+
+	sigemptyset(&sigs);
+
+	/* make our thread ignore these signals (which should allow that
+	 * they be delivered to the main thread) */
+	sigaddset(&sigs, SIGHUP);
+	sigaddset(&sigs, SIGINT);
+	sigaddset(&sigs, SIGTERM);
+	sigaddset(&sigs, SIGQUIT);
+	sigaddset(&sigs, SIGALRM);
+	sigaddset(&sigs, SIGUSR1);
+	sigaddset(&sigs, SIGUSR2);
+
+	err = pthread_sigmask(SIG_BLOCK, &sigs, old_sigs);
+	if (err != 0)
+		elog(ERROR, "Failed to get pthread signal masks with return value: %d", err);
+#else
+	(void) old_sigs;
+#endif
+}
+
+void
+gp_reset_thread_sigmasks(sigset_t *sigs)
+{
+#ifndef WIN32
+	int err;
+
+	err = pthread_sigmask(SIG_SETMASK, sigs, NULL);
+	if (err != 0)
+		elog(ERROR, "Failed to reset pthread signal masks with return value: %d", err);
+#else
+	(void) sigs;
+#endif
+}
@@ -183,6 +183,11 @@ int			Gp_interconnect_fc_method = INTERCONNECT_FC_METHOD_LOSS;
 int			Gp_interconnect_transmit_timeout = 3600;
 int			Gp_interconnect_min_retries_before_timeout = 100;
 int			Gp_interconnect_debug_retry_interval = 10;
+int			Gp_interconnect_tuple_batch_size = 0;
+int			Gp_interconnect_compression = INTERCONNECT_COMPRESSION_NONE;
+int			Gp_interconnect_rx_threads = 1;
+int			Gp_interconnect_mmsg_batch_size = 1;
+bool		Gp_interconnect_local_transport = false;
 
 int			interconnect_setup_timeout = 7200;
 
@@ -235,7 +240,10 @@ double		gp_selectivity_damping_factor = 1;
 bool		gp_selectivity_damping_sigsort = true;
 
 int			gp_hashjoin_tuples_per_bucket = 5;
+int			gp_hashjoin_build_threads = 1;
 int			gp_hashagg_groups_per_bucket = 5;
+bool		gp_hashagg_open_addressing = false;
+bool		gp_hashjoin_bloomfilter = false;
 
 /* Analyzing aid */
 int			gp_motion_slice_noop = 0;
@@ -290,6 +298,9 @@ bool		gp_enable_fast_sri = true;
 /* Enable single-mirror pair dispatch. */
 bool		gp_enable_direct_dispatch = true;
 
+/* Cache dispatched plans. */
+bool		gp_enable_dispatch_plan_cache = false;
+
 /* Force core dump on memory context error */
 bool		coredump_on_memerror = false;
 
@@ -301,6 +301,9 @@ cdbdisp_makeDispatcherState(bool isExtendedQuery)
 #endif
 	handle->dispatcherState->allocatedGangs = NIL;
 	handle->dispatcherState->largestGangSize = 0;
+	handle->dispatcherState->planHandle = 0;
+	handle->dispatcherState->planlessQueryText = NULL;
+	handle->dispatcherState->planlessQueryTextLen = 0;
 
 	return handle->dispatcherState;
 }
@@ -503,11 +506,7 @@ AtAbort_DispatcherState(void)
 	if (Gp_role != GP_ROLE_DISPATCH)
 		return;
 
-	if (CurrentGangCreating != NULL)
-	{
-		RecycleGang(CurrentGangCreating, true);
-		CurrentGangCreating = NULL;
-	}
+	DestroyGangsCreating();
 
 	/*
 	 * Cleanup all outbound dispatcher states belong to
@@ -531,11 +530,7 @@ AtSubAbort_DispatcherState(void)
 	if (Gp_role != GP_ROLE_DISPATCH)
 		return;
 
-	if (CurrentGangCreating != NULL)
-	{
-		RecycleGang(CurrentGangCreating, true);
-		CurrentGangCreating = NULL;
-	}
+	DestroyGangsCreating();
 
 	CdbResourceOwnerWalker(CurrentResourceOwner, cdbdisp_cleanupDispatcherHandle);
 }
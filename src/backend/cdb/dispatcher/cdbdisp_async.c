@@ -28,6 +28,7 @@
 #include "tcop/tcopprot.h"
 #include "cdb/cdbdisp.h"
 #include "cdb/cdbdisp_async.h"
+#include "cdb/cdbdisp_plancache.h"
 #include "cdb/cdbdispatchresult.h"
 #include "libpq-fe.h"
 #include "libpq-int.h"
@@ -302,7 +303,15 @@ cdbdisp_dispatchToGang_async(struct CdbDispatcherState *ds,
 		}
 		pParms->dispatchResultPtrArray[pParms->dispatchCount++] = qeResult;
 
-		dispatchCommand(qeResult, pParms->query_text, pParms->query_text_len);
+		/* Leave out the plan if the QE has it cached */
+		if (ds->planHandle != 0 && cdbdisp_qeHasPlan(segdbDesc, ds->planHandle))
+			dispatchCommand(qeResult, ds->planlessQueryText, ds->planlessQueryTextLen);
+		else
+		{
+			dispatchCommand(qeResult, pParms->query_text, pParms->query_text_len);
+			if (ds->planHandle != 0)
+				cdbdisp_qeAddPlan(segdbDesc, ds->planHandle);
+		}
 	}
 }
 
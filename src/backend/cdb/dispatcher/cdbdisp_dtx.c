@@ -75,16 +75,40 @@ CdbDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 							  int serializedDtxContextInfoLen)
 {
 	CdbDispatcherState *ds;
-	CdbDispatchResults *pr;
-	CdbPgResults cdb_pgresults = {NULL, 0};
+
+	ds = CdbDispatchDtxProtocolCommandStart(dtxProtocolCommand,
+											dtxProtocolCommandLoggingStr,
+											gid,
+											twophaseSegments,
+											serializedDtxContextInfo,
+											serializedDtxContextInfoLen);
+
+	return CdbDispatchDtxProtocolCommandFinish(ds, qeError, numresults);
+}
+
+/*
+ * CdbDispatchDtxProtocolCommandStart:
+ * Sends a non-cancelable command to the segment dbs without waiting for
+ * them to answer.
+ *
+ * Returns the dispatcher state, which the caller must hand to
+ * CdbDispatchDtxProtocolCommandFinish() before dispatching anything else.
+ */
+CdbDispatcherState *
+CdbDispatchDtxProtocolCommandStart(DtxProtocolCommand dtxProtocolCommand,
+								   char *dtxProtocolCommandLoggingStr,
+								   char *gid,
+								   List *twophaseSegments,
+								   char *serializedDtxContextInfo,
+								   int serializedDtxContextInfoLen)
+{
+	CdbDispatcherState *ds;
 
 	DispatchCommandDtxProtocolParms dtxProtocolParms;
 	Gang	   *primaryGang;
 	char	   *queryText = NULL;
 	int			queryTextLen = 0;
 
-	*qeError = NULL;
-
 	MemSet(&dtxProtocolParms, 0, sizeof(dtxProtocolParms));
 	dtxProtocolParms.dtxProtocolCommand = dtxProtocolCommand;
 	dtxProtocolParms.dtxProtocolCommandLoggingStr = dtxProtocolCommandLoggingStr;
@@ -111,6 +135,26 @@ CdbDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 	cdbdisp_dispatchToGang(ds, primaryGang, -1);
 	addToGxactTwophaseSegments(primaryGang);
 
+	return ds;
+}
+
+/*
+ * CdbDispatchDtxProtocolCommandFinish:
+ * Waits for the segment dbs to answer a command sent by
+ * CdbDispatchDtxProtocolCommandStart(), and destroys the dispatcher state.
+ *
+ * The results are returned as for CdbDispatchDtxProtocolCommand().
+ */
+struct pg_result **
+CdbDispatchDtxProtocolCommandFinish(CdbDispatcherState *ds,
+									ErrorData **qeError,
+									int *numresults)
+{
+	CdbDispatchResults *pr;
+	CdbPgResults cdb_pgresults = {NULL, 0};
+
+	*qeError = NULL;
+
 	cdbdisp_waitDispatchFinish(ds);
 
 	cdbdisp_checkDispatchResult(ds, DISPATCH_WAIT_NONE);
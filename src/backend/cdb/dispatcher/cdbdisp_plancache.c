@@ -0,0 +1,285 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbdisp_plancache.c
+ *	  Caches of dispatched plans, on the QD and on the QEs.
+ *
+ * With gp_enable_dispatch_plan_cache on, the QD remembers the plans it has
+ * recently dispatched, along with their compressed form, so that a query
+ * that is run again with the same plan doesn't compress it again.  Each
+ * cached plan has a handle, which is sent to the QEs along with the plan.
+ * A QE keeps the last QE_PLAN_CACHE_SLOTS plans that came with a handle,
+ * and when the QD knows that a QE has the plan, it sends only the handle.
+ *
+ * The QD cache is looked up by the serialized plan itself, not by the
+ * CachedPlan it came from: the QD fills in parts of the plan for each
+ * execution (memory for each operator, AO segment files, values of stable
+ * functions), so the same CachedPlan doesn't always dispatch the same plan.
+ *
+ * The QD doesn't ask a QE what it has cached.  Instead, the QE caches plans
+ * in a ring in the order they arrive, and the QD keeps the same ring of
+ * handles for each QE connection in its SegmentDatabaseDescriptor.
+ *
+ * The QE also keeps each cached plan deserialized, after the first time it
+ * is executed, so that a plan that is sent only as a handle (with just the
+ * parameters, slice table and snapshot that come in every dispatch) doesn't
+ * have to be decompressed and read back into a PlannedStmt again.  The
+ * executor doesn't scribble on the plan tree, as the QD also relies on for
+ * its own cached plans; exec_mpp_query() copies what it does change.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/dispatcher/cdbdisp_plancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "libpq-fe.h"
+#include "cdb/cdbconn.h"
+#include "cdb/cdbdisp_plancache.h"
+#include "cdb/cdbsrlz.h"
+#include "nodes/plannodes.h"
+#include "utils/memutils.h"
+
+/* Number of plans the QD keeps. */
+#define PLAN_DISPATCH_CACHE_SIZE	32
+
+typedef struct PlanDispatchCacheEntry
+{
+	int32		planHandle;		/* 0 if the entry is unused */
+	uint32		hashval;		/* hash of splan */
+	char	   *splan;			/* serialized plan, uncompressed */
+	int			splan_len;
+	char	   *cplan;			/* the same, as dispatched */
+	int			cplan_len;
+	uint64		lastUsed;
+} PlanDispatchCacheEntry;
+
+static PlanDispatchCacheEntry planDispatchCache[PLAN_DISPATCH_CACHE_SIZE];
+static uint64 planDispatchCacheClock = 0;
+static int32 nextPlanHandle = 1;
+static MemoryContext PlanDispatchCacheContext = NULL;
+
+typedef struct QEPlanCacheEntry
+{
+	int32		planHandle;		/* 0 if the entry is unused */
+	char	   *splan;			/* serialized plan, as dispatched */
+	int			splan_len;
+	PlannedStmt *plan;			/* deserialized plan, or NULL if not yet */
+	MemoryContext plancxt;		/* holds 'plan' */
+} QEPlanCacheEntry;
+
+static QEPlanCacheEntry qePlanCache[QE_PLAN_CACHE_SLOTS];
+static int	qePlanCacheNextSlot = 0;
+static MemoryContext QEPlanCacheContext = NULL;
+
+/*
+ * Look up a plan in the QD's cache, adding it if it is not there yet.
+ *
+ * 'splan' is the plan as serialized by nodeToBinaryStringFast().  Returns
+ * the plan's handle, and the compressed plan to dispatch in *cplan_p and
+ * *cplan_len_p; that stays valid until the next call.  Returns 0 if the
+ * plan is too large to cache, leaving the compression to the caller.
+ */
+int32
+PlanDispatchCacheLookup(char *splan, int splan_len,
+						const char **cplan_p, int *cplan_len_p)
+{
+	PlanDispatchCacheEntry *victim = NULL;
+	PlanDispatchCacheEntry *entry;
+	MemoryContext oldcontext;
+	uint32		hashval;
+	int			i;
+
+	if (splan_len > PLAN_CACHE_MAX_PLAN_SIZE)
+		return 0;
+
+	hashval = DatumGetUInt32(hash_any((const unsigned char *) splan, splan_len));
+
+	for (i = 0; i < PLAN_DISPATCH_CACHE_SIZE; i++)
+	{
+		entry = &planDispatchCache[i];
+
+		if (entry->planHandle != 0 &&
+			entry->hashval == hashval &&
+			entry->splan_len == splan_len &&
+			memcmp(entry->splan, splan, splan_len) == 0)
+		{
+			entry->lastUsed = ++planDispatchCacheClock;
+			*cplan_p = entry->cplan;
+			*cplan_len_p = entry->cplan_len;
+			return entry->planHandle;
+		}
+
+		/* unused entries have lastUsed 0, so they go first */
+		if (victim == NULL || entry->lastUsed < victim->lastUsed)
+			victim = entry;
+	}
+
+	/* Not cached yet.  Compress it into the least recently used entry. */
+	if (PlanDispatchCacheContext == NULL)
+		PlanDispatchCacheContext = AllocSetContextCreate(TopMemoryContext,
+														 "Plan dispatch cache",
+														 ALLOCSET_DEFAULT_MINSIZE,
+														 ALLOCSET_DEFAULT_INITSIZE,
+														 ALLOCSET_DEFAULT_MAXSIZE);
+
+	if (victim->planHandle != 0)
+	{
+		victim->planHandle = 0;
+		victim->lastUsed = 0;
+		if (victim->cplan != victim->splan)
+			pfree(victim->cplan);
+		pfree(victim->splan);
+	}
+
+	oldcontext = MemoryContextSwitchTo(PlanDispatchCacheContext);
+	victim->splan = palloc(splan_len);
+	memcpy(victim->splan, splan, splan_len);
+	victim->splan_len = splan_len;
+	victim->cplan = compressSerializedNode(victim->splan, splan_len,
+										   &victim->cplan_len);
+	MemoryContextSwitchTo(oldcontext);
+
+	victim->hashval = hashval;
+	victim->lastUsed = ++planDispatchCacheClock;
+	victim->planHandle = nextPlanHandle++;
+	if (nextPlanHandle <= 0)
+		nextPlanHandle = 1;
+
+	*cplan_p = victim->cplan;
+	*cplan_len_p = victim->cplan_len;
+	return victim->planHandle;
+}
+
+/*
+ * Does the QE behind 'segdbDesc' have the plan cached?
+ */
+bool
+cdbdisp_qeHasPlan(SegmentDatabaseDescriptor *segdbDesc, int32 planHandle)
+{
+	int			i;
+
+	Assert(planHandle != 0);
+
+	for (i = 0; i < QE_PLAN_CACHE_SLOTS; i++)
+	{
+		if (segdbDesc->planHandles[i] == planHandle)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Note that a plan with a handle has been sent to the QE behind 'segdbDesc',
+ * which will cache it in place of the oldest one, like QEPlanCacheAdd().
+ */
+void
+cdbdisp_qeAddPlan(SegmentDatabaseDescriptor *segdbDesc, int32 planHandle)
+{
+	Assert(planHandle != 0);
+
+	segdbDesc->planHandles[segdbDesc->nextPlanHandleSlot] = planHandle;
+	segdbDesc->nextPlanHandleSlot =
+		(segdbDesc->nextPlanHandleSlot + 1) % QE_PLAN_CACHE_SLOTS;
+}
+
+/*
+ * Cache a plan that the QD sent with a handle, in place of the oldest one.
+ */
+void
+QEPlanCacheAdd(int32 planHandle, const char *splan, int splan_len)
+{
+	QEPlanCacheEntry *entry = &qePlanCache[qePlanCacheNextSlot];
+
+	Assert(planHandle != 0);
+
+	qePlanCacheNextSlot = (qePlanCacheNextSlot + 1) % QE_PLAN_CACHE_SLOTS;
+
+	if (QEPlanCacheContext == NULL)
+		QEPlanCacheContext = AllocSetContextCreate(TopMemoryContext,
+												   "QE plan cache",
+												   ALLOCSET_DEFAULT_MINSIZE,
+												   ALLOCSET_DEFAULT_INITSIZE,
+												   ALLOCSET_DEFAULT_MAXSIZE);
+
+	if (entry->splan != NULL)
+	{
+		pfree(entry->splan);
+		entry->splan = NULL;
+	}
+	if (entry->plancxt != NULL)
+	{
+		MemoryContextDelete(entry->plancxt);
+		entry->plancxt = NULL;
+	}
+	entry->plan = NULL;
+	entry->planHandle = 0;
+
+	entry->plancxt = AllocSetContextCreate(QEPlanCacheContext,
+										   "QE cached plan",
+										   ALLOCSET_SMALL_MINSIZE,
+										   ALLOCSET_SMALL_INITSIZE,
+										   ALLOCSET_DEFAULT_MAXSIZE);
+	entry->splan = MemoryContextAlloc(QEPlanCacheContext, splan_len);
+	memcpy(entry->splan, splan, splan_len);
+	entry->splan_len = splan_len;
+	entry->planHandle = planHandle;
+}
+
+/*
+ * Get a plan that the QD sent with a handle, now or earlier.
+ *
+ * The plan is deserialized the first time it is asked for, and kept for the
+ * following executions.  It belongs to the cache, so the caller must not
+ * modify it.
+ */
+PlannedStmt *
+QEPlanCacheGetPlan(int32 planHandle)
+{
+	QEPlanCacheEntry *entry = NULL;
+	MemoryContext oldcontext;
+	PlannedStmt *plan;
+	int			i;
+
+	Assert(planHandle != 0);
+
+	for (i = 0; i < QE_PLAN_CACHE_SLOTS; i++)
+	{
+		if (qePlanCache[i].planHandle == planHandle)
+		{
+			entry = &qePlanCache[i];
+			break;
+		}
+	}
+
+	if (entry == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("plan %d is not in the QE plan cache", planHandle)));
+
+	if (entry->plan != NULL)
+		return entry->plan;
+
+	/* Clean up after an earlier attempt that failed, if any. */
+	MemoryContextReset(entry->plancxt);
+
+	oldcontext = MemoryContextSwitchTo(entry->plancxt);
+	plan = (PlannedStmt *) deserializeNode(entry->splan, entry->splan_len);
+	MemoryContextSwitchTo(oldcontext);
+
+	if (!plan || !IsA(plan, PlannedStmt))
+		elog(ERROR, "MPPEXEC: receive invalid planned statement");
+
+	/* The serialized form is no longer needed. */
+	pfree(entry->splan);
+	entry->splan = NULL;
+	entry->splan_len = 0;
+	entry->plan = plan;
+
+	return plan;
+}
@@ -42,6 +42,7 @@
 #include "cdb/cdbdisp.h"
 #include "cdb/cdbdisp_query.h"
 #include "cdb/cdbdisp_dtx.h"	/* for qdSerializeDtxContextInfo() */
+#include "cdb/cdbdisp_plancache.h"
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbcopy.h"
 #include "executor/execUtils.h"
@@ -75,6 +76,7 @@ typedef struct DispatchCommandQueryParms
 	int			serializedQuerytreelen;
 	char	   *serializedPlantree;
 	int			serializedPlantreelen;
+	int32		planHandle;		/* handle of the plan, if it is cached */
 	char	   *serializedQueryDispatchDesc;
 	int			serializedQueryDispatchDesclen;
 	char	   *serializedParams;
@@ -572,6 +574,7 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 				sddesc_len,
 				sparams_len,
 				rootIdx;
+	int32		planHandle = 0;
 
 	rootIdx = RootSliceIndex(queryDesc->estate);
 
@@ -581,8 +584,35 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	 * serialized plan tree. Note that we're called for a single slice tree
 	 * (corresponding to an initPlan or the main plan), so the parameters are
 	 * fixed and we can include them in the prefix.
+	 *
+	 * If the same plan was dispatched recently, take the compressed plan
+	 * from the cache, along with the handle that lets us skip sending it
+	 * to the QEs that have it.
 	 */
-	splan = serializeNode((Node *) queryDesc->plannedstmt, &splan_len, &splan_len_uncompressed);
+	if (gp_enable_dispatch_plan_cache)
+	{
+		char	   *uplan;
+		const char *cplan;
+
+		uplan = nodeToBinaryStringFast((Node *) queryDesc->plannedstmt,
+									   &splan_len_uncompressed);
+		planHandle = PlanDispatchCacheLookup(uplan, splan_len_uncompressed,
+											 &cplan, &splan_len);
+		if (planHandle != 0)
+		{
+			splan = (char *) cplan;
+			pfree(uplan);
+		}
+		else
+		{
+			splan = compressSerializedNode(uplan, splan_len_uncompressed,
+										   &splan_len);
+			if (splan != uplan)
+				pfree(uplan);
+		}
+	}
+	else
+		splan = serializeNode((Node *) queryDesc->plannedstmt, &splan_len, &splan_len_uncompressed);
 
 	uint64		plan_size_in_kb = ((uint64) splan_len_uncompressed) / (uint64) 1024;
 
@@ -618,6 +648,7 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	pQueryParms->serializedQuerytreelen = 0;
 	pQueryParms->serializedPlantree = splan;
 	pQueryParms->serializedPlantreelen = splan_len;
+	pQueryParms->planHandle = planHandle;
 	pQueryParms->serializedParams = sparams;
 	pQueryParms->serializedParamslen = sparams_len;
 	pQueryParms->serializedQueryDispatchDesc = sddesc;
@@ -816,6 +847,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	int			querytree_len = pQueryParms->serializedQuerytreelen;
 	const char *plantree = pQueryParms->serializedPlantree;
 	int			plantree_len = pQueryParms->serializedPlantreelen;
+	int32		plan_handle = pQueryParms->planHandle;
 	const char *params = pQueryParms->serializedParams;
 	int			params_len = pQueryParms->serializedParamslen;
 	const char *sddesc = pQueryParms->serializedQueryDispatchDesc;
@@ -850,7 +882,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	 * Here we only need to determine the truncated size, the actual work is
 	 * done later when copying it to the result buffer.
 	 */
-	if (querytree || plantree)
+	if (querytree || plantree || plan_handle != 0)
 		command_len = strnlen(command, QUERY_STRING_TRUNCATE_SIZE - 1) + 1;
 	else
 		command_len = strlen(command) + 1;
@@ -869,6 +901,7 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 		sizeof(command_len) +
 		sizeof(querytree_len) +
 		sizeof(plantree_len) +
+		sizeof(plan_handle) +
 		sizeof(params_len) +
 		sizeof(sddesc_len) +
 		sizeof(dtxContextInfo_len) +
@@ -934,6 +967,10 @@ buildGpQueryString(DispatchCommandQueryParms *pQueryParms,
 	memcpy(pos, &tmp, sizeof(plantree_len));
 	pos += sizeof(plantree_len);
 
+	tmp = htonl(plan_handle);
+	memcpy(pos, &tmp, sizeof(plan_handle));
+	pos += sizeof(plan_handle);
+
 	tmp = htonl(params_len);
 	memcpy(pos, &tmp, sizeof(params_len));
 	pos += sizeof(params_len);
@@ -1068,6 +1105,21 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	pQueryParms = cdbdisp_buildPlanQueryParms(queryDesc, planRequiresTxn);
 	queryText = buildGpQueryString(pQueryParms, &queryTextLength);
 
+	/*
+	 * If the plan has a handle, QEs that have it cached get a query text
+	 * with just the handle.
+	 */
+	if (pQueryParms->planHandle != 0)
+	{
+		DispatchCommandQueryParms planlessParms = *pQueryParms;
+
+		planlessParms.serializedPlantree = NULL;
+		planlessParms.serializedPlantreelen = 0;
+		ds->planHandle = pQueryParms->planHandle;
+		ds->planlessQueryText = buildGpQueryString(&planlessParms,
+												   &ds->planlessQueryTextLen);
+	}
+
 	/*
 	 * Allocate result array with enough slots for QEs of primary gangs.
 	 */
@@ -66,9 +66,9 @@ int			host_segments = 0;
  */
 int			ic_htab_size = 0;
 
-Gang      *CurrentGangCreating = NULL;
+List      *CurrentGangsCreating = NIL;
 
-CreateGangFunc pCreateGangFunc = cdbgang_createGang_async;
+CreateGangsFunc pCreateGangsFunc = cdbgang_createGangs_async;
 
 static bool NeedResetSession = false;
 static Oid	OldTempNamespace = InvalidOid;
@@ -86,9 +86,30 @@ static void resetSessionForPrimaryGangLoss(void);
 Gang *
 cdbgang_createGang(List *segments, SegmentType segmentType)
 {
-	Assert(pCreateGangFunc);
+	Gang	   *newGang;
 
-	return pCreateGangFunc(segments, segmentType);
+	cdbgang_createGangs(1, &segments, &segmentType, &newGang);
+
+	return newGang;
+}
+
+/*
+ * cdbgang_createGangs:
+ *
+ * Creates 'ngangs' new gangs, one for each list of segments in 'segments',
+ * and returns them in 'gangs'.  The QEs of all the gangs are connected in
+ * parallel.
+ *
+ * call this function in GangContext memory context.
+ * elog ERROR or return non-NULL gangs.
+ */
+void
+cdbgang_createGangs(int ngangs, List **segments, SegmentType *segmentTypes,
+					Gang **gangs)
+{
+	Assert(pCreateGangsFunc);
+
+	pCreateGangsFunc(ngangs, segments, segmentTypes, gangs);
 }
 
 /*
@@ -99,10 +120,35 @@ cdbgang_createGang(List *segments, SegmentType segmentType)
 Gang *
 AllocateGang(CdbDispatcherState *ds, GangType type, List *segments)
 {
-	MemoryContext	oldContext;
-	SegmentType 	segmentType;
 	Gang			*newGang = NULL;
+
+	if (segments == NIL)
+		return NULL;
+
+	AllocateGangs(ds, 1, &type, &segments, &newGang);
+
+	return newGang;
+}
+
+/*
+ * Creates 'ngangs' new gangs at once, one of type types[i] on segments[i]
+ * for each i, and returns them in 'gangs'.  None of the segment lists may be
+ * empty.
+ *
+ * When a query needs several gangs, allocating them together saves waiting
+ * for the QEs that have to be started for one gang before starting those
+ * for the next.
+ *
+ * elog ERROR or return non-NULL gangs.
+ */
+void
+AllocateGangs(CdbDispatcherState *ds, int ngangs, GangType *types,
+			  List **segments, Gang **gangs)
+{
+	MemoryContext	oldContext;
+	SegmentType 	*segmentTypes;
 	int				i;
+	int				j;
 
 	ELOG_DISPATCHER_DEBUG("AllocateGang begin.");
 
@@ -111,47 +157,56 @@ AllocateGang(CdbDispatcherState *ds, GangType type, List *segments)
 		elog(FATAL, "dispatch process called with role %d", Gp_role);
 	}
 
-	if (segments == NIL)
-		return NULL;
-
 	Assert(DispatcherContext);
 	oldContext = MemoryContextSwitchTo(DispatcherContext);
 
-	if (type == GANGTYPE_PRIMARY_WRITER)
-		segmentType = SEGMENTTYPE_EXPLICT_WRITER;
-	/* for extended query like cursor, must specify a reader */
-	else if (ds->isExtendedQuery)
-		segmentType = SEGMENTTYPE_EXPLICT_READER;
-	else
-		segmentType = SEGMENTTYPE_ANY;
+	segmentTypes = palloc(sizeof(SegmentType) * ngangs);
+	for (i = 0; i < ngangs; i++)
+	{
+		Assert(segments[i] != NIL);
 
-	newGang = cdbgang_createGang(segments, segmentType);
-	newGang->allocated = true;
-	newGang->type = type;
+		if (types[i] == GANGTYPE_PRIMARY_WRITER)
+			segmentTypes[i] = SEGMENTTYPE_EXPLICT_WRITER;
+		/* for extended query like cursor, must specify a reader */
+		else if (ds->isExtendedQuery)
+			segmentTypes[i] = SEGMENTTYPE_EXPLICT_READER;
+		else
+			segmentTypes[i] = SEGMENTTYPE_ANY;
+	}
 
-	/*
-	 * Push to the head of the allocated list, later in
-	 * cdbdisp_destroyDispatcherState() we should recycle them from the head to
-	 * restore the original order of the idle gangs.
-	 */
-	ds->allocatedGangs = lcons(newGang, ds->allocatedGangs);
-	ds->largestGangSize = Max(ds->largestGangSize, newGang->size);
+	cdbgang_createGangs(ngangs, segments, segmentTypes, gangs);
 
-	ELOG_DISPATCHER_DEBUG("AllocateGang end.");
-
-	if (type == GANGTYPE_PRIMARY_WRITER)
+	for (i = 0; i < ngangs; i++)
 	{
+		Gang	   *newGang = gangs[i];
+
+		newGang->allocated = true;
+		newGang->type = types[i];
+
 		/*
-		 * set "whoami" for utility statement. non-utility statement will
-		 * overwrite it in function getCdbProcessList.
+		 * Push to the head of the allocated list, later in
+		 * cdbdisp_destroyDispatcherState() we should recycle them from the
+		 * head to restore the original order of the idle gangs.
 		 */
-		for (i = 0; i < newGang->size; i++)
-			cdbconn_setQEIdentifier(newGang->db_descriptors[i], -1);
+		ds->allocatedGangs = lcons(newGang, ds->allocatedGangs);
+		ds->largestGangSize = Max(ds->largestGangSize, newGang->size);
+
+		if (types[i] == GANGTYPE_PRIMARY_WRITER)
+		{
+			/*
+			 * set "whoami" for utility statement. non-utility statement will
+			 * overwrite it in function getCdbProcessList.
+			 */
+			for (j = 0; j < newGang->size; j++)
+				cdbconn_setQEIdentifier(newGang->db_descriptors[j], -1);
+		}
 	}
 
-	MemoryContextSwitchTo(oldContext);
+	pfree(segmentTypes);
 
-	return newGang;
+	ELOG_DISPATCHER_DEBUG("AllocateGang end.");
+
+	MemoryContextSwitchTo(oldContext);
 }
 
 /*
@@ -615,12 +670,8 @@ DisconnectAndDestroyAllGangs(bool resetSession)
 
 	ELOG_DISPATCHER_DEBUG("DisconnectAndDestroyAllGangs");
 
-    /* Destroy CurrentGangCreating before GangContext is reset */
-    if (CurrentGangCreating != NULL)
-    {
-        RecycleGang(CurrentGangCreating, true);
-        CurrentGangCreating = NULL;
-    }
+    /* Destroy CurrentGangsCreating before GangContext is reset */
+    DestroyGangsCreating();
 
 	/* cleanup all out bound dispatcher state */
 	CdbResourceOwnerWalker(CurrentResourceOwner, cdbdisp_cleanupDispatcherHandle);
@@ -863,6 +914,21 @@ RecycleGang(Gang *gp, bool forceDestroy)
 	}
 }
 
+/*
+ * Destroy the gangs that were being created when an error occurred; the
+ * connections to their QEs may be only partly established.
+ */
+void
+DestroyGangsCreating(void)
+{
+	ListCell   *lc;
+
+	foreach(lc, CurrentGangsCreating)
+		RecycleGang((Gang *) lfirst(lc), true);
+
+	CurrentGangsCreating = NIL;
+}
+
 void
 ResetAllGangs(void)
 {
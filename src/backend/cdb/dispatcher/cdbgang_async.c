@@ -22,6 +22,8 @@
 #include <sys/poll.h>
 #endif
 
+#include "funcapi.h"
+#include "portability/instr_time.h"
 #include "storage/ipc.h"		/* For proc_exit_inprogress  */
 #include "tcop/tcopprot.h"
 #include "libpq-fe.h"
@@ -31,28 +33,157 @@
 #include "cdb/cdbgang_async.h"
 #include "cdb/cdbvars.h"
 #include "miscadmin.h"
+#include "utils/builtins.h"
 
 static int	getPollTimeout(const struct timeval *startTS);
+static void connectSegdbs_async(SegmentDatabaseDescriptor **segdbs, int size);
 
 /*
- * Creates a new gang by logging on a session to each segDB involved.
+ * Gangs created by this session, the QEs it found connected and the ones it
+ * had to connect, and the time spent connecting them.  Reported by
+ * gp_session_gang_stats().
+ */
+static int64 numGangsCreated = 0;
+static int64 numQEsReused = 0;
+static int64 numQEsConnected = 0;
+static double connectTimeMs = 0.0;
+
+Datum		gp_session_gang_stats(PG_FUNCTION_ARGS);
+
+/*
+ * Creates new gangs by logging on a session to each segDB involved.
+ *
+ * The QEs of all the gangs are connected at the same time, so that a query
+ * with several slices waits for one round of QE startups rather than one
+ * for each slice.  New writer QEs are connected before the readers, though,
+ * because a reader looks for the writer of its session on the segment when
+ * it takes its first lock, and gives up if it doesn't find it soon.
  *
  * call this function in GangContext memory context.
- * elog ERROR or return a non-NULL gang.
+ * elog ERROR or fill in 'gangs' with 'ngangs' non-NULL gangs.
+ */
+void
+cdbgang_createGangs_async(int ngangs, List **segments,
+						  SegmentType *segmentTypes, Gang **gangs)
+{
+	SegmentDatabaseDescriptor **writers;
+	SegmentDatabaseDescriptor **readers;
+	int			nwriters = 0;
+	int			nreaders = 0;
+	int			nreused = 0;
+	int			total = 0;
+	instr_time	starttime;
+	instr_time	elapsed;
+	int			i;
+	int			j;
+
+	Assert(CurrentGangsCreating == NIL);
+
+	for (i = 0; i < ngangs; i++)
+	{
+		ELOG_DISPATCHER_DEBUG("createGang size = %d, segment type = %d",
+							  list_length(segments[i]), segmentTypes[i]);
+
+		/*
+		 * allocate and initialize a gang structure, and remember it so that
+		 * it is destroyed if we fail before all the gangs are created.
+		 */
+		gangs[i] = buildGangDefinition(segments[i], segmentTypes[i]);
+		CurrentGangsCreating = lappend(CurrentGangsCreating, gangs[i]);
+		total += gangs[i]->size;
+	}
+
+	writers = palloc(sizeof(SegmentDatabaseDescriptor *) * total);
+	readers = palloc(sizeof(SegmentDatabaseDescriptor *) * total);
+
+	for (i = 0; i < ngangs; i++)
+	{
+		for (j = 0; j < gangs[i]->size; j++)
+		{
+			SegmentDatabaseDescriptor *segdbDesc = gangs[i]->db_descriptors[j];
+
+			/* if it's a cached QE, it needs no connection */
+			if (segdbDesc->conn != NULL && !cdbconn_isBadConnection(segdbDesc))
+				nreused++;
+			else if (segdbDesc->isWriter)
+				writers[nwriters++] = segdbDesc;
+			else
+				readers[nreaders++] = segdbDesc;
+		}
+	}
+
+	INSTR_TIME_SET_CURRENT(starttime);
+
+	if (nwriters > 0)
+		connectSegdbs_async(writers, nwriters);
+	if (nreaders > 0)
+		connectSegdbs_async(readers, nreaders);
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, starttime);
+
+	numGangsCreated += ngangs;
+	numQEsReused += nreused;
+	numQEsConnected += nwriters + nreaders;
+	connectTimeMs += INSTR_TIME_GET_MILLISEC(elapsed);
+
+	elog(((gp_log_gang >= GPVARS_VERBOSITY_VERBOSE) ? LOG : DEBUG1),
+		 "created %d gang(s) of %d QEs: %d reused, %d connected in %.3f ms "
+		 "(this session: " INT64_FORMAT " reused, " INT64_FORMAT " connected)",
+		 ngangs, total, nreused, nwriters + nreaders,
+		 INSTR_TIME_GET_MILLISEC(elapsed),
+		 numQEsReused, numQEsConnected);
+
+	pfree(writers);
+	pfree(readers);
+
+	list_free(CurrentGangsCreating);
+	CurrentGangsCreating = NIL;
+}
+
+/*
+ * gp_session_gang_stats - the gang creation totals of this session
+ *
+ * QEs taken from the session's pool of idle QEs count as reused.
  */
-Gang *
-cdbgang_createGang_async(List *segments, SegmentType segmentType)
+Datum
+gp_session_gang_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[4];
+	bool		nulls[4];
+	HeapTuple	tuple;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	MemSet(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(numGangsCreated);
+	values[1] = Int64GetDatum(numQEsReused);
+	values[2] = Int64GetDatum(numQEsConnected);
+	values[3] = Float8GetDatum(connectTimeMs);
+
+	tuple = heap_form_tuple(tupdesc, values, nulls);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
+/*
+ * Log on a session to each of 'segdbs', all at the same time.
+ *
+ * elog ERROR if any of them cannot be connected.
+ */
+static void
+connectSegdbs_async(SegmentDatabaseDescriptor **segdbs, int size)
 {
 	PostgresPollingStatusType	*pollingStatus = NULL;
 	SegmentDatabaseDescriptor	*segdbDesc = NULL;
 	struct timeval	startTS;
-	Gang	*newGangDefinition;
 	int		create_gang_retry_counter = 0;
 	int		in_recovery_mode_count = 0;
 	int		successful_connections = 0;
 	int		poll_timeout = 0;
 	int		i = 0;
-	int		size = 0;
 	bool	retry = false;
 	int		totalSegs = 0;
 
@@ -62,23 +193,10 @@ cdbgang_createGang_async(List *segments, SegmentType segmentType)
 	 */
 	bool	   *connStatusDone = NULL;
 
-	size = list_length(segments);
-
-	ELOG_DISPATCHER_DEBUG("createGang size = %d, segment type = %d", size, segmentType);
-
-	Assert(CurrentGangCreating == NULL);
-
-	/* If we're in a retry, we may need to reset our initial state, a bit */
-	newGangDefinition = NULL;
-	/* allocate and initialize a gang structure */
-	newGangDefinition = buildGangDefinition(segments, segmentType);
-	CurrentGangCreating = newGangDefinition;
 	totalSegs = getgpsegmentCount();
 	Assert(totalSegs > 0);
 
 create_gang_retry:
-	Assert(newGangDefinition != NULL);
-	Assert(newGangDefinition->size == size);
 	successful_connections = 0;
 	in_recovery_mode_count = 0;
 	retry = false;
@@ -105,7 +223,7 @@ create_gang_retry:
 			 * valid segdb we error out.  Also, if this segdb is invalid, we
 			 * must fail the connection.
 			 */
-			segdbDesc = newGangDefinition->db_descriptors[i];
+			segdbDesc = segdbs[i];
 
 			/* if it's a cached QE, skip */
 			if (segdbDesc->conn != NULL && !cdbconn_isBadConnection(segdbDesc))
@@ -168,7 +286,7 @@ create_gang_retry:
 
 			for (i = 0; i < size; i++)
 			{
-				segdbDesc = newGangDefinition->db_descriptors[i];
+				segdbDesc = segdbs[i];
 
 				/*
 				 * Skip established connections and in-recovery-mode
@@ -257,7 +375,7 @@ create_gang_retry:
 
 				for (i = 0; i < size; i++)
 				{
-					segdbDesc = newGangDefinition->db_descriptors[i];
+					segdbDesc = segdbs[i];
 					if (connStatusDone[i])
 						continue;
 
@@ -297,7 +415,7 @@ create_gang_retry:
 	{
 		FtsNotifyProber();
 		/* FTS shows some segment DBs are down */
-		if (FtsTestSegmentDBIsDown(newGangDefinition->db_descriptors, size))
+		if (FtsTestSegmentDBIsDown(segdbs, size))
 		{
 			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 							errmsg("failed to acquire resources on one or more segments"),
@@ -319,10 +437,6 @@ create_gang_retry:
 
 		goto create_gang_retry;
 	}
-
-	CurrentGangCreating = NULL;
-
-	return newGangDefinition;
 }
 
 static int
@@ -34,6 +34,12 @@
  */
 int			Gp_max_tuple_chunk_size;
 
+/*
+ * Compression works on tuple batches.  If gp_interconnect_compression is set
+ * but batching isn't, batches of this size are used.
+ */
+#define DEFAULT_COMPRESS_BATCH_SIZE		(32 * 1024)
+
 /*
  * STATIC STATE VARS
  *
@@ -67,8 +73,22 @@ static void processIncomingChunks(MotionLayerState *mlStates,
 
 static inline void reconstructTuple(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry, TupleRemapper *remapper);
 
+static SendReturnCode sendTupleBatched(MotionLayerState *mlStates,
+				 ChunkTransportState *transportStates,
+				 MotionNodeEntry *pMNEntry,
+				 int16 motNodeID,
+				 TupleTableSlot *slot,
+				 int16 targetRoute);
+static SendReturnCode flushTupleBatch(MotionLayerState *mlStates,
+				ChunkTransportState *transportStates,
+				MotionNodeEntry *pMNEntry,
+				int16 motNodeID,
+				int16 targetRoute);
+static void compressTupleBatch(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry,
+				   TupleBatchBuffer *batch);
+
 /* Stats-function declarations. */
-static void statSendTuple(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry, TupleChunkList tcList);
+static void statSendTuple(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry, TupleChunkList tcList, int ntuples);
 static void statSendEOS(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry);
 static void statChunksProcessed(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry, int chunksProcessed, int chunkBytes, int tupleBytes);
 static void statNewTupleArrived(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry);
@@ -78,34 +98,30 @@ static void UpdateSentRecordCache(MotionConn *conn);
 
 
 
-/* Helper function to perform the operations necessary to reconstruct a
- * HeapTuple from a list of tuple-chunks, and then update the Motion Layer
- * state appropriately.  This includes storing the tuple, cleaning out the
- * tuple-chunk list, and recording statistics about the newly formed tuple.
+/* Helper function to perform the operations necessary to reconstruct
+ * HeapTuples from a list of tuple-chunks, and then update the Motion Layer
+ * state appropriately.  This includes storing the tuples, cleaning out the
+ * tuple-chunk list, and recording statistics about the newly formed tuples.
+ * The list holds more than one tuple if the sender batches tuples.
  */
 static inline void
 reconstructTuple(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry, TupleRemapper *remapper)
 {
-	GenericTuple tup;
 	SerTupInfo *pSerInfo = &pMNEntry->ser_tup_info;
+	int			ntuples;
 
 	/*
-	 * Convert the list of chunks into a tuple, then stow it away.
+	 * Convert the list of chunks into tuples, and stow them away.
 	 */
-	tup = CvtChunksToTup(&pCSEntry->chunk_list, pSerInfo, remapper);
+	ntuples = CvtChunksToTuples(&pCSEntry->chunk_list, pSerInfo, remapper,
+								pCSEntry->ready_tuples);
 
 	/* We're done with the chunks now. */
 	clearTCList(NULL, &pCSEntry->chunk_list);
 
-	if (!tup)
-		return;
-
-	tup = TRCheckAndRemap(remapper, pSerInfo->tupdesc, tup);
-
-	htfifo_addtuple(pCSEntry->ready_tuples, tup);
-
 	/* Stats */
-	statNewTupleArrived(pMNEntry, pCSEntry);
+	while (ntuples-- > 0)
+		statNewTupleArrived(pMNEntry, pCSEntry);
 }
 
 /*
@@ -243,7 +259,8 @@ createMotionLayerState(int maxMotNodeID)
  * This function is called from:  ExecInitMotion()
  */
 void
-UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserveOrder, TupleDesc tupDesc)
+UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserveOrder, TupleDesc tupDesc,
+					  bool isSender)
 {
 	MemoryContext oldCtxt;
 	MotionNodeEntry *pEntry;
@@ -292,11 +309,41 @@ UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserve
 	pEntry->stat_total_chunks_recvd = 0;
 	pEntry->stat_total_bytes_recvd = 0;
 	pEntry->stat_tuple_bytes_recvd = 0;
+	pEntry->stat_compress_batches = 0;
+	pEntry->stat_compressed_batches = 0;
+	pEntry->stat_compress_raw_bytes = 0;
+	pEntry->stat_compress_sent_bytes = 0;
 
 	pEntry->cleanedUp = false;
 	pEntry->stopped = false;
 	pEntry->moreNetWork = true;
 
+	/*
+	 * Decide once per motion node whether to batch, so that a change of the
+	 * GUC can't reorder tuples that are already buffered.
+	 */
+	pEntry->send_batch_size = Gp_interconnect_tuple_batch_size;
+	pEntry->num_send_batches = 0;
+	pEntry->send_batches = NULL;
+
+	/*
+	 * Same for compression.  The setting is dispatched to all QEs, so the
+	 * receivers of a compressed batch are always set up to decompress it.
+	 */
+	pEntry->send_compress = false;
+	if (Gp_interconnect_compression != INTERCONNECT_COMPRESSION_NONE &&
+		pEntry->tuple_desc->natts > 0)
+	{
+		InitSerTupCompression(&pEntry->ser_tup_info, Gp_interconnect_compression,
+							  isSender);
+		if (isSender)
+		{
+			pEntry->send_compress = true;
+			if (pEntry->send_batch_size == 0)
+				pEntry->send_batch_size = DEFAULT_COMPRESS_BATCH_SIZE;
+		}
+	}
+
 
 	/* All done!  Go back to caller memory-context. */
 	MemoryContextSwitchTo(oldCtxt);
@@ -417,7 +464,7 @@ CheckAndSendRecordCache(MotionLayerState *mlStates,
 	else
 	{
 		/* update stats */
-		statSendTuple(mlStates, pMNEntry, &tcList);
+		statSendTuple(mlStates, pMNEntry, &tcList, 1);
 	}
 
 	/* cleanup */
@@ -456,6 +503,16 @@ SendTuple(MotionLayerState *mlStates,
 	 */
 	pMNEntry = getMotionNodeEntry(mlStates, motNodeID);
 
+	/*
+	 * Batch the tuple up with others going to the same route, if enabled.
+	 * Broadcasts and attribute-less tuples always take the regular path.
+	 */
+	if (pMNEntry->send_batch_size > 0 &&
+		targetRoute != BROADCAST_SEGIDX &&
+		pMNEntry->tuple_desc->natts > 0)
+		return sendTupleBatched(mlStates, transportStates, pMNEntry,
+								motNodeID, slot, targetRoute);
+
 #ifdef AMS_VERBOSE_LOGGING
 	elog(DEBUG5, "Serializing HeapTuple for sending.");
 #endif
@@ -481,7 +538,7 @@ SendTuple(MotionLayerState *mlStates,
 		tcList.serialized_data_length = sent;
 
 		/* update stats */
-		statSendTuple(mlStates, pMNEntry, &tcList);
+		statSendTuple(mlStates, pMNEntry, &tcList, 1);
 
 		return SEND_COMPLETE;
 	}
@@ -506,7 +563,7 @@ SendTuple(MotionLayerState *mlStates,
 	else
 	{
 		/* update stats */
-		statSendTuple(mlStates, pMNEntry, &tcList);
+		statSendTuple(mlStates, pMNEntry, &tcList, 1);
 
 		rc = SEND_COMPLETE;
 	}
@@ -517,6 +574,145 @@ SendTuple(MotionLayerState *mlStates,
 	return rc;
 }
 
+/*
+ * Append a tuple to the batch for 'targetRoute', and send the batch once it
+ * is full.
+ */
+static SendReturnCode
+sendTupleBatched(MotionLayerState *mlStates,
+				 ChunkTransportState *transportStates,
+				 MotionNodeEntry *pMNEntry,
+				 int16 motNodeID,
+				 TupleTableSlot *slot,
+				 int16 targetRoute)
+{
+	TupleBatchBuffer *batch;
+	MemoryContext oldCtxt;
+
+	oldCtxt = MemoryContextSwitchTo(mlStates->motion_layer_mctx);
+
+	if (pMNEntry->send_batches == NULL)
+	{
+		ChunkTransportStateEntry *pEntry = NULL;
+
+		getChunkTransportState(transportStates, motNodeID, &pEntry);
+
+		pMNEntry->num_send_batches = pEntry->numConns;
+		pMNEntry->send_batches = (TupleBatchBuffer *)
+			palloc0(pEntry->numConns * sizeof(TupleBatchBuffer));
+	}
+
+	if (targetRoute < 0 || targetRoute >= pMNEntry->num_send_batches)
+		elog(ERROR, "invalid route %d for motion node %d", targetRoute, motNodeID);
+
+	batch = &pMNEntry->send_batches[targetRoute];
+
+	SerializeTupleIntoBatch(slot, &pMNEntry->ser_tup_info, batch);
+
+	MemoryContextSwitchTo(oldCtxt);
+
+	if (batch->chunks.serialized_data_length >= pMNEntry->send_batch_size ||
+		batch->ntuples >= TUPLE_BATCH_MAX_TUPLES)
+		return flushTupleBatch(mlStates, transportStates, pMNEntry,
+							   motNodeID, targetRoute);
+
+	return SEND_COMPLETE;
+}
+
+/*
+ * Send out the tuples accumulated for 'targetRoute', if any.
+ */
+static SendReturnCode
+flushTupleBatch(MotionLayerState *mlStates,
+				ChunkTransportState *transportStates,
+				MotionNodeEntry *pMNEntry,
+				int16 motNodeID,
+				int16 targetRoute)
+{
+	TupleBatchBuffer *batch = &pMNEntry->send_batches[targetRoute];
+	SendReturnCode rc;
+
+	if (batch->ntuples == 0)
+		return SEND_COMPLETE;
+
+	FinishTupleBatch(batch);
+
+	if (pMNEntry->send_compress)
+		compressTupleBatch(mlStates, pMNEntry, batch);
+
+#ifdef AMS_VERBOSE_LOGGING
+	elog(DEBUG5, "Serialized tuple batch for sending:\n"
+		 "\ttarget-route %d \n"
+		 "\t%d tuples, %d bytes in serial form\n"
+		 "\tbroken into %d chunks",
+		 targetRoute,
+		 batch->ntuples,
+		 batch->chunks.serialized_data_length,
+		 batch->chunks.num_chunks);
+#endif
+
+	if (!SendTupleChunkToAMS(mlStates, transportStates, motNodeID, targetRoute, batch->chunks.p_first))
+	{
+		pMNEntry->stopped = true;
+		rc = STOP_SENDING;
+	}
+	else
+	{
+		/* update stats */
+		statSendTuple(mlStates, pMNEntry, &batch->chunks, batch->ntuples);
+
+		rc = SEND_COMPLETE;
+	}
+
+	/* cleanup */
+	clearTCList(&pMNEntry->ser_tup_info.chunkCache, &batch->chunks);
+	batch->ntuples = 0;
+
+	return rc;
+}
+
+/*
+ * Compress a finished batch, unless its route has been sending data that
+ * doesn't compress.  Each failed attempt doubles the number of batches sent
+ * as is before the next attempt, up to TUPLE_BATCH_MAX_COMPRESS_BACKOFF, and
+ * a successful one resets it.
+ */
+static void
+compressTupleBatch(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry,
+				   TupleBatchBuffer *batch)
+{
+	MemoryContext oldCtxt;
+	uint64		rawlen = batch->chunks.serialized_data_length;
+
+	pMNEntry->stat_compress_batches++;
+	pMNEntry->stat_compress_raw_bytes += rawlen;
+
+	if (batch->compress_skip > 0)
+	{
+		batch->compress_skip--;
+		pMNEntry->stat_compress_sent_bytes += rawlen;
+		return;
+	}
+
+	oldCtxt = MemoryContextSwitchTo(mlStates->motion_layer_mctx);
+
+	if (CompressTupleBatch(&pMNEntry->ser_tup_info, batch))
+	{
+		batch->compress_backoff = 0;
+		pMNEntry->stat_compressed_batches++;
+	}
+	else
+	{
+		batch->compress_backoff = Min(Max(batch->compress_backoff * 2, 1),
+									  TUPLE_BATCH_MAX_COMPRESS_BACKOFF);
+		batch->compress_skip = batch->compress_backoff;
+	}
+
+	MemoryContextSwitchTo(oldCtxt);
+
+	pMNEntry->stat_compress_sent_bytes += batch->chunks.serialized_data_length;
+}
+
 TupleChunkListItem
 get_eos_tuplechunklist(void)
 {
@@ -541,6 +737,22 @@ SendEndOfStream(MotionLayerState *mlStates,
 	 */
 	pMNEntry = getMotionNodeEntry(mlStates, motNodeID);
 
+	/* Tuples still sitting in batches must go out ahead of end-of-stream. */
+	for (int route = 0; route < pMNEntry->num_send_batches; route++)
+	{
+		/*
+		 * flushTupleBatch() marks the motion node stopped if the receivers
+		 * don't want any more tuples; there's no point sending the rest.
+		 * End-of-stream still goes out, as it does after SendTuple() has
+		 * returned STOP_SENDING.
+		 */
+		if (pMNEntry->stopped)
+			break;
+		if (flushTupleBatch(mlStates, transportStates, pMNEntry,
+							motNodeID, route) == STOP_SENDING)
+			break;
+	}
+
 	transportStates->SendEos(transportStates, motNodeID, s_eos_chunk_data);
 
 	/*
@@ -827,6 +1039,26 @@ EndMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool flushCommLa
 	pMNEntry->valid = false;
 }
 
+/*
+ * Report how much compression saved on the batches sent by a motion node.
+ * All counters are zero if the node didn't compress.
+ */
+void
+GetMotionCompressionStats(MotionLayerState *mlStates,
+						  int16 motNodeID,
+						  uint64 *batches,
+						  uint64 *compressedBatches,
+						  uint64 *rawBytes,
+						  uint64 *sentBytes)
+{
+	MotionNodeEntry *pMNEntry = getMotionNodeEntry(mlStates, motNodeID);
+
+	*batches = pMNEntry->stat_compress_batches;
+	*compressedBatches = pMNEntry->stat_compressed_batches;
+	*rawBytes = pMNEntry->stat_compress_raw_bytes;
+	*sentBytes = pMNEntry->stat_compress_sent_bytes;
+}
+
 /*
  * Helper function to get the motion node entry for a given ID.  NULL
  * is returned if the ID is unrecognized.
@@ -1142,7 +1374,7 @@ addChunkToSorter(MotionLayerState *mlStates,
  * SerializeTupleDirect() only fills those fields out.
  */
 static void
-statSendTuple(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry, TupleChunkList tcList)
+statSendTuple(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry, TupleChunkList tcList, int ntuples)
 {
 	int			headerOverhead;
 
@@ -1151,7 +1383,7 @@ statSendTuple(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry, TupleChunkL
 	headerOverhead = TUPLE_CHUNK_HEADER_SIZE * tcList->num_chunks;
 
 	/* per motion-node stats. */
-	pMNEntry->stat_total_sends++;
+	pMNEntry->stat_total_sends += ntuples;
 	pMNEntry->stat_total_chunks_sent += tcList->num_chunks;
 	pMNEntry->stat_total_bytes_sent += tcList->serialized_data_length + headerOverhead;
 	pMNEntry->stat_tuple_bytes_sent += tcList->serialized_data_length;
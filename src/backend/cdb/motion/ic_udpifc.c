@@ -48,6 +48,7 @@
 #include "cdb/cdbvars.h"
 #include "cdb/cdbdisp.h"
 #include "cdb/cdbdispatchresult.h"
+#include "cdb/cdbutil.h"
 #include "cdb/cdbicudpfaultinjection.h"
 
 #include <fcntl.h>
@@ -112,6 +113,24 @@ WSAPoll(
 #undef select
 #endif
 
+/*
+ * sendmmsg()/recvmmsg() are Linux specific; glibc exposes them (together
+ * with MSG_WAITFORONE) under _GNU_SOURCE.
+ */
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define USE_UDP_MMSG
+#endif
+
+/*
+ * The same-host transport binds its sockets in the Linux abstract socket
+ * namespace, which needs no filesystem cleanup.
+ */
+#ifdef __linux__
+#define USE_UDP_LOCAL_TRANSPORT
+#include <ifaddrs.h>
+#include <sys/un.h>
+#endif
+
 #define MAX_TRY (11)
 int
 			timeoutArray[] =
@@ -271,11 +290,6 @@ struct ReceiveControlInfo
 	/* Main thread waiting state. */
 	ThreadWaitingState mainWaitingState;
 
-	/*
-	 * Buffers used to assemble disorder messages at receiver side.
-	 */
-	icpkthdr   *disorderBuffer;
-
 	/* The last interconnect instance id which is torn down. */
 	uint32		lastTornIcId;
 
@@ -309,6 +323,12 @@ static ReceiveControlInfo rx_control_info;
 typedef struct RxBufferPool RxBufferPool;
 struct RxBufferPool
 {
+	/*
+	 * Protects the fields below. It may be taken while holding connection
+	 * locks, but not the other way round.
+	 */
+	pthread_mutex_t lock;
+
 	/* The max number of buffers we can get from this pool. */
 	int			maxCount;
 
@@ -323,9 +343,10 @@ struct RxBufferPool
  * The buffer pool used for keeping data packets.
  *
  * maxCount is set to 1 to make sure there is always a buffer
- * for picking packets from OS buffer.
+ * for picking packets from OS buffer. It is raised at startup to cover
+ * the spare buffers held by the receive slots of every rx thread.
  */
-static RxBufferPool rx_buffer_pool = {1, 0, NULL};
+static RxBufferPool rx_buffer_pool = {PTHREAD_MUTEX_INITIALIZER, 1, 0, NULL};
 
 /*
  * SendBufferPool
@@ -374,6 +395,17 @@ struct SendControlInfo
 	/* slow start threshold */
 	float		ssthresh;
 
+#ifdef USE_UDP_MMSG
+	/*
+	 * Packets queued by sendOnceBatched() and not yet handed to the kernel,
+	 * see flushSendBatch(). All of them go out through mmsgFd.
+	 */
+	struct mmsghdr *mmsgs;
+	struct iovec *mmsgIovs;
+	MotionConn **mmsgConns;
+	int			mmsgCount;
+	int			mmsgFd;
+#endif
 };
 
 /*
@@ -382,6 +414,52 @@ struct SendControlInfo
  */
 static SendControlInfo snd_control_info;
 
+/*
+ * RxThreadInfo
+ *
+ * Per receive thread state. Each rx thread polls its own socket; when there
+ * is more than one thread, the extra sockets are bound to the listener port
+ * with SO_REUSEPORT so that the kernel shards incoming flows across them.
+ * All packets from one sender socket hash to the same thread, so packet
+ * order within a connection is preserved.
+ *
+ * The counters are only updated by the owning thread with a connection
+ * lock held, and read and reset by the main thread holding all of them.
+ */
+typedef struct RxThreadInfo RxThreadInfo;
+struct RxThreadInfo
+{
+	pthread_t	threadHandle;
+
+	/* The socket polled by this thread. */
+	int			fd;
+
+	/* Load statistics. */
+	uint32		recvPktNum;
+	uint64		recvBytes;
+
+	/*
+	 * Receive slots, ic_control_info.mmsgBatchSize of each. Every slot holds
+	 * a spare rx buffer between reads.
+	 */
+	icpkthdr  **pkts;
+	int		   *lens;
+	struct sockaddr_storage *peers;
+	socklen_t  *peerlens;
+#ifdef USE_UDP_MMSG
+	struct mmsghdr *msgs;
+	struct iovec *iovs;
+#endif
+};
+
+/*
+ * The max number of connection locks, see ICGlobalControlInfo. There are
+ * IC_CONN_LOCKS_PER_RX_THREAD per rx thread, to keep collisions between the
+ * connections the threads work on rare.
+ */
+#define IC_MAX_CONN_LOCKS (256)
+#define IC_CONN_LOCKS_PER_RX_THREAD (4)
+
 /*
  * ICGlobalControlInfo
  *
@@ -392,8 +470,15 @@ static SendControlInfo snd_control_info;
 typedef struct ICGlobalControlInfo ICGlobalControlInfo;
 struct ICGlobalControlInfo
 {
-	/* The background thread handle. */
-	pthread_t	threadHandle;
+	/* The background threads, see gp_interconnect_rx_threads. */
+	RxThreadInfo *rxThreads;
+	int			numRxThreads;
+
+	/*
+	 * Max number of packets moved per sendmmsg()/recvmmsg() call, see
+	 * gp_interconnect_mmsg_batch_size. 1 means plain sendto()/recvfrom().
+	 */
+	int			mmsgBatchSize;
 
 	/* Keep the udp socket buffer size used. */
 	uint32		socketSendBufferSize;
@@ -409,17 +494,28 @@ struct ICGlobalControlInfo
 	MemoryContext memContext;
 
 	/*
-	 * Lock and latch for coordination between main thread and
-	 * background thread. It protects the shared data between the two threads
-	 * (the connHtab, rx buffer pool and the mainWaitingState etc.).
+	 * Locks and latch for coordination between main thread and background
+	 * threads.
+	 *
+	 * The connection locks protect the shared data between the threads
+	 * (the connHtab, the mainWaitingState etc.), except for the rx buffer
+	 * pool, which has a lock of its own. Each lock covers the connections
+	 * whose CONN_HASH_VALUE() maps to it, see connLockFor(); an rx thread
+	 * handling a data packet only takes the lock of that packet's
+	 * connection, so that rx threads working on different connections
+	 * don't serialize. Everything else, including adding and removing
+	 * connections and the main thread's waiting for data, takes all of
+	 * them, in order, see lockAllConns(). With a single rx thread there is
+	 * a single lock.
 	 */
-	pthread_mutex_t lock;
+	pthread_mutex_t connLocks[IC_MAX_CONN_LOCKS];
+	int			numConnLocks;
 	Latch		latch;
 
 	/* Am I a sender? */
 	bool		isSender;
 
-	/* Flag showing whether the thread is created. */
+	/* Flag showing whether the threads are created. */
 	bool		threadCreated;
 
 	/* Error number. Actually int but we do not have pg_atomic_int32. */
@@ -427,7 +523,7 @@ struct ICGlobalControlInfo
 
 	/*
 	 * Global connection htab for both sending connections and receiving
-	 * connections. Protected by the lock in this data structure.
+	 * connections. Protected by the connection locks in this data structure.
 	 */
 	ConnHashTable connHtab;
 
@@ -523,6 +619,17 @@ static ICGlobalControlInfo ic_control_info;
 
 #define MAX_SEQS_IN_DISORDER_ACK (4)
 
+/*
+ * A disorder message, see handleDisorderPacket(). It is assembled on the
+ * stack, as several rx threads may be sending one at the same time.
+ */
+typedef struct DisorderAckMsg DisorderAckMsg;
+struct DisorderAckMsg
+{
+	icpkthdr	hdr;
+	uint32		lostSeqs[MAX_SEQS_IN_DISORDER_ACK];
+};
+
 /*
  * UnackQueueRing
  *
@@ -570,6 +677,19 @@ static int	ICSenderSocket = -1;
 static uint16 ICSenderPort = 0;
 static int	ICSenderFamily = 0;
 
+/*
+ * AF_UNIX datagram sockets used to talk to peers on the same host, see
+ * gp_interconnect_local_transport. The listener is polled by its own rx
+ * thread, the sender socket receives acks next to ICSenderSocket. Both are
+ * -1 when the local transport is disabled.
+ */
+static int	ICLocalListenerSocket = -1;
+static int	ICLocalSenderSocket = -1;
+
+/* Addresses of the network interfaces of this host. */
+static struct sockaddr_storage *ICLocalHostAddrs = NULL;
+static int	ICNumLocalHostAddrs = 0;
+
 /*
  * AckSendParam
  *
@@ -659,6 +779,12 @@ static void getSockAddr(struct sockaddr_storage *peer, socklen_t *peer_len, cons
 static void setXmitSocketOptions(int txfd);
 static uint32 setSocketBufferSize(int fd, int type, int expectedSize, int leastSize);
 static void setupUDPListeningSocket(int *listenerSocketFd, uint16 *listenerPort, int *txFamily);
+static int	setupUDPShardSocket(int listenerSocketFd);
+static void setupUDPLocalSockets(uint16 listenerPort);
+static void getLocalSockAddr(struct sockaddr_storage *addr, socklen_t *addr_len, int listenerPort);
+static bool isLocalHostAddr(struct sockaddr_storage *addr);
+static void startRxThreads(void);
+static void joinRxThreads(void);
 static ChunkTransportStateEntry *startOutgoingUDPConnections(ChunkTransportState *transportStates,
 							ExecSlice *sendSlice,
 							int *pOutgoingCount);
@@ -673,7 +799,7 @@ static void destroyConnHashTable(ConnHashTable *ht);
 
 static inline void sendAckWithParam(AckSendParam *param);
 static void sendAck(MotionConn *conn, int32 flags, uint32 seq, uint32 extraSeq);
-static void sendDisorderAck(MotionConn *conn, uint32 seq, uint32 extraSeq, uint32 lostPktCnt);
+static void sendDisorderAck(MotionConn *conn, DisorderAckMsg *msg, uint32 seq, uint32 extraSeq, uint32 lostPktCnt);
 static void sendStatusQueryMessage(MotionConn *conn, int fd, uint32 seq);
 static inline void sendControlMessage(icpkthdr *pkt, int fd, struct sockaddr *addr, socklen_t peerLen);
 
@@ -743,6 +869,8 @@ static inline void addCRC(icpkthdr *pkt);
 static inline bool checkCRC(icpkthdr *pkt);
 static void sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn);
 static void sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn *conn);
+static void sendOnceBatched(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn *conn);
+static void flushSendBatch(void);
 static inline uint64 computeExpirationPeriod(MotionConn *conn, uint32 retry);
 
 static ICBuffer *getSndBuffer(MotionConn *conn);
@@ -760,6 +888,9 @@ static void handleCachedPackets(void);
 
 static uint64 getCurrentTime(void);
 static void initMutex(pthread_mutex_t *mutex);
+static inline pthread_mutex_t *connLockFor(icpkthdr *hdr);
+static void lockAllConns(void);
+static void unlockAllConns(void);
 
 static inline void logPkt(char *prefix, icpkthdr *pkt);
 static void aggregateStatistics(ChunkTransportStateEntry *pEntry);
@@ -1317,6 +1448,271 @@ error:
 	return;
 }
 
+/*
+ * setupUDPShardSocket
+ * 		Create another socket bound to the same address and port as the
+ * 		listener socket, for an additional rx thread.
+ *
+ * Both sockets are put into one SO_REUSEPORT group, so the kernel hashes
+ * every incoming flow to one of them. The option is set on the listener
+ * socket only after it has been bound to an ephemeral port, so that other
+ * processes can never be handed the same port by the kernel.
+ *
+ * Returns -1 if SO_REUSEPORT is not supported on this platform.
+ */
+static int
+setupUDPShardSocket(int listenerSocketFd)
+{
+#ifdef SO_REUSEPORT
+	int			errnoSave;
+	int			fd = -1;
+	int			on = 1;
+	const char *fun;
+	struct sockaddr_storage our_addr;
+	socklen_t	our_addr_len;
+
+	MemSet(&our_addr, 0, sizeof(our_addr));
+	our_addr_len = sizeof(our_addr);
+
+	fun = "getsockname";
+	if (getsockname(listenerSocketFd, (struct sockaddr *) &our_addr, &our_addr_len) < 0)
+		goto error;
+
+	fun = "setsockopt(SO_REUSEPORT)";
+	if (setsockopt(listenerSocketFd, SOL_SOCKET, SO_REUSEPORT, (char *) &on, sizeof(on)) < 0)
+		goto error;
+
+	fun = "socket";
+	fd = socket(our_addr.ss_family, SOCK_DGRAM, 0);
+	if (fd < 0)
+		goto error;
+
+	fun = "setsockopt(SO_REUSEPORT)";
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (char *) &on, sizeof(on)) < 0)
+		goto error;
+
+	fun = "fcntl(O_NONBLOCK)";
+	if (!pg_set_noblock(fd))
+		goto error;
+
+	fun = "bind";
+	if (bind(fd, (struct sockaddr *) &our_addr, our_addr_len) < 0)
+		goto error;
+
+	setXmitSocketOptions(fd);
+
+	return fd;
+
+error:
+	errnoSave = errno;
+	if (fd >= 0)
+		closesocket(fd);
+	errno = errnoSave;
+	ereport(ERROR,
+			(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+			 errmsg("interconnect error: Could not set up udp receive socket for rx thread"),
+			 errdetail("%s: %m", fun)));
+#endif
+
+	return -1;
+}
+
+/*
+ * getLocalSockAddr
+ * 		Build the AF_UNIX address of the same-host listener of the process
+ * 		whose UDP listener port is listenerPort.
+ *
+ * UDP ports are unique on a host, so the port doubles as the name of the
+ * process' local socket.
+ */
+static void
+getLocalSockAddr(struct sockaddr_storage *addr, socklen_t *addr_len, int listenerPort)
+{
+#ifdef USE_UDP_LOCAL_TRANSPORT
+	struct sockaddr_un *un = (struct sockaddr_un *) addr;
+	int			namelen;
+
+	MemSet(addr, 0, sizeof(struct sockaddr_storage));
+	un->sun_family = AF_UNIX;
+
+	/* leading '\0' selects the abstract namespace */
+	namelen = snprintf(un->sun_path + 1, sizeof(un->sun_path) - 1,
+					   "gpdb_interconnect.%d", listenerPort);
+	*addr_len = offsetof(struct sockaddr_un, sun_path) + 1 + namelen;
+#else
+	elog(ERROR, "same-host interconnect transport is not supported on this platform");
+#endif
+}
+
+/*
+ * setupUDPLocalSockets
+ * 		Set up the AF_UNIX sockets used for peers on this host, and remember
+ * 		the addresses of this host to recognize such peers.
+ */
+static void
+setupUDPLocalSockets(uint16 listenerPort)
+{
+#ifdef USE_UDP_LOCAL_TRANSPORT
+	int			errnoSave;
+	const char *fun;
+	struct sockaddr_storage addr;
+	socklen_t	addr_len;
+	struct ifaddrs *ifaddrs = NULL;
+	struct ifaddrs *ifa;
+	int			n;
+
+	fun = "socket";
+	ICLocalListenerSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (ICLocalListenerSocket < 0)
+		goto error;
+
+	fun = "fcntl(O_NONBLOCK)";
+	if (!pg_set_noblock(ICLocalListenerSocket))
+		goto error;
+
+	fun = "bind";
+	getLocalSockAddr(&addr, &addr_len, listenerPort);
+	if (bind(ICLocalListenerSocket, (struct sockaddr *) &addr, addr_len) < 0)
+		goto error;
+	setXmitSocketOptions(ICLocalListenerSocket);
+
+	fun = "socket";
+	ICLocalSenderSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (ICLocalSenderSocket < 0)
+		goto error;
+
+	fun = "fcntl(O_NONBLOCK)";
+	if (!pg_set_noblock(ICLocalSenderSocket))
+		goto error;
+
+	/*
+	 * Binding with just the address family autobinds the socket to a unique
+	 * abstract name, which receivers see as the source of our packets and
+	 * send their acks to.
+	 */
+	fun = "bind";
+	MemSet(&addr, 0, sizeof(addr));
+	addr.ss_family = AF_UNIX;
+	if (bind(ICLocalSenderSocket, (struct sockaddr *) &addr, sizeof(sa_family_t)) < 0)
+		goto error;
+	setXmitSocketOptions(ICLocalSenderSocket);
+
+	fun = "getifaddrs";
+	if (getifaddrs(&ifaddrs) < 0)
+		goto error;
+
+	n = 0;
+	for (ifa = ifaddrs; ifa != NULL; ifa = ifa->ifa_next)
+		n++;
+	ICLocalHostAddrs = palloc0(n * sizeof(struct sockaddr_storage));
+	ICNumLocalHostAddrs = 0;
+	for (ifa = ifaddrs; ifa != NULL; ifa = ifa->ifa_next)
+	{
+		if (ifa->ifa_addr == NULL)
+			continue;
+		if (ifa->ifa_addr->sa_family == AF_INET)
+			memcpy(&ICLocalHostAddrs[ICNumLocalHostAddrs++], ifa->ifa_addr, sizeof(struct sockaddr_in));
+		else if (ifa->ifa_addr->sa_family == AF_INET6)
+			memcpy(&ICLocalHostAddrs[ICNumLocalHostAddrs++], ifa->ifa_addr, sizeof(struct sockaddr_in6));
+	}
+	freeifaddrs(ifaddrs);
+
+	return;
+
+error:
+	errnoSave = errno;
+	if (ICLocalListenerSocket >= 0)
+		closesocket(ICLocalListenerSocket);
+	if (ICLocalSenderSocket >= 0)
+		closesocket(ICLocalSenderSocket);
+	ICLocalListenerSocket = -1;
+	ICLocalSenderSocket = -1;
+	errno = errnoSave;
+	ereport(ERROR,
+			(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+			 errmsg("interconnect error: Could not set up same-host interconnect socket"),
+			 errdetail("%s: %m", fun)));
+#endif
+}
+
+/*
+ * isLocalHostAddr
+ * 		Does this IPv4/IPv6 address belong to one of our network interfaces?
+ *
+ * V4-mapped IPv6 addresses are compared as IPv4 addresses.
+ */
+static bool
+isLocalHostAddr(struct sockaddr_storage *addr)
+{
+	struct in_addr v4;
+	bool		isV4 = false;
+	int			i;
+
+	if (addr->ss_family == AF_INET)
+	{
+		v4 = ((struct sockaddr_in *) addr)->sin_addr;
+		isV4 = true;
+	}
+#ifdef HAVE_IPV6
+	else if (addr->ss_family == AF_INET6 &&
+			 IN6_IS_ADDR_V4MAPPED(&((struct sockaddr_in6 *) addr)->sin6_addr))
+	{
+		memcpy(&v4, ((char *) &((struct sockaddr_in6 *) addr)->sin6_addr) + 12, 4);
+		isV4 = true;
+	}
+#endif
+
+	for (i = 0; i < ICNumLocalHostAddrs; i++)
+	{
+		struct sockaddr_storage *local = &ICLocalHostAddrs[i];
+
+		if (isV4)
+		{
+			if (local->ss_family == AF_INET &&
+				memcmp(&((struct sockaddr_in *) local)->sin_addr, &v4, sizeof(v4)) == 0)
+				return true;
+		}
+#ifdef HAVE_IPV6
+		else if (addr->ss_family == AF_INET6 && local->ss_family == AF_INET6)
+		{
+			if (memcmp(&((struct sockaddr_in6 *) local)->sin6_addr,
+					   &((struct sockaddr_in6 *) addr)->sin6_addr,
+					   sizeof(struct in6_addr)) == 0)
+				return true;
+		}
+#endif
+	}
+
+	return false;
+}
+
+/*
+ * connTxFd
+ * 		The socket a sender uses to send to conn's receiver.
+ */
+static inline int
+connTxFd(ChunkTransportStateEntry *pEntry, MotionConn *conn)
+{
+	if (conn->peer.ss_family == AF_UNIX)
+		return ICLocalSenderSocket;
+	return pEntry->txfd;
+}
+
+/*
+ * rxSocketForPeer
+ * 		The socket a receiver uses to send control messages to a sender.
+ *
+ * NOTE: This function is called by the rx threads, it MUST NOT contain elog
+ * or ereport statements.
+ */
+static inline int
+rxSocketForPeer(struct sockaddr_storage *peer)
+{
+	if (peer->ss_family == AF_UNIX)
+		return ICLocalListenerSocket;
+	return UDP_listenerFd;
+}
+
 /*
  * InitMutex
  * 		Initialize mutex.
@@ -1333,51 +1729,62 @@ initMutex(pthread_mutex_t *mutex)
 }
 
 /*
- * Set up the udp interconnect pthread signal mask, we don't want to run our signal handlers
+ * connLockFor
+ * 		The connection lock of the connection with the given header.
+ */
+static inline pthread_mutex_t *
+connLockFor(icpkthdr *hdr)
+{
+	return &ic_control_info.connLocks[CONN_HASH_VALUE(hdr) % ic_control_info.numConnLocks];
+}
+
+/*
+ * lockAllConns
+ * 		Take all the connection locks.
  */
 static void
-ic_set_pthread_sigmasks(sigset_t *old_sigs)
+lockAllConns(void)
 {
-#ifndef WIN32
-	sigset_t sigs;
-	int		 err;
-
-	sigemptyset(&sigs);
-
-	/* make our thread ignore these signals (which should allow that
-	 * they be delivered to the main thread) */
-	sigaddset(&sigs, SIGHUP);
-	sigaddset(&sigs, SIGINT);
-	sigaddset(&sigs, SIGTERM);
-	sigaddset(&sigs, SIGALRM);
-	sigaddset(&sigs, SIGUSR1);
-	sigaddset(&sigs, SIGUSR2);
-
-	err = pthread_sigmask(SIG_BLOCK, &sigs, old_sigs);
-	if (err != 0)
-		elog(ERROR, "Failed to get pthread signal masks with return value: %d", err);
-#else
-	(void) old_sigs;
-#endif
+	int			i;
 
-	return;
+	for (i = 0; i < ic_control_info.numConnLocks; i++)
+		pthread_mutex_lock(&ic_control_info.connLocks[i]);
 }
 
+/*
+ * unlockAllConns
+ * 		Release all the connection locks.
+ *
+ * The locks are error checking mutexes, so this is harmless for the ones
+ * we don't hold, e.g. after an error.
+ */
 static void
-ic_reset_pthread_sigmasks(sigset_t *sigs)
+unlockAllConns(void)
 {
-#ifndef WIN32
-	int err;
+	int			i;
 
-	err = pthread_sigmask(SIG_SETMASK, sigs, NULL);
-	if (err != 0)
-		elog(ERROR, "Failed to reset pthread signal masks with return value: %d", err);
-#else
-	(void) sigs;
-#endif
+	for (i = ic_control_info.numConnLocks - 1; i >= 0; i--)
+		pthread_mutex_unlock(&ic_control_info.connLocks[i]);
+}
 
-	return;
+#ifdef USE_ASSERT_CHECKING
+/*
+ * connLocksReleased
+ * 		Internal error check: none of the connection locks may be held by us.
+ */
+static bool
+connLocksReleased(void)
+{
+	int			i;
+
+	for (i = 0; i < ic_control_info.numConnLocks; i++)
+	{
+		if (pthread_mutex_unlock(&ic_control_info.connLocks[i]) == 0)
+			return false;
+	}
+	return true;
 }
+#endif
 
 /*
  * InitMotionUDPIFC
@@ -1386,12 +1793,8 @@ ic_reset_pthread_sigmasks(sigset_t *sigs)
 void
 InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 {
-	int			pthread_err;
+	int			i;
 	int			txFamily = -1;
-
-	/* attributes of the thread we're creating */
-	pthread_attr_t t_atts;
-	sigset_t	   pthread_sigs;
 	MemoryContext  old;
 
 #ifdef USE_ASSERT_CHECKING
@@ -1408,7 +1811,10 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 													   ALLOCSET_DEFAULT_MINSIZE,
 													   ALLOCSET_DEFAULT_INITSIZE,
 													   ALLOCSET_DEFAULT_MAXSIZE);
-	initMutex(&ic_control_info.lock);
+	for (i = 0; i < IC_MAX_CONN_LOCKS; i++)
+		initMutex(&ic_control_info.connLocks[i]);
+	ic_control_info.numConnLocks = 1;
+	initMutex(&rx_buffer_pool.lock);
 	InitLatch(&ic_control_info.latch);
 	ic_control_info.shutdown = 0;
 	ic_control_info.threadCreated = false;
@@ -1427,24 +1833,87 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 	setupUDPListeningSocket(listenerSocketFd, listenerPort, &txFamily);
 	setupUDPListeningSocket(&ICSenderSocket, &ICSenderPort, &ICSenderFamily);
 
+	/*
+	 * One receive socket per rx thread; the first thread uses the listener
+	 * socket itself.
+	 */
+	ic_control_info.numRxThreads = 1;
+	ic_control_info.rxThreads = palloc0((Gp_interconnect_rx_threads + 1) * sizeof(RxThreadInfo));
+	ic_control_info.rxThreads[0].fd = *listenerSocketFd;
+	while (ic_control_info.numRxThreads < Gp_interconnect_rx_threads)
+	{
+		int			fd = setupUDPShardSocket(*listenerSocketFd);
+
+		if (fd < 0)
+		{
+			elog(LOG, "SO_REUSEPORT is not supported, using a single interconnect rx thread");
+			break;
+		}
+		ic_control_info.rxThreads[ic_control_info.numRxThreads++].fd = fd;
+	}
+
+	/* The same-host listener gets an rx thread of its own. */
+	if (Gp_interconnect_local_transport)
+	{
+#ifdef USE_UDP_LOCAL_TRANSPORT
+		setupUDPLocalSockets(*listenerPort);
+		ic_control_info.rxThreads[ic_control_info.numRxThreads++].fd = ICLocalListenerSocket;
+#else
+		elog(LOG, "same-host interconnect transport is not supported, ignoring gp_interconnect_local_transport");
+#endif
+	}
+
+	if (ic_control_info.numRxThreads > 1)
+		ic_control_info.numConnLocks = Min(IC_MAX_CONN_LOCKS,
+										   ic_control_info.numRxThreads * IC_CONN_LOCKS_PER_RX_THREAD);
+
 	/* Initialize receive control data. */
 	resetMainThreadWaiting(&rx_control_info.mainWaitingState);
 
-	/* allocate a buffer for sending disorder messages */
-	rx_control_info.disorderBuffer = palloc0(MIN_PACKET_SIZE);
 	rx_control_info.lastDXatId = InvalidTransactionId;
 	rx_control_info.lastTornIcId = 0;
 	initCursorICHistoryTable(&rx_control_info.cursorHistoryTable);
 
+	/* Initialize receive slots, each holds one spare rx buffer. */
+	ic_control_info.mmsgBatchSize = Gp_interconnect_mmsg_batch_size;
+#ifndef USE_UDP_MMSG
+	if (ic_control_info.mmsgBatchSize > 1)
+	{
+		elog(LOG, "sendmmsg()/recvmmsg() are not supported, ignoring gp_interconnect_mmsg_batch_size");
+		ic_control_info.mmsgBatchSize = 1;
+	}
+#endif
+	for (i = 0; i < ic_control_info.numRxThreads; i++)
+	{
+		RxThreadInfo *thread = &ic_control_info.rxThreads[i];
+		int			nslots = ic_control_info.mmsgBatchSize;
+
+		thread->pkts = palloc0(nslots * sizeof(icpkthdr *));
+		thread->lens = palloc0(nslots * sizeof(int));
+		thread->peers = palloc0(nslots * sizeof(struct sockaddr_storage));
+		thread->peerlens = palloc0(nslots * sizeof(socklen_t));
+#ifdef USE_UDP_MMSG
+		thread->msgs = palloc0(nslots * sizeof(struct mmsghdr));
+		thread->iovs = palloc0(nslots * sizeof(struct iovec));
+#endif
+	}
+
 	/* Initialize receive buffer pool */
 	rx_buffer_pool.count = 0;
-	rx_buffer_pool.maxCount = 1;
+	rx_buffer_pool.maxCount = ic_control_info.numRxThreads * ic_control_info.mmsgBatchSize;
 	rx_buffer_pool.freeList = NULL;
 
 	/* Initialize send control data */
 	snd_control_info.cwnd = 0;
 	snd_control_info.minCwnd = 0;
 	snd_control_info.ackBuffer = palloc0(MIN_PACKET_SIZE);
+#ifdef USE_UDP_MMSG
+	snd_control_info.mmsgs = palloc0(ic_control_info.mmsgBatchSize * sizeof(struct mmsghdr));
+	snd_control_info.mmsgIovs = palloc0(ic_control_info.mmsgBatchSize * sizeof(struct iovec));
+	snd_control_info.mmsgConns = palloc0(ic_control_info.mmsgBatchSize * sizeof(MotionConn *));
+	snd_control_info.mmsgCount = 0;
+	snd_control_info.mmsgFd = -1;
+#endif
 
 	MemoryContextSwitchTo(old);
 
@@ -1452,7 +1921,22 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 	initMutex(&trans_proto_stats.lock);
 #endif
 
-	/* Start up our rx-thread */
+	startRxThreads();
+}
+
+/*
+ * startRxThreads
+ * 		Start up our rx-threads.
+ */
+static void
+startRxThreads(void)
+{
+	int			pthread_err = 0;
+	int			i;
+
+	/* attributes of the thread we're creating */
+	pthread_attr_t t_atts;
+	sigset_t	   pthread_sigs;
 
 	/*
 	 * save ourselves some memory: the defaults for thread stack size are
@@ -1461,14 +1945,22 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 	pthread_attr_init(&t_atts);
 
 	pthread_attr_setstacksize(&t_atts, Max(PTHREAD_STACK_MIN, (128 * 1024)));
-	ic_set_pthread_sigmasks(&pthread_sigs);
-	pthread_err = pthread_create(&ic_control_info.threadHandle, &t_atts, rxThreadFunc, NULL);
-	ic_reset_pthread_sigmasks(&pthread_sigs);
+	gp_set_thread_sigmasks(&pthread_sigs);
+	for (i = 0; i < ic_control_info.numRxThreads; i++)
+	{
+		pthread_err = pthread_create(&ic_control_info.rxThreads[i].threadHandle, &t_atts,
+									 rxThreadFunc, &ic_control_info.rxThreads[i]);
+		if (pthread_err != 0)
+			break;
+	}
+	gp_reset_thread_sigmasks(&pthread_sigs);
 
 	pthread_attr_destroy(&t_atts);
 	if (pthread_err != 0)
 	{
-		ic_control_info.threadCreated = false;
+		/* Only the threads started so far need to be joined at cleanup. */
+		ic_control_info.numRxThreads = i;
+		ic_control_info.threadCreated = (i > 0);
 		ereport(FATAL,
 				(errcode(ERRCODE_INTERNAL_ERROR),
 				 errmsg("InitMotionLayerIPC: failed to create thread"),
@@ -1476,7 +1968,19 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 	}
 
 	ic_control_info.threadCreated = true;
-	return;
+}
+
+/*
+ * joinRxThreads
+ * 		Wait for all the rx-threads to exit.
+ */
+static void
+joinRxThreads(void)
+{
+	int			i;
+
+	for (i = 0; i < ic_control_info.numRxThreads; i++)
+		pthread_join(ic_control_info.rxThreads[i].threadHandle, NULL);
 }
 
 /*
@@ -1486,13 +1990,16 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 void
 CleanupMotionUDPIFC(void)
 {
+	int			i;
+
 	elog(DEBUG2, "udp-ic: telling receiver thread to shutdown.");
 
 	/*
 	 * We should not hold any lock when we reach here even when we report
 	 * FATAL errors. Just in case, We still release the locks here.
 	 */
-	pthread_mutex_unlock(&ic_control_info.lock);
+	unlockAllConns();
+	pthread_mutex_unlock(&rx_buffer_pool.lock);
 
 	uint32		expected = 0;
 
@@ -1500,10 +2007,26 @@ CleanupMotionUDPIFC(void)
 	pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &ic_control_info.shutdown, &expected, 1);
 
 	if (ic_control_info.threadCreated)
-		pthread_join(ic_control_info.threadHandle, NULL);
+		joinRxThreads();
+	ic_control_info.threadCreated = false;
 
 	elog(DEBUG2, "udp-ic: receiver thread shutdown.");
 
+	/*
+	 * The first rx socket is the listener, which ic_common.c closes. The
+	 * same-host listener, if any, is among the others.
+	 */
+	for (i = 1; i < ic_control_info.numRxThreads; i++)
+		closesocket(ic_control_info.rxThreads[i].fd);
+	ic_control_info.numRxThreads = 0;
+	ICLocalListenerSocket = -1;
+
+	if (ICLocalSenderSocket >= 0)
+		closesocket(ICLocalSenderSocket);
+	ICLocalSenderSocket = -1;
+	ICLocalHostAddrs = NULL;
+	ICNumLocalHostAddrs = 0;
+
 	purgeCursorIcEntry(&rx_control_info.cursorHistoryTable);
 
 	destroyConnHashTable(&ic_control_info.connHtab);
@@ -1512,10 +2035,6 @@ CleanupMotionUDPIFC(void)
 	cleanupStartupCache();
 	destroyConnHashTable(&ic_control_info.startupCacheHtab);
 
-	/* free the disorder buffer */
-	pfree(rx_control_info.disorderBuffer);
-	rx_control_info.disorderBuffer = NULL;
-
 	/* free the buffer for acks */
 	pfree(snd_control_info.ackBuffer);
 	snd_control_info.ackBuffer = NULL;
@@ -1822,7 +2341,7 @@ setAckSendParam(AckSendParam *param, MotionConn *conn, int32 flags, uint32 seq,
 static inline void
 sendAckWithParam(AckSendParam *param)
 {
-	sendControlMessage(&param->msg, UDP_listenerFd, (struct sockaddr *) &param->peer, param->peer_len);
+	sendControlMessage(&param->msg, rxSocketForPeer(&param->peer), (struct sockaddr *) &param->peer, param->peer_len);
 }
 
 /*
@@ -1846,7 +2365,7 @@ sendAck(MotionConn *conn, int32 flags, uint32 seq, uint32 extraSeq)
 			  msg.flags, msg.motNodeId, conn->route, msg.seq, msg.extraSeq);
 #endif
 
-	sendControlMessage(&msg, UDP_listenerFd, (struct sockaddr *) &conn->peer, conn->peer_len);
+	sendControlMessage(&msg, rxSocketForPeer(&conn->peer), (struct sockaddr *) &conn->peer, conn->peer_len);
 
 }
 
@@ -1859,9 +2378,9 @@ sendAck(MotionConn *conn, int32 flags, uint32 seq, uint32 extraSeq)
  *
  */
 static void
-sendDisorderAck(MotionConn *conn, uint32 seq, uint32 extraSeq, uint32 lostPktCnt)
+sendDisorderAck(MotionConn *conn, DisorderAckMsg *msg, uint32 seq, uint32 extraSeq, uint32 lostPktCnt)
 {
-	icpkthdr   *disorderBuffer = rx_control_info.disorderBuffer;
+	icpkthdr   *disorderBuffer = &msg->hdr;
 
 	memcpy(disorderBuffer, (char *) &conn->conn_info, sizeof(icpkthdr));
 
@@ -1870,14 +2389,17 @@ sendDisorderAck(MotionConn *conn, uint32 seq, uint32 extraSeq, uint32 lostPktCnt
 	disorderBuffer->extraSeq = extraSeq;
 	disorderBuffer->len = lostPktCnt * sizeof(uint32) + sizeof(icpkthdr);
 
+	StaticAssertStmt(offsetof(DisorderAckMsg, lostSeqs) == sizeof(icpkthdr),
+					 "lost sequence numbers must follow the header");
+
 #ifdef AMS_VERBOSE_LOGGING
-	if (!(conn->peer.ss_family == AF_INET || conn->peer.ss_family == AF_INET6))
+	if (!(conn->peer.ss_family == AF_INET || conn->peer.ss_family == AF_INET6 || conn->peer.ss_family == AF_UNIX))
 	{
 		write_log("UDP Interconnect bug (in sendDisorderAck): trying to send ack when we don't know where to send to %s", conn->remoteHostAndPort);
 	}
 #endif
 
-	sendControlMessage(disorderBuffer, UDP_listenerFd, (struct sockaddr *) &conn->peer, conn->peer_len);
+	sendControlMessage(disorderBuffer, rxSocketForPeer(&conn->peer), (struct sockaddr *) &conn->peer, conn->peer_len);
 
 }
 
@@ -1911,7 +2433,7 @@ sendStatusQueryMessage(MotionConn *conn, int fd, uint32 seq)
  * putRxBufferAndSendAck
  * 		Return a buffer and send an acknowledgment.
  *
- *  SHOULD BE CALLED WITH ic_control_info.lock *LOCKED*
+ *  SHOULD BE CALLED WITH the connection lock of conn *LOCKED*
  */
 static void
 putRxBufferAndSendAck(MotionConn *conn, AckSendParam *param)
@@ -1922,7 +2444,7 @@ putRxBufferAndSendAck(MotionConn *conn, AckSendParam *param)
 	buf = (icpkthdr *) conn->pkt_q[conn->pkt_q_head];
 	if (buf == NULL)
 	{
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 		elog(FATAL, "putRxBufferAndSendAck: buffer is NULL");
 	}
 
@@ -1941,7 +2463,9 @@ putRxBufferAndSendAck(MotionConn *conn, AckSendParam *param)
 	elog(LOG, "putRxBufferAndSendAck conn %p pkt [seq %d] for node %d route %d, [head seq] %d queue size %d, queue head %d queue tail %d", conn, seq, buf->motNodeId, conn->route, conn->conn_info.seq - conn->pkt_q_size, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
 #endif
 
+	pthread_mutex_lock(&rx_buffer_pool.lock);
 	putRxBufferToFreeList(&rx_buffer_pool, buf);
+	pthread_mutex_unlock(&rx_buffer_pool.lock);
 
 	conn->conn_info.extraSeq = seq;
 
@@ -1970,15 +2494,17 @@ MlPutRxBufferIFC(ChunkTransportState *transportStates, int motNodeID, int route)
 {
 	ChunkTransportStateEntry *pEntry = NULL;
 	MotionConn *conn = NULL;
+	pthread_mutex_t *connLock;
 	AckSendParam param;
 
 	getChunkTransportState(transportStates, motNodeID, &pEntry);
 
 	conn = pEntry->conns + route;
+	connLock = connLockFor(&conn->conn_info);
 
 	memset(&param, 0, sizeof(AckSendParam));
 
-	pthread_mutex_lock(&ic_control_info.lock);
+	pthread_mutex_lock(connLock);
 
 	if (conn->pBuff != NULL)
 	{
@@ -1986,11 +2512,11 @@ MlPutRxBufferIFC(ChunkTransportState *transportStates, int motNodeID, int route)
 	}
 	else
 	{
-		pthread_mutex_unlock(&ic_control_info.lock);
+		pthread_mutex_unlock(connLock);
 		elog(FATAL, "Interconnect error: tried to release a NULL buffer");
 	}
 
-	pthread_mutex_unlock(&ic_control_info.lock);
+	pthread_mutex_unlock(connLock);
 
 	/*
 	 * real ack sending is after lock release to decrease the lock holding
@@ -2004,7 +2530,7 @@ MlPutRxBufferIFC(ChunkTransportState *transportStates, int motNodeID, int route)
  * getRxBuffer
  * 		Get a receive buffer.
  *
- * SHOULD BE CALLED WITH ic_control_info.lock *LOCKED*
+ * SHOULD BE CALLED WITH rx_buffer_pool.lock *LOCKED*
  *
  * NOTE: This function MUST NOT contain elog or ereport statements.
  * elog is NOT thread-safe.  Developers should instead use something like:
@@ -2063,7 +2589,7 @@ getRxBuffer(RxBufferPool *p)
  * putRxBufferToFreeList
  * 		Return a receive buffer to free list
  *
- *  SHOULD BE CALLED WITH ic_control_info.lock *LOCKED*
+ *  SHOULD BE CALLED WITH rx_buffer_pool.lock *LOCKED*
  */
 static inline void
 putRxBufferToFreeList(RxBufferPool *p, icpkthdr *buf)
@@ -2077,7 +2603,7 @@ putRxBufferToFreeList(RxBufferPool *p, icpkthdr *buf)
  * getRxBufferFromFreeList
  * 		Get a receive buffer from free list
  *
- * SHOULD BE CALLED WITH ic_control_info.lock *LOCKED*
+ * SHOULD BE CALLED WITH rx_buffer_pool.lock *LOCKED*
  *
  * NOTE: This function MUST NOT contain elog or ereport statements.
  * elog is NOT thread-safe.  Developers should instead use something like:
@@ -2101,6 +2627,8 @@ getRxBufferFromFreeList(RxBufferPool *p)
  * freeRxBuffer
  * 		Free a receive buffer.
  *
+ * SHOULD BE CALLED WITH rx_buffer_pool.lock *LOCKED*
+ *
  * NOTE: This function MUST NOT contain elog or ereport statements.
  * elog is NOT thread-safe.  Developers should instead use something like:
  *
@@ -2882,6 +3410,13 @@ setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportS
 		}
 	}
 
+	/*
+	 * Receivers on this host are reached through their same-host socket,
+	 * bypassing the IP stack.
+	 */
+	if (ICLocalSenderSocket >= 0 && isLocalHostAddr(&conn->peer))
+		getLocalSockAddr(&conn->peer, &conn->peer_len, cdbProc->listenerPort);
+
 	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
 		ereport(DEBUG1, (errmsg("Interconnect connecting to seg%d slice%d %s "
 								"pid=%d sockfd=%d",
@@ -2924,7 +3459,8 @@ setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportS
 	conn->msgSize = sizeof(conn->conn_info);
 	conn->stillActive = true;
 	conn->conn_info.seq = 1;
-	Assert(conn->peer.ss_family == AF_INET || conn->peer.ss_family == AF_INET6);
+	Assert(conn->peer.ss_family == AF_INET || conn->peer.ss_family == AF_INET6 ||
+		   conn->peer.ss_family == AF_UNIX);
 
 }								/* setupOutgoingUDPConnection */
 
@@ -2960,14 +3496,18 @@ handleCachedPackets(void)
 				if (pkt == NULL)
 					continue;
 
+				pthread_mutex_lock(&rx_buffer_pool.lock);
 				rx_buffer_pool.maxCount--;
+				pthread_mutex_unlock(&rx_buffer_pool.lock);
 
 				/* look up this pkt's connection in connHtab */
 				setupConn = findConnByHeader(&ic_control_info.connHtab, pkt);
 				if (setupConn == NULL)
 				{
 					/* mismatch! */
+					pthread_mutex_lock(&rx_buffer_pool.lock);
 					putRxBufferToFreeList(&rx_buffer_pool, pkt);
+					pthread_mutex_unlock(&rx_buffer_pool.lock);
 					cachedConn->pkt_q[j] = NULL;
 					continue;
 				}
@@ -2976,7 +3516,9 @@ handleCachedPackets(void)
 				if (!handleDataPacket(setupConn, pkt, &cachedConn->peer, &cachedConn->peer_len, &param, &dummy))
 				{
 					/* no need to cache this packet */
+					pthread_mutex_lock(&rx_buffer_pool.lock);
 					putRxBufferToFreeList(&rx_buffer_pool, pkt);
+					pthread_mutex_unlock(&rx_buffer_pool.lock);
 				}
 
 				ic_statistics.recvPktNum++;
@@ -3019,7 +3561,7 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 	ChunkTransportStateEntry *sendingChunkTransportState = NULL;
 	ChunkTransportState *interconnect_context;
 
-	pthread_mutex_lock(&ic_control_info.lock);
+	lockAllConns();
 
 	gp_interconnect_id = sliceTable->ic_instance_id;
 
@@ -3119,7 +3661,9 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 				conn->pkt_q = (uint8 **) palloc0(conn->pkt_q_capacity * sizeof(uint8 *));
 
 				/* update the max buffer count of our rx buffer pool.  */
+				pthread_mutex_lock(&rx_buffer_pool.lock);
 				rx_buffer_pool.maxCount += conn->pkt_q_capacity;
+				pthread_mutex_unlock(&rx_buffer_pool.lock);
 
 
 				/*
@@ -3212,7 +3756,7 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 
 	interconnect_context->activated = true;
 
-	pthread_mutex_unlock(&ic_control_info.lock);
+	unlockAllConns();
 
 	return interconnect_context;
 }
@@ -3236,7 +3780,7 @@ SetupUDPIFCInterconnect(EState *estate)
 		icContext = SetupUDPIFCInterconnect_Internal(estate->es_sliceTable);
 
 		/* Internal error if we locked the mutex but forgot to unlock it. */
-		Assert(pthread_mutex_unlock(&ic_control_info.lock) != 0);
+		Assert(connLocksReleased());
 	}
 	PG_CATCH();
 	{
@@ -3262,7 +3806,7 @@ SetupUDPIFCInterconnect(EState *estate)
 				connDelHash(ht, conn);
 			}
 		}
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 
 		PG_RE_THROW();
 	}
@@ -3300,7 +3844,9 @@ freeDisorderedPackets(MotionConn *conn)
 				elog(DEBUG1, "CLEAR Out-of-order PKT: conn %p pkt [seq %d] for node %d route %d, [head seq] %d queue size %d, queue head %d queue tail %d", conn, buf->seq, buf->motNodeId, conn->route, conn->conn_info.seq - conn->pkt_q_size, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
 
 			/* return the buffer into the free list. */
+			pthread_mutex_lock(&rx_buffer_pool.lock);
 			putRxBufferToFreeList(&rx_buffer_pool, buf);
+			pthread_mutex_unlock(&rx_buffer_pool.lock);
 			conn->pkt_q[k] = NULL;
 		}
 	}
@@ -3367,6 +3913,8 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 
 	bool		isReceiver = false;
 
+	StringInfoData rxThreadLoad;
+
 	if (transportStates == NULL || transportStates->sliceTable == NULL)
 	{
 		elog(LOG, "TeardownUDPIFCInterconnect: missing slice table.");
@@ -3415,7 +3963,7 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 	 * add lock to protect the hash table, since background thread is still
 	 * working.
 	 */
-	pthread_mutex_lock(&ic_control_info.lock);
+	lockAllConns();
 
 	if (gp_interconnect_cache_future_packets)
 		cleanupStartupCache();
@@ -3534,7 +4082,9 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 					if (!conn->pkt_q)
 						break;
 
+					pthread_mutex_lock(&rx_buffer_pool.lock);
 					rx_buffer_pool.maxCount -= conn->pkt_q_capacity;
+					pthread_mutex_unlock(&rx_buffer_pool.lock);
 
 					connDelHash(&ic_control_info.connHtab, conn);
 
@@ -3568,6 +4118,7 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 	 * now that we've moved active rx-buffers to the freelist, we can prune
 	 * the freelist itself
 	 */
+	pthread_mutex_lock(&rx_buffer_pool.lock);
 	while (rx_buffer_pool.count > rx_buffer_pool.maxCount)
 	{
 		icpkthdr   *buf = NULL;
@@ -3575,13 +4126,18 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		/* If this happened, there are some memory leaks.. */
 		if (rx_buffer_pool.freeList == NULL)
 		{
-			pthread_mutex_unlock(&ic_control_info.lock);
-			elog(FATAL, "freelist NULL: count %d max %d buf %p", rx_buffer_pool.count, rx_buffer_pool.maxCount, rx_buffer_pool.freeList);
+			int			count = rx_buffer_pool.count;
+			int			maxCount = rx_buffer_pool.maxCount;
+
+			pthread_mutex_unlock(&rx_buffer_pool.lock);
+			unlockAllConns();
+			elog(FATAL, "freelist NULL: count %d max %d", count, maxCount);
 		}
 
 		buf = getRxBufferFromFreeList(&rx_buffer_pool);
 		freeRxBuffer(&rx_buffer_pool, buf);
 	}
+	pthread_mutex_unlock(&rx_buffer_pool.lock);
 
 	/*
 	 * Update the history of interconnect instance id.
@@ -3592,7 +4148,19 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 	}
 	else if (Gp_role == GP_ROLE_EXECUTE)
 	{
-		rx_control_info.lastTornIcId = transportStates->sliceTable->ic_instance_id;
+		rx_control_info.lastTornIcId = transportStates->sliceTable->ic_instance_id;
+	}
+
+	/* packets/bytes handled by each rx thread since the last teardown */
+	initStringInfo(&rxThreadLoad);
+	for (i = 0; i < ic_control_info.numRxThreads; i++)
+	{
+		RxThreadInfo *thread = &ic_control_info.rxThreads[i];
+
+		appendStringInfo(&rxThreadLoad, "%s%u/" UINT64_FORMAT,
+						 (i > 0 ? ", " : ""), thread->recvPktNum, thread->recvBytes);
+		thread->recvPktNum = 0;
+		thread->recvBytes = 0;
 	}
 
 	elog((gp_interconnect_log_stats ? LOG : DEBUG1), "Interconnect State: "
@@ -3608,7 +4176,8 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		 " freebuf_avg %f "
 		 "mismatch_pkt_num %d disordered_pkt_num %d duplicated_pkt_num %d"
 		 " rtt/dev [" UINT64_FORMAT "/" UINT64_FORMAT ", %f/%f, " UINT64_FORMAT "/" UINT64_FORMAT "] "
-		 " cwnd %f status_query_msg_num %d",
+		 " cwnd %f status_query_msg_num %d"
+		 " rx_thread_load [%s]",
 		 ic_control_info.isSender, isReceiver,
 		 Gp_interconnect_snd_queue_depth, Gp_interconnect_queue_depth, Gp_max_packet_size,
 		 UNACK_QUEUE_RING_SLOTS_NUM, TIMER_SPAN, DEFAULT_RTT,
@@ -3621,12 +4190,19 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		 (double) ((double) ic_statistics.totalBuffers) / ((double) ic_statistics.bufferCountingTime),
 		 ic_statistics.mismatchNum, ic_statistics.disorderedPktNum, ic_statistics.duplicatedPktNum,
 		 (minRtt == ~((uint64) 0) ? 0 : minRtt), (minDev == ~((uint64) 0) ? 0 : minDev), avgRtt, avgDev, maxRtt, maxDev,
-		 snd_control_info.cwnd, ic_statistics.statusQueryMsgNum);
+		 snd_control_info.cwnd, ic_statistics.statusQueryMsgNum,
+		 rxThreadLoad.data);
 
 	ic_control_info.isSender = false;
 	memset(&ic_statistics, 0, sizeof(ICStatistics));
+	pfree(rxThreadLoad.data);
+
+#ifdef USE_UDP_MMSG
+	/* drop any packets left queued by an error, their buffers are gone */
+	snd_control_info.mmsgCount = 0;
+#endif
 
-	pthread_mutex_unlock(&ic_control_info.lock);
+	unlockAllConns();
 
 	/* reset the rx thread network error flag */
 	resetRxThreadError();
@@ -3664,11 +4240,11 @@ TeardownUDPIFCInterconnect(ChunkTransportState *transportStates,
 	{
 		TeardownUDPIFCInterconnect_Internal(transportStates, forceEOS);
 
-		Assert(pthread_mutex_unlock(&ic_control_info.lock) != 0);
+		Assert(connLocksReleased());
 	}
 	PG_CATCH();
 	{
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 		PG_RE_THROW();
 	}
 	PG_END_TRY();
@@ -3678,7 +4254,7 @@ TeardownUDPIFCInterconnect(ChunkTransportState *transportStates,
  * prepareRxConnForRead
  * 		Prepare the receive connection for reading.
  *
- * MUST BE CALLED WITH ic_control_info.lock LOCKED.
+ * MUST BE CALLED WITH all the connection locks LOCKED.
  */
 static void
 prepareRxConnForRead(MotionConn *conn)
@@ -3696,7 +4272,7 @@ prepareRxConnForRead(MotionConn *conn)
  * receiveChunksUDPIFC
  * 		Receive chunks from the senders
  *
- * MUST BE CALLED WITH ic_control_info.lock LOCKED.
+ * MUST BE CALLED WITH all the connection locks LOCKED.
  */
 static TupleChunkListItem
 receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEntry *pEntry,
@@ -3748,7 +4324,7 @@ receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEn
 		{
 			Assert(rxconn->pBuff);
 
-			pthread_mutex_unlock(&ic_control_info.lock);
+			unlockAllConns();
 
 			elog(DEBUG2, "got data with length %d", rxconn->recvBytes);
 			/* successfully read into this connection's buffer. */
@@ -3768,7 +4344,7 @@ receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEn
 		 * arrive. The RX thread will wake us up using the latch.
 		 */
 		ResetLatch(&ic_control_info.latch);
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 
 		/*
 		 * Wait for data to become ready.
@@ -3828,7 +4404,7 @@ receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEn
 						 errdetail("Postmaster is not alive.")));
 		}
 
-		pthread_mutex_lock(&ic_control_info.lock);
+		lockAllConns();
 
 	}							/* for (;;) */
 
@@ -3866,7 +4442,7 @@ RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
 
 	index = pEntry->scanStart;
 
-	pthread_mutex_lock(&ic_control_info.lock);
+	lockAllConns();
 
 	for (i = 0; i < pEntry->numConns; i++, index++)
 	{
@@ -3891,7 +4467,7 @@ RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
 
 	if (found)
 	{
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 
 		tcItem = RecvTupleChunk(conn, transportStates);
 		*srcRoute = conn->route;
@@ -3906,11 +4482,11 @@ RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
 #endif
 	if (activeCount == 0)
 	{
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 		return NULL;
 	}
 
-	/* receiveChunksUDPIFC() releases ic_control_info.lock as a side-effect */
+	/* receiveChunksUDPIFC() releases the connection locks as a side-effect */
 	tcItem = receiveChunksUDPIFC(transportStates, pEntry, motNodeID, srcRoute, NULL);
 
 	pEntry->scanStart = *srcRoute + 1;
@@ -3934,11 +4510,11 @@ RecvTupleChunkFromAnyUDPIFC(ChunkTransportState *transportStates,
 		icItem = RecvTupleChunkFromAnyUDPIFC_Internal(transportStates, motNodeID, srcRoute);
 
 		/* error if mutex still held (debug build only) */
-		Assert(pthread_mutex_unlock(&ic_control_info.lock) != 0);
+		Assert(connLocksReleased());
 	}
 	PG_CATCH();
 	{
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 
 		PG_RE_THROW();
 	}
@@ -3990,11 +4566,11 @@ RecvTupleChunkFromUDPIFC_Internal(ChunkTransportState *transportStates,
 	}
 #endif
 
-	pthread_mutex_lock(&ic_control_info.lock);
+	lockAllConns();
 
 	if (!conn->stillActive)
 	{
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 		return NULL;
 	}
 
@@ -4005,7 +4581,7 @@ RecvTupleChunkFromUDPIFC_Internal(ChunkTransportState *transportStates,
 	{
 		prepareRxConnForRead(conn);
 
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 
 		TupleChunkListItem tcItem = NULL;
 
@@ -4015,7 +4591,7 @@ RecvTupleChunkFromUDPIFC_Internal(ChunkTransportState *transportStates,
 	}
 
 	/* no existing data, we've got to read a packet */
-	/* receiveChunksUDPIFC() releases ic_control_info.lock as a side-effect */
+	/* receiveChunksUDPIFC() releases the connection locks as a side-effect */
 
 	TupleChunkListItem chunks = receiveChunksUDPIFC(transportStates, pEntry, motNodeID, &route, conn);
 
@@ -4038,11 +4614,11 @@ RecvTupleChunkFromUDPIFC(ChunkTransportState *transportStates,
 		icItem = RecvTupleChunkFromUDPIFC_Internal(transportStates, motNodeID, srcRoute);
 
 		/* error if mutex still held (debug build only) */
-		Assert(pthread_mutex_unlock(&ic_control_info.lock) != 0);
+		Assert(connLocksReleased());
 	}
 	PG_CATCH();
 	{
-		pthread_mutex_unlock(&ic_control_info.lock);
+		unlockAllConns();
 
 		PG_RE_THROW();
 	}
@@ -4058,9 +4634,11 @@ RecvTupleChunkFromUDPIFC(ChunkTransportState *transportStates,
 void
 markUDPConnInactiveIFC(MotionConn *conn)
 {
-	pthread_mutex_lock(&ic_control_info.lock);
+	pthread_mutex_t *connLock = connLockFor(&conn->conn_info);
+
+	pthread_mutex_lock(connLock);
 	conn->stillActive = false;
-	pthread_mutex_unlock(&ic_control_info.lock);
+	pthread_mutex_unlock(connLock);
 
 	return;
 }
@@ -4247,6 +4825,8 @@ handleAcks(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntr
 
 	struct icpkthdr *pkt = snd_control_info.ackBuffer;
 
+	/* drain the sender socket first, then the same-host one */
+	int			fd = pEntry->txfd;
 
 	bool		shouldSendBuffers = false;
 
@@ -4255,13 +4835,18 @@ handleAcks(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntr
 
 		/* ready to read on our socket ? */
 		peerlen = sizeof(peer);
-		n = recvfrom(pEntry->txfd, (char *) pkt, MIN_PACKET_SIZE, 0,
+		n = recvfrom(fd, (char *) pkt, MIN_PACKET_SIZE, 0,
 					 (struct sockaddr *) &peer, &peerlen);
 
 		if (n < 0)
 		{
 			if (errno == EWOULDBLOCK)	/* had nothing to read. */
 			{
+				if (fd != ICLocalSenderSocket && ICLocalSenderSocket >= 0)
+				{
+					fd = ICLocalSenderSocket;
+					continue;
+				}
 				aggregateStatistics(pEntry);
 				return ret;
 			}
@@ -4539,7 +5124,7 @@ sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
 #endif
 
 xmit_retry:
-	n = sendto(pEntry->txfd, buf->pkt, buf->pkt->len, 0,
+	n = sendto(connTxFd(pEntry, conn), buf->pkt, buf->pkt->len, 0,
 			   (struct sockaddr *) &conn->peer, conn->peer_len);
 	if (n < 0)
 	{
@@ -4588,6 +5173,142 @@ xmit_retry:
 	return;
 }
 
+/*
+ * sendOnceBatched
+ * 		Queue a packet to be sent by the next flushSendBatch().
+ *
+ * Callers that may send a run of packets use this instead of sendOnce(),
+ * and call flushSendBatch() before returning, so that the whole run is
+ * handed to the kernel with as few sendmmsg() calls as possible. The
+ * buffers stay on their unack queues until acked, so they are still valid
+ * at flush time.
+ */
+static void
+sendOnceBatched(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn *conn)
+{
+#ifdef USE_UDP_MMSG
+	int			idx;
+
+	if (ic_control_info.mmsgBatchSize <= 1)
+	{
+		sendOnce(transportStates, pEntry, buf, conn);
+		return;
+	}
+
+#ifdef USE_ASSERT_CHECKING
+	if (testmode_inject_fault(gp_udpic_dropxmit_percent))
+	{
+#ifdef AMS_VERBOSE_LOGGING
+		write_log("THROW PKT with seq %d srcpid %d despid %d", buf->pkt->seq, buf->pkt->srcPid, buf->pkt->dstPid);
+#endif
+		return;
+	}
+#endif
+
+	if (snd_control_info.mmsgCount == ic_control_info.mmsgBatchSize ||
+		(snd_control_info.mmsgCount > 0 && snd_control_info.mmsgFd != connTxFd(pEntry, conn)))
+		flushSendBatch();
+
+	idx = snd_control_info.mmsgCount++;
+	snd_control_info.mmsgFd = connTxFd(pEntry, conn);
+	snd_control_info.mmsgConns[idx] = conn;
+	snd_control_info.mmsgIovs[idx].iov_base = buf->pkt;
+	snd_control_info.mmsgIovs[idx].iov_len = buf->pkt->len;
+
+	MemSet(&snd_control_info.mmsgs[idx], 0, sizeof(struct mmsghdr));
+	snd_control_info.mmsgs[idx].msg_hdr.msg_name = &conn->peer;
+	snd_control_info.mmsgs[idx].msg_hdr.msg_namelen = conn->peer_len;
+	snd_control_info.mmsgs[idx].msg_hdr.msg_iov = &snd_control_info.mmsgIovs[idx];
+	snd_control_info.mmsgs[idx].msg_hdr.msg_iovlen = 1;
+#else
+	sendOnce(transportStates, pEntry, buf, conn);
+#endif
+}
+
+/*
+ * flushSendBatch
+ * 		Send the packets queued by sendOnceBatched().
+ *
+ * Errors are handled the same way as in sendOnce(): EAGAIN drops the rest
+ * of the batch (it will be retransmitted), EPERM drops one packet.
+ */
+static void
+flushSendBatch(void)
+{
+#ifdef USE_UDP_MMSG
+	int			count = snd_control_info.mmsgCount;
+	int			sent = 0;
+	int			vlen;
+	int			i;
+	int			n;
+
+	/* Reset first, so nothing stale is left behind if we error out. */
+	snd_control_info.mmsgCount = 0;
+
+	while (sent < count)
+	{
+		vlen = count - sent;
+
+#ifdef USE_ASSERT_CHECKING
+		/* Make sendmmsg() take only part of the batch, as it may. */
+		if (vlen > 1 && FINC_HAS_FAULT(FINC_OS_SENDMMSG_SHORT) &&
+			testmode_inject_fault(gp_udpic_fault_inject_percent))
+		{
+			vlen = 1 + random() % (vlen - 1);
+			write_log("inject fault to sendmmsg: FINC_OS_SENDMMSG_SHORT");
+		}
+#endif
+
+		n = sendmmsg(snd_control_info.mmsgFd, &snd_control_info.mmsgs[sent], vlen, 0);
+		if (n < 0)
+		{
+			MotionConn *conn = snd_control_info.mmsgConns[sent];
+
+			if (errno == EINTR)
+				continue;
+
+			if (errno == EAGAIN)	/* no space ? not an error. */
+				return;
+
+			/* See sendOnce() */
+			if (errno == EPERM)
+			{
+				ereport(LOG,
+						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						 errmsg("Interconnect error writing an outgoing packet: %m"),
+						 errdetail("error during sendmmsg() for Remote Connection: contentId=%d at %s",
+								   conn->remoteContentId, conn->remoteHostAndPort)));
+				sent++;
+				continue;
+			}
+
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect error writing an outgoing packet: %m"),
+							errdetail("error during sendmmsg() call (error:%d).\n"
+									  "For Remote Connection: contentId=%d at %s",
+									  errno, conn->remoteContentId,
+									  conn->remoteHostAndPort)));
+			/* not reached */
+		}
+
+		for (i = sent; i < sent + n; i++)
+		{
+			if (snd_control_info.mmsgs[i].msg_len != snd_control_info.mmsgIovs[i].iov_len)
+			{
+				icpkthdr   *pkt = (icpkthdr *) snd_control_info.mmsgIovs[i].iov_base;
+
+				if (DEBUG1 >= log_min_messages)
+					write_log("Interconnect error writing an outgoing packet [seq %d]: short transmit (given %d sent %d) during sendmmsg() call."
+							  "For Remote Connection: contentId=%d at %s", pkt->seq, pkt->len, snd_control_info.mmsgs[i].msg_len,
+							  snd_control_info.mmsgConns[i]->remoteContentId,
+							  snd_control_info.mmsgConns[i]->remoteHostAndPort);
+			}
+		}
+		sent += n;
+	}
+#endif
+}
+
 
 /*
  * handleStopMsgs
@@ -4749,7 +5470,7 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 		updateStats(TPE_DATA_PKT_SEND, conn, buf->pkt);
 #endif
 
-		sendOnce(transportStates, pEntry, buf, conn);
+		sendOnceBatched(transportStates, pEntry, buf, conn);
 		ic_statistics.sndPktNum++;
 
 #ifdef AMS_VERBOSE_LOGGING
@@ -4758,6 +5479,8 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 
 		buf->conn->sentSeq = buf->pkt->seq;
 	}
+
+	flushSendBatch();
 }
 
 /*
@@ -4791,7 +5514,8 @@ handleDisorderPacket(MotionConn *conn, int pos, uint32 tailSeq, icpkthdr *pkt)
 {
 	int			start = 0;
 	uint32		lostPktCnt = 0;
-	uint32	   *curSeq = (uint32 *) &rx_control_info.disorderBuffer[1];
+	DisorderAckMsg msg;
+	uint32	   *curSeq = msg.lostSeqs;
 	uint32		maxSeqs = MAX_SEQS_IN_DISORDER_ACK;
 
 #ifdef AMS_VERBOSE_LOGGING
@@ -4821,7 +5545,7 @@ handleDisorderPacket(MotionConn *conn, int pos, uint32 tailSeq, icpkthdr *pkt)
 #endif
 
 	/* when reaching here, cnt must not be 0 */
-	sendDisorderAck(conn, pkt->seq, conn->conn_info.seq - 1, lostPktCnt);
+	sendDisorderAck(conn, &msg, pkt->seq, conn->conn_info.seq - 1, lostPktCnt);
 }
 
 /*
@@ -5112,7 +5836,7 @@ checkExpiration(ChunkTransportState *transportStates,
 			updateStats(TPE_DATA_PKT_SEND, curBuf->conn, curBuf->pkt);
 #endif
 
-			sendOnce(transportStates, pEntry, curBuf, curBuf->conn);
+			sendOnceBatched(transportStates, pEntry, curBuf, curBuf->conn);
 
 			retransmits++;
 			ic_statistics.retransmits++;
@@ -5133,6 +5857,8 @@ checkExpiration(ChunkTransportState *transportStates,
 		unack_queue_ring.idx = (unack_queue_ring.idx + 1) % (UNACK_QUEUE_RING_SLOTS_NUM);
 	}
 
+	flushSendBatch();
+
 	/*
 	 * deal with case when there is a long time this function is not called.
 	 */
@@ -5190,7 +5916,7 @@ checkDeadlock(ChunkTransportStateEntry *pEntry, MotionConn *conn)
 		if (((now - ic_control_info.lastDeadlockCheckTime) > deadlockCheckTime) &&
 			((now - conn->deadlockCheckBeginTime) > deadlockCheckTime))
 		{
-			sendStatusQueryMessage(conn, pEntry->txfd, conn->conn_info.seq - 1);
+			sendStatusQueryMessage(conn, connTxFd(pEntry, conn), conn->conn_info.seq - 1);
 			ic_control_info.lastDeadlockCheckTime = now;
 			ic_statistics.statusQueryMsgNum++;
 
@@ -5213,17 +5939,38 @@ checkDeadlock(ChunkTransportStateEntry *pEntry, MotionConn *conn)
 /*
  * pollAcks
  * 		Timeout polling of acks
+ *
+ * Waits up to 'timeout' ms for something handleAcks() has to read, and
+ * returns true if there is.  That is either a packet, or a pending socket
+ * error, on the sender socket 'fd', or a packet on the same-host sender
+ * socket when gp_interconnect_local_transport is in use.  The same-host
+ * socket only ever receives acks and stop messages from receivers on this
+ * host, so it carries the same kind of traffic as 'fd', and every caller
+ * simply follows a true result with handleAcks(), which drains both.
+ *
+ * Returns false on timeout, on EINTR, and if the same-host socket reports
+ * anything but readable data, which handleAcks() would not consume.
  */
 static inline bool
 pollAcks(ChunkTransportState *transportStates, int fd, int timeout)
 {
-	struct pollfd nfd;
+	struct pollfd nfds[2];
+	int			nfd = 1;
 	int			n;
 
-	nfd.fd = fd;
-	nfd.events = POLLIN;
+	nfds[0].fd = fd;
+	nfds[0].events = POLLIN;
+	nfds[0].revents = 0;
+
+	if (ICLocalSenderSocket >= 0)
+	{
+		nfds[1].fd = ICLocalSenderSocket;
+		nfds[1].events = POLLIN;
+		nfds[1].revents = 0;
+		nfd++;
+	}
 
-	n = poll(&nfd, 1, timeout);
+	n = poll(nfds, nfd, timeout);
 	if (n < 0)
 	{
 		ML_CHECK_FOR_INTERRUPTS(transportStates->teardownActive);
@@ -5244,13 +5991,12 @@ pollAcks(ChunkTransportState *transportStates, int fd, int timeout)
 	}
 
 	/* got an ack to handle (possibly a stop message) */
-	if (n == 1 && (nfd.events & POLLIN))
-	{
+	if (nfds[0].revents != 0)
+		return true;
+	if (nfd > 1 && (nfds[1].revents & POLLIN) != 0)
 		return true;
-	}
 
 	return false;
-
 }
 
 /*
@@ -5655,7 +6401,7 @@ doSendStopMessageUDPIFC(ChunkTransportState *transportStates, int16 motNodeID)
 	/*
 	 * Note: we're only concerned with receivers here.
 	 */
-	pthread_mutex_lock(&ic_control_info.lock);
+	lockAllConns();
 
 	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
 		elog(DEBUG1, "Interconnect needs no more input from slice%d; notifying senders to stop.",
@@ -5731,7 +6477,7 @@ doSendStopMessageUDPIFC(ChunkTransportState *transportStates, int16 motNodeID)
 			}
 		}
 	}
-	pthread_mutex_unlock(&ic_control_info.lock);
+	unlockAllConns();
 }
 
 /*
@@ -5982,7 +6728,7 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 	/* dropped ack or timeout */
 	if (pkt->seq < conn->conn_info.seq)
 	{
-		ic_statistics.duplicatedPktNum++;
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.duplicatedPktNum, 1);
 		if (DEBUG3 >= log_min_messages)
 			write_log("dropped ack ? ignored data packet w/ cmd %d conn->cmd %d node %d route %d seq %d expected %d flags 0x%x",
 					  pkt->icId, conn->conn_info.icId, pkt->motNodeId,
@@ -6016,7 +6762,7 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 		 * Error case: NO RX SPACE or out of range pkt This indicates a bug.
 		 */
 		logPkt("Interconnect error: received a packet when the queue is full ", pkt);
-		ic_statistics.disorderedPktNum++;
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.disorderedPktNum, 1);
 		conn->stat_count_dropped++;
 		return false;
 	}
@@ -6068,7 +6814,7 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 				write_log("SAVE conn %p OUT-OF-ORDER pkt [seq %d] at pos [%d] for node %d route %d, [head seq] %d, queue size %d, queue head %d queue tail %d", conn, pkt->seq, pos, pkt->motNodeId, conn->route, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
 
 			/* send an ack for out-of-order packet */
-			ic_statistics.disorderedPktNum++;
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.disorderedPktNum, 1);
 			handleDisorderPacket(conn, pos, headSeq + conn->pkt_q_size, pkt);
 		}
 	}
@@ -6078,7 +6824,7 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 			write_log("DUPLICATE pkt [seq %d], [head seq] %d, queue size %d, queue head %d queue tail %d", pkt->seq, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
 
 		setAckSendParam(param, conn, UDPIC_FLAGS_DUPLICATE | conn->conn_info.flags, pkt->seq, conn->conn_info.seq - 1);
-		ic_statistics.duplicatedPktNum++;
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.duplicatedPktNum, 1);
 		return false;
 	}
 
@@ -6089,8 +6835,14 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 	{
 		if (rx_control_info.mainWaitingState.waitingRoute == ANY_ROUTE)
 		{
-			if (rx_control_info.mainWaitingState.reachRoute == ANY_ROUTE)
-				rx_control_info.mainWaitingState.reachRoute = conn->route;
+			/*
+			 * rx threads holding the locks of other connections may be
+			 * here too; the first one wins.
+			 */
+			uint32		expected = (uint32) ANY_ROUTE;
+
+			pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &rx_control_info.mainWaitingState.reachRoute,
+										   &expected, (uint32) conn->route);
 		}
 		else if (rx_control_info.mainWaitingState.waitingRoute == conn->route)
 		{
@@ -6105,9 +6857,205 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 	return true;
 }
 
+/*
+ * receiveRxPackets
+ * 		Read as many packets as the thread has buffers for.
+ *
+ * Uses a single recvmmsg() call when syscall batching is enabled, and
+ * recvfrom() otherwise. Returns the number of packets read, or -1 with
+ * errno set.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ */
+static int
+receiveRxPackets(RxThreadInfo *thread)
+{
+	int			read_count;
+
+#ifdef USE_UDP_MMSG
+	if (ic_control_info.mmsgBatchSize > 1)
+	{
+		int			i;
+		int			n;
+
+		for (i = 0; i < ic_control_info.mmsgBatchSize; i++)
+		{
+			struct msghdr *hdr = &thread->msgs[i].msg_hdr;
+
+			thread->iovs[i].iov_base = thread->pkts[i];
+			thread->iovs[i].iov_len = Gp_max_packet_size;
+			hdr->msg_name = &thread->peers[i];
+			hdr->msg_namelen = sizeof(struct sockaddr_storage);
+			hdr->msg_iov = &thread->iovs[i];
+			hdr->msg_iovlen = 1;
+			hdr->msg_control = NULL;
+			hdr->msg_controllen = 0;
+			hdr->msg_flags = 0;
+		}
+
+		n = recvmmsg(thread->fd, thread->msgs, ic_control_info.mmsgBatchSize, 0, NULL);
+
+		for (i = 0; i < n; i++)
+		{
+			thread->lens[i] = thread->msgs[i].msg_len;
+			thread->peerlens[i] = thread->msgs[i].msg_hdr.msg_namelen;
+		}
+
+		return n;
+	}
+#endif
+
+	thread->peerlens[0] = sizeof(struct sockaddr_storage);
+	read_count = recvfrom(thread->fd, (char *) thread->pkts[0], Gp_max_packet_size, 0,
+						  (struct sockaddr *) &thread->peers[0], &thread->peerlens[0]);
+	if (read_count < 0)
+		return -1;
+
+	thread->lens[0] = read_count;
+	return 1;
+}
+
+/*
+ * handleRxPacket
+ * 		Validate and dispatch one packet read by an rx thread.
+ *
+ * Returns true if the packet buffer has been taken over (queued on its
+ * connection or cached), in which case the caller needs a new one.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ */
+static bool
+handleRxPacket(RxThreadInfo *thread, icpkthdr *pkt, int read_count,
+			   struct sockaddr_storage *peer, socklen_t *peerlen)
+{
+	MotionConn *conn = NULL;
+	pthread_mutex_t *connLock;
+	bool		allLocked = false;
+	bool		consumed = false;
+	bool		wakeup_mainthread = false;
+	AckSendParam param;
+
+	if (DEBUG5 >= log_min_messages)
+		write_log("received inbound len %d", read_count);
+
+	if (read_count < sizeof(icpkthdr))
+	{
+		if (DEBUG1 >= log_min_messages)
+			write_log("Interconnect error: short conn receive (%d)", read_count);
+		return false;
+	}
+
+	/* length must be >= 0 */
+	if (pkt->len < 0)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound with negative length");
+		return false;
+	}
+
+	if (pkt->len != read_count)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
+		return false;
+	}
+
+	/*
+	 * check the CRC of the payload.
+	 */
+	if (gp_interconnect_full_crc)
+	{
+		if (!checkCRC(pkt))
+		{
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
+			if (DEBUG2 >= log_min_messages)
+				write_log("received network data error, dropping bad packet, user data unaffected.");
+			return false;
+		}
+	}
+
+#ifdef AMS_VERBOSE_LOGGING
+	logPkt("GOT MESSAGE", pkt);
+#endif
+
+	memset(&param, 0, sizeof(AckSendParam));
+
+	/*
+	 * Get the connection for the pkt.
+	 *
+	 * The connection hash table should be locked until finishing the
+	 * processing of the packet to avoid the connection addition/removal from
+	 * the hash table during the mean time. The lock of the packet's
+	 * connection is enough for that; a mismatched packet needs all of them,
+	 * as it is handled with the startup cache, which is shared.
+	 */
+	connLock = connLockFor(pkt);
+	pthread_mutex_lock(connLock);
+	conn = findConnByHeader(&ic_control_info.connHtab, pkt);
+	if (conn == NULL && ic_control_info.numConnLocks > 1)
+	{
+		pthread_mutex_unlock(connLock);
+		lockAllConns();
+		allLocked = true;
+
+		/* it may have been set up meanwhile */
+		conn = findConnByHeader(&ic_control_info.connHtab, pkt);
+	}
+
+	if (conn != NULL)
+	{
+		/* Handling a regular packet */
+		thread->recvPktNum++;
+		thread->recvBytes += read_count;
+		if (handleDataPacket(conn, pkt, peer, peerlen, &param, &wakeup_mainthread))
+			consumed = true;
+		pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.recvPktNum, 1);
+	}
+	else
+	{
+		/*
+		 * There may have two kinds of Mismatched packets: a) Past packets
+		 * from previous command after I was torn down b) Future packets from
+		 * current command before my connections are built.
+		 *
+		 * The handling logic is to "Ack the past and Nak the future".
+		 */
+		if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
+		{
+			if (DEBUG1 >= log_min_messages)
+				write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
+
+#ifdef AMS_VERBOSE_LOGGING
+			logPkt("Got a Mismatched Packet", pkt);
+#endif
+
+			if (handleMismatch(pkt, peer, *peerlen))
+				consumed = true;
+			ic_statistics.mismatchNum++;
+		}
+	}
+	if (allLocked)
+		unlockAllConns();
+	else
+		pthread_mutex_unlock(connLock);
+
+	if (wakeup_mainthread)
+		SetLatch(&ic_control_info.latch);
+
+	/*
+	 * real ack sending is after lock release to decrease the lock holding
+	 * time.
+	 */
+	if (param.msg.len != 0)
+		sendAckWithParam(&param);
+
+	return consumed;
+}
+
 /*
  * rxThreadFunc
- * 		Main function of the receive background thread.
+ * 		Main function of the receive background threads. arg is the
+ * 		RxThreadInfo of the calling thread.
  *
  * NOTE: This function MUST NOT contain elog or ereport statements.
  * elog is NOT thread-safe.  Developers should instead use something like:
@@ -6120,18 +7068,18 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 static void *
 rxThreadFunc(void *arg)
 {
-	icpkthdr   *pkt = NULL;
+	RxThreadInfo *thread = (RxThreadInfo *) arg;
 	bool		skip_poll = false;
-	uint32		expected = 1;
+	int			i;
 
 	for (;;)
 	{
 		struct pollfd nfd;
 		int			n;
+		bool		gotBuffers = true;
 
 		/* check shutdown condition */
-		expected = 1;
-		if (pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &ic_control_info.shutdown, &expected, 0))
+		if (pg_atomic_read_u32((pg_atomic_uint32 *) &ic_control_info.shutdown) == 1)
 		{
 			if (DEBUG1 >= log_min_messages)
 			{
@@ -6140,30 +7088,32 @@ rxThreadFunc(void *arg)
 			break;
 		}
 
-		/* Try to get a buffer */
-		if (pkt == NULL)
+		/* Try to get a buffer for every receive slot */
+		pthread_mutex_lock(&rx_buffer_pool.lock);
+		for (i = 0; i < ic_control_info.mmsgBatchSize; i++)
 		{
-			pthread_mutex_lock(&ic_control_info.lock);
-			pkt = getRxBuffer(&rx_buffer_pool);
-			pthread_mutex_unlock(&ic_control_info.lock);
+			if (thread->pkts[i] == NULL)
+				thread->pkts[i] = getRxBuffer(&rx_buffer_pool);
+			if (thread->pkts[i] == NULL)
+				gotBuffers = false;
+		}
+		pthread_mutex_unlock(&rx_buffer_pool.lock);
 
-			if (pkt == NULL)
-			{
-				setRxThreadError(ENOMEM);
-				continue;
-			}
+		if (!gotBuffers)
+		{
+			setRxThreadError(ENOMEM);
+			continue;
 		}
 
 		if (!skip_poll)
 		{
 			/* Do we have inbound traffic to handle ? */
-			nfd.fd = UDP_listenerFd;
+			nfd.fd = thread->fd;
 			nfd.events = POLLIN;
 
 			n = poll(&nfd, 1, RX_THREAD_POLL_TIMEOUT);
 
-			expected = 1;
-			if (pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &ic_control_info.shutdown, &expected, 0))
+			if (pg_atomic_read_u32((pg_atomic_uint32 *) &ic_control_info.shutdown) == 1)
 			{
 				if (DEBUG1 >= log_min_messages)
 				{
@@ -6198,18 +7148,9 @@ rxThreadFunc(void *arg)
 			/* we've got something interesting to read */
 			/* handle incoming */
 			/* ready to read on our socket */
-			MotionConn *conn = NULL;
-			int			read_count = 0;
-
-			struct sockaddr_storage peer;
-			socklen_t	peerlen;
-
-			peerlen = sizeof(peer);
-			read_count = recvfrom(UDP_listenerFd, (char *) pkt, Gp_max_packet_size, 0,
-								  (struct sockaddr *) &peer, &peerlen);
+			int			nrecv = receiveRxPackets(thread);
 
-			expected = 1;
-			if (pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &ic_control_info.shutdown, &expected, 0))
+			if (pg_atomic_read_u32((pg_atomic_uint32 *) &ic_control_info.shutdown) == 1)
 			{
 				if (DEBUG1 >= log_min_messages)
 				{
@@ -6218,10 +7159,7 @@ rxThreadFunc(void *arg)
 				break;
 			}
 
-			if (DEBUG5 >= log_min_messages)
-				write_log("received inbound len %d", read_count);
-
-			if (read_count < 0)
+			if (nrecv < 0)
 			{
 				skip_poll = false;
 
@@ -6242,123 +7180,35 @@ rxThreadFunc(void *arg)
 				continue;
 			}
 
-			if (read_count < sizeof(icpkthdr))
-			{
-				if (DEBUG1 >= log_min_messages)
-					write_log("Interconnect error: short conn receive (%d)", read_count);
-				continue;
-			}
-
-			/*
-			 * when we get a "good" recvfrom() result, we can skip poll()
-			 * until we get a bad one.
-			 */
-			skip_poll = true;
-
-			/* length must be >= 0 */
-			if (pkt->len < 0)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound with negative length");
-				continue;
-			}
-
-			if (pkt->len != read_count)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
-				continue;
-			}
-
-			/*
-			 * check the CRC of the payload.
-			 */
-			if (gp_interconnect_full_crc)
-			{
-				if (!checkCRC(pkt))
-				{
-					pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
-					if (DEBUG2 >= log_min_messages)
-						write_log("received network data error, dropping bad packet, user data unaffected.");
-					continue;
-				}
-			}
-
-#ifdef AMS_VERBOSE_LOGGING
-			logPkt("GOT MESSAGE", pkt);
-#endif
-
-			bool		wakeup_mainthread = false;
-			AckSendParam param;
-
-			memset(&param, 0, sizeof(AckSendParam));
-
 			/*
-			 * Get the connection for the pkt.
-			 *
-			 * The connection hash table should be locked until finishing the
-			 * processing of the packet to avoid the connection
-			 * addition/removal from the hash table during the mean time.
+			 * when we get a "good" receive result, we can skip poll() until
+			 * we get a bad one. A partially filled batch means the socket
+			 * has been drained, so go back to poll() right away.
 			 */
+			skip_poll = (nrecv == ic_control_info.mmsgBatchSize);
 
-			pthread_mutex_lock(&ic_control_info.lock);
-			conn = findConnByHeader(&ic_control_info.connHtab, pkt);
-
-			if (conn != NULL)
-			{
-				/* Handling a regular packet */
-				if (handleDataPacket(conn, pkt, &peer, &peerlen, &param, &wakeup_mainthread))
-					pkt = NULL;
-				ic_statistics.recvPktNum++;
-			}
-			else
+			for (i = 0; i < nrecv; i++)
 			{
-				/*
-				 * There may have two kinds of Mismatched packets: a) Past
-				 * packets from previous command after I was torn down b)
-				 * Future packets from current command before my connections
-				 * are built.
-				 *
-				 * The handling logic is to "Ack the past and Nak the future".
-				 */
-				if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
-				{
-					if (DEBUG1 >= log_min_messages)
-						write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
-
-#ifdef AMS_VERBOSE_LOGGING
-					logPkt("Got a Mismatched Packet", pkt);
-#endif
-
-					if (handleMismatch(pkt, &peer, peerlen))
-						pkt = NULL;
-					ic_statistics.mismatchNum++;
-				}
+				if (handleRxPacket(thread, thread->pkts[i], thread->lens[i],
+								   &thread->peers[i], &thread->peerlens[i]))
+					thread->pkts[i] = NULL;
 			}
-			pthread_mutex_unlock(&ic_control_info.lock);
-
-			if (wakeup_mainthread)
-				SetLatch(&ic_control_info.latch);
-
-			/*
-			 * real ack sending is after lock release to decrease the lock
-			 * holding time.
-			 */
-			if (param.msg.len != 0)
-				sendAckWithParam(&param);
 		}
 
 		/* pthread_yield(); */
 	}
 
-	/* Before return, we release the packet. */
-	if (pkt)
+	/* Before return, we release the packets. */
+	pthread_mutex_lock(&rx_buffer_pool.lock);
+	for (i = 0; i < ic_control_info.mmsgBatchSize; i++)
 	{
-		pthread_mutex_lock(&ic_control_info.lock);
-		freeRxBuffer(&rx_buffer_pool, pkt);
-		pkt = NULL;
-		pthread_mutex_unlock(&ic_control_info.lock);
+		if (thread->pkts[i])
+		{
+			freeRxBuffer(&rx_buffer_pool, thread->pkts[i]);
+			thread->pkts[i] = NULL;
+		}
 	}
+	pthread_mutex_unlock(&rx_buffer_pool.lock);
 
 	/* nothing to return */
 	return NULL;
@@ -6369,7 +7219,7 @@ rxThreadFunc(void *arg)
  * 		If the mismatched packet is from an old connection, we may need to
  * 		send an acknowledgment.
  *
- * We are called with the receiver-lock held, and we never release it.
+ * We are called with all the connection locks held, and we never release them.
  *
  * For QD:
  * 1) Not in hashtable     : NAK it/Do nothing
@@ -6610,7 +7460,9 @@ cacheFuturePacket(icpkthdr *pkt, struct sockaddr_storage *peer, int peer_len)
 		return false;
 
 	conn->pkt_q[pkt->seq - 1] = (uint8 *) pkt;
+	pthread_mutex_lock(&rx_buffer_pool.lock);
 	rx_buffer_pool.maxCount++;
+	pthread_mutex_unlock(&rx_buffer_pool.lock);
 	ic_statistics.startupCachedPktNum++;
 	return true;
 }
@@ -6643,9 +7495,10 @@ cleanupStartupCache()
 				if (pkt == NULL)
 					continue;
 
+				pthread_mutex_lock(&rx_buffer_pool.lock);
 				rx_buffer_pool.maxCount--;
-
 				putRxBufferToFreeList(&rx_buffer_pool, pkt);
+				pthread_mutex_unlock(&rx_buffer_pool.lock);
 				cachedConn->pkt_q[j] = NULL;
 			}
 			bin = bin->next;
@@ -6845,14 +7698,15 @@ WaitInterconnectQuitUDPIFC(void)
 	/*
 	 * Just in case ic thread is waiting on the locks.
 	 */
-	pthread_mutex_unlock(&ic_control_info.lock);
+	unlockAllConns();
+	pthread_mutex_unlock(&rx_buffer_pool.lock);
 
 	pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &ic_control_info.shutdown, &expected, 1);
 
 	if (ic_control_info.threadCreated)
 	{
 		SendDummyPacket();
-		pthread_join(ic_control_info.threadHandle, NULL);
+		joinRxThreads();
 	}
 	ic_control_info.threadCreated = false;
 }
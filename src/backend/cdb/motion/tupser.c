@@ -16,12 +16,14 @@
 #include "postgres.h"
 
 #include "access/htup.h"
+#include "catalog/pg_compression.h"
 #include "catalog/pg_type.h"
 #include "cdb/cdbmotion.h"
 #include "cdb/cdbsrlz.h"
 #include "cdb/tupser.h"
 #include "cdb/cdbvars.h"
 #include "libpq/pqformat.h"
+#include "storage/gp_compress.h"
 #include "storage/smgr.h"
 #include "utils/acl.h"
 #include "utils/date.h"
@@ -45,6 +47,46 @@
 #define RECORD_CACHE_MAGIC_NATTS	0xffff
 #define RECORD_CACHE_MAGIC_INFOMASK	0xffff
 
+/*
+ * A batch of tuples (see SerializeTupleIntoBatch()) is framed the same way,
+ * with natts set to TUPLE_BATCH_MAGIC_NATTS.  The infomask field of a batch
+ * header carries the number of tuples packed into the batch.
+ */
+#define TUPLE_BATCH_MAGIC_NATTS		0xfffe
+
+/*
+ * A compressed batch (see CompressTupleBatch()) has natts set to
+ * TUPLE_COMPRESSED_MAGIC_NATTS, and the compression method in infomask.
+ * The header is followed by the uncompressed length of the batch, as a
+ * uint32, and the compressed data.  Uncompressed, the data is a regular
+ * batch, header included.
+ */
+#define TUPLE_COMPRESSED_MAGIC_NATTS	0xfffd
+
+/*
+ * Compression state of a motion node, created by InitSerTupCompression().
+ * A sender compresses with it, a receiver decompresses.
+ */
+typedef struct TupSerCompressor
+{
+	int			method;			/* GpVars_Interconnect_Compression */
+	bool		is_compress;
+	PGFunction *funcs;			/* see GetCompressionImplementation() */
+	CompressionState *state;
+
+	/* Scratch space for compressing a batch, allocated in 'mcxt' */
+	MemoryContext mcxt;
+	char	   *rawbuf;
+	char	   *compbuf;
+	int			buflen;
+} TupSerCompressor;
+
+/* pg_compression names of the GpVars_Interconnect_Compression methods */
+static const char *const tupser_comptypes[] = {
+	"none",						/* INTERCONNECT_COMPRESSION_NONE */
+	"zlib",						/* INTERCONNECT_COMPRESSION_ZLIB */
+};
+
 /* A MemoryContext used within the tuple serialize code, so that freeing of
  * space is SUPAFAST.  It is initialized in the first call to InitSerTupInfo()
  * since that must be called before any tuple serialization or deserialization
@@ -82,6 +124,17 @@ skipPadding(StringInfo serialTup)
 	serialTup->cursor = TYPEALIGN(TUPLE_CHUNK_ALIGN, serialTup->cursor);
 }
 
+/* Start a message with a TC_WHOLE chunk header; the caller fixes the type. */
+static inline void
+startChunkList(TupleChunkList tcList, TupleChunkListCache *cache)
+{
+	TupleChunkListItem tcItem = getChunkFromCache(cache);
+
+	SetChunkType(tcItem->chunk_data, TC_WHOLE);
+	tcItem->chunk_length = TUPLE_CHUNK_HEADER_SIZE;
+	appendChunkToTCList(tcList, tcItem);
+}
+
 /* Look up all of the information that SerializeTuple() and DeserializeTuple()
  * need to perform their jobs quickly.	Also, scratchpad space is allocated
  * for serialization and desrialization of datum values, and for formation/
@@ -216,6 +269,55 @@ CleanupSerTupInfo(SerTupInfo *pSerInfo)
 		pSerInfo->chunkCache.items = item->p_next;
 		pfree(item);
 	}
+
+	if (pSerInfo->compressor != NULL)
+	{
+		TupSerCompressor *comp = pSerInfo->compressor;
+
+		callCompressionDestructor(comp->funcs[COMPRESSION_DESTRUCTOR], comp->state);
+		if (comp->rawbuf != NULL)
+			pfree(comp->rawbuf);
+		if (comp->compbuf != NULL)
+			pfree(comp->compbuf);
+		pfree(comp->funcs);
+		pfree(comp);
+		pSerInfo->compressor = NULL;
+	}
+}
+
+/*
+ * Set up a SerTupInfo to compress (on a sender) or decompress (on a
+ * receiver) tuple batches with the given GpVars_Interconnect_Compression
+ * method.  The compressor is looked up in pg_compression, so this has to be
+ * called inside a transaction.  Allocations are made in the current memory
+ * context, like in InitSerTupInfo().
+ */
+void
+InitSerTupCompression(SerTupInfo *pSerInfo, int method, bool is_compress)
+{
+	TupSerCompressor *comp;
+	StorageAttributes sa;
+
+	AssertArg(pSerInfo != NULL);
+	AssertArg(method > INTERCONNECT_COMPRESSION_NONE &&
+			  method < lengthof(tupser_comptypes));
+	Assert(pSerInfo->compressor == NULL);
+
+	comp = (TupSerCompressor *) palloc0(sizeof(TupSerCompressor));
+	comp->method = method;
+	comp->is_compress = is_compress;
+	comp->mcxt = CurrentMemoryContext;
+	comp->funcs = GetCompressionImplementation((char *) tupser_comptypes[method]);
+
+	/* Favour speed over ratio, the data is only in flight for a moment */
+	sa.comptype = (char *) tupser_comptypes[method];
+	sa.complevel = 1;
+	sa.blocksize = 0;
+	sa.typid = InvalidOid;
+	comp->state = callCompressionConstructor(comp->funcs[COMPRESSION_CONSTRUCTOR],
+											 NULL, &sa, is_compress);
+
+	pSerInfo->compressor = comp;
 }
 
 /*
@@ -286,6 +388,35 @@ typedef struct TupSerHeader
 	uint16		infomask;		/* various flag bits */
 } TupSerHeader;
 
+/*
+ * If we have more than 1 chunk we have to set the chunk types on our first
+ * chunk and last chunk.
+ */
+static void
+setChunkListBoundaryTypes(TupleChunkList tcList)
+{
+	if (tcList->num_chunks > 1)
+	{
+		TupleChunkListItem first,
+					last;
+
+		first = tcList->p_first;
+		last = tcList->p_last;
+
+		Assert(first != NULL);
+		Assert(first != last);
+		Assert(last != NULL);
+
+		SetChunkType(first->chunk_data, TC_PARTIAL_START);
+		SetChunkType(last->chunk_data, TC_PARTIAL_END);
+
+		/*
+		 * any intervening chunks are already set to TC_PARTIAL_MID when
+		 * allocated
+		 */
+	}
+}
+
 /*
  * Convert RecordCache into a byte-sequence, and store it directly
  * into a chunklist for transmission.
@@ -351,30 +482,7 @@ SerializeRecordCacheIntoChunks(SerTupInfo *pSerInfo,
 	addByteStringToChunkList(tcList, buf, size, &pSerInfo->chunkCache);
 	addPadding(tcList, &pSerInfo->chunkCache, size);
 
-	/*
-	 * if we have more than 1 chunk we have to set the chunk types on our
-	 * first chunk and last chunk
-	 */
-	if (tcList->num_chunks > 1)
-	{
-		TupleChunkListItem first,
-					last;
-
-		first = tcList->p_first;
-		last = tcList->p_last;
-
-		Assert(first != NULL);
-		Assert(first != last);
-		Assert(last != NULL);
-
-		SetChunkType(first->chunk_data, TC_PARTIAL_START);
-		SetChunkType(last->chunk_data, TC_PARTIAL_END);
-
-		/*
-		 * any intervening chunks are already set to TC_PARTIAL_MID when
-		 * allocated
-		 */
-	}
+	setChunkListBoundaryTypes(tcList);
 
 	return;
 }
@@ -386,44 +494,28 @@ CandidateForSerializeDirect(int16 targetRoute, struct directTransportBuffer *b)
 }
 
 /*
+ * Serialize one tuple, the part of the wire format that follows the chunk
+ * header.  This is shared by SerializeTuple() and SerializeTupleIntoBatch(),
+ * so that single tuples and members of a batch are laid out the same way.
  *
- * First try to serialize a tuple directly into a buffer.
- *
- * We're called with at least enough space for a tuple-chunk-header.
+ * If 'b' is given, we first try to serialize the tuple in-line into that
+ * transport buffer, as one TC_WHOLE chunk.  On success, the number of bytes
+ * used, including the chunk header, is returned.
  *
- * Convert a HeapTuple into a byte-sequence, and store it directly
- * into a chunklist for transmission.
+ * Otherwise the tuple is appended to 'tcList' and 0 is returned.  If the list
+ * is empty, it's started with a TC_WHOLE chunk header first; a batch already
+ * has its header chunk, and the tuple just goes after the previous ones.  The
+ * caller is responsible for setChunkListBoundaryTypes().
  *
  * This code is based on the printtup_internal_20() function in printtup.c.
  */
-int
-SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTransportBuffer *b, TupleChunkList tcList, int16 targetRoute)
+static int
+serializeTupleToTarget(TupleTableSlot *slot, SerTupInfo *pSerInfo,
+					   struct directTransportBuffer *b, TupleChunkList tcList)
 {
-	int			natts;
 	int			dataSize = TUPLE_CHUNK_HEADER_SIZE;
-	TupleDesc	tupdesc;
-	TupleChunkListItem tcItem = NULL;
-
-	AssertArg(pSerInfo != NULL);
-	AssertArg(b != NULL);
-
-	tupdesc = pSerInfo->tupdesc;
-	natts = tupdesc->natts;
 
-	if (natts == 0 && CandidateForSerializeDirect(targetRoute, b))
-	{
-		/* TC_EMTPY is just one chunk */
-		SetChunkType(b->pri, TC_EMPTY);
-		SetChunkDataSize(b->pri, 0);
-
-		return TUPLE_CHUNK_HEADER_SIZE;
-	}
-
-	tcList->p_first = NULL;
-	tcList->p_last = NULL;
-	tcList->num_chunks = 0;
-	tcList->serialized_data_length = 0;
-	tcList->max_chunk_length = Gp_max_tuple_chunk_size;
+	AssertState(s_tupSerMemCtxt != NULL);
 
 	if (slot->PRIVATE_tts_heaptuple == NULL ||
 		(slot->PRIVATE_tts_heaptuple->t_data->t_infomask & HEAP_HASEXTERNAL) != 0)
@@ -445,50 +537,37 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 		else
 		{
 			MemoryContext oldContext;
+
 			oldContext = MemoryContextSwitchTo(s_tupSerMemCtxt);
 			slot_getallattrs(slot);
 			tuple = memtuple_form_to(slot->tts_mt_bind, slot_get_values(slot), slot_get_isnull(slot),
-									  NULL, NULL, true);
+									 NULL, NULL, true);
 			MemoryContextSwitchTo(oldContext);
 		}
 
-		if (CandidateForSerializeDirect(targetRoute, b))
-		{
-			/*
-			 * Here we first try to in-line serialize the tuple directly into
-			 * buffer.
-			 */
-			tupleSize = memtuple_get_size(tuple);
+		tupleSize = memtuple_get_size(tuple);
+		paddedSize = TYPEALIGN(TUPLE_CHUNK_ALIGN, tupleSize);
 
-			paddedSize = TYPEALIGN(TUPLE_CHUNK_ALIGN, tupleSize);
+		if (b != NULL && paddedSize + TUPLE_CHUNK_HEADER_SIZE <= b->prilen)
+		{
+			/* will fit. */
+			memcpy(b->pri + TUPLE_CHUNK_HEADER_SIZE, tuple, tupleSize);
+			memset(b->pri + TUPLE_CHUNK_HEADER_SIZE + tupleSize, 0, paddedSize - tupleSize);
 
-			if (paddedSize + TUPLE_CHUNK_HEADER_SIZE <= b->prilen)
-			{
-				/* will fit. */
-				memcpy(b->pri + TUPLE_CHUNK_HEADER_SIZE, tuple, tupleSize);
-				memset(b->pri + TUPLE_CHUNK_HEADER_SIZE + tupleSize, 0, paddedSize - tupleSize);
+			dataSize += paddedSize;
 
-				dataSize += paddedSize;
+			SetChunkType(b->pri, TC_WHOLE);
+			SetChunkDataSize(b->pri, dataSize - TUPLE_CHUNK_HEADER_SIZE);
 
-				SetChunkType(b->pri, TC_WHOLE);
-				SetChunkDataSize(b->pri, dataSize - TUPLE_CHUNK_HEADER_SIZE);
-				return dataSize;
-			}
+			MemoryContextReset(s_tupSerMemCtxt);
+			return dataSize;
 		}
 
-		/*
-		 * If direct in-line serialization failed then we fallback to chunked
-		 * out-of-line serialization.
-		 */
-		tcItem = getChunkFromCache(&pSerInfo->chunkCache);
-		SetChunkType(tcItem->chunk_data, TC_WHOLE);
-		tcItem->chunk_length = TUPLE_CHUNK_HEADER_SIZE;
-		appendChunkToTCList(tcList, tcItem);
-
-		AssertState(s_tupSerMemCtxt != NULL);
+		if (tcList->p_first == NULL)
+			startChunkList(tcList, &pSerInfo->chunkCache);
 
-		addByteStringToChunkList(tcList, (char *) tuple, memtuple_get_size(tuple), &pSerInfo->chunkCache);
-		addPadding(tcList, &pSerInfo->chunkCache, memtuple_get_size(tuple));
+		addByteStringToChunkList(tcList, (char *) tuple, tupleSize, &pSerInfo->chunkCache);
+		addPadding(tcList, &pSerInfo->chunkCache, tupleSize);
 
 		MemoryContextReset(s_tupSerMemCtxt);
 	}
@@ -496,12 +575,11 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 	{
 		/* HeapTuple that doesn't require detoasting */
 		HeapTuple	tuple = slot->PRIVATE_tts_heaptuple;
+		HeapTupleHeader t_data = tuple->t_data;
 		TupSerHeader tsh;
 		unsigned int datalen;
 		unsigned int nullslen;
 
-		HeapTupleHeader t_data = tuple->t_data;
-
 		datalen = tuple->t_len - t_data->t_hoff;
 		if (HeapTupleHasNulls(tuple))
 			nullslen = BITMAPLEN(HeapTupleHeaderGetNatts(t_data));
@@ -512,52 +590,37 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 		tsh.natts = HeapTupleHeaderGetNatts(t_data);
 		tsh.infomask = t_data->t_infomask;
 
-		if (CandidateForSerializeDirect(targetRoute, b))
+		if (b != NULL && dataSize + tsh.tuplen <= b->prilen)
 		{
-			/*
-			 * Here we first try to in-line serialize the tuple directly into
-			 * buffer.
-			 */
-			if (dataSize + tsh.tuplen <= b->prilen)
-			{
-				unsigned char *pos;
+			unsigned char *pos;
 
-				pos = b->pri + TUPLE_CHUNK_HEADER_SIZE;
+			pos = b->pri + TUPLE_CHUNK_HEADER_SIZE;
 
-				memcpy(pos, (char *) &tsh, sizeof(TupSerHeader));
-				pos += sizeof(TupSerHeader);
+			memcpy(pos, (char *) &tsh, sizeof(TupSerHeader));
+			pos += sizeof(TupSerHeader);
 
-				if (nullslen)
-				{
-					memcpy(pos, (char *) t_data->t_bits, nullslen);
-					pos += nullslen;
-					memset(pos, 0, TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen) - nullslen);
-					pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen) - nullslen;
-				}
+			if (nullslen)
+			{
+				memcpy(pos, (char *) t_data->t_bits, nullslen);
+				pos += nullslen;
+				memset(pos, 0, TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen) - nullslen);
+				pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen) - nullslen;
+			}
 
-				memcpy(pos, (char *) t_data + t_data->t_hoff, datalen);
-				pos += datalen;
-				memset(pos, 0, TYPEALIGN(TUPLE_CHUNK_ALIGN, datalen) - datalen);
-				pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, datalen) - datalen;
+			memcpy(pos, (char *) t_data + t_data->t_hoff, datalen);
+			pos += datalen;
+			memset(pos, 0, TYPEALIGN(TUPLE_CHUNK_ALIGN, datalen) - datalen);
+			pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, datalen) - datalen;
 
-				dataSize += tsh.tuplen;
+			dataSize += tsh.tuplen;
 
-				SetChunkType(b->pri, TC_WHOLE);
-				SetChunkDataSize(b->pri, dataSize - TUPLE_CHUNK_HEADER_SIZE);
-				return dataSize;
-			}
+			SetChunkType(b->pri, TC_WHOLE);
+			SetChunkDataSize(b->pri, dataSize - TUPLE_CHUNK_HEADER_SIZE);
+			return dataSize;
 		}
 
-		/*
-		 * If direct in-line serialization failed then we fallback to chunked
-		 * out-of-line serialization.
-		 */
-		tcItem = getChunkFromCache(&pSerInfo->chunkCache);
-		SetChunkType(tcItem->chunk_data, TC_WHOLE);
-		tcItem->chunk_length = TUPLE_CHUNK_HEADER_SIZE;
-		appendChunkToTCList(tcList, tcItem);
-
-		AssertState(s_tupSerMemCtxt != NULL);
+		if (tcList->p_first == NULL)
+			startChunkList(tcList, &pSerInfo->chunkCache);
 
 		addByteStringToChunkList(tcList, (char *) &tsh, sizeof(TupSerHeader), &pSerInfo->chunkCache);
 
@@ -571,42 +634,379 @@ SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTranspor
 		addPadding(tcList, &pSerInfo->chunkCache, datalen);
 	}
 
+	return 0;
+}
+
+/*
+ *
+ * First try to serialize a tuple directly into a buffer.
+ *
+ * We're called with at least enough space for a tuple-chunk-header.
+ *
+ * Convert a HeapTuple into a byte-sequence, and store it directly
+ * into a chunklist for transmission.
+ */
+int
+SerializeTuple(TupleTableSlot *slot, SerTupInfo *pSerInfo, struct directTransportBuffer *b, TupleChunkList tcList, int16 targetRoute)
+{
+	int			sent;
+
+	AssertArg(pSerInfo != NULL);
+	AssertArg(b != NULL);
+
+	if (!CandidateForSerializeDirect(targetRoute, b))
+		b = NULL;
+
+	if (pSerInfo->tupdesc->natts == 0 && b != NULL)
+	{
+		/* TC_EMTPY is just one chunk */
+		SetChunkType(b->pri, TC_EMPTY);
+		SetChunkDataSize(b->pri, 0);
+
+		return TUPLE_CHUNK_HEADER_SIZE;
+	}
+
+	tcList->p_first = NULL;
+	tcList->p_last = NULL;
+	tcList->num_chunks = 0;
+	tcList->serialized_data_length = 0;
+	tcList->max_chunk_length = Gp_max_tuple_chunk_size;
+
+	sent = serializeTupleToTarget(slot, pSerInfo, b, tcList);
+	if (sent > 0)
+		return sent;
+
+	setChunkListBoundaryTypes(tcList);
+
 	/*
-	 * if we have more than 1 chunk we have to set the chunk types on our
-	 * first chunk and last chunk
+	 * performed "out-of-line" serialization
 	 */
-	if (tcList->num_chunks > 1)
+	return 0;
+}
+
+/*
+ * Serialize a tuple onto the end of a per-route batch, instead of shipping
+ * it right away.
+ *
+ * The batch is built directly as a chunk list, starting with a header that
+ * is filled in by FinishTupleBatch() once the batch is complete.  Each tuple
+ * is written by the same serializeTupleToTarget() that SerializeTuple() uses,
+ * so the receiver deserializes the members of a batch with the same code it
+ * uses for single tuples.  Tuples without attributes can't be batched, since
+ * they're sent as bare TC_EMPTY chunks.
+ */
+void
+SerializeTupleIntoBatch(TupleTableSlot *slot, SerTupInfo *pSerInfo, TupleBatchBuffer *batch)
+{
+	TupleChunkList tcList = &batch->chunks;
+
+	AssertArg(pSerInfo != NULL);
+	AssertArg(batch != NULL);
+	AssertArg(pSerInfo->tupdesc->natts > 0);
+
+	if (batch->ntuples == 0)
 	{
-		TupleChunkListItem first,
-					last;
+		TupSerHeader tsh;
 
-		first = tcList->p_first;
-		last = tcList->p_last;
+		/* Start a new batch, reserving room for the header. */
+		tcList->p_first = NULL;
+		tcList->p_last = NULL;
+		tcList->num_chunks = 0;
+		tcList->serialized_data_length = 0;
+		tcList->max_chunk_length = Gp_max_tuple_chunk_size;
 
-		Assert(first != NULL);
-		Assert(first != last);
-		Assert(last != NULL);
+		startChunkList(tcList, &pSerInfo->chunkCache);
 
-		SetChunkType(first->chunk_data, TC_PARTIAL_START);
-		SetChunkType(last->chunk_data, TC_PARTIAL_END);
+		memset(&tsh, 0, sizeof(TupSerHeader));
+		addByteStringToChunkList(tcList, (char *) &tsh, sizeof(TupSerHeader), &pSerInfo->chunkCache);
+	}
 
-		/*
-		 * any intervening chunks are already set to TC_PARTIAL_MID when
-		 * allocated
-		 */
+	(void) serializeTupleToTarget(slot, pSerInfo, NULL, tcList);
+
+	batch->ntuples++;
+}
+
+/*
+ * Complete a batch built by SerializeTupleIntoBatch(), so that its chunk
+ * list can be handed to the transport.
+ *
+ * The whole batch travels as one (possibly multi-chunk) message, so the
+ * per-message overhead on both ends is paid once per batch instead of once
+ * per tuple.  The caller clears the chunk list and resets the tuple count
+ * once the chunks have been sent.
+ */
+void
+FinishTupleBatch(TupleBatchBuffer *batch)
+{
+	TupleChunkList tcList = &batch->chunks;
+	TupSerHeader tsh;
+
+	AssertArg(batch != NULL);
+	AssertArg(batch->ntuples > 0 && batch->ntuples <= TUPLE_BATCH_MAX_TUPLES);
+
+	tsh.tuplen = tcList->serialized_data_length;
+	tsh.natts = TUPLE_BATCH_MAGIC_NATTS;
+	tsh.infomask = (uint16) batch->ntuples;
+
+	/* The header always fits in the first chunk, see SerializeTupleIntoBatch() */
+	Assert(tcList->p_first->chunk_length >= TUPLE_CHUNK_HEADER_SIZE + sizeof(TupSerHeader));
+	memcpy(tcList->p_first->chunk_data + TUPLE_CHUNK_HEADER_SIZE, &tsh, sizeof(TupSerHeader));
+
+	setChunkListBoundaryTypes(tcList);
+}
+
+/*
+ * Try to replace a batch completed by FinishTupleBatch() with a compressed
+ * copy of it.
+ *
+ * The compressed copy is only used if it saves at least an eighth of the
+ * batch; otherwise the batch is left alone, and false is returned.  The
+ * caller decides how soon to try again on the same route.
+ */
+bool
+CompressTupleBatch(SerTupInfo *pSerInfo, TupleBatchBuffer *batch)
+{
+	TupSerCompressor *comp = pSerInfo->compressor;
+	TupleChunkList tcList = &batch->chunks;
+	TupleChunkListItem tcItem;
+	TupSerHeader tsh;
+	uint32		rawlen;
+	int32		limit;
+	int32		complen;
+	char	   *pos;
+
+	AssertArg(comp != NULL && comp->is_compress);
+	AssertArg(batch->ntuples > 0);
+
+	rawlen = tcList->serialized_data_length;
+	limit = rawlen - rawlen / 8;
+
+	if (comp->buflen < rawlen)
+	{
+		if (comp->rawbuf != NULL)
+			pfree(comp->rawbuf);
+		if (comp->compbuf != NULL)
+			pfree(comp->compbuf);
+		comp->buflen = Max(rawlen, 2 * comp->buflen);
+		comp->rawbuf = MemoryContextAlloc(comp->mcxt, comp->buflen);
+		comp->compbuf = MemoryContextAlloc(comp->mcxt, comp->buflen);
 	}
 
+	/* Flatten the chunks, leaving out the chunk headers. */
+	pos = comp->rawbuf;
+	for (tcItem = tcList->p_first; tcItem != NULL; tcItem = tcItem->p_next)
+	{
+		int			this_len = tcItem->chunk_length - TUPLE_CHUNK_HEADER_SIZE;
+
+		memcpy(pos, tcItem->chunk_data + TUPLE_CHUNK_HEADER_SIZE, this_len);
+		pos += this_len;
+	}
+	Assert(pos - comp->rawbuf == rawlen);
+
 	/*
-	 * performed "out-of-line" serialization
+	 * Give the compressor no more room than we're willing to use, so that it
+	 * can give up early on data that doesn't compress.
 	 */
-	return 0;
+	gp_trycompress((uint8 *) comp->rawbuf, rawlen,
+				   (uint8 *) comp->compbuf, limit,
+				   &complen, comp->funcs[COMPRESSION_COMPRESS], comp->state);
+	if (complen >= limit)
+		return false;
+
+	/* Build the compressed message in place of the batch. */
+	clearTCList(&pSerInfo->chunkCache, tcList);
+
+	tcItem = getChunkFromCache(&pSerInfo->chunkCache);
+	SetChunkType(tcItem->chunk_data, TC_WHOLE);
+	tcItem->chunk_length = TUPLE_CHUNK_HEADER_SIZE;
+	appendChunkToTCList(tcList, tcItem);
+
+	tsh.tuplen = sizeof(TupSerHeader) + sizeof(uint32) + complen;
+	tsh.natts = TUPLE_COMPRESSED_MAGIC_NATTS;
+	tsh.infomask = (uint16) comp->method;
+
+	addByteStringToChunkList(tcList, (char *) &tsh, sizeof(TupSerHeader), &pSerInfo->chunkCache);
+	addByteStringToChunkList(tcList, (char *) &rawlen, sizeof(uint32), &pSerInfo->chunkCache);
+	addByteStringToChunkList(tcList, comp->compbuf, complen, &pSerInfo->chunkCache);
+
+	setChunkListBoundaryTypes(tcList);
+
+	return true;
+}
+
+/*
+ * Replace the contents of 'serData', a batch compressed by
+ * CompressTupleBatch(), with the uncompressed batch.
+ */
+static void
+decompressTupleBatch(SerTupInfo *pSerInfo, StringInfo serData, bool *serDataMustFree)
+{
+	TupSerCompressor *comp = pSerInfo->compressor;
+	TupSerHeader *tshp = (TupSerHeader *) serData->data;
+	TupSerHeader *rawtshp;
+	uint32		rawlen;
+	char	   *raw;
+	int			hdrlen = sizeof(TupSerHeader) + sizeof(uint32);
+
+	if (tshp->tuplen < hdrlen || tshp->tuplen > serData->len)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("compressed tuple batch length %u is invalid for received data length %d",
+						tshp->tuplen, serData->len)));
+
+	if (comp == NULL || comp->is_compress || comp->method != tshp->infomask)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("received tuple batch compressed with unexpected method %d",
+						tshp->infomask)));
+
+	memcpy(&rawlen, serData->data + sizeof(TupSerHeader), sizeof(uint32));
+	if (rawlen < sizeof(TupSerHeader) || rawlen > MaxAllocSize)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("invalid uncompressed tuple batch length %u", rawlen)));
+
+	raw = palloc(rawlen);
+	gp_decompress((uint8 *) serData->data + hdrlen, tshp->tuplen - hdrlen,
+				  (uint8 *) raw, rawlen,
+				  comp->funcs[COMPRESSION_DECOMPRESS], comp->state, 0);
+
+	rawtshp = (TupSerHeader *) raw;
+	if (rawtshp->natts != TUPLE_BATCH_MAGIC_NATTS)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("compressed message does not contain a tuple batch")));
+
+	if (*serDataMustFree)
+		pfree(serData->data);
+
+	serData->data = raw;
+	serData->len = serData->maxlen = rawlen;
+	serData->cursor = 0;
+	*serDataMustFree = true;
 }
 
 /*
- * Reassemble and deserialize a list of tuple chunks, into a tuple.
+ * Deserialize one tuple, starting at 'pos'.  The number of bytes consumed,
+ * including trailing padding, is returned in *serlen.
  */
-GenericTuple
-CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remapper)
+static GenericTuple
+deserializeTuple(SerTupInfo *pSerInfo, char *pos, uint32 *serlen)
+{
+	TupSerHeader *tshp = (TupSerHeader *) pos;
+	GenericTuple tup;
+
+	if ((tshp->tuplen & MEMTUP_LEAD_BIT) != 0)
+	{
+		uint32		tuplen = memtuple_size_from_uint32(tshp->tuplen);
+
+		tup = (GenericTuple) palloc(tuplen);
+		memcpy(tup, pos, tuplen);
+
+		*serlen = TYPEALIGN(TUPLE_CHUNK_ALIGN, tuplen);
+	}
+	else
+	{
+		HeapTuple	htup;
+		HeapTupleHeader t_data;
+		unsigned int datalen;
+		unsigned int nullslen;
+		unsigned int hoff;
+
+		pos += sizeof(TupSerHeader);
+
+		/*
+		 * Tuples with toasted elements should've been converted to MemTuples.
+		 */
+		Assert((tshp->infomask & HEAP_HASEXTERNAL) == 0);
+
+		/* reconstruct lengths of null bitmap and data part */
+		if (tshp->infomask & HEAP_HASNULL)
+			nullslen = BITMAPLEN(tshp->natts);
+		else
+			nullslen = 0;
+
+		if (tshp->tuplen < sizeof(TupSerHeader) + nullslen)
+			ereport(ERROR,
+					(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+					 errmsg("interconnect error: cannot convert chunks to a heap tuple"),
+					 errdetail("Tuple len %d < nullslen %d + headersize (%d)",
+							   tshp->tuplen, nullslen, (int) sizeof(TupSerHeader))));
+
+		datalen = tshp->tuplen - sizeof(TupSerHeader) - TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
+
+		/* determine overhead size of tuple (should match heap_form_tuple) */
+		hoff = offsetof(HeapTupleHeaderData, t_bits) + TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
+		if (tshp->infomask & HEAP_HASOID)
+			hoff += sizeof(Oid);
+		hoff = MAXALIGN(hoff);
+
+		/* Allocate the space in one chunk, like heap_form_tuple */
+		htup = (HeapTuple) palloc(HEAPTUPLESIZE + hoff + datalen);
+		tup = (GenericTuple) htup;
+
+		t_data = (HeapTupleHeader) ((char *) htup + HEAPTUPLESIZE);
+
+		/* make sure unused header fields are zeroed */
+		MemSetAligned(t_data, 0, hoff);
+
+		/* reconstruct the HeapTupleData fields */
+		htup->t_len = hoff + datalen;
+		ItemPointerSetInvalid(&(htup->t_self));
+		htup->t_data = t_data;
+
+		/* reconstruct the HeapTupleHeaderData fields */
+		ItemPointerSetInvalid(&(t_data->t_ctid));
+		HeapTupleHeaderSetNatts(t_data, tshp->natts);
+		t_data->t_infomask = tshp->infomask & ~HEAP_XACT_MASK;
+		t_data->t_infomask |= HEAP_XMIN_INVALID | HEAP_XMAX_INVALID;
+		t_data->t_hoff = hoff;
+
+		if (nullslen)
+		{
+			memcpy((void *) t_data->t_bits, pos, nullslen);
+			pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
+		}
+
+		/*
+		 * does the tuple descriptor expect an OID ? Note: we don't have
+		 * to set the oid itself, just the flag! (see heap_formtuple())
+		 */
+		if (pSerInfo->tupdesc->tdhasoid)	/* else leave infomask = 0 */
+		{
+			t_data->t_infomask |= HEAP_HASOID;
+		}
+
+		/*
+		 * and now the data proper (it would be nice if we could just
+		 * point our caller into our existing buffer in-place, but we'll
+		 * leave that for another day)
+		 */
+		memcpy((char *) t_data + hoff, pos, datalen);
+
+		*serlen = sizeof(TupSerHeader) +
+			TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen) +
+			TYPEALIGN(TUPLE_CHUNK_ALIGN, datalen);
+	}
+
+	return tup;
+}
+
+/*
+ * Reassemble and deserialize a list of tuple chunks, and add the resulting
+ * tuple(s) to 'ready_tuples'.
+ *
+ * A chunk list normally carries a single tuple, but a batching sender packs
+ * many tuples into one list (see SerializeTupleIntoBatch() and
+ * FinishTupleBatch()).  Each tuple is passed through the record type
+ * remapper before it is queued.
+ *
+ * Returns the number of tuples added.  That is zero for the special message
+ * carrying the sender's record type cache.
+ */
+int
+CvtChunksToTuples(TupleChunkList tcList, SerTupInfo *pSerInfo,
+				  TupleRemapper *remapper, htup_fifo ready_tuples)
 {
 	StringInfoData serData;
 	bool		serDataMustFree;
@@ -614,6 +1014,7 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 	TupleChunkListItem firstTcItem;
 	GenericTuple tup;
 	TupleChunkType tcType;
+	int			ntuples;
 
 	AssertArg(tcList != NULL);
 	AssertArg(tcList->p_first != NULL);
@@ -649,8 +1050,10 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 		 * the sender is indicating that there was a row with no
 		 * attributes: return a NULL tuple
 		 */
-		return (GenericTuple)
+		tup = (GenericTuple)
 			heap_form_tuple(pSerInfo->tupdesc, pSerInfo->values, pSerInfo->nulls);
+		htfifo_addtuple(ready_tuples, TRCheckAndRemap(remapper, pSerInfo->tupdesc, tup));
+		return 1;
 	}
 	else if (tcType == TC_PARTIAL_START)
 	{
@@ -730,15 +1133,21 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 				 errmsg("unexpected tuple chunk type %d at beginning of chunk list", tcType)));
 	}
 
-	/* We now have the reassembled data in 'serData'. Deserialize it back to a tuple. */
+	/* A compressed batch is inflated first, and then parsed like any other. */
+	if (serData.len >= sizeof(TupSerHeader))
 	{
-		TupSerHeader *tshp;
-		unsigned int datalen;
-		unsigned int nullslen;
-		unsigned int hoff;
-		HeapTupleHeader t_data;
+		TupSerHeader *tshp = (TupSerHeader *) serData.data;
+
+		if (!(tshp->tuplen & MEMTUP_LEAD_BIT) &&
+			tshp->natts == TUPLE_COMPRESSED_MAGIC_NATTS)
+			decompressTupleBatch(pSerInfo, &serData, &serDataMustFree);
+	}
 
+	/* We now have the reassembled data in 'serData'. Deserialize it back to tuples. */
+	{
+		TupSerHeader *tshp;
 		char	   *pos = serData.data;
+		uint32		serlen;
 
 		tshp = (TupSerHeader *) pos;
 
@@ -754,96 +1163,43 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 
 			TRHandleTypeLists(remapper, typelist);
 
-			/* Free up memory we used. */
-			if (serDataMustFree)
-				pfree(serData.data);
-
-			return NULL;
-		}
-
-		if ((tshp->tuplen & MEMTUP_LEAD_BIT) != 0)
-		{
-			uint32		tuplen = memtuple_size_from_uint32(tshp->tuplen);
-
-			tup = (GenericTuple) palloc(tuplen);
-			memcpy(tup, pos, tuplen);
-
-			pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, tuplen);
+			ntuples = 0;
 		}
-		else
+		else if (!(tshp->tuplen & MEMTUP_LEAD_BIT) &&
+				 tshp->natts == TUPLE_BATCH_MAGIC_NATTS)
 		{
-			HeapTuple htup;
-
-			pos += sizeof(TupSerHeader);
-
-			/*
-			 * Tuples with toasted elements should've been converted to MemTuples.
-			 */
-			Assert((tshp->infomask & HEAP_HASEXTERNAL) == 0);
-
-			/* reconstruct lengths of null bitmap and data part */
-			if (tshp->infomask & HEAP_HASNULL)
-				nullslen = BITMAPLEN(tshp->natts);
-			else
-				nullslen = 0;
+			/* a batch of tuples packed back-to-back */
+			char	   *end = pos + tshp->tuplen;
+			int			i;
 
-			if (tshp->tuplen < sizeof(TupSerHeader) + nullslen)
+			if (tshp->tuplen > serData.len)
 				ereport(ERROR,
-						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-						 errmsg("interconnect error: cannot convert chunks to a heap tuple"),
-						 errdetail("Tuple len %d < nullslen %d + headersize (%d)",
-								   tshp->tuplen, nullslen, (int) sizeof(TupSerHeader))));
-
-			datalen = tshp->tuplen - sizeof(TupSerHeader) - TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
-
-			/* determine overhead size of tuple (should match heap_form_tuple) */
-			hoff = offsetof(HeapTupleHeaderData, t_bits) + TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
-			if (tshp->infomask & HEAP_HASOID)
-				hoff += sizeof(Oid);
-			hoff = MAXALIGN(hoff);
-
-			/* Allocate the space in one chunk, like heap_form_tuple */
-			htup = (HeapTuple) palloc(HEAPTUPLESIZE + hoff + datalen);
-			tup = (GenericTuple) htup;
-
-			t_data = (HeapTupleHeader) ((char *) htup + HEAPTUPLESIZE);
-
-			/* make sure unused header fields are zeroed */
-			MemSetAligned(t_data, 0, hoff);
-
-			/* reconstruct the HeapTupleData fields */
-			htup->t_len = hoff + datalen;
-			ItemPointerSetInvalid(&(htup->t_self));
-			htup->t_data = t_data;
+						(errcode(ERRCODE_PROTOCOL_VIOLATION),
+						 errmsg("tuple batch length %u exceeds received data length %d",
+								tshp->tuplen, serData.len)));
 
-			/* reconstruct the HeapTupleHeaderData fields */
-			ItemPointerSetInvalid(&(t_data->t_ctid));
-			HeapTupleHeaderSetNatts(t_data, tshp->natts);
-			t_data->t_infomask = tshp->infomask & ~HEAP_XACT_MASK;
-			t_data->t_infomask |= HEAP_XMIN_INVALID | HEAP_XMAX_INVALID;
-			t_data->t_hoff = hoff;
+			ntuples = tshp->infomask;
+			pos += sizeof(TupSerHeader);
 
-			if (nullslen)
+			for (i = 0; i < ntuples; i++)
 			{
-				memcpy((void *) t_data->t_bits, pos, nullslen);
-				pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
-			}
+				if (pos >= end)
+					ereport(ERROR,
+							(errcode(ERRCODE_PROTOCOL_VIOLATION),
+							 errmsg("tuple batch ended after %d of %d tuples", i, ntuples)));
 
-			/*
-			 * does the tuple descriptor expect an OID ? Note: we don't have
-			 * to set the oid itself, just the flag! (see heap_formtuple())
-			 */
-			if (pSerInfo->tupdesc->tdhasoid)	/* else leave infomask = 0 */
-			{
-				t_data->t_infomask |= HEAP_HASOID;
+				tup = deserializeTuple(pSerInfo, pos, &serlen);
+				pos += serlen;
+
+				htfifo_addtuple(ready_tuples, TRCheckAndRemap(remapper, pSerInfo->tupdesc, tup));
 			}
+		}
+		else
+		{
+			tup = deserializeTuple(pSerInfo, pos, &serlen);
+			htfifo_addtuple(ready_tuples, TRCheckAndRemap(remapper, pSerInfo->tupdesc, tup));
 
-			/*
-			 * and now the data proper (it would be nice if we could just
-			 * point our caller into our existing buffer in-place, but we'll
-			 * leave that for another day)
-			 */
-			memcpy((char *) t_data + hoff, pos, datalen);
+			ntuples = 1;
 		}
 	}
 
@@ -851,5 +1207,5 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 	if (serDataMustFree)
 		pfree(serData.data);
 
-	return tup;
+	return ntuples;
 }
@@ -23,6 +23,11 @@
 #include <sys/stat.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <catalog/catalog.h>
 
 #include "access/heapam.h"
@@ -142,6 +147,105 @@ if (1) \
 	goto not_end_of_copy; \
 } else ((void) 0)
 
+/*
+ * The bytes that the COPY parsing loops have to stop at: line ends, quotes,
+ * escapes and delimiters, depending on the loop and format.  Everything else
+ * is copied through as is, so CopyScanSpecial() skips over runs of ordinary
+ * bytes 16 or 32 at a time where the compiler targets SSE2 or AVX2.
+ */
+#define COPY_SCAN_MAX_CHARS 4
+
+typedef struct CopyScanSet
+{
+	char		chars[COPY_SCAN_MAX_CHARS];	/* unused slots repeat chars[0] */
+	bool		highbit;		/* also stop at bytes with the high bit set */
+} CopyScanSet;
+
+static void
+CopyScanSetInit(CopyScanSet *set, const char *chars, int nchars, bool highbit)
+{
+	int			i;
+
+	Assert(nchars > 0 && nchars <= COPY_SCAN_MAX_CHARS);
+
+	for (i = 0; i < COPY_SCAN_MAX_CHARS; i++)
+		set->chars[i] = chars[i < nchars ? i : 0];
+	set->highbit = highbit;
+}
+
+/*
+ * Return the offset of the first byte in s[0 .. len - 1] that is in 'set',
+ * or len if there is none.
+ */
+static inline int
+CopyScanSpecial(const char *s, int len, const CopyScanSet *set)
+{
+	int			i = 0;
+
+#if defined(__AVX2__) && defined(__GNUC__)
+	if (len >= 32)
+	{
+		__m256i		c0 = _mm256_set1_epi8(set->chars[0]);
+		__m256i		c1 = _mm256_set1_epi8(set->chars[1]);
+		__m256i		c2 = _mm256_set1_epi8(set->chars[2]);
+		__m256i		c3 = _mm256_set1_epi8(set->chars[3]);
+
+		for (; i + 32 <= len; i += 32)
+		{
+			__m256i		v = _mm256_loadu_si256((const __m256i *) (s + i));
+			__m256i		m;
+			uint32		mask;
+
+			m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, c0),
+												_mm256_cmpeq_epi8(v, c1)),
+								_mm256_or_si256(_mm256_cmpeq_epi8(v, c2),
+												_mm256_cmpeq_epi8(v, c3)));
+			if (set->highbit)
+				m = _mm256_or_si256(m, v);
+			mask = (uint32) _mm256_movemask_epi8(m);
+			if (mask != 0)
+				return i + __builtin_ctz(mask);
+		}
+	}
+#elif defined(__SSE2__) && defined(__GNUC__)
+	if (len >= 16)
+	{
+		__m128i		c0 = _mm_set1_epi8(set->chars[0]);
+		__m128i		c1 = _mm_set1_epi8(set->chars[1]);
+		__m128i		c2 = _mm_set1_epi8(set->chars[2]);
+		__m128i		c3 = _mm_set1_epi8(set->chars[3]);
+
+		for (; i + 16 <= len; i += 16)
+		{
+			__m128i		v = _mm_loadu_si128((const __m128i *) (s + i));
+			__m128i		m;
+			uint32		mask;
+
+			m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, c0),
+										  _mm_cmpeq_epi8(v, c1)),
+							 _mm_or_si128(_mm_cmpeq_epi8(v, c2),
+										  _mm_cmpeq_epi8(v, c3)));
+			if (set->highbit)
+				m = _mm_or_si128(m, v);
+			mask = (uint32) _mm_movemask_epi8(m);
+			if (mask != 0)
+				return i + __builtin_ctz(mask);
+		}
+	}
+#endif
+
+	for (; i < len; i++)
+	{
+		char		c = s[i];
+
+		if (c == set->chars[0] || c == set->chars[1] ||
+			c == set->chars[2] || c == set->chars[3] ||
+			(set->highbit && IS_HIGHBIT_SET(c)))
+			break;
+	}
+	return i;
+}
+
 static const char BinarySignature[11] = "PGCOPY\n\377\r\n\0";
 
 
@@ -6161,15 +6265,27 @@ CopyReadLineText(CopyState cstate)
 				last_was_esc = false;
 	char		quotec = '\0';
 	char		escapec = '\0';
+	CopyScanSet scanset;
 
 	if (cstate->csv_mode)
 	{
+		char		special[4];
+
 		quotec = cstate->quote[0];
 		escapec = cstate->escape[0];
 		/* ignore special escape processing if it's the same as quotec */
 		if (quotec == escapec)
 			escapec = '\0';
+
+		special[0] = '\n';
+		special[1] = '\r';
+		special[2] = quotec;
+		special[3] = escapec;
+		CopyScanSetInit(&scanset, special, escapec ? 4 : 3,
+						cstate->encoding_embeds_ascii);
 	}
+	else
+		CopyScanSetInit(&scanset, "\n\r\\", 3, cstate->encoding_embeds_ascii);
 
 	mblen_str[1] = '\0';
 
@@ -6238,6 +6354,27 @@ CopyReadLineText(CopyState cstate)
 			need_data = false;
 		}
 
+		/*
+		 * Skip over the run of bytes that can't end the line or change the
+		 * CSV state.  In CSV mode, the first byte of a line is looked at in
+		 * any case, for the \. end marker.
+		 */
+		if (!cstate->csv_mode || !first_char_in_line)
+		{
+			int			skip;
+
+			skip = CopyScanSpecial(copy_raw_buf + raw_buf_ptr,
+								   copy_buf_len - raw_buf_ptr, &scanset);
+			if (skip > 0)
+			{
+				raw_buf_ptr += skip;
+				last_was_esc = false;
+				first_char_in_line = false;
+				if (raw_buf_ptr >= copy_buf_len)
+					continue;
+			}
+		}
+
 		/* OK to fetch a character */
 		prev_raw_ptr = raw_buf_ptr;
 		c = copy_raw_buf[raw_buf_ptr++];
@@ -6587,6 +6724,8 @@ CopyReadAttributesText(CopyState cstate, int stop_processing_at_field)
 	char	   *output_ptr;
 	char	   *cur_ptr;
 	char	   *line_end_ptr;
+	CopyScanSet scanset;
+	char		special[2];
 
 	/*
 	 * We need a special case for zero-column tables: check that the input
@@ -6618,6 +6757,10 @@ CopyReadAttributesText(CopyState cstate, int stop_processing_at_field)
 	cur_ptr = cstate->line_buf.data + cstate->line_buf.cursor;
 	line_end_ptr = cstate->line_buf.data + cstate->line_buf.len;
 
+	special[0] = delimc;
+	special[1] = escapec;
+	CopyScanSetInit(&scanset, special, 2, false);
+
 	/* Outer loop iterates over fields */
 	fieldno = 0;
 	for (;;)
@@ -6663,6 +6806,16 @@ CopyReadAttributesText(CopyState cstate, int stop_processing_at_field)
 		for (;;)
 		{
 			char		c;
+			int			run;
+
+			/* Copy the bytes up to the next delimiter or escape as they are */
+			run = CopyScanSpecial(cur_ptr, line_end_ptr - cur_ptr, &scanset);
+			if (run > 0)
+			{
+				memcpy(output_ptr, cur_ptr, run);
+				output_ptr += run;
+				cur_ptr += run;
+			}
 
 			end_ptr = cur_ptr;
 			if (cur_ptr >= line_end_ptr)
@@ -6835,6 +6988,9 @@ CopyReadAttributesCSV(CopyState cstate, int stop_processing_at_field)
 	char	   *output_ptr;
 	char	   *cur_ptr;
 	char	   *line_end_ptr;
+	CopyScanSet unquoted_set;
+	CopyScanSet quoted_set;
+	char		special[2];
 
 	/*
 	 * We need a special case for zero-column tables: check that the input
@@ -6866,6 +7022,12 @@ CopyReadAttributesCSV(CopyState cstate, int stop_processing_at_field)
 	cur_ptr = cstate->line_buf.data + cstate->line_buf.cursor;
 	line_end_ptr = cstate->line_buf.data + cstate->line_buf.len;
 
+	special[0] = delimc;
+	special[1] = quotec;
+	CopyScanSetInit(&unquoted_set, special, 2, false);
+	special[0] = escapec;
+	CopyScanSetInit(&quoted_set, special, 2, false);
+
 	/* Outer loop iterates over fields */
 	fieldno = 0;
 	for (;;)
@@ -6911,6 +7073,17 @@ CopyReadAttributesCSV(CopyState cstate, int stop_processing_at_field)
 			/* Not in quote */
 			for (;;)
 			{
+				int			run;
+
+				run = CopyScanSpecial(cur_ptr, line_end_ptr - cur_ptr,
+									  &unquoted_set);
+				if (run > 0)
+				{
+					memcpy(output_ptr, cur_ptr, run);
+					output_ptr += run;
+					cur_ptr += run;
+				}
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					goto endfield;
@@ -6934,6 +7107,17 @@ CopyReadAttributesCSV(CopyState cstate, int stop_processing_at_field)
 			/* In quote */
 			for (;;)
 			{
+				int			run;
+
+				run = CopyScanSpecial(cur_ptr, line_end_ptr - cur_ptr,
+									  &quoted_set);
+				if (run > 0)
+				{
+					memcpy(output_ptr, cur_ptr, run);
+					output_ptr += run;
+					cur_ptr += run;
+				}
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					ereport(ERROR,
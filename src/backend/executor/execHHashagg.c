@@ -27,6 +27,7 @@
 #include "executor/instrument.h"            /* Instrumentation */
 #include "executor/execHHashagg.h"
 #include "storage/buffile.h"
+#include "storage/bufmgr.h"
 #include "utils/datum.h"
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
@@ -111,6 +112,14 @@ typedef enum InputRecordType
 #define BUCKET_IDX(hashtable, hashkey) \
 		(((hashkey) >> (hashtable)->pshift) & ((hashtable)->nbuckets - 1))
 
+/*
+ * An open-addressing table is doubled when it's 3/4 full. If there's no
+ * memory to do that, it's filled up to 7/8 before spilling, since probe
+ * sequences get long quickly after that.
+ */
+#define OA_GROW_FILL(nslots) ((nslots) - Max((nslots) / 4, 1))
+#define OA_MAX_FILL(nslots) ((nslots) - Max((nslots) / 8, 1))
+
 #define LOG2(x) (ceil(log((x)) / log(2)))
 
 /* Methods that handle batch files */
@@ -131,6 +140,9 @@ static uint32 calc_hash_value(AggState* aggstate, TupleTableSlot *inputslot);
 static void spill_hash_table(AggState *aggstate);
 static void expand_hash_table(AggState *aggstate);
 static void init_agg_hash_iter(HashAggTable* ht);
+static HashAggEntry *lookup_agg_hash_slot(AggState *aggstate, void *input_record,
+										 InputRecordType input_type, int32 input_size,
+										 uint32 hashkey, bool *p_isnew);
 static HashAggEntry *lookup_agg_hash_entry(AggState *aggstate, void *input_record,
 										   InputRecordType input_type, int32 input_size,
 										   uint32 hashkey, bool *p_isnew);
@@ -138,6 +150,7 @@ static void agg_hash_table_stat_upd(HashAggTable *ht);
 static void reset_agg_hash_table(AggState *aggstate, int64 nentries);
 static bool agg_hash_reload(AggState *aggstate);
 static void reCalcNumberBatches(HashAggTable *hashtable, SpillFile *spill_file);
+static void prefetch_next_batch(HashAggTable *hashtable);
 static inline void *mpool_cxt_alloc(void *manager, Size len);
 
 static inline void *mpool_cxt_alloc(void *manager, Size len)
@@ -433,6 +446,97 @@ setGroupAggs(HashAggTable *hashtable, HashAggEntry *entry)
 	}
 }
 
+/*
+ * Function: agg_hash_entry_matches
+ *
+ * Do the grouping keys of the input record equal those of the entry?
+ * NULLs match each other.
+ */
+static bool
+agg_hash_entry_matches(AggState *aggstate, HashAggEntry *entry,
+					   void *input_record, InputRecordType input_type)
+{
+	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
+	Agg *agg = (Agg*)aggstate->ss.ps.plan;
+	MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
+	int i;
+	bool match = true;
+
+	for (i = 0; match && i < agg->numCols; i++)
+	{
+		AttrNumber	att = agg->grpColIdx[i];
+		Datum input_datum = 0;
+		Datum entry_datum = 0;
+		bool input_isNull = false;
+		bool entry_isNull = false;
+			
+		switch(input_type)
+		{
+			case INPUT_RECORD_TUPLE:
+				input_datum = slot_getattr((TupleTableSlot *)input_record, att, &input_isNull);
+				break;
+			case INPUT_RECORD_GROUP_AND_AGGS:
+				input_datum = memtuple_getattr((MemTuple)input_record, mt_bind, att, &input_isNull);
+				break;
+			default:
+				elog(ERROR, "invalid record type %d", input_type);
+		}
+
+		entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
+
+		if ( !input_isNull && !entry_isNull &&
+			 (DatumGetBool(FunctionCall2(&aggstate->phase->eqfunctions[i],
+										 input_datum,
+										 entry_datum)) ) )
+			continue; /* Both non-NULL and equal. */
+		match = (input_isNull && entry_isNull);/* NULLs match in group keys. */
+	}
+
+	return match;
+}
+
+/*
+ * Function: makeHashAggEntry
+ *
+ * Create an entry for the input record, or return NULL if there isn't
+ * enough memory for it.
+ */
+static HashAggEntry *
+makeHashAggEntry(AggState *aggstate, void *input_record,
+				 InputRecordType input_type, int32 input_size,
+				 uint32 hashkey)
+{
+	switch(input_type)
+	{
+		case INPUT_RECORD_TUPLE:
+			return makeHashAggEntryForInput(aggstate, (TupleTableSlot *)input_record, hashkey);
+		case INPUT_RECORD_GROUP_AND_AGGS:
+			return makeHashAggEntryForGroup(aggstate, input_record, input_size, hashkey);
+		default:
+			elog(ERROR, "invalid record type %d", input_type);
+	}
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * Open-addressing slot navigation. The slot a hash value maps to is picked
+ * like the bucket of the chained table, so that spilling can still assign
+ * groups to batch files by the same bits of the hash value.
+ */
+static inline HashAggSlot *
+probe_agg_hash_slot(HashAggTable *hashtable, uint32 hashkey)
+{
+	return &hashtable->slots[BUCKET_IDX(hashtable, hashkey)];
+}
+
+static inline HashAggSlot *
+next_agg_hash_slot(HashAggTable *hashtable, HashAggSlot *slot)
+{
+	if (++slot == hashtable->slots + hashtable->nbuckets)
+		slot = hashtable->slots;
+	return slot;
+}
+
 /*
  * Function: lookup_agg_hash_entry
  *
@@ -458,18 +562,18 @@ lookup_agg_hash_entry(AggState *aggstate,
 {
 	HashAggEntry *entry;
 	HashAggTable *hashtable = aggstate->hhashtable;
-	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
 	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
-	Agg *agg = (Agg*)aggstate->ss.ps.plan;
 	MemoryContext oldcxt;
 	unsigned int bucket_idx;
 	uint64 bloomval;			/* bloom filter value */
-   
-	Assert(mt_bind != NULL);
 
 	if (p_isnew != NULL)
 		*p_isnew = false;
 
+	if (hashtable->slots != NULL)
+		return lookup_agg_hash_slot(aggstate, input_record, input_type,
+									input_size, hashkey, p_isnew);
+
 	oldcxt = MemoryContextSwitchTo(tmpcontext->ecxt_per_tuple_memory);
 
 	bucket_idx = BUCKET_IDX(hashtable, hashkey);
@@ -485,48 +589,9 @@ lookup_agg_hash_entry(AggState *aggstate,
 	 */
 	while (entry != NULL)
 	{
-		MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
-		int i;
-		bool match = true;
-
-		if (hashkey != entry->hashvalue)
-		{
-			entry = entry->next;
-			continue;
-		}
-		
-		for (i = 0; match && i < agg->numCols; i++)
-		{
-			AttrNumber	att = agg->grpColIdx[i];
-			Datum input_datum = 0;
-			Datum entry_datum = 0;
-			bool input_isNull = false;
-			bool entry_isNull = false;
-				
-			switch(input_type)
-			{
-				case INPUT_RECORD_TUPLE:
-					input_datum = slot_getattr((TupleTableSlot *)input_record, att, &input_isNull);
-					break;
-				case INPUT_RECORD_GROUP_AND_AGGS:
-					input_datum = memtuple_getattr((MemTuple)input_record, mt_bind, att, &input_isNull);
-					break;
-				default:
-					elog(ERROR, "invalid record type %d", input_type);
-			}
-
-			entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
-
-			if ( !input_isNull && !entry_isNull &&
-				 (DatumGetBool(FunctionCall2(&aggstate->phase->eqfunctions[i],
-											 input_datum,
-											 entry_datum)) ) )
-				continue; /* Both non-NULL and equal. */
-			match = (input_isNull && entry_isNull);/* NULLs match in group keys. */
-		}
-		
 		/* Break if found an existing matching entry. */
-		if (match)
+		if (hashkey == entry->hashvalue &&
+			agg_hash_entry_matches(aggstate, entry, input_record, input_type))
 			break;
 
 		entry = entry->next;
@@ -535,17 +600,8 @@ lookup_agg_hash_entry(AggState *aggstate,
 	if (entry == NULL)
 	{
 		/* Entry not found! Create a new matching entry. */
-		switch(input_type)
-		{
-			case INPUT_RECORD_TUPLE:
-				entry = makeHashAggEntryForInput(aggstate, (TupleTableSlot *)input_record, hashkey);
-				break;
-			case INPUT_RECORD_GROUP_AND_AGGS:
-				entry = makeHashAggEntryForGroup(aggstate, input_record, input_size, hashkey);
-				break;
-			default:
-				elog(ERROR, "invalid record type %d", input_type);
-		}
+		entry = makeHashAggEntry(aggstate, input_record, input_type,
+								 input_size, hashkey);
 			
 		if (entry != NULL)
 		{
@@ -577,6 +633,75 @@ lookup_agg_hash_entry(AggState *aggstate,
 	return entry;
 }
 
+/*
+ * Function: lookup_agg_hash_slot
+ *
+ * lookup_agg_hash_entry() for an open-addressing hash table. Groups are
+ * placed by linear probing from the slot their hash value maps to. The
+ * table is doubled when it gets OA_GROW_FILL full; if it can't grow, no
+ * new groups are added past OA_MAX_FILL, and NULL is returned so that the
+ * caller spills, like when it runs out of memory for groups.
+ */
+static HashAggEntry *
+lookup_agg_hash_slot(AggState *aggstate,
+					 void *input_record,
+					 InputRecordType input_type, int32 input_size,
+					 uint32 hashkey, bool *p_isnew)
+{
+	HashAggEntry *entry = NULL;
+	HashAggTable *hashtable = aggstate->hhashtable;
+	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
+	MemoryContext oldcxt;
+	HashAggSlot *slot;
+
+	oldcxt = MemoryContextSwitchTo(tmpcontext->ecxt_per_tuple_memory);
+
+	slot = probe_agg_hash_slot(hashtable, hashkey);
+	while (slot->entry != NULL)
+	{
+		if (slot->hashvalue == hashkey &&
+			agg_hash_entry_matches(aggstate, slot->entry, input_record, input_type))
+		{
+			entry = slot->entry;
+			break;
+		}
+		slot = next_agg_hash_slot(hashtable, slot);
+	}
+
+	if (entry == NULL)
+	{
+		if (hashtable->expandable &&
+			hashtable->num_entries >= OA_GROW_FILL(hashtable->nbuckets))
+		{
+			expand_hash_table(aggstate);
+
+			/* The empty slot found above has moved */
+			slot = probe_agg_hash_slot(hashtable, hashkey);
+			while (slot->entry != NULL)
+				slot = next_agg_hash_slot(hashtable, slot);
+		}
+
+		if (hashtable->num_entries < OA_MAX_FILL(hashtable->nbuckets))
+			entry = makeHashAggEntry(aggstate, input_record, input_type,
+									 input_size, hashkey);
+
+		if (entry != NULL)
+		{
+			slot->hashvalue = hashkey;
+			slot->entry = entry;
+
+			++hashtable->num_ht_groups;
+			++hashtable->num_entries;
+
+			*p_isnew = true; /* created a new entry */
+		}
+	}
+
+	(void) MemoryContextSwitchTo(oldcxt);
+
+	return entry;
+}
+
 /*
  * Compute HHashTable entry size
  *
@@ -606,6 +731,8 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 					  HashAggTableSizes   *out_hats)
 {
 	double entrysize, nbuckets, nentries;
+	/* An open-addressing table holds at most one group per slot */
+	int groups_per_bucket = (gp_hashagg_open_addressing ? 1 : gp_hashagg_groups_per_bucket);
 
 	/* Assume we don't need to spill */
 	bool expectSpill = false;
@@ -614,7 +741,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	Assert(ngroups >= 0);
 
 	/* Estimate the overhead per entry in the hash table */
-	entrysize = entrywidth + OVERHEAD_PER_BUCKET / (double) gp_hashagg_groups_per_bucket;
+	entrysize = entrywidth + OVERHEAD_PER_BUCKET / (double) groups_per_bucket;
 
 	elog(HHA_MSG_LVL, "HashAgg: ngroups = %g, memquota = %g, entrysize = %g",
 		 ngroups, memquota, entrysize);
@@ -652,7 +779,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	nentries = Min(ngroups, nentries);
 
 	/* but at least a few hash entries as required */
-	nentries = Max(nentries, gp_hashagg_groups_per_bucket);
+	nentries = Max(nentries, groups_per_bucket);
 	entries_mem = nentries * entrywidth;
 
 	/*
@@ -668,7 +795,7 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 	memquota -= entries_mem;
 
 	/* Determine the number of buckets */
-	nbuckets = ceil(nentries / gp_hashagg_groups_per_bucket);
+	nbuckets = ceil(nentries / groups_per_bucket);
 
 	/* Use only as many allowed by memory */
 	nbuckets = Min(nbuckets, floor(memquota / OVERHEAD_PER_BUCKET));
@@ -702,8 +829,8 @@ calcHashAggTableSizes(double memquota,	/* Memory quota in bytes. */
 		elog(HHA_MSG_LVL, "HashAgg: not enough memory for the hash table parameters chosen:");
 		elog(HHA_MSG_LVL, "HashAgg: nbuckets = %d, nentries = %d, nbatches = %d",
 			 (int)nbuckets, (int)nentries, (int)nbatches);
-		elog(HHA_MSG_LVL, "HashAgg: ngroups = %d, gp_hashagg_groups_per_bucket = %d",
-			 (int)ngroups, (int)gp_hashagg_groups_per_bucket);
+		elog(HHA_MSG_LVL, "HashAgg: ngroups = %d, groups_per_bucket = %d",
+			 (int)ngroups, (int)groups_per_bucket);
 		return false;
 	}
 
@@ -844,8 +971,17 @@ create_agg_hash_table(AggState *aggstate)
 
 	/* Initialize the hash buckets */
 	hashtable->nbuckets = hashtable->hats.nbuckets;
-	hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
-	hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+	if (gp_hashagg_open_addressing)
+	{
+		StaticAssertStmt(sizeof(HashAggSlot) <= OVERHEAD_PER_BUCKET,
+						 "open-addressing slots must fit in the memory accounted per bucket");
+		hashtable->slots = (HashAggSlot *) palloc0(hashtable->nbuckets * sizeof(HashAggSlot));
+	}
+	else
+	{
+		hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
+		hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+	}
 
 	hashtable->pshift = 0;
 	hashtable->expandable = true;
@@ -1390,6 +1526,10 @@ spill_hash_table(AggState *aggstate)
 			CheckSendPlanStateGpmonPkt(&aggstate->ss.ps);
 		}
 
+		/* Open-addressing tables are written below, in one pass */
+		if (hashtable->slots != NULL)
+			continue;
+
 		for (bucket_no = file_no; bucket_no < hashtable->nbuckets;
 			 bucket_no += spill_set->num_spill_files)
 		{
@@ -1421,6 +1561,33 @@ spill_hash_table(AggState *aggstate)
 		}
 	}
 
+	/*
+	 * A group's slot may not be the one its hash value maps to, so pick the
+	 * file from the hash value, the same way as for the bucket of a chained
+	 * table. The files are buffered, so writing them in turns is fine.
+	 */
+	if (hashtable->slots != NULL)
+	{
+		for (bucket_no = 0; bucket_no < hashtable->nbuckets; bucket_no++)
+		{
+			HashAggSlot *slot = &hashtable->slots[bucket_no];
+			int32 written_bytes;
+
+			if (slot->entry == NULL)
+				continue;
+
+			file_no = BUCKET_IDX(hashtable, slot->hashvalue) % spill_set->num_spill_files;
+			spill_file = &spill_set->spill_files[file_no];
+
+			written_bytes = writeHashEntry(aggstate, spill_file->file_info, slot->entry);
+			spill_file->file_info->ntuples++;
+			spill_file->file_info->total_bytes += written_bytes;
+
+			hashtable->num_spill_groups++;
+		}
+		MemSet(hashtable->slots, 0, hashtable->nbuckets * sizeof(HashAggSlot));
+	}
+
 	/* Reset the buffer */
 	mpool_reset(hashtable->group_buf);
 
@@ -1476,6 +1643,37 @@ expand_hash_table(AggState *aggstate)
 
 	Assert(GET_TOTAL_USED_SIZE(hashtable) < hashtable->max_mem);
 
+	if (hashtable->slots != NULL)
+	{
+		HashAggSlot *old_slots = hashtable->slots;
+		unsigned slot_idx;
+
+		hashtable->slots = (HashAggSlot *)
+			MemoryContextAllocZero(GetMemoryChunkContext(old_slots),
+								   hashtable->nbuckets * sizeof(HashAggSlot));
+
+		for (slot_idx = 0; slot_idx < old_nbuckets; slot_idx++)
+		{
+			HashAggSlot *slot;
+
+			if (old_slots[slot_idx].entry == NULL)
+				continue;
+
+			slot = probe_agg_hash_slot(hashtable, old_slots[slot_idx].hashvalue);
+			while (slot->entry != NULL)
+				slot = next_agg_hash_slot(hashtable, slot);
+			*slot = old_slots[slot_idx];
+#ifdef USE_ASSERT_CHECKING
+			++nentries;
+#endif
+		}
+		pfree(old_slots);
+
+		hashtable->num_expansions++;
+		Assert(nentries == hashtable->num_entries);
+		return;
+	}
+
 	hashtable->buckets = (HashAggBucket *) repalloc(hashtable->buckets,
 		hashtable->nbuckets * sizeof(HashAggBucket));
 	hashtable->bloom =  (uint64 *) repalloc(hashtable->bloom,
@@ -1679,6 +1877,26 @@ agg_hash_table_stat_upd(HashAggTable *hashtable)
 {
 	unsigned int	i;
 
+	/*
+	 * For an open-addressing table, count the number of slots probed to find
+	 * each group instead.
+	 */
+	if (hashtable->slots != NULL)
+	{
+		for (i = 0; i < hashtable->nbuckets; i++)
+		{
+			HashAggSlot *slot = &hashtable->slots[i];
+
+			if (slot->entry != NULL)
+				cdbexplain_agg_upd(&hashtable->chainlength,
+								   ((i - BUCKET_IDX(hashtable, slot->hashvalue)) &
+									(hashtable->nbuckets - 1)) + 1,
+								   i);
+		}
+		hashtable->total_buckets += hashtable->nbuckets;
+		return;
+	}
+
 	for (i = 0; i < hashtable->nbuckets; i++)
 	{
 		HashAggEntry   *entry = hashtable->buckets[i];
@@ -1703,7 +1921,9 @@ agg_hash_table_stat_upd(HashAggTable *hashtable)
  * Initialize the HashAggTable's (one and only) entry iterator. */
 void init_agg_hash_iter(HashAggTable* hashtable)
 {
-	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
+	Assert( hashtable != NULL &&
+			(hashtable->buckets != NULL || hashtable->slots != NULL) &&
+			hashtable->nbuckets > 0 );
 	
 	hashtable->curr_bucket_idx = -1;
 	hashtable->next_entry = NULL;
@@ -1726,7 +1946,9 @@ agg_hash_iter(AggState *aggstate)
 	SpillSet *spill_set = hashtable->spill_set;
 	MemoryContext oldcxt;
 
-	Assert( hashtable != NULL && hashtable->buckets != NULL && hashtable->nbuckets > 0 );
+	Assert( hashtable != NULL &&
+			(hashtable->buckets != NULL || hashtable->slots != NULL) &&
+			hashtable->nbuckets > 0 );
 
 	if (hashtable->curr_spill_file != NULL)
 		spill_set = hashtable->curr_spill_file->spill_set;
@@ -1736,7 +1958,10 @@ agg_hash_iter(AggState *aggstate)
 	while (entry == NULL &&
 		   hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
 	{
-		entry = hashtable->buckets[hashtable->curr_bucket_idx];
+		if (hashtable->slots != NULL)
+			entry = hashtable->slots[hashtable->curr_bucket_idx].entry;
+		else
+			entry = hashtable->buckets[hashtable->curr_bucket_idx];
 		if (entry != NULL)
 		{
 			Assert(entry->is_primodial);
@@ -2003,6 +2228,12 @@ agg_hash_reload(AggState *aggstate)
 		hashtable->mem_wanted += 
 			((hashtable->mem_for_metadata - start_mem_for_metadata) +
 			 GET_BUFFER_SIZE(hashtable));
+
+		/*
+		 * All groups of this batch are in memory now, and emitting them
+		 * needs no I/O. Let the disk work on the next batch meanwhile.
+		 */
+		prefetch_next_batch(hashtable);
 	}
 
 	if (!hashtable->is_spilling && aggstate->ss.ps.instrument && aggstate->ss.ps.instrument->need_cdb)
@@ -2072,6 +2303,48 @@ reCalcNumberBatches(HashAggTable *hashtable, SpillFile *spill_file)
 	hashtable->hats.nbatches = nbatches;
 }
 
+/*
+ * Function: prefetch_next_batch
+ *
+ * Start reading the batch file that agg_hash_next_pass() will pick after
+ * the current one, in the background. That is the next non-empty file
+ * after the current one in its spill set, or failing that, in an ancestor
+ * spill set. A batch is meant to fit in the operator's memory, so that's
+ * how much of the file is read ahead.
+ */
+static void
+prefetch_next_batch(HashAggTable *hashtable)
+{
+	SpillFile *spill_file = hashtable->curr_spill_file;
+
+	if (target_prefetch_pages <= 0)
+		return;
+
+	while (spill_file != NULL)
+	{
+		SpillSet *spill_set = spill_file->parent_spill_set;
+		int file_no;
+
+		for (file_no = spill_file->index_in_parent + 1;
+			 file_no < spill_set->num_spill_files;
+			 file_no++)
+		{
+			BatchFileInfo *file_info = spill_set->spill_files[file_no].file_info;
+
+			if (file_info != NULL && file_info->ntuples > 0 &&
+				file_info->wfile != NULL)
+			{
+				elog(HHA_MSG_LVL, "HashAgg: prefetching %d level batch file %d",
+					 spill_set->level, file_no);
+				BufFilePrefetch(file_info->wfile, (int64) hashtable->max_mem);
+				return;
+			}
+		}
+
+		spill_file = spill_set->parent_spill_file;
+	}
+}
+
 /*
  * Fucntion: agg_hash_next_pass
  *
@@ -2282,7 +2555,7 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 		"HashAgg: resetting " INT64_FORMAT "-entry hash table",
 		hashtable->num_ht_groups);
 
-	Assert(hashtable->buckets && hashtable->bloom);
+	Assert((hashtable->buckets && hashtable->bloom) || hashtable->slots);
 
 	/*
 	 * Determine whether to reallocate buckets. Especially avoid re-allocation if
@@ -2313,11 +2586,19 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 		hashtable->hats.nbuckets = hats.nbuckets;
 		hashtable->hats.nentries = hats.nentries;
 
-		pfree(hashtable->buckets);
-		pfree(hashtable->bloom);
+		if (hashtable->slots != NULL)
+		{
+			pfree(hashtable->slots);
+			hashtable->slots = (HashAggSlot *) palloc0(hashtable->nbuckets * sizeof(HashAggSlot));
+		}
+		else
+		{
+			pfree(hashtable->buckets);
+			pfree(hashtable->bloom);
 
-		hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
-		hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+			hashtable->buckets = (HashAggBucket *) palloc0(hashtable->nbuckets * sizeof(HashAggBucket));
+			hashtable->bloom = (uint64 *) palloc0(hashtable->nbuckets * sizeof(uint64));
+		}
 
 		hashtable->expandable = true;
 
@@ -2330,8 +2611,13 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 	else
 	{
 		/* No need to reallocated buckets. Reset to zero. */
-		MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggBucket));
-		MemSet(hashtable->bloom, 0, hashtable->nbuckets * sizeof(uint64));
+		if (hashtable->slots != NULL)
+			MemSet(hashtable->slots, 0, hashtable->nbuckets * sizeof(HashAggSlot));
+		else
+		{
+			MemSet(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashAggBucket));
+			MemSet(hashtable->bloom, 0, hashtable->nbuckets * sizeof(uint64));
+		}
 	}
 
 	Assert(hashtable->mem_for_metadata > 0);
@@ -2370,8 +2656,13 @@ void destroy_agg_hash_table(AggState *aggstate)
 		Gpmon_ResetAggHashTable(aggstate);
 
 		/* destroy_batches(aggstate->hhashtable); */
-		pfree(aggstate->hhashtable->buckets);
-		pfree(aggstate->hhashtable->bloom);
+		if (aggstate->hhashtable->slots)
+			pfree(aggstate->hhashtable->slots);
+		else
+		{
+			pfree(aggstate->hhashtable->buckets);
+			pfree(aggstate->hhashtable->bloom);
+		}
 		if (aggstate->hhashtable->hashkey_buf)
 			pfree(aggstate->hhashtable->hashkey_buf);
 
@@ -1438,7 +1438,7 @@ sliceCalculateNumSendingProcesses(ExecSlice *slice)
 }
 
 /* Forward declarations */
-static void InventorySliceTree(CdbDispatcherState *ds, SliceTable *sliceTable, int sliceIndex);
+static void InventorySliceTree(SliceTable *sliceTable, int sliceIndex, List **slices);
 
 /*
  * Function AssignGangs runs on the QD and finishes construction of the
@@ -1463,6 +1463,13 @@ AssignGangs(CdbDispatcherState *ds, QueryDesc *queryDesc)
 	SliceTable	*sliceTable;
 	EState		*estate;
 	int			rootIdx;
+	List		*slices = NIL;
+	ListCell	*lc;
+	GangType	*gangTypes;
+	List		**gangSegments;
+	Gang		**gangs;
+	int			ngangs = 0;
+	int			i;
 
 	estate = queryDesc->estate;
 	sliceTable = estate->es_sliceTable;
@@ -1472,37 +1479,73 @@ AssignGangs(CdbDispatcherState *ds, QueryDesc *queryDesc)
 	for (int i = 0; i < sliceTable->numSlices; i++)
 		sliceTable->slices[i].processesMap = NULL;
 
-	InventorySliceTree(ds, sliceTable, rootIdx);
+	InventorySliceTree(sliceTable, rootIdx, &slices);
+
+	/*
+	 * Allocate the gangs of all the slices at once, so that the QEs that
+	 * have to be started for them are started in parallel.
+	 */
+	gangTypes = palloc(sizeof(GangType) * list_length(slices));
+	gangSegments = palloc(sizeof(List *) * list_length(slices));
+	gangs = palloc(sizeof(Gang *) * list_length(slices));
+
+	foreach(lc, slices)
+	{
+		ExecSlice  *slice = (ExecSlice *) lfirst(lc);
+
+		if (slice->gangType != GANGTYPE_UNALLOCATED)
+		{
+			Assert(slice->segments != NIL);
+			gangTypes[ngangs] = slice->gangType;
+			gangSegments[ngangs] = slice->segments;
+			ngangs++;
+		}
+	}
+
+	if (ngangs > 0)
+		AllocateGangs(ds, ngangs, gangTypes, gangSegments, gangs);
+
+	i = 0;
+	foreach(lc, slices)
+	{
+		ExecSlice  *slice = (ExecSlice *) lfirst(lc);
+
+		if (slice->gangType == GANGTYPE_UNALLOCATED)
+		{
+			slice->primaryGang = NULL;
+			slice->primaryProcesses = getCdbProcessesForQD(true);
+		}
+		else
+		{
+			slice->primaryGang = gangs[i++];
+			setupCdbProcessList(slice);
+		}
+	}
+
+	pfree(gangTypes);
+	pfree(gangSegments);
+	pfree(gangs);
+	list_free(slices);
 }
 
 /*
- * Helper for AssignGangs takes a simple inventory of the gangs required
- * by a slice tree.  Recursive.  Closely coupled with AssignGangs.	Not
- * generally useful.
+ * Helper for AssignGangs takes a simple inventory of the slices in a slice
+ * tree, in the order their gangs are allocated.  Recursive.  Closely coupled
+ * with AssignGangs.  Not generally useful.
  */
 static void
-InventorySliceTree(CdbDispatcherState *ds, SliceTable *sliceTable, int sliceIndex)
+InventorySliceTree(SliceTable *sliceTable, int sliceIndex, List **slices)
 {
 	ExecSlice *slice = &sliceTable->slices[sliceIndex];
 	ListCell *cell;
 
-	if (slice->gangType == GANGTYPE_UNALLOCATED)
-	{
-		slice->primaryGang = NULL;
-		slice->primaryProcesses = getCdbProcessesForQD(true);
-	}
-	else
-	{
-		Assert(slice->segments != NIL);
-		slice->primaryGang = AllocateGang(ds, slice->gangType, slice->segments);
-		setupCdbProcessList(slice);
-	}
+	*slices = lappend(*slices, slice);
 
 	foreach(cell, slice->children)
 	{
 		int			childIndex = lfirst_int(cell);
 
-		InventorySliceTree(ds, sliceTable, childIndex);
+		InventorySliceTree(sliceTable, childIndex, slices);
 	}
 }
 
@@ -25,6 +25,7 @@
 
 #include <math.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include "access/hash.h"
 #include "access/htup_details.h"
@@ -47,6 +48,7 @@
 
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecHashIncreaseNumBuckets(HashJoinTable hashtable);
+static void ExecHashLinkTuples(HashJoinTable hashtable);
 static void ExecHashBuildSkewHash(HashJoinTable hashtable, Hash *node,
 					  int mcvsToUse);
 static void ExecHashSkewTableInsert(HashState *hashState, HashJoinTable hashtable,
@@ -64,6 +66,25 @@ ExecHashTableExplainBatches(HashJoinTable   hashtable,
                             const char     *title);
 static void *dense_alloc(HashJoinTable hashtable, Size size);
 
+/*
+ * Bloom filter sizing.  With 8 bits per inner tuple and two probes, about 5%
+ * of non-matching outer rows get through; once there are fewer than 4 bits
+ * per tuple, the filter is not worth testing.
+ */
+#define HASH_BLOOM_BITS_PER_TUPLE	8
+#define HASH_BLOOM_MIN_BITS			(1 << 13)
+#define HASH_BLOOM_MAX_BITS			(1 << 26)
+
+static inline void
+ExecHashBloomFilterAdd(HashBloomFilter *filter, uint32 hashvalue)
+{
+	uint32		bit1 = hashvalue & filter->mask;
+	uint32		bit2 = DatumGetUInt32(hash_uint32(hashvalue)) & filter->mask;
+
+	filter->bits[bit1 / 64] |= UINT64CONST(1) << (bit1 % 64);
+	filter->bits[bit2 / 64] |= UINT64CONST(1) << (bit2 % 64);
+}
+
 /* ----------------------------------------------------------------
  *		ExecHash
  *
@@ -93,6 +114,7 @@ MultiExecHash(HashState *node)
 	TupleTableSlot *slot;
 	ExprContext *econtext;
 	uint32		hashvalue;
+	HashBloomFilter *bloomfilter;
 
 	/* must provide our own instrumentation support */
 	if (node->ps.instrument)
@@ -103,6 +125,7 @@ MultiExecHash(HashState *node)
 	 */
 	outerNode = outerPlanState(node);
 	hashtable = node->hashtable;
+	bloomfilter = hashtable->hjstate ? hashtable->hjstate->hj_BloomFilter : NULL;
 
 	/*
 	 * set expression context
@@ -112,6 +135,9 @@ MultiExecHash(HashState *node)
 
 	SIMPLE_FAULT_INJECTOR("multi_exec_hash_large_vmem");
 
+	/* with several build threads, link the tuples after loading them all */
+	hashtable->linkDeferred = (gp_hashjoin_build_threads > 1);
+
 	/*
 	 * get all inner tuples and insert into the hash table (or temp files)
 	 */
@@ -145,6 +171,9 @@ MultiExecHash(HashState *node)
 				ExecHashTableInsert(node, hashtable, slot, hashvalue);
 			}
 			hashtable->totalTuples += 1;
+
+			if (bloomfilter)
+				ExecHashBloomFilterAdd(bloomfilter, hashvalue);
 		}
 
 		if (hashkeys_null)
@@ -165,6 +194,9 @@ MultiExecHash(HashState *node)
 	/* resize the hash table if needed (NTUP_PER_BUCKET exceeded) */
 	if (hashtable->nbuckets != hashtable->nbuckets_optimal)
 		ExecHashIncreaseNumBuckets(hashtable);
+	else if (hashtable->linkDeferred)
+		ExecHashLinkTuples(hashtable);
+	hashtable->linkDeferred = false;
 
 	/* Account for the buckets in spaceUsed (reported in EXPLAIN ANALYZE) */
 	hashtable->spaceUsed += hashtable->nbuckets * sizeof(HashJoinTuple);
@@ -325,6 +357,7 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 	hashtable->log2_nbuckets = log2_nbuckets;
 	hashtable->log2_nbuckets_optimal = log2_nbuckets;
 	hashtable->buckets = NULL;
+	hashtable->linkDeferred = false;
 	hashtable->keepNulls = keepNulls;
 	hashtable->skewEnabled = false;
 	hashtable->skewBucket = NULL;
@@ -866,8 +899,11 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 				memcpy(copyTuple, hashTuple, hashTupleSize);
 
 				/* and add it back to the appropriate bucket */
-				copyTuple->next = hashtable->buckets[bucketno];
-				hashtable->buckets[bucketno] = copyTuple;
+				if (!hashtable->linkDeferred)
+				{
+					copyTuple->next = hashtable->buckets[bucketno];
+					hashtable->buckets[bucketno] = copyTuple;
+				}
 			}
 			else
 			{
@@ -936,8 +972,6 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 static void
 ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 {
-	HashMemoryChunk chunk;
-
 	/* do nothing if not an increase (it's called increase for a reason) */
 	if (hashtable->nbuckets >= hashtable->nbuckets_optimal)
 		return;
@@ -964,32 +998,266 @@ ExecHashIncreaseNumBuckets(HashJoinTable hashtable)
 		(HashJoinTuple *) repalloc(hashtable->buckets,
 								hashtable->nbuckets * sizeof(HashJoinTuple));
 
-	memset(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashJoinTuple));
-
 	/* scan through all tuples in all chunks to rebuild the hash table */
-	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next)
+	ExecHashLinkTuples(hashtable);
+}
+
+/*
+ * Parallel linking of the hash table.
+ *
+ * Once all the tuples of the batch sit in the dense chunks, with their hash
+ * values already computed, putting them into buckets is nothing but a
+ * random write per tuple.  For a large table that is dominated by cache
+ * misses, and it can be spread over several threads by partitioning the
+ * bucket array into contiguous ranges:
+ *
+ * 1. each thread counts the tuples of its share of the chunks that fall
+ *	  into each partition;
+ * 2. each thread copies pointers to those tuples into one array, grouped by
+ *	  partition, at offsets computed from the counts;
+ * 3. each thread links the tuples of its own partition, whose buckets no
+ *	  other thread touches.
+ *
+ * The threads only read the chunks and write to memory that was allocated
+ * for them up front: they must not palloc, elog or check for interrupts.
+ * The calling backend does the work of worker 0 itself.
+ */
+#define HASH_LINK_MIN_TUPLES_PER_THREAD		(64 * 1024)
+
+typedef struct HashLinkShared
+{
+	HashJoinTable hashtable;
+	HashMemoryChunk *chunks;
+	int			nchunks;
+	int			nworkers;		/* also the number of partitions */
+	int			pass;			/* 1, 2 or 3; see above */
+	uint64	   *offsets;		/* [worker][partition] counts, then offsets */
+	uint64	   *partstart;		/* start of each partition in 'tuples' */
+	HashJoinTuple *tuples;
+} HashLinkShared;
+
+typedef struct HashLinkWorker
+{
+	HashLinkShared *shared;
+	int			worker;
+	pthread_t	thread;
+} HashLinkWorker;
+
+static inline int
+hash_link_partition(HashLinkShared *shared, int bucketno)
+{
+	return (int) (((uint64) bucketno * shared->nworkers) >>
+				  shared->hashtable->log2_nbuckets);
+}
+
+static void *
+hash_link_worker(void *arg)
+{
+	HashLinkWorker *me = (HashLinkWorker *) arg;
+	HashLinkShared *shared = me->shared;
+	HashJoinTable hashtable = shared->hashtable;
+	uint64	   *offsets = shared->offsets + (uint64) me->worker * shared->nworkers;
+	int			i;
+
+	if (shared->pass == 3)
+	{
+		uint64		k;
+
+		for (k = shared->partstart[me->worker];
+			 k < shared->partstart[me->worker + 1]; k++)
+		{
+			HashJoinTuple hashTuple = shared->tuples[k];
+			int			bucketno = hashTuple->hashvalue & (hashtable->nbuckets - 1);
+
+			hashTuple->next = hashtable->buckets[bucketno];
+			hashtable->buckets[bucketno] = hashTuple;
+		}
+		return NULL;
+	}
+
+	for (i = me->worker; i < shared->nchunks; i += shared->nworkers)
 	{
-		/* process all tuples stored in this chunk */
+		HashMemoryChunk chunk = shared->chunks[i];
 		size_t		idx = 0;
 
 		while (idx < chunk->used)
 		{
 			HashJoinTuple hashTuple = (HashJoinTuple) (chunk->data + idx);
-			int			bucketno;
-			int			batchno;
-
-			ExecHashGetBucketAndBatch(hashtable, hashTuple->hashvalue,
-									  &bucketno, &batchno);
+			int			bucketno = hashTuple->hashvalue & (hashtable->nbuckets - 1);
+			int			part = hash_link_partition(shared, bucketno);
 
-			/* add the tuple to the proper bucket */
-			hashTuple->next = hashtable->buckets[bucketno];
-			hashtable->buckets[bucketno] = hashTuple;
+			if (shared->pass == 1)
+				offsets[part]++;
+			else
+				shared->tuples[offsets[part]++] = hashTuple;
 
-			/* advance index past the tuple */
 			idx += MAXALIGN(HJTUPLE_OVERHEAD +
 							memtuple_get_size(HJTUPLE_MINTUPLE(hashTuple)));
 		}
 	}
+
+	return NULL;
+}
+
+/*
+ * Run one pass of the parallel linking in all workers.  If a thread cannot
+ * be started, the backend does that worker's share itself.
+ */
+static void
+hash_link_run_pass(HashLinkWorker *workers, int pass)
+{
+	HashLinkShared *shared = workers[0].shared;
+	bool	   *started;
+	sigset_t	old_sigs;
+	pthread_attr_t t_atts;
+	int			i;
+
+	shared->pass = pass;
+	started = (bool *) palloc0(shared->nworkers * sizeof(bool));
+
+	pthread_attr_init(&t_atts);
+	pthread_attr_setstacksize(&t_atts, Max(PTHREAD_STACK_MIN, (128 * 1024)));
+
+	/* leave the signals to be handled by the main thread */
+	gp_set_thread_sigmasks(&old_sigs);
+	for (i = 1; i < shared->nworkers; i++)
+		started[i] = (pthread_create(&workers[i].thread, &t_atts,
+									 hash_link_worker, &workers[i]) == 0);
+	gp_reset_thread_sigmasks(&old_sigs);
+	pthread_attr_destroy(&t_atts);
+
+	hash_link_worker(&workers[0]);
+	for (i = 1; i < shared->nworkers; i++)
+	{
+		if (started[i])
+			pthread_join(workers[i].thread, NULL);
+		else
+			hash_link_worker(&workers[i]);
+	}
+
+	pfree(started);
+}
+
+/*
+ * ExecHashLinkTuples
+ *		(Re)build the buckets of the hash table from the dense chunks.
+ */
+static void
+ExecHashLinkTuples(HashJoinTable hashtable)
+{
+	HashLinkShared shared;
+	HashLinkWorker *workers;
+	HashMemoryChunk chunk;
+	uint64		ntuples = 0;
+	uint64		pos;
+	int			nworkers;
+	int			part;
+	int			i;
+
+	memset(hashtable->buckets, 0, hashtable->nbuckets * sizeof(HashJoinTuple));
+
+	shared.nchunks = 0;
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next)
+	{
+		ntuples += chunk->ntuples;
+		shared.nchunks++;
+	}
+
+	nworkers = Min(gp_hashjoin_build_threads,
+				   ntuples / HASH_LINK_MIN_TUPLES_PER_THREAD);
+	nworkers = Min(nworkers, hashtable->nbuckets);
+
+	/*
+	 * The parallel link gathers pointers to all the tuples into one array.
+	 * Count it in spaceUsed, and link serially if it doesn't fit.
+	 */
+	if (nworkers > 1 &&
+		hashtable->spaceUsed + (hashtable->nbuckets + ntuples) * sizeof(HashJoinTuple)
+		> hashtable->spaceAllowed)
+		nworkers = 1;
+
+	if (nworkers <= 1)
+	{
+		for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next)
+		{
+			/* process all tuples stored in this chunk */
+			size_t		idx = 0;
+
+			while (idx < chunk->used)
+			{
+				HashJoinTuple hashTuple = (HashJoinTuple) (chunk->data + idx);
+				int			bucketno;
+				int			batchno;
+
+				ExecHashGetBucketAndBatch(hashtable, hashTuple->hashvalue,
+										  &bucketno, &batchno);
+
+				/* add the tuple to the proper bucket */
+				hashTuple->next = hashtable->buckets[bucketno];
+				hashtable->buckets[bucketno] = hashTuple;
+
+				/* advance index past the tuple */
+				idx += MAXALIGN(HJTUPLE_OVERHEAD +
+								memtuple_get_size(HJTUPLE_MINTUPLE(hashTuple)));
+			}
+		}
+		return;
+	}
+
+	shared.hashtable = hashtable;
+	shared.nworkers = nworkers;
+	shared.chunks = (HashMemoryChunk *)
+		palloc(shared.nchunks * sizeof(HashMemoryChunk));
+	i = 0;
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next)
+		shared.chunks[i++] = chunk;
+	shared.offsets = (uint64 *) palloc0((Size) nworkers * nworkers * sizeof(uint64));
+	shared.partstart = (uint64 *) palloc((nworkers + 1) * sizeof(uint64));
+	shared.tuples = (HashJoinTuple *)
+		MemoryContextAllocHuge(CurrentMemoryContext,
+							   ntuples * sizeof(HashJoinTuple));
+	hashtable->spaceUsed += ntuples * sizeof(HashJoinTuple);
+	if (hashtable->spaceUsed + hashtable->nbuckets * sizeof(HashJoinTuple) >
+		hashtable->spacePeak)
+		hashtable->spacePeak = hashtable->spaceUsed +
+			hashtable->nbuckets * sizeof(HashJoinTuple);
+
+	workers = (HashLinkWorker *) palloc(nworkers * sizeof(HashLinkWorker));
+	for (i = 0; i < nworkers; i++)
+	{
+		workers[i].shared = &shared;
+		workers[i].worker = i;
+	}
+
+	/* count the tuples per worker and partition */
+	hash_link_run_pass(workers, 1);
+
+	/* turn the counts into offsets, partition by partition */
+	pos = 0;
+	for (part = 0; part < nworkers; part++)
+	{
+		shared.partstart[part] = pos;
+		for (i = 0; i < nworkers; i++)
+		{
+			uint64		count = shared.offsets[i * nworkers + part];
+
+			shared.offsets[i * nworkers + part] = pos;
+			pos += count;
+		}
+	}
+	shared.partstart[nworkers] = pos;
+	Assert(pos == ntuples);
+
+	/* gather the tuples by partition, then link each partition */
+	hash_link_run_pass(workers, 2);
+	hash_link_run_pass(workers, 3);
+
+	pfree(workers);
+	pfree(shared.tuples);
+	hashtable->spaceUsed -= ntuples * sizeof(HashJoinTuple);
+	pfree(shared.partstart);
+	pfree(shared.offsets);
+	pfree(shared.chunks);
 }
 
 
@@ -1052,8 +1320,11 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 		MemTupleClearMatch(HJTUPLE_MINTUPLE(hashTuple));
 
 		/* Push it onto the front of the bucket's list */
-		hashTuple->next = hashtable->buckets[bucketno];
-		hashtable->buckets[bucketno] = hashTuple;
+		if (!hashtable->linkDeferred)
+		{
+			hashTuple->next = hashtable->buckets[bucketno];
+			hashtable->buckets[bucketno] = hashTuple;
+		}
 
 		/*
 		 * Increase the (optimal) number of buckets if we just exceeded the
@@ -1504,6 +1775,131 @@ ExecReScanHash(HashState *node)
 }
 
 
+/*
+ * ExecHashBloomFilterCreate
+ *		Set up a Bloom filter for an inner relation of about 'ntuples' rows.
+ *
+ * 'keyexprs' are the outer hash keys, already initialized against the scan
+ * that will apply the filter, and 'hashOperators' the join's hash operators.
+ * The filter is allocated in the current memory context, and is not ready
+ * for use until the hash table has been built.
+ */
+HashBloomFilter *
+ExecHashBloomFilterCreate(double ntuples, List *keyexprs, List *hashOperators)
+{
+	HashBloomFilter *filter;
+	double		wantbits;
+	uint32		nbits;
+	ListCell   *lc;
+	int			i;
+
+	wantbits = Min(ntuples * HASH_BLOOM_BITS_PER_TUPLE, HASH_BLOOM_MAX_BITS);
+	nbits = HASH_BLOOM_MIN_BITS;
+	while (nbits < wantbits)
+		nbits <<= 1;
+
+	filter = (HashBloomFilter *) palloc0(sizeof(HashBloomFilter));
+	filter->mask = nbits - 1;
+	filter->bits = (uint64 *) palloc0(nbits / 8);
+	filter->keyexprs = keyexprs;
+	filter->hashfunctions = (FmgrInfo *)
+		palloc(list_length(hashOperators) * sizeof(FmgrInfo));
+
+	i = 0;
+	foreach(lc, hashOperators)
+	{
+		Oid			hashop = lfirst_oid(lc);
+		Oid			left_hashfn;
+		Oid			right_hashfn;
+
+		if (!get_op_hash_functions(hashop, &left_hashfn, &right_hashfn))
+			elog(ERROR, "could not find hash function for hash operator %u",
+				 hashop);
+		fmgr_info(left_hashfn, &filter->hashfunctions[i]);
+		i++;
+	}
+
+	return filter;
+}
+
+/*
+ * ExecHashBloomFilterReset
+ *		Clear the filter before the hash table is (re)built.
+ */
+void
+ExecHashBloomFilterReset(HashBloomFilter *filter)
+{
+	filter->ready = false;
+	memset(filter->bits, 0, (filter->mask / 8) + 1);
+}
+
+/*
+ * ExecHashBloomFilterFinish
+ *		Called once all inner tuples have been added.  Enables the filter,
+ *		unless the inner relation turned out too large for it to be useful.
+ */
+void
+ExecHashBloomFilterFinish(HashBloomFilter *filter, uint64 ntuples)
+{
+	filter->ready = (ntuples <= ((uint64) filter->mask + 1) / 4);
+}
+
+/*
+ * ExecHashBloomFilterTest
+ *		Can the scan tuple in econtext->ecxt_scantuple find a join partner?
+ *
+ * The hash value is computed exactly like ExecHashGetHashValue() does for
+ * the outer tuple.  Rows with a NULL key are always let through, and left
+ * for the join to deal with.
+ */
+bool
+ExecHashBloomFilterTest(HashBloomFilter *filter, ExprContext *econtext)
+{
+	uint32		hashkey = 0;
+	uint32		bit1;
+	uint32		bit2;
+	ListCell   *lc;
+	int			i = 0;
+	MemoryContext oldContext;
+
+	filter->ntested += 1;
+
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	foreach(lc, filter->keyexprs)
+	{
+		ExprState  *keyexpr = (ExprState *) lfirst(lc);
+		Datum		keyval;
+		bool		isNull;
+
+		/* rotate hashkey left 1 bit at each step */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		keyval = ExecEvalExpr(keyexpr, econtext, &isNull, NULL);
+		if (isNull)
+		{
+			MemoryContextSwitchTo(oldContext);
+			return true;
+		}
+
+		hashkey ^= DatumGetUInt32(FunctionCall1(&filter->hashfunctions[i],
+												keyval));
+		i++;
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	bit1 = hashkey & filter->mask;
+	bit2 = DatumGetUInt32(hash_uint32(hashkey)) & filter->mask;
+	if ((filter->bits[bit1 / 64] & (UINT64CONST(1) << (bit1 % 64))) &&
+		(filter->bits[bit2 / 64] & (UINT64CONST(1) << (bit2 % 64))))
+		return true;
+
+	filter->nrejected += 1;
+	return false;
+}
+
+
 /*
  * ExecHashTableExplainInit
  *      Called after ExecHashTableCreate to set up EXPLAIN ANALYZE reporting.
@@ -1640,6 +2036,13 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
 				"Secondary Overflow");
     }
 
+    /* Report how many outer rows the Bloom filter discarded. */
+    if (hjstate->hj_BloomFilter && hjstate->hj_BloomFilter->ntested > 0)
+        appendStringInfo(buf,
+                         "Bloom filter discarded %.0f of %.0f outer rows.\n",
+                         hjstate->hj_BloomFilter->nrejected,
+                         hjstate->hj_BloomFilter->ntested);
+
     /* Report hash chain statistics. */
     total_buckets = stats->nonemptybatches * hashtable->nbuckets;
     if (total_buckets > 0)
@@ -1675,6 +2078,7 @@ ExecHashTableExplainBatches(HashJoinTable   hashtable,
     CdbExplain_Agg      iwrbytes;
     CdbExplain_Agg      ordbytes;
     CdbExplain_Agg      owrbytes;
+    CdbExplain_Agg      nlchunks;
     int                 i;
 
     if (ibatch_begin >= ibatch_end)
@@ -1689,6 +2093,7 @@ ExecHashTableExplainBatches(HashJoinTable   hashtable,
     cdbexplain_agg_init0(&iwrbytes);
     cdbexplain_agg_init0(&ordbytes);
     cdbexplain_agg_init0(&owrbytes);
+    cdbexplain_agg_init0(&nlchunks);
 
     /* Add up the batch stats. */
     for (i = ibatch_begin; i < ibatch_end; i++)
@@ -1699,9 +2104,11 @@ ExecHashTableExplainBatches(HashJoinTable   hashtable,
         cdbexplain_agg_upd(&iwrbytes, (double)bs->iwrbytes, i);
         cdbexplain_agg_upd(&ordbytes, (double)bs->ordbytes, i);
         cdbexplain_agg_upd(&owrbytes, (double)bs->owrbytes, i);
+        cdbexplain_agg_upd(&nlchunks, (double)bs->nlchunks, i);
     }
 
-    if (iwrbytes.vcnt + irdbytes.vcnt + owrbytes.vcnt + ordbytes.vcnt > 0)
+    if (iwrbytes.vcnt + irdbytes.vcnt + owrbytes.vcnt + ordbytes.vcnt +
+        nlchunks.vcnt > 0)
     {
         if (ibatch_begin == ibatch_end - 1)
             appendStringInfo(buf,
@@ -1779,6 +2186,20 @@ ExecHashTableExplainBatches(HashJoinTable   hashtable,
                              ceil(owrbytes.vmax / 1024));
         appendStringInfoString(buf, ".\n");
     }
+
+    /* Batches that could not be split, and were joined by nested loop */
+    if (nlchunks.vcnt > 0)
+    {
+        appendStringInfo(buf,
+                         "  Joined %d unsplittable batch%s by nested loop"
+                         " over %.0f inner chunks",
+                         nlchunks.vcnt,
+                         nlchunks.vcnt == 1 ? "" : "es",
+                         nlchunks.vsum);
+        if (nlchunks.vcnt > 1)
+            appendStringInfo(buf, ", %.0f max", nlchunks.vmax);
+        appendStringInfoString(buf, ".\n");
+    }
 }                               /* ExecHashTableExplainBatches */
 
 
@@ -2188,8 +2609,11 @@ ExecHashRemoveNextSkewBucket(HashState *hashState, HashJoinTable hashtable)
 			memcpy(copyTuple, hashTuple, tupleSize);
 			pfree(hashTuple);
 
-			copyTuple->next = hashtable->buckets[bucketno];
-			hashtable->buckets[bucketno] = copyTuple;
+			if (!hashtable->linkDeferred)
+			{
+				copyTuple->next = hashtable->buckets[bucketno];
+				hashtable->buckets[bucketno] = copyTuple;
+			}
 
 			/* We have reduced skew space, but overall space doesn't change */
 			hashtable->spaceUsedSkew -= tupleSize;
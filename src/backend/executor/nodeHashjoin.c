@@ -24,6 +24,7 @@
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
 #include "miscadmin.h"
+#include "parser/parsetree.h"
 #include "utils/faultinjector.h"
 #include "utils/memutils.h"
 
@@ -54,6 +55,9 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 						  TupleTableSlot *tupleSlot);
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
 static bool isNotDistinctJoin(List *qualList);
+static void InitBloomFilter(HashJoinState *hjstate, HashJoin *node);
+static bool ExecHashJoinNLOuterMatched(HashJoinTable hashtable);
+static void ExecHashJoinNLSetOuterMatched(HashJoinTable hashtable);
 
 static void ReleaseHashTable(HashJoinState *node);
 
@@ -184,6 +188,9 @@ ExecHashJoin_guts(HashJoinState *node)
 					node->hj_FirstOuterTupleSlot = NULL;
 				}
 
+				if (node->hj_BloomFilter)
+					ExecHashBloomFilterReset(node->hj_BloomFilter);
+
 				/*
 				 * create the hash table
 				 */
@@ -220,6 +227,11 @@ ExecHashJoin_guts(HashJoinState *node)
 				elog(gp_workfile_caching_loglevel, "HashJoin built table with %.1f tuples by executing subplan for batch 0", hashtable->totalTuples);
 #endif
 
+				/* The outer scan may now start using the Bloom filter */
+				if (node->hj_BloomFilter)
+					ExecHashBloomFilterFinish(node->hj_BloomFilter,
+											  hashtable->totalTuples);
+
 				/**
 				 * If LASJ_NOTIN and a null was found on the inner side, then clean out.
 				 */
@@ -299,6 +311,20 @@ ExecHashJoin_guts(HashJoinState *node)
 				econtext->ecxt_outertuple = outerTupleSlot;
 				node->hj_MatchedOuter = false;
 
+				/*
+				 * When joining a batch chunk by chunk, the outer tuple may
+				 * already have found its match in an earlier chunk.
+				 */
+				if (hashtable->nlOuterMatched &&
+					ExecHashJoinNLOuterMatched(hashtable))
+				{
+					if (node->js.jointype == JOIN_SEMI ||
+						node->js.jointype == JOIN_ANTI ||
+						node->js.jointype == JOIN_LASJ_NOTIN)
+						continue;
+					node->hj_MatchedOuter = true;
+				}
+
 				/*
 				 * Find the corresponding bucket for this tuple in the main
 				 * hash table or skew hash table.
@@ -319,9 +345,13 @@ ExecHashJoin_guts(HashJoinState *node)
 				{
 					/*
 					 * Need to postpone this outer tuple to a later batch.
-					 * Save it in the corresponding outer-batch file.
+					 * Save it in the corresponding outer-batch file.  With
+					 * the nested-loop fallback, that was already done while
+					 * joining the first inner chunk.
 					 */
 					Assert(batchno > hashtable->curbatch);
+					if (hashtable->nlFallback && hashtable->nlChunkNo > 0)
+						continue;
 					ExecHashJoinSaveTuple(&node->js.ps, ExecFetchSlotMemTuple(outerTupleSlot),
 										  hashvalue,
 										  hashtable,
@@ -386,6 +416,9 @@ ExecHashJoin_guts(HashJoinState *node)
 				{
 					node->hj_MatchedOuter = true;
 					MemTupleSetMatch(HJTUPLE_MINTUPLE(node->hj_CurTuple));
+					if (hashtable->nlFallback && !hashtable->nlLastChunk &&
+						(HJ_FILL_OUTER(node) || node->js.jointype == JOIN_SEMI))
+						ExecHashJoinNLSetOuterMatched(hashtable);
 
 					/* In an antijoin, we never return a matched tuple */
 					if (node->js.jointype == JOIN_ANTI ||
@@ -427,8 +460,10 @@ ExecHashJoin_guts(HashJoinState *node)
 				 */
 				node->hj_JoinState = HJ_NEED_NEW_OUTER;
 
+				/* with the nested-loop fallback, wait for the last chunk */
 				if (!node->hj_MatchedOuter &&
-					HJ_FILL_OUTER(node))
+					HJ_FILL_OUTER(node) &&
+					(!hashtable->nlFallback || hashtable->nlLastChunk))
 				{
 					/*
 					 * Generate a fake join tuple with nulls for the inner
@@ -723,6 +758,9 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	/* child Hash node needs to evaluate inner hash keys, too */
 	((HashState *) innerPlanState(hjstate))->hashkeys = rclauses;
 
+	if (gp_hashjoin_bloomfilter)
+		InitBloomFilter(hjstate, node);
+
 	hjstate->hj_JoinState = HJ_BUILD_HASHTABLE;
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
@@ -873,7 +911,11 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 										 hashvalue,
 										 hjstate->hj_OuterTupleSlot);
 		if (!TupIsNull(slot))
+		{
+			if (hashtable->nlFallback)
+				hashtable->nlOuterTupno++;
 			return slot;
+		}
 
 #ifdef HJDEBUG
 		elog(gp_workfile_caching_loglevel, "HashJoin built table with %.1f tuples for batch %d", hashtable->totalTuples, curbatch);
@@ -909,6 +951,38 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 	if (curbatch >= nbatch)
 		return false;
 
+	/*
+	 * A batch that is joined by nested loop is not done until its last inner
+	 * chunk has been joined; until then, load the next chunk and read the
+	 * outer batch file again.
+	 */
+	if (hashtable->nlFallback)
+	{
+		if (!hashtable->nlLastChunk)
+		{
+			hashtable->nlChunkNo++;
+			if (!ExecHashJoinReloadHashTable(hjstate))
+				return false;
+
+			if (hashtable->outerBatchFile[curbatch] != NULL &&
+				BufFileSeek(hashtable->outerBatchFile[curbatch], 0, 0, SEEK_SET) != 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not access temporary file")));
+			hashtable->nlOuterTupno = -1;
+			return true;
+		}
+
+		if (hashtable->stats)
+			hashtable->stats->batchstats[curbatch].nlchunks = hashtable->nlChunkNo + 1;
+		if (hashtable->nlOuterMatched)
+			pfree(hashtable->nlOuterMatched);
+		hashtable->nlOuterMatched = NULL;
+		hashtable->nlOuterMatchedWords = 0;
+		hashtable->nlFallback = false;
+		hashtable->nlLastChunk = false;
+	}
+
 	if (curbatch >= 0 && hashtable->stats)
 		ExecHashTableExplainBatchEnd(hashState, hashtable);
 
@@ -1249,6 +1323,10 @@ ExecReScanHashJoin(HashJoinState *node)
 			node->hj_HashTable = NULL;
 			node->hj_JoinState = HJ_BUILD_HASHTABLE;
 
+			/* the outer scan must not use the old filter in the meantime */
+			if (node->hj_BloomFilter)
+				node->hj_BloomFilter->ready = false;
+
 			/*
 			 * if chgParam of subnode is not null then plan will be re-scanned
 			 * by first ExecProcNode.
@@ -1310,6 +1388,110 @@ ReleaseHashTable(HashJoinState *node)
 
 }
 
+/*
+ * InitBloomFilter
+ *		Push a Bloom filter of the inner hash keys down to the outer scan.
+ *
+ * This is only done when the outer child is a SeqScan in the same slice,
+ * each outer hash key is a plain column of the scanned table, and outer
+ * rows without a match are not emitted by the join.  The filter is then
+ * tested in SeqNext, before the scan's own quals.
+ */
+static void
+InitBloomFilter(HashJoinState *hjstate, HashJoin *node)
+{
+	PlanState  *outerState = outerPlanState(hjstate);
+	List	   *keyexprs = NIL;
+	ListCell   *lc;
+
+	if (!IsA(outerState, SeqScanState))
+		return;
+
+	switch (node->join.jointype)
+	{
+		case JOIN_INNER:
+		case JOIN_SEMI:
+		case JOIN_RIGHT:
+			break;
+		default:
+			return;
+	}
+
+	foreach(lc, node->hashclauses)
+	{
+		OpExpr	   *hclause = (OpExpr *) lfirst(lc);
+		Expr	   *outerkey = (Expr *) linitial(hclause->args);
+		TargetEntry *tle;
+
+		while (IsA(outerkey, RelabelType))
+			outerkey = ((RelabelType *) outerkey)->arg;
+		if (!IsA(outerkey, Var) || ((Var *) outerkey)->varno != OUTER_VAR)
+			return;
+
+		/* find the scan column that the join's outer Var refers to */
+		tle = get_tle_by_resno(outerState->plan->targetlist,
+							   ((Var *) outerkey)->varattno);
+		if (tle == NULL || !IsA(tle->expr, Var) ||
+			((Var *) tle->expr)->varattno <= 0)
+			return;
+
+		keyexprs = lappend(keyexprs, ExecInitExpr(tle->expr, outerState));
+	}
+
+	hjstate->hj_BloomFilter =
+		ExecHashBloomFilterCreate(innerPlan(node)->plan_rows, keyexprs,
+								  hjstate->hj_HashOperators);
+	((SeqScanState *) outerState)->ss_bloomfilter = hjstate->hj_BloomFilter;
+}
+
+/*
+ * ExecHashJoinNLOuterMatched
+ *		Did the current outer tuple match in an earlier inner chunk?
+ */
+static bool
+ExecHashJoinNLOuterMatched(HashJoinTable hashtable)
+{
+	int64		tupno = hashtable->nlOuterTupno;
+
+	return (tupno / 64 < hashtable->nlOuterMatchedWords &&
+			(hashtable->nlOuterMatched[tupno / 64] &
+			 (UINT64CONST(1) << (tupno % 64))) != 0);
+}
+
+/*
+ * ExecHashJoinNLSetOuterMatched
+ *		Remember that the current outer tuple has found a match, for the
+ *		later inner chunks of a batch joined by nested loop.
+ */
+static void
+ExecHashJoinNLSetOuterMatched(HashJoinTable hashtable)
+{
+	int64		tupno = hashtable->nlOuterTupno;
+	int64		word = tupno / 64;
+
+	Assert(tupno >= 0);
+
+	if (word >= hashtable->nlOuterMatchedWords)
+	{
+		int64		oldwords = hashtable->nlOuterMatchedWords;
+		int64		newwords = Max(word + 1, Max(oldwords * 2, 1024));
+
+		if (hashtable->nlOuterMatched == NULL)
+			hashtable->nlOuterMatched = (uint64 *)
+				MemoryContextAllocHuge(hashtable->hashCxt,
+									   newwords * sizeof(uint64));
+		else
+			hashtable->nlOuterMatched = (uint64 *)
+				repalloc_huge(hashtable->nlOuterMatched,
+							  newwords * sizeof(uint64));
+		memset(hashtable->nlOuterMatched + oldwords, 0,
+			   (newwords - oldwords) * sizeof(uint64));
+		hashtable->nlOuterMatchedWords = newwords;
+	}
+
+	hashtable->nlOuterMatched[word] |= UINT64CONST(1) << (tupno % 64);
+}
+
 /* Is this an IS-NOT-DISTINCT-join qual list (as opposed the an equijoin)?
  *
  * XXX We perform an abbreviated test based on the assumptions that 
@@ -1402,19 +1584,31 @@ ExecHashJoinReloadHashTable(HashJoinState *hjstate)
 #endif
 
 	/*
-	 * Reload the hash table with the new inner batch (which could be empty)
+	 * Reload the hash table with the new inner batch (which could be empty),
+	 * or with the next chunk of it if we're joining it by nested loop.
 	 */
 	ExecHashTableReset(hashState, hashtable);
 
 	if (hashtable->innerBatchFile[curbatch] != NULL)
 	{
+		bool		chunkfull = false;
+
 		/* Rewind batch file */
-		if (BufFileSeek(hashtable->innerBatchFile[curbatch], 0, 0, SEEK_SET) != 0)
+		if (!hashtable->nlFallback &&
+			BufFileSeek(hashtable->innerBatchFile[curbatch], 0, 0, SEEK_SET) != 0)
 		{
 			ereport(ERROR, (errcode_for_file_access(),
 							errmsg("could not access temporary file")));
 		}
 
+		/*
+		 * Even if an earlier batch could not be split, this one may be.  A
+		 * rescannable hash table must not respill after the first pass,
+		 * though, and a batch being joined in chunks must stay as it is.
+		 */
+		if (!hashtable->nlFallback && !hjstate->reuse_hashtable)
+			hashtable->growEnabled = true;
+
 		for (;;)
 		{
 			CHECK_FOR_INTERRUPTS();
@@ -1435,8 +1629,34 @@ ExecHashJoinReloadHashTable(HashJoinState *hjstate)
 			 */
 			if (!ExecHashTableInsert(hashState, hashtable, slot, hashvalue))
 				nmoved++;
+
+			/*
+			 * If the batch still doesn't fit and cannot be split any more,
+			 * stop here, and join it one chunk of inner tuples at a time.
+			 */
+			if (!hashtable->growEnabled && !hjstate->reuse_hashtable &&
+				hashtable->spaceUsed +
+				hashtable->nbuckets_optimal * sizeof(HashJoinTuple) >
+				hashtable->spaceAllowed)
+			{
+				if (!hashtable->nlFallback)
+				{
+					hashtable->nlFallback = true;
+					hashtable->nlChunkNo = 0;
+					hashtable->nlLastChunk = false;
+					hashtable->nlOuterTupno = -1;
+				}
+				chunkfull = true;
+				break;
+			}
 		}
 
+		/* keep reading the file for the next chunk */
+		if (chunkfull)
+			return true;
+		if (hashtable->nlFallback)
+			hashtable->nlLastChunk = true;
+
 		/*
 		 * after we build the hash table, the inner batch file is no longer
 		 * needed
@@ -107,10 +107,14 @@ static void execMotionSortedReceiverFirstTime(MotionState *node);
 
 static int	CdbMergeComparator(Datum lhs, Datum rhs, void *context);
 static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, CdbHash *h);
+static uint32 evalHashKeyAttrs(ExprContext *econtext, TupleTableSlot *slot,
+				 AttrNumber *attnos, CdbHash *h);
 
 static void doSendEndOfStream(Motion *motion, MotionState *node);
 static void doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot);
 
+static void ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf);
+
 
 /*=========================================================================
  */
@@ -725,6 +729,7 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 	motionstate->mstype = MOTIONSTATE_NONE;
 	motionstate->stopRequested = false;
 	motionstate->hashExprs = NIL;
+	motionstate->hashAttnos = NULL;
 	motionstate->cdbhash = NULL;
 
 	/* Look up the sending and receiving gang's slice table entries. */
@@ -863,6 +868,33 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 			motionstate->hashExprs = (List *) ExecInitExpr((Expr *) node->hashExprs,
 														   (PlanState *) motionstate);
 
+		/*
+		 * Most of the time, we redistribute on plain columns of the outer
+		 * tuple.  Remember their attribute numbers, so that doSendTuple()
+		 * can fetch the keys straight from the slot without going through
+		 * expression evaluation for every row.
+		 */
+		if (nkeys > 0)
+		{
+			AttrNumber *attnos = palloc(nkeys * sizeof(AttrNumber));
+			ListCell   *lc;
+			int			i = 0;
+
+			foreach(lc, node->hashExprs)
+			{
+				Var		   *var = (Var *) lfirst(lc);
+
+				if (!IsA(var, Var) || var->varno != OUTER_VAR || var->varattno <= 0)
+					break;
+				attnos[i++] = var->varattno;
+			}
+
+			if (i == nkeys)
+				motionstate->hashAttnos = attnos;
+			else
+				pfree(attnos);
+		}
+
 		/*
 		 * Create hash API reference
 		 */
@@ -898,7 +930,16 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 	UpdateMotionLayerNode(motionstate->ps.state->motionlayer_context,
 						  node->motionID,
 						  node->sendSorted,
-						  tupDesc);
+						  tupDesc,
+						  motionstate->mstype == MOTIONSTATE_SEND);
+
+	/*
+	 * CDB: Report the effect of interconnect compression in EXPLAIN ANALYZE.
+	 */
+	if (motionstate->mstype == MOTIONSTATE_SEND &&
+		Gp_interconnect_compression != INTERCONNECT_COMPRESSION_NONE &&
+		estate->es_instrument && (estate->es_instrument & INSTRUMENT_CDB))
+		motionstate->ps.cdbexplainfun = ExecMotionExplainEnd;
 
 
 #ifdef CDB_MOTION_DEBUG
@@ -918,6 +959,33 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 	return motionstate;
 }
 
+/*
+ * ExecMotionExplainEnd
+ *		Called before ExecEndMotion on a sender to report the bytes saved
+ *		by compressing its tuple batches.
+ */
+static void
+ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	Motion	   *motion = (Motion *) planstate->plan;
+	uint64		batches;
+	uint64		compressedBatches;
+	uint64		rawBytes;
+	uint64		sentBytes;
+
+	GetMotionCompressionStats(planstate->state->motionlayer_context,
+							  motion->motionID,
+							  &batches, &compressedBatches,
+							  &rawBytes, &sentBytes);
+
+	if (batches > 0)
+		appendStringInfo(buf,
+						 "Interconnect compression saved " UINT64_FORMAT " of " UINT64_FORMAT " bytes "
+						 "(" UINT64_FORMAT " of " UINT64_FORMAT " batches compressed).",
+						 rawBytes - sentBytes, rawBytes,
+						 compressedBatches, batches);
+}								/* ExecMotionExplainEnd */
+
 /* ----------------------------------------------------------------
  *		ExecEndMotion(node)
  * ----------------------------------------------------------------
@@ -1208,6 +1276,41 @@ evalHashKey(ExprContext *econtext, List *hashkeys, CdbHash * h)
 	return target_seg;
 }
 
+/*
+ * Like evalHashKey(), for the common case that all the hash keys are plain
+ * columns of the outer tuple.  The key values are fetched directly from
+ * the slot.
+ */
+static uint32
+evalHashKeyAttrs(ExprContext *econtext, TupleTableSlot *slot,
+				 AttrNumber *attnos, CdbHash *h)
+{
+	MemoryContext oldContext;
+	unsigned int target_seg;
+	int			i;
+
+	ResetExprContext(econtext);
+
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	cdbhashinit(h);
+
+	for (i = 0; i < h->natts; i++)
+	{
+		Datum		keyval;
+		bool		isNull;
+
+		keyval = slot_getattr(slot, attnos[i], &isNull);
+
+		cdbhash(h, i + 1, keyval, isNull);
+	}
+	target_seg = cdbhashreduce(h);
+
+	MemoryContextSwitchTo(oldContext);
+
+	return target_seg;
+}
+
 
 void
 doSendEndOfStream(Motion *motion, MotionState *node)
@@ -1277,9 +1380,15 @@ doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot)
 	{
 		uint32		hval = 0;
 
-		econtext->ecxt_outertuple = outerTupleSlot;
+		if (node->hashAttnos != NULL)
+			hval = evalHashKeyAttrs(econtext, outerTupleSlot,
+									node->hashAttnos, node->cdbhash);
+		else
+		{
+			econtext->ecxt_outertuple = outerTupleSlot;
 
-		hval = evalHashKey(econtext, node->hashExprs, node->cdbhash);
+			hval = evalHashKey(econtext, node->hashExprs, node->cdbhash);
+		}
 
 #ifdef USE_ASSERT_CHECKING
 		Assert(hval < node->numHashSegments &&
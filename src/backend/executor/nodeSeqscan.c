@@ -30,17 +30,23 @@
 
 #include "access/relscan.h"
 #include "executor/execdebug.h"
+#include "executor/nodeHash.h"
 #include "executor/nodeSeqscan.h"
 #include "utils/rel.h"
 
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbaocsam.h"
+#include "utils/guc.h"
 #include "utils/snapmgr.h"
 
 static void InitScanRelation(SeqScanState *node, EState *estate, int eflags, Relation currentRelation);
 static TupleTableSlot *SeqNext(SeqScanState *node);
+static TupleTableSlot *SeqNextBloomFiltered(SeqScanState *node);
 
 static void InitAOCSScanOpaque(SeqScanState *scanState, Relation currentRelation);
+static void InitAOCSLateColumns(SeqScanState *node);
+static void AOCSBatchNext(SeqScanState *node, TupleTableSlot *slot);
+static void AOCSBatchFilter(SeqScanState *node, TupleTableSlot *slot);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -120,6 +126,20 @@ SeqNext(SeqScanState *node)
 							   appendOnlyMetaDataSnapshot,
 							   NULL /* relationTupleDesc */,
 							   node->ss_aocs_proj);
+
+			if (gp_aocs_scan_batch_size > 0)
+			{
+				node->ss_aocs_batch = aocs_create_batch(node->ss_currentScanDesc_aocs,
+														gp_aocs_scan_batch_size);
+				node->ss_aocs_batch_row = 0;
+
+				/* The quals are still checked on every row */
+				aocs_enable_block_minmax(node->ss_currentScanDesc_aocs,
+										 node->ss.ps.plan->qual);
+
+				if (gp_aocs_late_materialization)
+					InitAOCSLateColumns(node);
+			}
 		}
 		else
 		{
@@ -138,7 +158,10 @@ SeqNext(SeqScanState *node)
 	}
 	else if (node->ss_currentScanDesc_aocs)
 	{
-		aocs_getnext(node->ss_currentScanDesc_aocs, direction, slot);
+		if (node->ss_aocs_batch)
+			AOCSBatchNext(node, slot);
+		else
+			aocs_getnext(node->ss_currentScanDesc_aocs, direction, slot);
 	}
 	else
 	{
@@ -167,6 +190,120 @@ SeqNext(SeqScanState *node)
 	return slot;
 }
 
+/*
+ * Set up late materialization for a batched AOCS scan: the projected columns
+ * that the quals don't reference are read only for the rows that pass the
+ * quals.  The quals are then checked here, in AOCSBatchFilter(), instead of
+ * by ExecScan().
+ */
+static void
+InitAOCSLateColumns(SeqScanState *node)
+{
+	List	   *qual = node->ss.ps.plan->qual;
+	int			ncol = node->ss_aocs_ncol;
+	bool	   *late;
+	int			i;
+
+	/* EvalPlanQual rechecks rely on ExecScan() checking the quals */
+	if (qual == NIL || node->ss.ps.state->es_epqTuple != NULL)
+		return;
+
+	late = palloc0(ncol * sizeof(bool));
+	GetNeededColumnsForScan((Node *) qual, late, ncol);
+	for (i = 0; i < ncol; i++)
+		late[i] = node->ss_aocs_proj[i] && !late[i];
+
+	aocs_batch_set_late_columns(node->ss_currentScanDesc_aocs,
+								node->ss_aocs_batch, late);
+	pfree(late);
+
+	if (node->ss_aocs_batch->late == NULL)
+		return;
+
+	node->ss_aocs_late_qual = node->ss.ps.qual;
+	node->ss_aocs_late_sel = palloc(node->ss_aocs_batch->maxrows * sizeof(int));
+	node->ss.ps.qual = NIL;
+}
+
+/*
+ * Return the next row of an AOCS scan that reads batches, fetching a new
+ * batch once the current one has been consumed.  The quals are evaluated by
+ * ExecScan() on each row as usual, unless the scan reads some columns late.
+ */
+static void
+AOCSBatchNext(SeqScanState *node, TupleTableSlot *slot)
+{
+	AOCSBatch	batch = node->ss_aocs_batch;
+
+	while (node->ss_aocs_batch_row >= batch->nrows)
+	{
+		node->ss_aocs_batch_row = 0;
+		if (!aocs_getnext_batch(node->ss_currentScanDesc_aocs, batch))
+		{
+			ExecClearTuple(slot);
+			return;
+		}
+		if (batch->late_pending)
+			AOCSBatchFilter(node, slot);
+	}
+
+	aocs_batch_store_row(node->ss_currentScanDesc_aocs, batch,
+						 node->ss_aocs_batch_row++, slot);
+}
+
+/*
+ * Check the quals on each row of a batch whose late columns haven't been
+ * read yet, then read those columns for the rows that passed.
+ */
+static void
+AOCSBatchFilter(SeqScanState *node, TupleTableSlot *slot)
+{
+	AOCSBatch	batch = node->ss_aocs_batch;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	int		   *sel = node->ss_aocs_late_sel;
+	int			nsel = 0;
+	int			row;
+
+	for (row = 0; row < batch->nrows; row++)
+	{
+		ResetExprContext(econtext);
+
+		aocs_batch_store_row(node->ss_currentScanDesc_aocs, batch, row, slot);
+		econtext->ecxt_scantuple = slot;
+		if (ExecQual(node->ss_aocs_late_qual, econtext, false))
+			sel[nsel++] = row;
+	}
+
+	InstrCountFiltered1(node, batch->nrows - nsel);
+
+	aocs_batch_read_late(node->ss_currentScanDesc_aocs, batch, sel, nsel);
+}
+
+/*
+ * Like SeqNext, but skip rows that the Bloom filter pushed down by the hash
+ * join above us says cannot find a match.
+ */
+static TupleTableSlot *
+SeqNextBloomFiltered(SeqScanState *node)
+{
+	HashBloomFilter *filter = node->ss_bloomfilter;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	TupleTableSlot *slot;
+
+	for (;;)
+	{
+		slot = SeqNext(node);
+		if (TupIsNull(slot) || !filter->ready)
+			return slot;
+
+		econtext->ecxt_scantuple = slot;
+		if (ExecHashBloomFilterTest(filter, econtext))
+			return slot;
+
+		ResetExprContext(econtext);
+	}
+}
+
 /*
  * SeqRecheck -- access method routine to recheck a tuple in EvalPlanQual
  */
@@ -192,6 +329,11 @@ SeqRecheck(SeqScanState *node, TupleTableSlot *slot)
 TupleTableSlot *
 ExecSeqScan(SeqScanState *node)
 {
+	if (node->ss_bloomfilter)
+		return ExecScan((ScanState *) node,
+						(ExecScanAccessMtd) SeqNextBloomFiltered,
+						(ExecScanRecheckMtd) SeqRecheck);
+
 	return ExecScan((ScanState *) node,
 					(ExecScanAccessMtd) SeqNext,
 					(ExecScanRecheckMtd) SeqRecheck);
@@ -333,6 +475,16 @@ ExecEndSeqScan(SeqScanState *node)
 		aocs_endscan(node->ss_currentScanDesc_aocs);
 		node->ss_currentScanDesc_aocs = NULL;
 	}
+	if (node->ss_aocs_batch)
+	{
+		aocs_free_batch(node->ss_aocs_batch);
+		node->ss_aocs_batch = NULL;
+	}
+	if (node->ss_aocs_late_sel)
+	{
+		pfree(node->ss_aocs_late_sel);
+		node->ss_aocs_late_sel = NULL;
+	}
 
 	/*
 	 * close the heap relation.
@@ -362,6 +514,11 @@ ExecReScanSeqScan(SeqScanState *node)
 	else if (node->ss_currentScanDesc_aocs)
 	{
 		aocs_rescan(node->ss_currentScanDesc_aocs);
+		if (node->ss_aocs_batch)
+		{
+			node->ss_aocs_batch->nrows = 0;
+			node->ss_aocs_batch_row = 0;
+		}
 	}
 	else if (node->ss_currentScanDesc_heap)
 	{
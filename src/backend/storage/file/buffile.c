@@ -847,6 +847,30 @@ BufFileGetSize(BufFile *buffile)
 	return buffile->maxoffset;
 }
 
+/*
+ * BufFilePrefetch
+ *
+ * Ask the kernel to start reading the first 'nbytes' of the file in the
+ * background, so that a later sequential read of it finds the data already
+ * in memory.  Sizes are of the file on disk, i.e. after any compression.
+ */
+void
+BufFilePrefetch(BufFile *buffile, int64 nbytes)
+{
+	int64		offset = 0;
+
+	Assert(NULL != buffile);
+
+	nbytes = Min(nbytes, buffile->maxoffset);
+	while (offset < nbytes)
+	{
+		int			amount = (int) Min(nbytes - offset, (int64) (1024 * 1024 * 1024));
+
+		(void) FilePrefetch(buffile->file, offset, amount);
+		offset += amount;
+	}
+}
+
 const char *
 BufFileGetFilename(BufFile *buffile)
 {
@@ -108,6 +108,38 @@ typedef struct ProcArrayStruct
 
 static ProcArrayStruct *procArray;
 
+/*
+ * GPDB: The in-progress distributed transactions found by the last walk of
+ * the proc array in CreateDistributedSnapshot(), for later distributed
+ * snapshots on the QD to copy instead of walking the proc array again.
+ *
+ * The set of in-progress distributed transactions only shrinks when one of
+ * them ends, with ProcArrayLock held exclusively; that bumps 'generation'.
+ * The contents are valid while 'validGeneration' matches it.  Snapshots are
+ * created with ProcArrayLock held in shared mode, so the contents can't be
+ * invalidated while they are copied.  Distributed transactions that start
+ * after the contents were filled in get a gxid above latestCompletedDxid,
+ * which snapshots made from them take their xmax from, and so are seen as
+ * in progress anyway.
+ *
+ * Several backends may walk the proc array at the same time; 'filling'
+ * lets only one of them fill in the contents.
+ */
+typedef struct DistributedSnapshotCache
+{
+	uint32		generation;
+	uint32		validGeneration;
+	pg_atomic_uint32 filling;
+
+	DistributedTransactionId xminAllDistributedSnapshots;
+	DistributedTransactionId xmin;
+	int			count;
+	/* includes the gxid of the backend that filled it in */
+	DistributedTransactionId inProgressXidArray[FLEXIBLE_ARRAY_MEMBER];
+} DistributedSnapshotCache;
+
+static DistributedSnapshotCache *distributedSnapshotCache;
+
 static PGPROC *allProcs;
 static PGXACT *allPgXact;
 static TMGXACT *allTmGxact;
@@ -186,6 +218,7 @@ static void KnownAssignedXidsReset(void);
 static inline void ProcArrayEndTransactionInternal(PGPROC *proc,
 								PGXACT *pgxact, TransactionId latestXid);
 static void ProcArrayGroupClearXid(PGPROC *proc, TransactionId latestXid);
+static inline void InvalidateDistributedSnapshotCache(void);
 
 /*
  * Report shared-memory space needed by CreateSharedProcArray.
@@ -226,6 +259,10 @@ ProcArrayShmemSize(void)
 						mul_size(sizeof(bool), TOTAL_MAX_CACHED_SUBXIDS));
 	}
 
+	size = add_size(size, offsetof(DistributedSnapshotCache, inProgressXidArray));
+	size = add_size(size, mul_size(sizeof(DistributedTransactionId),
+								   PROCARRAY_MAXPROCS));
+
 	return size;
 }
 
@@ -266,6 +303,19 @@ CreateSharedProcArray(void)
 	allPgXact = ProcGlobal->allPgXact;
 	allTmGxact = ProcGlobal->allTmGxact;
 
+	distributedSnapshotCache = (DistributedSnapshotCache *)
+		ShmemInitStruct("Distributed Snapshot Cache",
+						add_size(offsetof(DistributedSnapshotCache, inProgressXidArray),
+								 mul_size(sizeof(DistributedTransactionId),
+										  PROCARRAY_MAXPROCS)),
+						&found);
+	if (!found)
+	{
+		distributedSnapshotCache->generation = 1;
+		distributedSnapshotCache->validGeneration = 0;
+		pg_atomic_init_u32(&distributedSnapshotCache->filling, 0);
+	}
+
 	/* Create or attach to the KnownAssignedXids arrays too, if needed */
 	if (EnableHotStandby)
 	{
@@ -386,6 +436,8 @@ ProcArrayRemove(PGPROC *proc, TransactionId latestXid)
 		if (InvalidDistributedTransactionId != gxid &&
 			TransactionIdPrecedes(ShmemVariableCache->latestCompletedDxid, gxid))
 			ShmemVariableCache->latestCompletedDxid = gxid;
+		if (InvalidDistributedTransactionId != gxid)
+			InvalidateDistributedSnapshotCache();
 	}
 
 	for (index = 0; index < arrayP->numProcs; index++)
@@ -425,6 +477,20 @@ ProcArrayEndGxact(TMGXACT *gxact)
 	if (InvalidDistributedTransactionId != gxid &&
 		TransactionIdPrecedes(ShmemVariableCache->latestCompletedDxid, gxid))
 		ShmemVariableCache->latestCompletedDxid = gxid;
+
+	if (Gp_role == GP_ROLE_DISPATCH && gxid != InvalidDistributedTransactionId)
+		InvalidateDistributedSnapshotCache();
+}
+
+/*
+ * Forget the in-progress distributed transactions that the last distributed
+ * snapshot found, because one of them has ended.  Caller must hold
+ * ProcArrayLock exclusively.
+ */
+static inline void
+InvalidateDistributedSnapshotCache(void)
+{
+	distributedSnapshotCache->generation++;
 }
 
 /*
@@ -451,8 +517,18 @@ ProcArrayEndTransaction(PGPROC *proc, TransactionId latestXid)
 {
 	PGXACT	   *pgxact = &allPgXact[proc->pgprocno];
 	TMGXACT	   *gxact = &allTmGxact[proc->pgprocno];
+	bool		endGxact;
+
+	/*
+	 * GPDB: if the 'Commit Prepared' broadcast of our distributed transaction
+	 * is still in flight, the gxid must stay in progress until
+	 * finishAsyncCommitPrepared() ends it.  Such a transaction has no local
+	 * XID, see canAsyncCommitPrepared().
+	 */
+	endGxact = TransactionIdIsValid(gxact->gxid) &&
+		!(proc == MyProc && isAsyncCommitPreparedPending());
 
-	if (TransactionIdIsValid(latestXid) || TransactionIdIsValid(gxact->gxid))
+	if (TransactionIdIsValid(latestXid) || endGxact)
 	{
 		/*
 		 * We must lock ProcArrayLock while clearing our advertised XID, so
@@ -474,7 +550,7 @@ ProcArrayEndTransaction(PGPROC *proc, TransactionId latestXid)
 			if (TransactionIdIsValid(latestXid))
 				ProcArrayEndTransactionInternal(proc, pgxact, latestXid);
 
-			if (TransactionIdIsValid(gxact->gxid))
+			if (endGxact)
 				ProcArrayEndGxact(gxact);
 
 			LWLockRelease(ProcArrayLock);
@@ -493,7 +569,8 @@ ProcArrayEndTransaction(PGPROC *proc, TransactionId latestXid)
 	 * handle the cases like: there's a valid distributed XID but no local XID.
 	 */
 	Assert(!TransactionIdIsValid(allPgXact[proc->pgprocno].xid));
-	Assert(!TransactionIdIsValid(allTmGxact[proc->pgprocno].gxid));
+	Assert(!TransactionIdIsValid(allTmGxact[proc->pgprocno].gxid) ||
+		   isAsyncCommitPreparedPending());
 
 	proc->lxid = InvalidLocalTransactionId;
 	pgxact->xmin = InvalidTransactionId;
@@ -2039,77 +2116,153 @@ CreateDistributedSnapshot(DistributedSnapshot *ds)
 	DistributedTransactionId xmax;
 	DistributedSnapshotId distribSnapshotId;
 	DistributedTransactionId globalXminDistributedSnapshots;
+	DistributedTransactionId myGxid;
+	DistributedSnapshotCache *cache = distributedSnapshotCache;
+	uint32		generation;
 	ProcArrayStruct *arrayP = procArray;
 
 	Assert(LWLockHeldByMe(ProcArrayLock));
 	if (*shmNumCommittedGxacts != 0)
 		elog(ERROR, "Create distributed snapshot before DTM recovery finish");
 
-	xmin = xmax = ShmemVariableCache->latestCompletedDxid + 1;
+	Assert(ds->inProgressXidArray != NULL);
 
-	/*
-	 * initialize for calculation with xmax, the calculation for this is on
-	 * same lines as globalxmin for local snapshot.
-	 */
-	globalXminDistributedSnapshots = xmax;
 	count = 0;
+	myGxid = MyTmGxact->gxid;
+	generation = cache->generation;
 
-	Assert(ds->inProgressXidArray != NULL);
-
-	/*
-	 * Gather up current in-progress global transactions for the distributed
-	 * snapshot.
-	 */
-	for (i = 0; i < arrayP->numProcs; i++)
+	if (cache->validGeneration == generation)
 	{
-		int         pgprocno = arrayP->pgprocnos[i];
-		volatile TMGXACT	*gxact_candidate = &allTmGxact[pgprocno];
-		DistributedTransactionId gxid;
-		DistributedTransactionId dxid;
-
-		/* Update globalXminDistributedSnapshots to be the smallest valid dxid */
-		dxid = gxact_candidate->xminDistributedSnapshot;
-		if (dxid != InvalidDistributedTransactionId && dxid < globalXminDistributedSnapshots)
-			globalXminDistributedSnapshots = dxid;
-
-		/* just fetch once */
-		gxid = gxact_candidate->gxid;
-		if (gxid == InvalidDistributedTransactionId)
-			continue;
-
 		/*
-		 * Include the current distributed transaction in the min/max
-		 * calculation.
+		 * No distributed transaction has ended since the last walk of the
+		 * proc array, so what it found is still current.  Copy it, leaving
+		 * out our own transaction.
 		 */
-		if (gxid < xmin)
+		pg_read_barrier();
+
+		for (i = 0; i < cache->count; i++)
 		{
-			xmin = gxid;
+			DistributedTransactionId gxid = cache->inProgressXidArray[i];
+
+			if (gxid != myGxid)
+				ds->inProgressXidArray[count++] = gxid;
 		}
-		if (gxid > xmax)
+		xmin = cache->xmin;
+		xmax = ShmemVariableCache->latestCompletedDxid + 1;
+		globalXminDistributedSnapshots = cache->xminAllDistributedSnapshots;
+
+		elog((Debug_print_full_dtm ? LOG : DEBUG5),
+			 "CreateDistributedSnapshot reused %d in-progress distributed transactions",
+			 cache->count);
+	}
+	else
+	{
+		uint32		notFilling = 0;
+
+		xmin = xmax = ShmemVariableCache->latestCompletedDxid + 1;
+
+		/*
+		 * initialize for calculation with xmax, the calculation for this is
+		 * on same lines as globalxmin for local snapshot.
+		 */
+		globalXminDistributedSnapshots = xmax;
+
+		/*
+		 * Gather up current in-progress global transactions for the
+		 * distributed snapshot.
+		 */
+		for (i = 0; i < arrayP->numProcs; i++)
 		{
-			xmax = gxid;
+			int         pgprocno = arrayP->pgprocnos[i];
+			volatile TMGXACT	*gxact_candidate = &allTmGxact[pgprocno];
+			DistributedTransactionId gxid;
+			DistributedTransactionId dxid;
+
+			/* Update globalXminDistributedSnapshots to be the smallest valid dxid */
+			dxid = gxact_candidate->xminDistributedSnapshot;
+			if (dxid != InvalidDistributedTransactionId && dxid < globalXminDistributedSnapshots)
+				globalXminDistributedSnapshots = dxid;
+
+			/* just fetch once */
+			gxid = gxact_candidate->gxid;
+			if (gxid == InvalidDistributedTransactionId)
+				continue;
+
+			/*
+			 * Include the current distributed transaction in the min/max
+			 * calculation.
+			 */
+			if (gxid < xmin)
+			{
+				xmin = gxid;
+			}
+			if (gxid > xmax)
+			{
+				xmax = gxid;
+			}
+
+			if (gxact_candidate == MyTmGxact)
+				continue;
+
+			ds->inProgressXidArray[count++] = gxid;
+
+			elog((Debug_print_full_dtm ? LOG : DEBUG5),
+				 "CreateDistributedSnapshot added inProgressDistributedXid = %u to snapshot",
+				 gxid);
 		}
 
-		if (gxact_candidate == MyTmGxact)
-			continue;
+		/*
+		 * Above globalXminDistributedSnapshots was calculated based on lowest
+		 * dxid in all snapshots but update it to also include actual process
+		 * dxids.
+		 */
+		if (xmin < globalXminDistributedSnapshots)
+			globalXminDistributedSnapshots = xmin;
 
-		ds->inProgressXidArray[count++] = gxid;
+		/*
+		 * Sort the entry {distribXid}, so that the QEs can binary search it
+		 * in DistributedSnapshotWithLocalMapping_CommittedTest().
+		 */
+		if (count > 1)
+			qsort(ds->inProgressXidArray, count,
+				  sizeof(DistributedTransactionId), DistributedSnapshotMappedEntry_Compare);
 
-		elog((Debug_print_full_dtm ? LOG : DEBUG5),
-			 "CreateDistributedSnapshot added inProgressDistributedXid = %u to snapshot",
-			 gxid);
+		/*
+		 * Keep what we found for the next snapshots, unless another backend
+		 * is already doing that.  Our own transaction goes in at its place
+		 * in the order; the copies above leave it out again.
+		 */
+		if (pg_atomic_compare_exchange_u32(&cache->filling, &notFilling, 1))
+		{
+			if (cache->validGeneration != generation)
+			{
+				bool		placed = (myGxid == InvalidDistributedTransactionId);
+				int			n = 0;
+
+				for (i = 0; i < count; i++)
+				{
+					if (!placed && myGxid < ds->inProgressXidArray[i])
+					{
+						cache->inProgressXidArray[n++] = myGxid;
+						placed = true;
+					}
+					cache->inProgressXidArray[n++] = ds->inProgressXidArray[i];
+				}
+				if (!placed)
+					cache->inProgressXidArray[n++] = myGxid;
+				cache->count = n;
+				cache->xmin = xmin;
+				cache->xminAllDistributedSnapshots = globalXminDistributedSnapshots;
+
+				pg_write_barrier();
+				cache->validGeneration = generation;
+			}
+			pg_atomic_write_u32(&cache->filling, 0);
+		}
 	}
 
 	distribSnapshotId = pg_atomic_add_fetch_u32((pg_atomic_uint32 *)shmNextSnapshotId, 1);
 
-	/*
-	 * Above globalXminDistributedSnapshots was calculated based on lowest
-	 * dxid in all snapshots but update it to also include actual process
-	 * dxids.
-	 */
-	if (xmin < globalXminDistributedSnapshots)
-		globalXminDistributedSnapshots = xmin;
-
 	/*
 	 * Copy the information we just captured under lock and then sorted into
 	 * the distributed snapshot.
@@ -2575,16 +2728,6 @@ GetSnapshotData(Snapshot snapshot, DtxContext distributedTransactionContext)
 	snapshot->regd_count = 0;
 	snapshot->copied = false;
 
-	/*
-	 * Sort the entry {distribXid} to support the QEs doing culls on their
-	 * DisribToLocalXact sorted lists.
-	 */
-	if (distributedTransactionContext == DTX_CONTEXT_QD_DISTRIBUTED_CAPABLE &&
-		snapshot->haveDistribSnapshot &&
-		ds->count > 1)
-		qsort(ds->inProgressXidArray, ds->count,
-			  sizeof(DistributedTransactionId), DistributedSnapshotMappedEntry_Compare);
-
 	/*
 	 * MPP Addition. If we are the chief then we'll save our local snapshot
 	 * into the shared snapshot. Note: we need to use the shared local
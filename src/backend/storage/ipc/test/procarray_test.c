@@ -35,6 +35,13 @@ setup(void)
 	procArray->pgprocnos[4] = 4;
 
 	procArray->maxProcs = MAX_PROCS;
+
+	distributedSnapshotCache =
+		malloc(offsetof(DistributedSnapshotCache, inProgressXidArray) +
+			   sizeof(DistributedTransactionId) * MAX_PROCS);
+	distributedSnapshotCache->generation = 1;
+	distributedSnapshotCache->validGeneration = 0;
+	pg_atomic_init_u32(&distributedSnapshotCache->filling, 0);
 }
 
 static void
@@ -83,6 +90,7 @@ test__CreateDistributedSnapshot(void **state)
 	 * get adjusted correctly based on in-progress.
 	 */
 	allTmGxact[procArray->pgprocnos[0]].xminDistributedSnapshot = InvalidDistributedTransactionId;
+	InvalidateDistributedSnapshotCache();
 
 	allTmGxact[procArray->pgprocnos[1]].gxid = 10;
 	allTmGxact[procArray->pgprocnos[1]].xminDistributedSnapshot = 5;
@@ -109,6 +117,7 @@ test__CreateDistributedSnapshot(void **state)
 	 * ascending sorted order with distributed transactions.
 	 */
 	allTmGxact[procArray->pgprocnos[0]].xminDistributedSnapshot = InvalidDistributedTransactionId;
+	InvalidateDistributedSnapshotCache();
 
 	allTmGxact[procArray->pgprocnos[3]].gxid = 15;
 	allTmGxact[procArray->pgprocnos[3]].xminDistributedSnapshot = 12;
@@ -135,7 +144,34 @@ test__CreateDistributedSnapshot(void **state)
 	assert_true(ds.inProgressXidArray[2] == 15);
 	assert_true(ds.inProgressXidArray[3] == 30);
 
+	/*************************************************************************
+	 * No distributed transaction has ended since, so another backend's
+	 * snapshot is made from what the last one found, without walking the
+	 * proc array.  It sees the first backend's transaction as in progress,
+	 * but not its own.
+	 */
+	MyTmGxact = &allTmGxact[procArray->pgprocnos[3]];
+	MyTmGxact->xminDistributedSnapshot = InvalidDistributedTransactionId;
+	procArray->numProcs = 0;
+
+	memset(ds.inProgressXidArray, 0, SIZE_OF_IN_PROGRESS_ARRAY);
+	CreateDistributedSnapshot(&ds);
+	if (ds.count > 1)
+		qsort(ds.inProgressXidArray, ds.count,
+				sizeof(DistributedTransactionId), DistributedSnapshotMappedEntry_Compare);
+
+	assert_true(ds.xminAllDistributedSnapshots == 5);
+	assert_true(ds.xmin == 7);
+	assert_true(ds.xmax == 30);
+	assert_true(ds.count == 4);
+	assert_true(MyTmGxact->xminDistributedSnapshot == 7);
+	assert_true(ds.inProgressXidArray[0] == 7);
+	assert_true(ds.inProgressXidArray[1] == 10);
+	assert_true(ds.inProgressXidArray[2] == 20);
+	assert_true(ds.inProgressXidArray[3] == 30);
+
 	free(ds.inProgressXidArray);
+	free(distributedSnapshotCache);
 	free(allTmGxact);
 	free(procArray);
 }
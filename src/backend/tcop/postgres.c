@@ -87,6 +87,7 @@
 #include "cdb/cdbsrlz.h"
 #include "cdb/cdbtm.h"
 #include "cdb/cdbdtxcontextinfo.h"
+#include "cdb/cdbdisp_plancache.h"
 #include "cdb/cdbdisp_query.h"
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbgang.h"
@@ -989,6 +990,7 @@ pg_plan_queries(List *querytrees, int cursorOptions, ParamListInfo boundParams)
  * query_string -- optional query text (C string).
  * serializedQuerytree[len]  -- Query node or (NULL,0) if plan provided.
  * serializedPlantree[len] -- PlannedStmt node, or (NULL,0) if query provided.
+ * planHandle -- if not 0, the plan is in the QE plan cache under this handle.
  * serializedParams[len] -- optional parameters
  * serializedQueryDispatchDesc[len] -- QueryDispatchDesc node, or (NULL,0) if query provided.
  *
@@ -999,6 +1001,7 @@ static void
 exec_mpp_query(const char *query_string,
 			   const char * serializedQuerytree, int serializedQuerytreelen,
 			   const char * serializedPlantree, int serializedPlantreelen,
+			   int32 planHandle,
 			   const char * serializedParams, int serializedParamslen,
 			   const char * serializedQueryDispatchDesc, int serializedQueryDispatchDesclen)
 {
@@ -1075,8 +1078,16 @@ exec_mpp_query(const char *query_string,
 
  	/*
      * Deserialize the query execution plan (a PlannedStmt node), if there is one.
+     * A cached plan has been deserialized already, but is shared with the
+     * later executions of it.  The executor fills in some fields of the
+     * PlannedStmt itself, so make a copy of that, but not of the plan tree.
      */
-	if (serializedPlantree != NULL && serializedPlantreelen > 0)
+	if (planHandle != 0)
+	{
+		plan = makeNode(PlannedStmt);
+		memcpy(plan, QEPlanCacheGetPlan(planHandle), sizeof(PlannedStmt));
+	}
+	else if (serializedPlantree != NULL && serializedPlantreelen > 0)
 	{
 		plan = (PlannedStmt *) deserializeNode(serializedPlantree,serializedPlantreelen);
 		if (!plan || !IsA(plan, PlannedStmt))
@@ -1154,6 +1165,10 @@ exec_mpp_query(const char *query_string,
 			RangeTblEntry  *rte;
 			AclMode         removeperms = ACL_INSERT | ACL_UPDATE | ACL_DELETE | ACL_SELECT_FOR_UPDATE;
 
+			/* Don't clear the permissions in the cached plan. */
+			if (planHandle != 0)
+				plan->rtable = copyObject(plan->rtable);
+
 			/* Just reading, so don't check INS/DEL/UPD permissions. */
 			foreach(rtcell, plan->rtable)
 			{
@@ -5017,6 +5032,14 @@ PostgresMain(int argc, char *argv[],
 			send_ready_for_query = false;
 		}
 
+		/*
+		 * (1b) Now that the client has its answer, collect the
+		 * acknowledgements of a 'Commit Prepared' broadcast that the last
+		 * transaction left in flight.
+		 */
+		if (Gp_role == GP_ROLE_DISPATCH)
+			finishAsyncCommitPrepared();
+
 		/*
 		 * (2) Allow asynchronous signals to be executed immediately if they
 		 * come in while we are waiting for client input. (This must be
@@ -5150,6 +5173,7 @@ PostgresMain(int argc, char *argv[],
 					int serializedDtxContextInfolen = 0;
 					int serializedQuerytreelen = 0;
 					int serializedPlantreelen = 0;
+					int32 planHandle = 0;
 					int serializedParamslen = 0;
 					int serializedQueryDispatchDesclen = 0;
 					int resgroupInfoLen = 0;
@@ -5180,6 +5204,7 @@ PostgresMain(int argc, char *argv[],
 					query_string_len = pq_getmsgint(&input_message, 4);
 					serializedQuerytreelen = pq_getmsgint(&input_message, 4);
 					serializedPlantreelen = pq_getmsgint(&input_message, 4);
+					planHandle = (int32) pq_getmsgint(&input_message, 4);
 					serializedParamslen = pq_getmsgint(&input_message, 4);
 					serializedQueryDispatchDesclen = pq_getmsgint(&input_message, 4);
 					serializedDtxContextInfolen = pq_getmsgint(&input_message, 4);
@@ -5219,6 +5244,16 @@ PostgresMain(int argc, char *argv[],
 
 					pq_getmsgend(&input_message);
 
+					/*
+					 * A plan with a handle goes into the plan cache, and a
+					 * handle without a plan refers to one there, which
+					 * exec_mpp_query() gets.  Do this before anything can
+					 * fail, as the QD assumes that we have cached every plan
+					 * it sent.
+					 */
+					if (planHandle != 0 && serializedPlantreelen > 0)
+						QEPlanCacheAdd(planHandle, serializedPlantree, serializedPlantreelen);
+
 					elog((Debug_print_full_dtm ? LOG : DEBUG5), "MPP dispatched stmt from QD: %s.",query_string);
 
 					if (IsResGroupActivated() && resgroupInfoLen > 0)
@@ -5241,7 +5276,8 @@ PostgresMain(int argc, char *argv[],
 					if (cuid > 0)
 						SetUserIdAndContext(cuid, false); /* Set current userid */
 
-					if (serializedQuerytreelen==0 && serializedPlantreelen==0)
+					if (serializedQuerytreelen==0 && serializedPlantreelen==0 &&
+						planHandle == 0)
 					{
 						if (strncmp(query_string, "BEGIN", 5) == 0)
 						{
@@ -5272,6 +5308,7 @@ PostgresMain(int argc, char *argv[],
 						exec_mpp_query(query_string,
 									   serializedQuerytree, serializedQuerytreelen,
 									   serializedPlantree, serializedPlantreelen,
+									   planHandle,
 									   serializedParams, serializedParamslen,
 									   serializedQueryDispatchDesc, serializedQueryDispatchDesclen);
 
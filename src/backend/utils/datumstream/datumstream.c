@@ -295,6 +295,41 @@ datumstreamread_nthlarge(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Advance over up to 'maxvals' datums of the current block, storing them in
+ * values[] and nulls[].  Returns the number of datums read, which is less
+ * than 'maxvals' only if the end of the block was reached; the caller reads
+ * the next block once this returns 0.
+ *
+ * Pass-by-reference datums point into the block buffer, so they stay valid
+ * until the next block is read.
+ */
+int
+datumstreamread_get_batch(DatumStreamRead * acc, int maxvals,
+						  Datum *values, bool *nulls)
+{
+	int			n;
+
+	if (acc->largeObjectState != DatumStreamLargeObjectState_None)
+	{
+		/* A large object is the only datum of its block. */
+		if (maxvals <= 0 || datumstreamread_remaining(acc) == 0)
+			return 0;
+		datumstreamread_advancelarge(acc);
+		datumstreamread_getlarge(acc, &values[0], &nulls[0]);
+		return 1;
+	}
+
+	for (n = 0; n < maxvals; n++)
+	{
+		if (DatumStreamBlockRead_Advance(&acc->blockRead) == 0)
+			break;
+		DatumStreamBlockRead_Get(&acc->blockRead, &values[n], &nulls[n]);
+	}
+
+	return n;
+}
+
 
 int
 datumstreamwrite_put(
@@ -821,6 +856,9 @@ datumstreamwrite_open_file(DatumStreamWrite *ds, char *fn, int64 eof, int64 eofU
 									relFileNode,
 									segmentFileNum);
 
+	ds->blockWrite.dictionary_can_have_compression =
+		DatumStreamDictionaryAllowed(version);
+
 	ds->need_close_file = true;
 }
 
@@ -835,6 +873,9 @@ datumstreamread_open_file(DatumStreamRead * ds, char *fn, int64 eof, int64 eofUn
 
 	AppendOnlyStorageRead_OpenFile(&ds->ao_read, fn, version, ds->eof);
 
+	ds->blockRead.dictionary_can_have_compression =
+		DatumStreamDictionaryAllowed(version);
+
 	ds->need_close_file = true;
 }
 
@@ -1285,10 +1326,14 @@ datumstreamread_block_content(DatumStreamRead * acc)
 }
 
 
+/*
+ * Read the header of the next block, without reading its content.
+ *
+ * Returns -1 if there are no more blocks.  Otherwise the caller must follow
+ * up with either datumstreamread_block_content or datumstreamread_block_skip.
+ */
 int
-datumstreamread_block(DatumStreamRead * acc,
-					  AppendOnlyBlockDirectory *blockDirectory,
-					  int colGroupNo)
+datumstreamread_block_header(DatumStreamRead * acc)
 {
 	bool		readOK = false;
 
@@ -1346,6 +1391,55 @@ datumstreamread_block(DatumStreamRead * acc,
 			 acc->blockFileOffset,
 			 acc->blockRowCount);
 
+	return 0;
+}
+
+/*
+ * Skip over the block whose header was just read, without decompressing it.
+ */
+void
+datumstreamread_block_skip(DatumStreamRead * acc)
+{
+	Assert(acc);
+
+	AppendOnlyStorageRead_SkipCurrentBlock(&acc->ao_read);
+
+	DatumStreamBlockRead_Reset(&acc->blockRead);
+	acc->largeObjectState = DatumStreamLargeObjectState_None;
+}
+
+/*
+ * Drop the rest of the current block, whose content has already been read.
+ */
+void
+datumstreamread_block_discard(DatumStreamRead * acc)
+{
+	Assert(acc);
+
+	DatumStreamBlockRead_Reset(&acc->blockRead);
+	acc->largeObjectState = DatumStreamLargeObjectState_None;
+}
+
+/*
+ * Advance past the next 'n' datums of the current block.
+ */
+void
+datumstreamread_skip(DatumStreamRead * acc, int n)
+{
+	Assert(n <= datumstreamread_remaining(acc));
+
+	while (n-- > 0)
+		datumstreamread_advance(acc);
+}
+
+int
+datumstreamread_block(DatumStreamRead * acc,
+					  AppendOnlyBlockDirectory *blockDirectory,
+					  int colGroupNo)
+{
+	if (datumstreamread_block_header(acc) < 0)
+		return -1;
+
 	datumstreamread_block_content(acc);
 
 	if (blockDirectory)
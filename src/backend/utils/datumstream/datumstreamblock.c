@@ -13,6 +13,7 @@
  */
 
 #include "postgres.h"
+#include "access/hash.h"
 #include "access/tupmacs.h"
 #include "access/tuptoaster.h"
 #include "utils/datumstreamblock.h"
@@ -360,6 +361,9 @@ DatumStreamBlockRead_Init(
 
 	dsr->rle_can_have_compression = rle_can_have_compression;
 
+	/* Allowed per segfile by datumstreamread_open_file() */
+	dsr->dictionary_can_have_compression = false;
+
 	dsr->errdetailCallback = errdetailCallback;
 	dsr->errcontextArg = errcontextArg;
 	dsr->errcontextCallback = errcontextCallback;
@@ -403,7 +407,12 @@ void
 DatumStreamBlockRead_Finish(
 							DatumStreamBlockRead * dsr)
 {
-	/* Place holder. */
+	if (dsr->dictionary_entries != NULL)
+	{
+		pfree(dsr->dictionary_entries);
+		dsr->dictionary_entries = NULL;
+		dsr->dictionary_entries_maxcount = 0;
+	}
 }
 
 /*
@@ -609,6 +618,143 @@ DatumStreamBlockRead_ResetDense(DatumStreamBlockRead * dsr)
 
 	dsr->delta_block_was_compressed = false;
 	dsr->delta_item = false;
+
+	dsr->dictionary_block_was_compressed = false;
+	dsr->dictionary_entry_count = 0;
+	dsr->dictionary_index_width = 0;
+	dsr->dictionary_indexesp = NULL;
+}
+
+/*
+ * Set up reading a dictionary encoded block, whose dictionary extension
+ * starts at 'p'.
+ */
+static void
+DatumStreamBlockRead_GetReadyDictionary(
+										DatumStreamBlockRead * dsr,
+										uint8 * p,
+										int32 bufferSize)
+{
+	DatumStreamBlock_Dictionary_Extension dictionaryExtension;
+	int32		unalignedHeaderSize;
+	uint8	   *entryp;
+	int32		i;
+
+	/* The extension follows the bit-maps, so it may not be aligned. */
+	memcpy(&dictionaryExtension, p, sizeof(DatumStreamBlock_Dictionary_Extension));
+	p += sizeof(DatumStreamBlock_Dictionary_Extension);
+
+	dsr->dictionary_entry_count = dictionaryExtension.entry_count;
+	dsr->dictionary_index_width = dictionaryExtension.index_width;
+
+	if (dsr->typeInfo.datumlen != -1 ||
+		dsr->physical_datum_count <= 0 ||
+		dsr->dictionary_entry_count <= 0 ||
+		dsr->dictionary_entry_count > DICTIONARY_MAX_ENTRIES ||
+		(dsr->dictionary_index_width != 1 && dsr->dictionary_index_width != 2))
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream Dense block dictionary "
+						"(datum length %d, physical datum count %d, dictionary entry count %d, index width %d)",
+						dsr->typeInfo.datumlen,
+						dsr->physical_datum_count,
+						dsr->dictionary_entry_count,
+						dsr->dictionary_index_width),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
+
+	dsr->dictionary_indexesp = p;
+	p += dsr->physical_datum_count * dsr->dictionary_index_width;
+
+	unalignedHeaderSize = (int32) (p - dsr->buffer_beginp);
+
+	/*
+	 * Skip over alignment padding.
+	 */
+	dsr->datum_beginp = dsr->buffer_beginp + MAXALIGN(unalignedHeaderSize);
+	dsr->datum_afterp = dsr->datum_beginp + dsr->physical_data_size;
+
+	if (dsr->datum_afterp > dsr->buffer_beginp + bufferSize)
+	{
+		ereport(ERROR,
+				(errmsg("Datum stream Dense block dictionary goes beyond end of block "
+						"(header size %d, dictionary size %d, block size %d)",
+						(int32) MAXALIGN(unalignedHeaderSize),
+						dsr->physical_data_size,
+						bufferSize),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
+
+	if (dsr->dictionary_entries_maxcount < dsr->dictionary_entry_count)
+	{
+		MemoryContext oldCtxt;
+
+		oldCtxt = MemoryContextSwitchTo(dsr->memctxt);
+		if (dsr->dictionary_entries != NULL)
+			pfree(dsr->dictionary_entries);
+		dsr->dictionary_entries_maxcount = dsr->dictionary_entry_count;
+		dsr->dictionary_entries = palloc(dsr->dictionary_entries_maxcount * sizeof(uint8 *));
+		MemoryContextSwitchTo(oldCtxt);
+	}
+
+	/*
+	 * The entries are laid out like the items of a block without a
+	 * dictionary.
+	 */
+	entryp = dsr->datum_beginp;
+	for (i = 0; i < dsr->dictionary_entry_count; i++)
+	{
+		if (i > 0 && entryp < dsr->datum_afterp && *entryp == 0)
+			entryp = (uint8 *) att_align_nominal(entryp, dsr->typeInfo.align);
+
+		if (entryp >= dsr->datum_afterp)
+		{
+			ereport(ERROR,
+					(errmsg("Datum stream Dense block dictionary entry %d is beyond the dictionary "
+							"(dictionary entry count %d, dictionary size %d)",
+							i,
+							dsr->dictionary_entry_count,
+							dsr->physical_data_size),
+					 errdetail_datumstreamblockread(dsr),
+					 errcontext_datumstreamblockread(dsr)));
+		}
+
+		dsr->dictionary_entries[i] = entryp;
+		entryp += VARSIZE_ANY(entryp);
+	}
+
+	/*
+	 * Check the indexes once here, so that advancing can use them as is.
+	 */
+	for (i = 0; i < dsr->physical_datum_count; i++)
+	{
+		int32		entry;
+
+		if (dsr->dictionary_index_width == 1)
+			entry = dsr->dictionary_indexesp[i];
+		else
+			entry = dsr->dictionary_indexesp[2 * i] |
+				((int32) dsr->dictionary_indexesp[2 * i + 1] << 8);
+
+		if (entry >= dsr->dictionary_entry_count)
+		{
+			ereport(ERROR,
+					(errmsg("Datum stream Dense block dictionary index %d of physical datum %d is out of range "
+							"(dictionary entry count %d)",
+							entry,
+							i,
+							dsr->dictionary_entry_count),
+					 errdetail_datumstreamblockread(dsr),
+					 errcontext_datumstreamblockread(dsr)));
+		}
+	}
+
+	/*
+	 * Pre-position to the first item.
+	 */
+	dsr->datump = DatumStreamBlockRead_DictionaryItem(dsr, 0);
 }
 
 void
@@ -942,6 +1088,20 @@ DatumStreamBlockRead_GetReadyDense(
 					 errcontext_datumstreamblockread(dsr)));
 		}
 	}
+
+	dsr->dictionary_block_was_compressed = ((blockDense->orig_4_bytes.flags & DSB_HAS_DICTIONARY_COMPRESSION) != 0);
+	if (dsr->dictionary_block_was_compressed)
+	{
+		if (!dsr->dictionary_can_have_compression)
+			ereport(ERROR,
+					(errmsg("Datum stream block is dictionary encoded, but the format version of its segment file does not allow it"),
+					 errdetail_datumstreamblockread(dsr),
+					 errcontext_datumstreamblockread(dsr)));
+
+		DatumStreamBlockRead_GetReadyDictionary(dsr, p, bufferSize);
+		return;
+	}
+
 	dsr->datump = dsr->datum_beginp;
 }
 
@@ -3763,6 +3923,135 @@ DatumStreamBlockWrite_BlockOrig(
 	return writesz;
 }
 
+/*
+ * Try to replace the variable-length items of the block with a dictionary of
+ * its distinct items, plus an index into the dictionary per item.
+ *
+ * Returns true if that is smaller than the items, with the dictionary in
+ * dictionary_buffer, its size in *dictionaryDataSize, and a palloc'd array of
+ * the index of each physical datum in *indexes.
+ */
+static bool
+DatumStreamBlockWrite_DictionaryEncode(
+									   DatumStreamBlockWrite * dsw,
+									   DatumStreamBlock_Dictionary_Extension * dictionaryExtension,
+									   int32 * dictionaryDataSize,
+									   uint16 ** indexes)
+{
+	int32		count = dsw->physical_datum_count;
+	int32		dataSize = (int32) (dsw->datump - dsw->datum_buffer);
+	int32		maxEntries;
+	int32		hashSize;
+	int32	   *hash;
+	uint8	  **entries;
+	uint16	   *itemIndexes;
+	int32		entryCount;
+	int32		indexWidth;
+	int32		encodedSize;
+	uint8	   *p;
+	uint8	   *dictp;
+	uint8	   *dictafterp;
+	int32		i;
+	bool		result = false;
+
+	Assert(dsw->dictionary_want_compression);
+
+	if (count < 2)
+		return false;
+
+	maxEntries = Min(count, DICTIONARY_MAX_ENTRIES);
+	hashSize = 1;
+	while (hashSize < 2 * maxEntries)
+		hashSize <<= 1;
+
+	hash = palloc(hashSize * sizeof(int32));
+	memset(hash, -1, hashSize * sizeof(int32));
+	entries = palloc(maxEntries * sizeof(uint8 *));
+	itemIndexes = palloc(count * sizeof(uint16));
+
+	/*
+	 * Walk the items the way a reader does, and lay out each new distinct
+	 * item in the dictionary the way PutDense lays out items.
+	 */
+	p = dsw->datum_buffer;
+	dictp = dsw->dictionary_buffer;
+	dictafterp = dsw->dictionary_buffer + Min(dataSize, dsw->dictionary_buffer_size);
+	entryCount = 0;
+	for (i = 0; i < count; i++)
+	{
+		int32		len;
+		uint32		h;
+		int32		entry;
+
+		if (i > 0 && *p == 0)
+			p = (uint8 *) att_align_nominal(p, dsw->typeInfo->align);
+
+		len = VARSIZE_ANY(p);
+
+		h = DatumGetUInt32(hash_any(p, len)) & (hashSize - 1);
+		while ((entry = hash[h]) >= 0)
+		{
+			if (VARSIZE_ANY(entries[entry]) == len &&
+				memcmp(entries[entry], p, len) == 0)
+				break;
+			h = (h + 1) & (hashSize - 1);
+		}
+
+		if (entry < 0)
+		{
+			if (entryCount >= maxEntries)
+				goto done;
+
+			if (!VARATT_IS_SHORT(p))
+				dictp = (uint8 *) att_align_zero((char *) dictp, dsw->typeInfo->align);
+			if (dictp + len > dictafterp)
+				goto done;		/* not smaller */
+
+			memcpy(dictp, p, len);
+			entries[entryCount] = dictp;
+			entry = entryCount++;
+			hash[h] = entry;
+
+			dictp += len;
+		}
+
+		itemIndexes[i] = (uint16) entry;
+		p += len;
+	}
+	Assert(p == dsw->datump);
+
+	indexWidth = (entryCount <= 256 ? 1 : 2);
+	*dictionaryDataSize = (int32) (dictp - dsw->dictionary_buffer);
+	encodedSize = sizeof(DatumStreamBlock_Dictionary_Extension) +
+		count * indexWidth +
+		*dictionaryDataSize;
+
+	/*
+	 * Leave room for extra alignment padding of the meta-data, so the
+	 * block never grows.
+	 */
+	if (encodedSize + MAXIMUM_ALIGNOF >= dataSize)
+		goto done;
+
+	dictionaryExtension->entry_count = entryCount;
+	dictionaryExtension->index_width = indexWidth;
+	*indexes = itemIndexes;
+	itemIndexes = NULL;
+
+	/* Account for the encoding like we do for RLE_TYPE compression. */
+	dsw->savings += dataSize - encodedSize;
+
+	result = true;
+
+done:
+	pfree(hash);
+	pfree(entries);
+	if (itemIndexes != NULL)
+		pfree(itemIndexes);
+
+	return result;
+}
+
 static int64
 DatumStreamBlockWrite_BlockDense(
 								 DatumStreamBlockWrite * dsw,
@@ -3773,10 +4062,15 @@ DatumStreamBlockWrite_BlockDense(
 	DatumStreamBlock_Dense dense;
 	DatumStreamBlock_Rle_Extension rle_extension;
 	DatumStreamBlock_Delta_Extension delta_extension;
+	DatumStreamBlock_Dictionary_Extension dictionary_extension;
 	int32		headerSize;
 	int32		nullSize;
 	int32		rleSize;
 	int32		deltaSize;
+	int32		dictionarySize;
+	int32		dictionaryDataSize;
+	uint16	   *dictionaryIndexes;
+	bool		dictionaryHasCompression;
 	int32		metadataSize;
 	int32		metadataMaxAlignSize;
 	int32		nullPadSize;
@@ -3799,6 +4093,16 @@ DatumStreamBlockWrite_BlockDense(
 		DatumStreamBlockWrite_RleFinalizeRepeatCountSize(dsw);
 	}
 
+	dictionaryIndexes = NULL;
+	dictionaryDataSize = 0;
+	dictionaryHasCompression =
+		(dsw->dictionary_want_compression &&
+		 dsw->dictionary_can_have_compression &&
+		 DatumStreamBlockWrite_DictionaryEncode(dsw,
+												&dictionary_extension,
+												&dictionaryDataSize,
+												&dictionaryIndexes));
+
 	p = buffer;
 
 	/* First fill in orig header portion */
@@ -3814,9 +4118,17 @@ DatumStreamBlockWrite_BlockDense(
 		dense.orig_4_bytes.flags |= DSB_HAS_DELTA_COMPRESSION;
 	}
 
+	if (dictionaryHasCompression)
+	{
+		dense.orig_4_bytes.flags |= DSB_HAS_DICTIONARY_COMPRESSION;
+	}
+
 	dense.logical_row_count = dsw->nth;
 	dense.physical_datum_count = dsw->physical_datum_count;
-	dense.physical_data_size = dsw->datump - dsw->datum_buffer;
+	if (dictionaryHasCompression)
+		dense.physical_data_size = dictionaryDataSize;
+	else
+		dense.physical_data_size = dsw->datump - dsw->datum_buffer;
 
 	headerSize = sizeof(DatumStreamBlock_Dense);
 
@@ -3915,10 +4227,25 @@ DatumStreamBlockWrite_BlockDense(
 		deltaSize = 0;
 	}
 
+	/*
+	 * Add in the dictionary extension and the index of each physical datum.
+	 * The datum area holds just the dictionary.
+	 */
+	if (dictionaryHasCompression)
+	{
+		headerSize += sizeof(DatumStreamBlock_Dictionary_Extension);
+
+		dictionarySize = dense.physical_datum_count * dictionary_extension.index_width;
+	}
+	else
+	{
+		dictionarySize = 0;
+	}
+
 	/*
 	 * Align headers and meta-data (e.g. NULL bit-maps, etc).
 	 */
-	metadataSize = headerSize + nullSize + rleSize + deltaSize;
+	metadataSize = headerSize + nullSize + rleSize + deltaSize + dictionarySize;
 	metadataMaxAlignSize = MAXALIGN(metadataSize);
 
 	memcpy(p, &dense, sizeof(DatumStreamBlock_Dense));
@@ -3999,6 +4326,22 @@ DatumStreamBlockWrite_BlockDense(
 		}
 	}
 
+	/* Add the dictionary extension and indexes, after all other meta-data */
+	if (dictionaryHasCompression)
+	{
+		int			i;
+
+		memcpy(p, &dictionary_extension, sizeof(DatumStreamBlock_Dictionary_Extension));
+		p += sizeof(DatumStreamBlock_Dictionary_Extension);
+
+		for (i = 0; i < dense.physical_datum_count; i++)
+		{
+			*(p++) = (uint8) dictionaryIndexes[i];
+			if (dictionary_extension.index_width == 2)
+				*(p++) = (uint8) (dictionaryIndexes[i] >> 8);
+		}
+	}
+
 	/*
 	 * Were our meta-data size calculations correct?
 	 */
@@ -4040,7 +4383,13 @@ DatumStreamBlockWrite_BlockDense(
 				 errcontext_datumstreamblockwrite(dsw)));
 	}
 
-	memcpy(p, dsw->datum_buffer, dense.physical_data_size);
+	if (dictionaryHasCompression)
+	{
+		memcpy(p, dsw->dictionary_buffer, dense.physical_data_size);
+		pfree(dictionaryIndexes);
+	}
+	else
+		memcpy(p, dsw->datum_buffer, dense.physical_data_size);
 	p += dense.physical_data_size;
 
 	/* Calculate write size. */
@@ -4174,6 +4523,21 @@ DatumStreamBlockWrite_BlockDense(
 					 errdetail_datumstreamblockwrite(dsw),
 					 errcontext_datumstreamblockwrite(dsw)));
 		}
+
+		if (dictionaryHasCompression)
+		{
+			ereport(LOG,
+					(errmsg("Datum stream write Dense block formatted with DICTIONARY compression "
+							"(dictionary entry count %d, index width %d, dictionary size %d, "
+							"physical datum count %d, items size %d)",
+							dictionary_extension.entry_count,
+							dictionary_extension.index_width,
+							dense.physical_data_size,
+							dense.physical_datum_count,
+							(int32) (dsw->datump - dsw->datum_buffer)),
+					 errdetail_datumstreamblockwrite(dsw),
+					 errcontext_datumstreamblockwrite(dsw)));
+		}
 	}
 
 #ifdef USE_ASSERT_CHECKING
@@ -4251,6 +4615,19 @@ DatumStreamBlockWrite_Init(
 	dsw->rle_want_compression = rle_want_compression;
 	dsw->delta_want_compression = delta_want_compression;
 
+	/*
+	 * Dictionary encoding is decided per block, after RLE_TYPE compression,
+	 * for variable-length items only.
+	 */
+	dsw->dictionary_want_compression =
+		(gp_aocs_dictionary_encoding &&
+		 rle_want_compression &&
+		 datumStreamVersion == DatumStreamVersion_Dense_Enhanced &&
+		 typeInfo->datumlen == -1);
+
+	/* Allowed per segfile by datumstreamwrite_open_file() */
+	dsw->dictionary_can_have_compression = false;
+
 	dsw->initialMaxDatumPerBlock = initialMaxDatumPerBlock;
 	dsw->maxDatumPerBlock = maxDatumPerBlock;
 
@@ -4398,6 +4775,15 @@ DatumStreamBlockWrite_Init(
 				Assert(dsw->delta_sign == NULL);
 			}
 
+			if (dsw->dictionary_want_compression)
+			{
+				/*
+				 * A dictionary is only used when it's smaller than the items.
+				 */
+				dsw->dictionary_buffer_size = dsw->datum_buffer_size;
+				dsw->dictionary_buffer = palloc(dsw->dictionary_buffer_size);
+			}
+
 			if (Debug_appendonly_print_insert)
 			{
 				ereport(LOG,
@@ -4460,6 +4846,9 @@ DatumStreamBlockWrite_Finish(
 	if (dsw->delta_sign != NULL)
 		pfree(dsw->delta_sign);
 
+	if (dsw->dictionary_buffer != NULL)
+		pfree(dsw->dictionary_buffer);
+
 	MemoryContextSwitchTo(oldCtxt);
 }
 
@@ -4876,6 +5265,114 @@ DatumStreamBlock_IntegrityCheckDenseDelta(
 	}
 }
 
+/*
+ * Verify the dictionary extension and indexes of a Dense block, which start
+ * at 'p', 'headerSize' bytes into the block.  Returns the aligned size of
+ * all the meta-data, where the dictionary entries begin.
+ */
+static int32
+DatumStreamBlock_IntegrityCheckDenseDictionary(
+											   DatumStreamBlock_Dense * blockDense,
+											   uint8 * p,
+											   int32 bufferSize,
+											   int32 headerSize,
+											   bool hasDeltaCompression,
+											   DatumStreamTypeInfo * typeInfo,
+							   int (*errdetailCallback) (void *errdetailArg),
+											   void *errdetailArg,
+							 int (*errcontextCallback) (void *errcontextArg),
+											   void *errcontextArg)
+{
+	DatumStreamBlock_Dictionary_Extension dictionaryExtension;
+	int32		alignedHeaderSize;
+	int			i;
+
+	if (typeInfo->datumlen != -1 || hasDeltaCompression)
+	{
+		ereport(ERROR,
+				(errmsg("DICTIONARY compression is only expected for variable-length items without DELTA compression "
+						"(datum length %d, has DELTA compression %s)",
+						typeInfo->datumlen,
+						(hasDeltaCompression ? "true" : "false")),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
+	headerSize += sizeof(DatumStreamBlock_Dictionary_Extension);
+	if (bufferSize < headerSize)
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream DICTIONARY block header extension size. Found %d and expected the size to be at least %d",
+						bufferSize,
+						headerSize),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
+	memcpy(&dictionaryExtension, p, sizeof(DatumStreamBlock_Dictionary_Extension));
+	p += sizeof(DatumStreamBlock_Dictionary_Extension);
+
+	if (dictionaryExtension.entry_count <= 0 ||
+		dictionaryExtension.entry_count > DICTIONARY_MAX_ENTRIES ||
+		dictionaryExtension.entry_count > blockDense->physical_datum_count)
+	{
+		ereport(ERROR,
+				(errmsg("DICTIONARY entry count %d is expected to be greater than 0 and at most %d and the physical datum count %d",
+						dictionaryExtension.entry_count,
+						DICTIONARY_MAX_ENTRIES,
+						blockDense->physical_datum_count),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
+	if (dictionaryExtension.index_width != 1 &&
+		dictionaryExtension.index_width != 2)
+	{
+		ereport(ERROR,
+				(errmsg("DICTIONARY index width %d is expected to be 1 or 2",
+						dictionaryExtension.index_width),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
+	headerSize += blockDense->physical_datum_count * dictionaryExtension.index_width;
+	alignedHeaderSize = MAXALIGN(headerSize);
+
+	if (bufferSize < alignedHeaderSize + blockDense->physical_data_size)
+	{
+		ereport(ERROR,
+				(errmsg("Expected DICTIONARY header size %d including indexes plus dictionary size %d is larger than buffer size %d",
+						alignedHeaderSize,
+						blockDense->physical_data_size,
+						bufferSize),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
+	for (i = 0; i < blockDense->physical_datum_count; i++)
+	{
+		int32		entry;
+
+		if (dictionaryExtension.index_width == 1)
+			entry = p[i];
+		else
+			entry = p[2 * i] | ((int32) p[2 * i + 1] << 8);
+
+		if (entry >= dictionaryExtension.entry_count)
+		{
+			ereport(ERROR,
+					(errmsg("DICTIONARY index %d of physical datum %d is not less than the entry count %d",
+							entry,
+							i,
+							dictionaryExtension.entry_count),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+	}
+
+	return alignedHeaderSize;
+}
+
 static void
 DatumStreamBlock_IntegrityCheckDense(
 									 uint8 * buffer,
@@ -4898,6 +5395,7 @@ DatumStreamBlock_IntegrityCheckDense(
 	bool		hasNull;
 	bool		hasRleCompression;
 	bool		hasDeltaCompression;
+	bool		hasDictionaryCompression;
 
 	int32		alignedHeaderSize;
 	int32		deltaOnCount;
@@ -4934,16 +5432,29 @@ DatumStreamBlock_IntegrityCheckDense(
 				 errcontextCallback(errcontextArg)));
 	}
 
+	/*
+	 * A flag we don't know means a layout we can't read, so check this even
+	 * with minimal integrity checks.
+	 */
+	if ((blockDense->orig_4_bytes.flags & ~DSB_KNOWN_FLAGS) != 0)
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream Dense block flags.  Found 0x%x with unknown flags 0x%x",
+						blockDense->orig_4_bytes.flags,
+						blockDense->orig_4_bytes.flags & ~DSB_KNOWN_FLAGS),
+				 errdetailCallback(errdetailArg),
+				 errcontextCallback(errcontextArg)));
+	}
+
 	if (minimalIntegrityChecks)
 	{
 		return;
 	}
 
-	/* CONSIDER: Verify reserved flags are Zero */
-
 	hasNull = ((blockDense->orig_4_bytes.flags & DSB_HAS_NULLBITMAP) != 0);
 	hasRleCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_RLE_COMPRESSION) != 0);
 	hasDeltaCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_DELTA_COMPRESSION) != 0);
+	hasDictionaryCompression = ((blockDense->orig_4_bytes.flags & DSB_HAS_DICTIONARY_COMPRESSION) != 0);
 
 	/*
 	 * Verify logical row count.
@@ -5020,8 +5531,11 @@ DatumStreamBlock_IntegrityCheckDense(
 
 		/*
 		 * This check will make it safer to do multiplication of datum count and datum length.
+		 *
+		 * With a dictionary, the data is just the distinct items.
 		 */
-		if (blockDense->physical_datum_count > blockDense->physical_data_size)
+		if (!hasDictionaryCompression &&
+			blockDense->physical_datum_count > blockDense->physical_data_size)
 		{
 			ereport(ERROR,
 					(errmsg("More physical items %d than physical bytes %d",
@@ -5418,6 +5932,21 @@ DatumStreamBlock_IntegrityCheckDense(
 		/* UNDONE: Verify zero padding */
 	}
 
+	if (hasDictionaryCompression)
+	{
+		alignedHeaderSize = DatumStreamBlock_IntegrityCheckDenseDictionary(
+																		   blockDense,
+																		   p,
+																		   bufferSize,
+																		   headerSize,
+																		   hasDeltaCompression,
+																		   typeInfo,
+																		   errdetailCallback,
+																		   errdetailArg,
+																		   errcontextCallback,
+																		   errcontextArg);
+	}
+
 	if (hasDeltaCompression)
 	{
 		DatumStreamBlock_IntegrityCheckDenseDelta(
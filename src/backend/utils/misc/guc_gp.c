@@ -134,11 +134,17 @@ bool		Debug_bitmap_print_insert = false;
 bool		Test_print_direct_dispatch_info = false;
 bool		Test_copy_qd_qe_split = false;
 bool		gp_permit_relation_node_change = false;
-int			gp_max_local_distributed_cache = 1024;
+int			gp_max_local_distributed_cache = 8192;
 bool		gp_appendonly_verify_block_checksums = true;
 bool		gp_appendonly_verify_write_block = false;
 bool		gp_appendonly_compaction = true;
 int			gp_appendonly_compaction_threshold = 0;
+int			gp_appendonly_read_ahead = 1;
+int			gp_appendonly_decompress_threads = 1;
+int			gp_aocs_scan_batch_size = 0;
+int			gp_aocs_block_minmax_cache_size = 65536;
+bool		gp_aocs_dictionary_encoding = false;
+bool		gp_aocs_late_materialization = true;
 bool		gp_heap_require_relhasoids_match = true;
 bool		gp_local_distributed_cache_stats = false;
 bool		debug_xlog_record_read = false;
@@ -154,6 +160,7 @@ bool		gp_create_table_random_default_distribution = true;
 bool		gp_allow_non_uniform_partitioning_ddl = true;
 bool		gp_enable_exchange_default_partition = false;
 int			dtx_phase2_retry_count = 0;
+bool		gp_dtx_async_commit_prepared = false;
 
 bool		log_dispatch_stats = false;
 
@@ -428,6 +435,7 @@ bool		gp_reject_internal_tcp_conn = true;
 
 /* copy */
 bool		gp_enable_segment_copy_checking = true;
+int			gp_copy_dispatch_batch_size = 0;
 /*
  * Default storage options GUC.  Value is comma-separated name=value
  * pairs.  E.g. "appendonly=true,orientation=column"
@@ -531,6 +539,14 @@ static const struct config_enum_entry gp_interconnect_types[] = {
 	{NULL, 0}
 };
 
+static const struct config_enum_entry gp_interconnect_compressions[] = {
+	{"none", INTERCONNECT_COMPRESSION_NONE},
+#ifdef HAVE_LIBZ
+	{"zlib", INTERCONNECT_COMPRESSION_ZLIB},
+#endif
+	{NULL, 0}
+};
+
 static const struct config_enum_entry gp_log_verbosity[] = {
 	{"terse", GPVARS_VERBOSITY_TERSE},
 	{"off", GPVARS_VERBOSITY_OFF},
@@ -661,6 +677,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_enable_dispatch_plan_cache", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Cache dispatched plans on the master and the segments."),
+			gettext_noop("A plan that is dispatched again is not compressed again, "
+						 "and segments that already have it get only a handle.")
+		},
+		&gp_enable_dispatch_plan_cache,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"gp_enable_predicate_propagation", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("When two expressions are equivalent (such as with "
@@ -868,6 +894,30 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_hashagg_open_addressing", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Use an open-addressing hash table in hash aggregation."),
+			gettext_noop("Groups are found by linear probing in an array that holds each group's "
+						 "hash value, instead of by following a chain of entries."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&gp_hashagg_open_addressing,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_hashjoin_bloomfilter", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Filter the outer scan of a hash join using a Bloom filter of the inner keys."),
+			gettext_noop("The filter is built along with the hash table and applied in a "
+						 "sequential scan directly below the join, before its quals are evaluated."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&gp_hashjoin_bloomfilter,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_enable_motion_deadlock_sanity", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Enable verbose check at planning time."),
@@ -1000,6 +1050,28 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_aocs_dictionary_encoding", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Dictionary encode variable-length columns of RLE_TYPE compressed column-oriented tables."),
+			gettext_noop("Each block stores its distinct values once, with a small index per value, "
+						 "when that is smaller than storing the values themselves. Only segment files "
+						 "created while this is on, which get append-only format version 4, are encoded.")
+		},
+		&gp_aocs_dictionary_encoding,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_late_materialization", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Read only the columns the quals need before filtering rows in batched scans of column-oriented tables."),
+			gettext_noop("The other projected columns are then read only for the rows that pass the quals.")
+		},
+		&gp_aocs_late_materialization,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_heap_require_relhasoids_match", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Issue an error on discovery of a mismatch between relhasoids and a tuple header."),
@@ -1106,6 +1178,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_local_transport", PGC_BACKEND, GP_ARRAY_TUNING,
+			gettext_noop("Use AF_UNIX datagram sockets for UDP interconnect traffic between processes on the same host."),
+			gettext_noop("Must have the same value in all segments. The kernel's per-socket datagram queue limit "
+						 "(net.unix.max_dgram_qlen on Linux) should be raised when enabling this.")
+		},
+		&Gp_interconnect_local_transport,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_full_crc", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Sanity check incoming data stream."),
@@ -1189,6 +1272,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_dtx_async_commit_prepared", PGC_USERSET, WAL_SETTINGS,
+			gettext_noop("Reports the commit of a distributed transaction before the segments acknowledge 'Commit Prepared'."),
+			gettext_noop("The acknowledgements are collected before the session runs its next command. "
+						 "Until then other sessions still see the transaction as in progress.")
+		},
+		&gp_dtx_async_commit_prepared,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"debug_print_snapshot_dtm", PGC_SUSET, LOGGING_WHAT,
 			gettext_noop("Prints snapshot DTM information to server log."),
@@ -2976,6 +3070,18 @@ struct config_bool ConfigureNamesBool_gp[] =
 
 struct config_int ConfigureNamesInt_gp[] =
 {
+	{
+		{"gp_copy_dispatch_batch_size", PGC_USERSET, CUSTOM_OPTIONS,
+			gettext_noop("Sets the size of the batches in which the master forwards COPY FROM rows to each segment."),
+			gettext_noop("The batches are sent by a separate thread while the master parses the rows that follow. "
+						 "Zero forwards each row as it is parsed."),
+			GUC_UNIT_KB
+		},
+		&gp_copy_dispatch_batch_size,
+		0, 0, 16384,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"readable_external_table_timeout", PGC_USERSET, EXTERNAL_TABLES,
 			gettext_noop("Cancel the query if no data read within N seconds."),
@@ -3004,7 +3110,7 @@ struct config_int ConfigureNamesInt_gp[] =
 			NULL
 		},
 		&gp_max_local_distributed_cache,
-		1024, 0, INT_MAX,
+		8192, 0, INT_MAX,
 		NULL, NULL, NULL
 	},
 
@@ -3145,6 +3251,52 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_read_ahead", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets the number of large reads of append-only segment files to prefetch ahead of a scan."),
+			gettext_noop("The kernel is asked to start reading this many large reads past the one being "
+						 "decompressed, so that the next physical read overlaps it. Zero disables this.")
+		},
+		&gp_appendonly_read_ahead,
+		1, 0, 16,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_decompress_threads", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets the number of threads that decompress blocks of append-only tables during a scan."),
+			gettext_noop("Compressed blocks that follow the one being read are decompressed ahead "
+						 "of time by this many threads. One decompresses a block at a time.")
+		},
+		&gp_appendonly_decompress_threads,
+		1, 1, 32,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_scan_batch_size", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets the number of rows that sequential scans of column-oriented tables read per column at a time."),
+			gettext_noop("Values are decoded from each column's blocks in batches of up to this many rows. "
+						 "Zero reads one row at a time.")
+		},
+		&gp_aocs_scan_batch_size,
+		0, 0, 65536,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_aocs_block_minmax_cache_size", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets the number of column blocks whose min/max values each session remembers."),
+			gettext_noop("Batched sequential scans of column-oriented tables (gp_aocs_scan_batch_size > 0) "
+						 "skip blocks whose min/max values, remembered from earlier scans in the session, "
+						 "can't satisfy the scan's quals. Nothing is stored on disk, so the first scan "
+						 "of a block doesn't benefit; append-optimized row tables never do. Zero disables this.")
+		},
+		&gp_aocs_block_minmax_cache_size,
+		65536, 0, INT_MAX / 2,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_workfile_max_entries", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Sets the maximum number of entries that can be stored in the workfile directory"),
@@ -3330,6 +3482,39 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_tuple_batch_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the size (in bytes) of the per-route tuple batches built by Motion senders."),
+			gettext_noop("Tuples sent to the same receiver are accumulated and sent as one message "
+						 "once this many bytes are buffered. Zero disables batching.")
+		},
+		&Gp_interconnect_tuple_batch_size,
+		0, 0, 1024 * 1024,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_mmsg_batch_size", PGC_BACKEND, GP_ARRAY_TUNING,
+			gettext_noop("Sets the maximum number of packets sent or received with one system call by the UDP interconnect."),
+			gettext_noop("Values larger than 1 make the UDP interconnect use sendmmsg() and recvmmsg(), "
+						 "where the platform supports them.")
+		},
+		&Gp_interconnect_mmsg_batch_size,
+		1, 1, 64,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_rx_threads", PGC_BACKEND, GP_ARRAY_TUNING,
+			gettext_noop("Sets the number of receive threads used by the UDP interconnect."),
+			gettext_noop("Each thread polls its own socket bound to the interconnect port, "
+						 "and incoming packets are sharded across the threads by flow.")
+		},
+		&Gp_interconnect_rx_threads,
+		1, 1, 64,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_timer_period", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the timer period (in ms) for UDP interconnect"),
@@ -3702,6 +3887,18 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_hashjoin_build_threads", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Number of threads used to build the in-memory hash table of a hash join."),
+			gettext_noop("When greater than 1, inner tuples are linked into their buckets "
+						 "in parallel after the inner side has been read."),
+			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL
+		},
+		&gp_hashjoin_build_threads,
+		1, 1, 64,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_hashagg_groups_per_bucket", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Target density of hashtable used by Hashagg during execution"),
@@ -4617,6 +4814,17 @@ struct config_enum ConfigureNamesEnum_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_compression", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the compression method for the tuple batches sent by Motion senders."),
+			gettext_noop("Valid values are \"none\" and \"zlib\". Batches that don't compress "
+						 "well are sent uncompressed.")
+		},
+		&Gp_interconnect_compression,
+		INTERCONNECT_COMPRESSION_NONE, gp_interconnect_compressions,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_type", PGC_BACKEND, GP_ARRAY_TUNING,
 			gettext_noop("Sets the protocol used for inter-node communication."),
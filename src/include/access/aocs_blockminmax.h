@@ -0,0 +1,35 @@
+/*------------------------------------------------------------------------------
+ *
+ * aocs_blockminmax.h
+ *	  Block-level min/max summaries of AOCS columns.
+ *
+ * Copyright (c) 2013-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/access/aocs_blockminmax.h
+ *
+ *------------------------------------------------------------------------------
+ */
+#ifndef AOCS_BLOCKMINMAX_H
+#define AOCS_BLOCKMINMAX_H
+
+#include "nodes/pg_list.h"
+#include "utils/rel.h"
+
+struct AOCSBlockMinMaxScan;
+struct DatumStreamRead;
+
+extern struct AOCSBlockMinMaxScan *AOCSBlockMinMaxBeginScan(Relation rel, List *qual);
+extern void AOCSBlockMinMaxEndScan(struct AOCSBlockMinMaxScan *mmscan);
+extern bool AOCSBlockMinMaxHasKeys(struct AOCSBlockMinMaxScan *mmscan, int attno);
+extern bool AOCSBlockMinMaxSkipBlock(struct AOCSBlockMinMaxScan *mmscan, int segno,
+									 int attno, struct DatumStreamRead *ds);
+extern bool AOCSBlockMinMaxSkipDictionary(struct AOCSBlockMinMaxScan *mmscan,
+										  int attno, struct DatumStreamRead *ds);
+extern void AOCSBlockMinMaxAbandonBlock(struct AOCSBlockMinMaxScan *mmscan, int attno);
+extern void AOCSBlockMinMaxAccumulate(struct AOCSBlockMinMaxScan *mmscan, int attno,
+									  Datum *values, bool *nulls, int n,
+									  bool blockDone);
+
+#endif   /* AOCS_BLOCKMINMAX_H */
@@ -76,6 +76,10 @@ typedef FormData_pg_appendonly *Form_pg_appendonly;
 /*
  * AORelationVersion defines valid values for the version of AppendOnlyEntry.
  * NOTE: When this is updated, AoRelationVersion_GetLatest() must be updated accordingly.
+ *
+ * AORelationVersion_GP7 is the exception: it is only given to the segfiles of
+ * column-oriented tables created while gp_aocs_dictionary_encoding is on, so
+ * that other data stays readable by binaries that don't know it.
  */
 typedef enum AORelationVersion
 {
@@ -85,11 +89,20 @@ typedef enum AORelationVersion
 											 * were introduced, see MPP-7251 and MPP-7372. */
 	AORelationVersion_PG83 = 3,				/* Same as Aligned64bit, but numerics are stored
 											 * in the PostgreSQL 8.3 format. */
+	AORelationVersion_GP7 = 4,				/* Same as PG83, but the datum stream blocks
+											 * may be dictionary encoded. */
 	MaxAORelationVersion                    /* must always be last */
 } AORelationVersion;
 
 #define AORelationVersion_GetLatest() AORelationVersion_PG83
 
+/*
+ * Can new data be written to a segfile of this version?  That's the latest
+ * version, and AORelationVersion_GP7.
+ */
+#define AORelationVersion_IsWritable(version) \
+	(version >= AORelationVersion_GetLatest() && version < MaxAORelationVersion)
+
 #define AORelationVersion_IsValid(version) \
 	(version > AORelationVersion_None && version < MaxAORelationVersion)
 
@@ -125,4 +138,14 @@ static inline void AORelationVersion_CheckValid(int version)
 	(version < AORelationVersion_PG83) \
 )
 
+/*
+ * May the datum stream blocks of a column-oriented segfile of this version be
+ * dictionary encoded?  Readers of older versions don't know the layout.
+ */
+#define DatumStreamDictionaryAllowed(version) \
+( \
+	AORelationVersion_CheckValid(version), \
+	(version >= AORelationVersion_GP7) \
+)
+
 #endif   /* PG_APPENDONLY_H */
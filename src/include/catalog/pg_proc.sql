@@ -203,6 +203,8 @@
 
  CREATE FUNCTION gp_request_fts_probe_scan() RETURNS bool LANGUAGE internal VOLATILE PARALLEL SAFE AS 'gp_request_fts_probe_scan' EXECUTE ON MASTER WITH (OID=5035, DESCRIPTION="Request a FTS probe scan and wait for response");
 
+ CREATE FUNCTION gp_session_gang_stats(OUT gangs_created int8, OUT qes_reused int8, OUT qes_connected int8, OUT connect_time_ms float8) RETURNS record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_session_gang_stats' EXECUTE ON MASTER WITH (OID=5068, DESCRIPTION="statistics: gangs created by this session, and how many of their QEs were reused or connected");
+
 
  CREATE FUNCTION cosh(float8) RETURNS float8 LANGUAGE internal IMMUTABLE PARALLEL SAFE AS 'dcosh' WITH (OID=7539, DESCRIPTION="Hyperbolic cosine function");
 
@@ -22,7 +22,7 @@
 
    WARNING: DO NOT MODIFY THE FOLLOWING SECTION: 
    Generated by catullus.pl version 8
-   on Thu Jan 16 20:10:09 2020
+   on Fri Oct 16 01:35:21 2026
 
    Please make your changes in pg_proc.sql
 */
@@ -417,6 +417,10 @@ DESCR("Remove a primary segment from the system catalog");
 DATA(insert OID = 5035 ( gp_request_fts_probe_scan  PGNSP PGUID 12 1 0 0 0 f f f f f f v s 0 0 16 "" _null_ _null_ _null_ _null_ _null_ gp_request_fts_probe_scan _null_ _null_ _null_ n m ));
 DESCR("Request a FTS probe scan and wait for response");
 
+/* gp_session_gang_stats(OUT gangs_created int8, OUT qes_reused int8, OUT qes_connected int8, OUT connect_time_ms float8) => record */
+DATA(insert OID = 5068 ( gp_session_gang_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v r 0 0 2249 "" "{20,20,20,701}" "{o,o,o,o}" "{gangs_created,qes_reused,qes_connected,connect_time_ms}" _null_ _null_ gp_session_gang_stats _null_ _null_ _null_ n m ));
+DESCR("statistics: gangs created by this session, and how many of their QEs were reused or connected");
+
 /* cosh(float8) => float8 */
 DATA(insert OID = 7539 ( cosh  PGNSP PGUID 12 1 0 0 0 f f f f f f i s 1 0 701 "701" _null_ _null_ _null_ _null_ _null_ dcosh _null_ _null_ _null_ n a ));
 DESCR("Hyperbolic cosine function");
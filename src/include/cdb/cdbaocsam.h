@@ -40,6 +40,7 @@
  */
 struct DatumStream;
 struct AOCSFileSegInfo;
+struct AOCSBlockMinMaxScan;
 
 typedef struct AOCSInsertDescData
 {
@@ -126,10 +127,48 @@ typedef struct AOCSScanDescData
 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * Block min/max of the columns constrained by the scan's quals, used by
+	 * aocs_getnext_batch() to skip blocks.  NULL if none.
+	 */
+	struct AOCSBlockMinMaxScan *blockminmax;
+
 }	AOCSScanDescData;
 
 typedef AOCSScanDescData *AOCSScanDesc;
 
+/*
+ * A batch of rows read by aocs_getnext_batch().
+ *
+ * For each projected column, values[attno] and nulls[attno] hold one entry
+ * per row, decoded straight from the column's current block; they are NULL
+ * for the other columns.  Pass-by-reference values point into the blocks,
+ * and are only valid until the next call to aocs_getnext_batch().  Rows
+ * that aren't visible have already been left out.
+ *
+ * If some columns were marked late with aocs_batch_set_late_columns(),
+ * aocs_getnext_batch() may return with 'late_pending' set: the late columns
+ * haven't been read yet, and offsets[] gives the position of each row among
+ * the 'nread' rows the batch covers in the blocks.  The caller filters the
+ * rows and then calls aocs_batch_read_late() with the ones it keeps.
+ */
+typedef struct AOCSBatchData
+{
+	int			maxrows;		/* size of the arrays */
+	int			nrows;			/* number of rows in the batch */
+	int			natts;			/* size of values[] and nulls[] */
+	Datum	  **values;
+	bool	  **nulls;
+	AOTupleId  *tids;			/* TID of each row */
+
+	bool	   *late;			/* per column, or NULL if none are late */
+	bool		late_pending;	/* late columns not read yet? */
+	int			nread;			/* rows covered in the blocks, visible or not */
+	int		   *offsets;		/* position of each row among those */
+}	AOCSBatchData;
+
+typedef AOCSBatchData *AOCSBatch;
+
 /*
  * Used for fetch individual tuples from specified by TID of append only relations
  * using the AO Block Directory.
@@ -212,6 +251,16 @@ extern void aocs_rescan(AOCSScanDesc scan);
 extern void aocs_endscan(AOCSScanDesc scan);
 
 extern bool aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot);
+extern AOCSBatch aocs_create_batch(AOCSScanDesc scan, int maxrows);
+extern void aocs_free_batch(AOCSBatch batch);
+extern void aocs_enable_block_minmax(AOCSScanDesc scan, List *qual);
+extern bool aocs_getnext_batch(AOCSScanDesc scan, AOCSBatch batch);
+extern void aocs_batch_store_row(AOCSScanDesc scan, AOCSBatch batch, int row,
+								 TupleTableSlot *slot);
+extern void aocs_batch_set_late_columns(AOCSScanDesc scan, AOCSBatch batch,
+										bool *late);
+extern void aocs_batch_read_late(AOCSScanDesc scan, AOCSBatch batch,
+								 int *sel, int nsel);
 extern AOCSInsertDesc aocs_insert_init(Relation rel, int segno, bool update_mode);
 extern Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
 static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
@@ -189,6 +189,14 @@ typedef struct AppendOnlyStorageRead
 										 * pointers. The array index
 										 * corresponds to COMP_FUNC_*	*/
 
+	/*
+	 * Compressed blocks following the current one that were decompressed
+	 * ahead of time, when gp_appendonly_decompress_threads > 1.  Created by
+	 * AppendOnlyStorageRead_Init(), NULL if not enabled or not possible for
+	 * the compression used.
+	 */
+	struct AppendOnlyDecompressAhead *decompressAhead;
+
 } AppendOnlyStorageRead;
 
 extern void AppendOnlyStorageRead_Init(AppendOnlyStorageRead *storageRead,
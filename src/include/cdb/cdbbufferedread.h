@@ -76,6 +76,11 @@ typedef struct BufferedRead
 	bool				haveTemporaryLimitInEffect;
 	int64				temporaryLimitFileLen;
 
+	/*
+	 * End of the range the kernel has already been asked to read ahead.
+	 */
+	int64				prefetchedUpTo;
+
 } BufferedRead;
 
 /*
@@ -170,6 +175,14 @@ uint8 *BufferedReadGetCurrentBuffer(
 int64 BufferedReadCurrentPosition(
     BufferedRead       *bufferedRead);
 
+/*
+ * Return the data following the current buffer that the current large
+ * read already holds, without consuming it.
+ */
+uint8 *BufferedReadPeekAhead(
+    BufferedRead       *bufferedRead,
+    int32              *peekLen);
+
 /*
  * Finishes the current file for reading.  Caller is resposible for closing
  * the file afterwards.
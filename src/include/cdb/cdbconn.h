@@ -16,6 +16,7 @@
 #ifndef CDBCONN_H
 #define CDBCONN_H
 
+#include "cdb/cdbdisp_plancache.h"
 
 /* --------------------------------------------------------------------------------------------------
  * Structure for segment database definition and working values
@@ -53,6 +54,13 @@ typedef struct SegmentDatabaseDescriptor
     char                   *whoami;         /* QE identifier for msgs */
 	bool					isWriter;
 	int						identifier;		/* unique identifier in the cdbcomponent segment pool */
+
+	/*
+	 * Handles of the plans the QE has cached, in the order it caches them;
+	 * see cdbdisp_plancache.c.  0 is an empty slot.
+	 */
+	int32					planHandles[QE_PLAN_CACHE_SLOTS];
+	int						nextPlanHandleSlot;
 } SegmentDatabaseDescriptor;
 
 SegmentDatabaseDescriptor *
@@ -25,6 +25,7 @@
 
 struct CdbDispatcherState;
 struct CopyStateData;
+struct CdbCopySender;
 
 typedef struct CdbCopy
 {
@@ -38,6 +39,7 @@ typedef struct CdbCopy
 								 * data rows, it is taken out of the list */
 	HTAB		*aotupcounts;	/* hash of ao relation id to processed tuple count */
 	struct CdbDispatcherState *dispatcherState;
+	struct CdbCopySender *sender;	/* COPY FROM batches in flight, or NULL */
 } CdbCopy;
 
 
@@ -45,6 +45,14 @@ typedef struct CdbDispatcherState
 	int	largestGangSize;
 	bool forceDestroyGang;
 	bool isExtendedQuery;
+
+	/*
+	 * Handle of the dispatched plan, if it is cached, and the query text to
+	 * send to the QEs that have it already.
+	 */
+	int32 planHandle;
+	char *planlessQueryText;
+	int planlessQueryTextLen;
 #ifdef USE_ASSERT_CHECKING
 	bool isGangDestroying;
 #endif
@@ -19,6 +19,7 @@
 
 struct pg_result;                   /* #include "libpq-fe.h" */
 struct CdbPgResults;
+struct CdbDispatcherState;
 /*
  * CdbDispatchDtxProtocolCommand:
  * Sends a non-cancelable command to all segment dbs, primary
@@ -40,6 +41,24 @@ CdbDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 							  char *serializedDtxContextInfo,
 							  int serializedDtxContextInfoLen);
 
+/*
+ * CdbDispatchDtxProtocolCommandStart / CdbDispatchDtxProtocolCommandFinish:
+ * The two halves of CdbDispatchDtxProtocolCommand, for callers that have
+ * something better to do while the segment dbs work on the command.
+ */
+struct CdbDispatcherState *
+CdbDispatchDtxProtocolCommandStart(DtxProtocolCommand dtxProtocolCommand,
+								   char *dtxProtocolCommandLoggingStr,
+								   char *gid,
+								   List *twophaseSegments,
+								   char *serializedDtxContextInfo,
+								   int serializedDtxContextInfoLen);
+
+struct pg_result **
+CdbDispatchDtxProtocolCommandFinish(struct CdbDispatcherState *ds,
+									ErrorData **qeError,
+									int *resultCount);
+
 
 /*
  * used to take the current Transaction Snapshot and serialized a version of it
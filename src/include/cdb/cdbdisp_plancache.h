@@ -0,0 +1,41 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbdisp_plancache.h
+ * routines for caching dispatched plans on the QD and on the QEs.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbdisp_plancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef CDBDISP_PLANCACHE_H
+#define CDBDISP_PLANCACHE_H
+
+/*
+ * Number of plans a QE keeps.  The QD mirrors each QE's cache in its
+ * SegmentDatabaseDescriptor, so both sides must agree on this.
+ */
+#define QE_PLAN_CACHE_SLOTS		16
+
+/* Plans larger than this, serialized and uncompressed, are not cached. */
+#define PLAN_CACHE_MAX_PLAN_SIZE	(64 * 1024)
+
+struct SegmentDatabaseDescriptor;
+struct PlannedStmt;
+
+/* QD side */
+extern int32 PlanDispatchCacheLookup(char *splan, int splan_len,
+						const char **cplan_p, int *cplan_len_p);
+extern bool cdbdisp_qeHasPlan(struct SegmentDatabaseDescriptor *segdbDesc,
+				  int32 planHandle);
+extern void cdbdisp_qeAddPlan(struct SegmentDatabaseDescriptor *segdbDesc,
+				  int32 planHandle);
+
+/* QE side */
+extern void QEPlanCacheAdd(int32 planHandle, const char *splan, int splan_len);
+extern struct PlannedStmt *QEPlanCacheGetPlan(int32 planHandle);
+
+#endif   /* CDBDISP_PLANCACHE_H */
@@ -50,7 +50,7 @@ extern int host_segments;
 extern int ic_htab_size;
 
 extern MemoryContext GangContext;
-extern Gang *CurrentGangCreating;
+extern List *CurrentGangsCreating;
 
 /*
  * cdbgang_createGang:
@@ -63,6 +63,16 @@ extern Gang *CurrentGangCreating;
 extern Gang *
 cdbgang_createGang(List *segments, SegmentType segmentType);
 
+/*
+ * cdbgang_createGangs:
+ *
+ * Creates 'ngangs' new gangs at once, connecting the QEs of all of them in
+ * parallel.
+ */
+extern void
+cdbgang_createGangs(int ngangs, List **segments, SegmentType *segmentTypes,
+					Gang **gangs);
+
 extern const char *gangTypeToString(GangType type);
 
 extern void setupCdbProcessList(ExecSlice *slice);
@@ -72,7 +82,10 @@ extern bool GangOK(Gang *gp);
 extern List *getCdbProcessesForQD(int isPrimary);
 
 extern Gang *AllocateGang(struct CdbDispatcherState *ds, enum GangType type, List *segments);
+extern void AllocateGangs(struct CdbDispatcherState *ds, int ngangs,
+			  enum GangType *types, List **segments, Gang **gangs);
 extern void RecycleGang(Gang *gp, bool forceDestroy);
+extern void DestroyGangsCreating(void);
 extern void DisconnectAndDestroyAllGangs(bool resetSession);
 extern void DisconnectAndDestroyUnusedQEs(void);
 
@@ -125,6 +138,7 @@ typedef struct CdbProcess
 	int contentid;
 } CdbProcess;
 
-typedef Gang *(*CreateGangFunc)(List *segments, SegmentType segmentType);
+typedef void (*CreateGangsFunc)(int ngangs, List **segments,
+								SegmentType *segmentTypes, Gang **gangs);
 
 #endif   /* _CDBGANG_H_ */
@@ -17,6 +17,7 @@
 
 #include "cdb/cdbgang.h"
 
-extern Gang *cdbgang_createGang_async(List *segments, SegmentType segmentType);
+extern void cdbgang_createGangs_async(int ngangs, List **segments,
+						  SegmentType *segmentTypes, Gang **gangs);
 
 #endif
@@ -30,6 +30,18 @@ typedef enum
 	REDUCE_JUMP_HASH
 } CdbHashReduce;
 
+/*
+ * Common hash functions that cdbhash() evaluates inline, instead of going
+ * through the function manager for every datum.
+ */
+typedef enum
+{
+	CDBHASH_FAST_NONE = 0,		/* call the hash function through fmgr */
+	CDBHASH_FAST_INT4,			/* hashint4() */
+	CDBHASH_FAST_INT8,			/* hashint8() */
+	CDBHASH_FAST_TEXT			/* hashtext() */
+} CdbHashFastFunc;
+
 /*
  * Structure that holds Greenplum Database hashing information.
  */
@@ -43,6 +55,7 @@ typedef struct CdbHash
 
 	int			natts;
 	FmgrInfo   *hashfuncs;
+	CdbHashFastFunc *fastfuncs;	/* inline replacement for each hashfunc, if any */
 } CdbHash;
 
 /*
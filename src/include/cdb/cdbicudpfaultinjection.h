@@ -83,6 +83,7 @@ typedef enum {
 	FINC_OS_NET_INTERFACE = 19,
 	FINC_OS_MEM_INTERFACE = 20,
 	FINC_OS_CREATE_THREAD = 21,
+	FINC_OS_SENDMMSG_SHORT = 22,
 
 	/* These are used to inject network faults. */
 	FINC_NET_PKT_DUP = 24,
@@ -436,6 +436,22 @@ typedef struct MotionNodeEntry
 	bool            moreNetWork;
 	bool            stopped;
 
+	/*
+	 * Sender-side tuple batching.  If send_batch_size is non-zero, tuples
+	 * for each route are accumulated in send_batches[route] until the batch
+	 * reaches send_batch_size bytes, and are then sent as one message.  The
+	 * array is allocated on the first batched send.
+	 */
+	int             send_batch_size;
+	int             num_send_batches;
+	TupleBatchBuffer *send_batches;
+
+	/*
+	 * Sender-side compression of the batches, see
+	 * gp_interconnect_compression.
+	 */
+	bool            send_compress;
+
 	/*
 	 * PER-MOTION-NODE STATISTICS
 	 */
@@ -455,6 +471,11 @@ typedef struct MotionNodeEntry
 	uint64          stat_tuples_available;  /* Total tuples awaiting receive. */
 	uint64          stat_tuples_available_hwm;              /* High-water-mark of this
 		* value. */
+
+	uint64          stat_compress_batches;  /* Batches considered for compression. */
+	uint64          stat_compressed_batches;        /* Batches sent compressed. */
+	uint64          stat_compress_raw_bytes;        /* Their size before compression. */
+	uint64          stat_compress_sent_bytes;       /* Their size as sent. */
 }       MotionNodeEntry;
 
 
@@ -52,7 +52,7 @@ extern MotionLayerState *createMotionLayerState(int maxMotNodeID);
 
 /* Initialization of each motion node in execution plan. */
 extern void UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserveOrder,
-								  TupleDesc tupDesc);
+								  TupleDesc tupDesc, bool isSender);
 
 /* Cleanup of each motion node in execution plan (normal termination). */
 extern void EndMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool flushCommLayer);
@@ -129,6 +129,16 @@ extern void SendStopMessage(MotionLayerState *mlStates,
 extern void UpdateMotionExpectedReceivers(MotionLayerState *mlStates,
 										  struct SliceTable *sliceTable);
 
+/*
+ * Sender-side compression statistics of a motion node, for EXPLAIN ANALYZE.
+ */
+extern void GetMotionCompressionStats(MotionLayerState *mlStates,
+									  int16 motNodeID,
+									  uint64 *batches,
+									  uint64 *compressedBatches,
+									  uint64 *rawBytes,
+									  uint64 *sentBytes);
+
 /*
  * Return a pointer to the internal "end-of-stream" message
  */
@@ -288,6 +288,8 @@ extern void	prepareDtxTransaction(void);
 extern bool isPreparedDtxTransaction(void);
 extern bool notifyCommittedDtxTransactionIsNeeded(void);
 extern void notifyCommittedDtxTransaction(void);
+extern bool isAsyncCommitPreparedPending(void);
+extern void finishAsyncCommitPrepared(void);
 extern void	rollbackDtxTransaction(void);
 
 extern void insertingDistributedCommitted(void);
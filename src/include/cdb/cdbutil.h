@@ -17,6 +17,8 @@
 #ifndef CDBUTIL_H
 #define CDBUTIL_H
 
+#include <signal.h>
+
 #include "catalog/gp_segment_config.h"
 #include "nodes/pg_list.h"
 #include "nodes/plannodes.h"
@@ -212,6 +214,13 @@ extern int getgpsegmentCount(void);
 
 extern bool IsOnConflictUpdate(PlannedStmt *ps);
 
+/*
+ * Around pthread_create(), so that the backend's signals are delivered to
+ * the main thread, which runs the handlers, rather than to the new thread.
+ */
+extern void gp_set_thread_sigmasks(sigset_t *old_sigs);
+extern void gp_reset_thread_sigmasks(sigset_t *sigs);
+
 #define ELOG_DISPATCHER_DEBUG(...) do { \
        if (gp_log_gang >= GPVARS_VERBOSITY_DEBUG) elog(LOG, __VA_ARGS__); \
     } while(false);
@@ -380,6 +380,57 @@ extern int  Gp_interconnect_transmit_timeout;
 extern int	Gp_interconnect_min_retries_before_timeout;
 extern int	Gp_interconnect_debug_retry_interval;
 
+/*
+ * Parameter Gp_interconnect_tuple_batch_size
+ *
+ * When non-zero, Motion senders accumulate the tuples headed for each
+ * receiver and ship them as one message once this many bytes are buffered,
+ * instead of handing every tuple to the interconnect separately.
+ */
+extern int	Gp_interconnect_tuple_batch_size;
+
+/*
+ * Parameter Gp_interconnect_compression
+ *
+ * Compression method applied to the tuple batches of Motion senders.  Each
+ * batch that doesn't shrink enough is sent as is, and senders stop trying
+ * for a while on routes whose data keeps turning out incompressible.
+ */
+typedef enum GpVars_Interconnect_Compression
+{
+	INTERCONNECT_COMPRESSION_NONE = 0,
+	INTERCONNECT_COMPRESSION_ZLIB,
+} GpVars_Interconnect_Compression;
+
+extern int	Gp_interconnect_compression;
+
+/*
+ * Parameter Gp_interconnect_rx_threads
+ *
+ * Number of receive threads started by the UDPIFC interconnect in each
+ * backend.  With more than one, every thread owns its own listener socket
+ * bound to the shared interconnect port, and the kernel spreads incoming
+ * flows across them.
+ */
+extern int	Gp_interconnect_rx_threads;
+
+/*
+ * Parameter Gp_interconnect_mmsg_batch_size
+ *
+ * Maximum number of packets the UDPIFC interconnect moves with a single
+ * sendmmsg()/recvmmsg() call. 1 uses plain sendto()/recvfrom().
+ */
+extern int	Gp_interconnect_mmsg_batch_size;
+
+/*
+ * Parameter Gp_interconnect_local_transport
+ *
+ * When set, the UDPIFC interconnect exchanges packets with peers on the
+ * same host through AF_UNIX datagram sockets instead of UDP. Like
+ * gp_interconnect_type, it must have the same value in all processes.
+ */
+extern bool Gp_interconnect_local_transport;
+
 /* UDP recv buf size in KB.  For testing */
 extern int 	Gp_udp_bufsize_k;
 
@@ -460,6 +511,9 @@ extern bool gp_enable_fast_sri;
 /* Enable single-mirror pair dispatch. */
 extern bool gp_enable_direct_dispatch;
 
+/* Cache dispatched plans, and send QEs only a handle for plans they have. */
+extern bool gp_enable_dispatch_plan_cache;
+
 /* Name of pseudo-function to access any table as if it was randomly distributed. */
 #define GP_DIST_RANDOM_NAME "GP_DIST_RANDOM"
 
@@ -557,6 +611,24 @@ extern bool gp_adjust_selectivity_for_outerjoins;
 extern int gp_hashjoin_tuples_per_bucket;
 extern int gp_hashagg_groups_per_bucket;
 
+/*
+ * Number of threads that link the tuples of a large hash join table into
+ * their buckets, once the inner side has been loaded.
+ */
+extern int gp_hashjoin_build_threads;
+
+/*
+ * Use an open-addressing (linear probing) hash table in HashAgg, instead of
+ * chained buckets.
+ */
+extern bool gp_hashagg_open_addressing;
+
+/*
+ * Build a Bloom filter over the inner hash keys of a hash join, and use it
+ * to discard rows in an outer SeqScan that cannot find a match.
+ */
+extern bool gp_hashjoin_bloomfilter;
+
 /*
  * Damping of selectivities of clauses which pertain to the same base
  * relation; compensates for undetected correlation
@@ -15,6 +15,7 @@
 
 
 #include "access/heapam.h"
+#include "cdb/htupfifo.h"
 #include "cdb/tupchunklist.h"
 #include "lib/stringinfo.h"
 #include "cdb/tupleremap.h"
@@ -60,8 +61,33 @@ typedef struct SerTupInfo
 
 	/* true if tupdesc contains record types */
 	bool		has_record_types;
+
+	/* Interconnect compression state, see InitSerTupCompression() */
+	struct TupSerCompressor *compressor;
 }	SerTupInfo;
 
+/*
+ * Per-route accumulation buffer used by senders that batch tuples, see
+ * gp_interconnect_tuple_batch_size.  Tuples are appended in serialized form
+ * by SerializeTupleIntoBatch(), and the whole chunk list is shipped as a
+ * single message once FinishTupleBatch() has filled in its header.
+ */
+typedef struct TupleBatchBuffer
+{
+	TupleChunkListData chunks;	/* batch header, then serialized tuples */
+	int			ntuples;		/* number of tuples in 'chunks' */
+
+	/* Adaptive compression, see gp_interconnect_compression */
+	int			compress_skip;	/* batches left to send without trying */
+	int			compress_backoff;	/* compress_skip after the next failure */
+}	TupleBatchBuffer;
+
+/* The tuple count of a batch has to fit in 16 bits of the batch header */
+#define TUPLE_BATCH_MAX_TUPLES	0xffff
+
+/* Upper limit of TupleBatchBuffer.compress_backoff */
+#define TUPLE_BATCH_MAX_COMPRESS_BACKOFF	64
+
 /*
  * forward declaration to avoid #including cdbmotion.h here, which would create a circular
  * dependency
@@ -84,9 +110,18 @@ extern void SerializeRecordCacheIntoChunks(SerTupInfo *pSerInfo,
 /* Convert a tuple into chunks directly in a set of transport buffers */
 extern int SerializeTuple(TupleTableSlot *tuple, SerTupInfo *pSerInfo, struct directTransportBuffer *b, TupleChunkList tcList, int16 targetRoute);
 
-/* Convert a sequence of chunks containing serialized tuple data into a
- * HeapTuple or MemTuple.
+/* Append a tuple to a batch, and convert a full batch into chunks */
+extern void SerializeTupleIntoBatch(TupleTableSlot *slot, SerTupInfo *pSerInfo, TupleBatchBuffer *batch);
+extern void FinishTupleBatch(TupleBatchBuffer *batch);
+
+/* Compress finished batches on the interconnect */
+extern void InitSerTupCompression(SerTupInfo *pSerInfo, int method, bool is_compress);
+extern bool CompressTupleBatch(SerTupInfo *pSerInfo, TupleBatchBuffer *batch);
+
+/* Convert a sequence of chunks containing serialized tuple data into
+ * HeapTuples or MemTuples, queued to the given FIFO.
  */
-extern GenericTuple CvtChunksToTup(TupleChunkList tclist, SerTupInfo * pSerInfo, TupleRemapper *remapper);
+extern int CvtChunksToTuples(TupleChunkList tclist, SerTupInfo * pSerInfo,
+							 TupleRemapper *remapper, htup_fifo ready_tuples);
 
 #endif   /* TUPSER_H */
@@ -48,6 +48,19 @@ typedef struct HashAggEntry
 
 typedef HashAggEntry* HashAggBucket;
 
+/*
+ * A slot of an open-addressing hash table (gp_hashagg_open_addressing).
+ *
+ * The hash value is kept next to the entry pointer, so that probing over
+ * slots of other groups only reads the slot array.  An empty slot has a NULL
+ * entry.
+ */
+typedef struct HashAggSlot
+{
+	HashKey hashvalue;
+	HashAggEntry *entry;
+} HashAggSlot;
+
 /* A SpillFile controls access to a temporary file used to hold  
  * transition tuples spilled from the hash table in order to free 
  * up space.
@@ -156,6 +169,12 @@ typedef struct HashAggTable
 	HashAggBucket  *buckets;
 	uint64 *bloom;
 
+	/*
+	 * With open addressing, the table is an array of nbuckets slots instead,
+	 * and buckets and bloom are NULL.
+	 */
+	HashAggSlot *slots;
+
 	/* hashkey bitshift amount to determine bucket - used when spilling */
 	unsigned pshift;
 
@@ -143,6 +143,7 @@ typedef struct HashJoinBatchStats
     uint64      spillspace_in;      /* work_mem from lower batches to this one */
     uint64      spillspace_out;     /* work_mem from this batch to higher ones */
     uint64      spillrows_out;      /* rows spilled from this batch to higher */
+    int         nlchunks;           /* inner chunks, if joined by nested loop */
 } HashJoinBatchStats;
 
 typedef struct HashJoinTableStats
@@ -159,6 +160,34 @@ typedef struct HashJoinTableStats
 } HashJoinTableStats;
 
 
+/*
+ * HashBloomFilter
+ *
+ * A Bloom filter over the hash values of all inner tuples, built while the
+ * Hash node loads the hash table (including tuples written to batch files).
+ * When the outer child of the join is a SeqScan, the scan tests each row's
+ * outer hash value against the filter and drops rows that cannot match,
+ * before evaluating its quals and projection.  See gp_hashjoin_bloomfilter.
+ *
+ * The filter lives in the query context, not in the hash table, so that the
+ * scan never sees it freed; 'ready' is cleared whenever the hash table is
+ * about to be rebuilt.
+ */
+typedef struct HashBloomFilter
+{
+	bool		ready;			/* filled in for the current hash table? */
+	uint32		mask;			/* number of bits - 1 (a power of 2) */
+	uint64	   *bits;
+
+	/* outer hash keys, initialized against the scan tuple of the SeqScan */
+	List	   *keyexprs;		/* list of ExprState nodes */
+	FmgrInfo   *hashfunctions;	/* outer hash function for each key */
+
+	/* statistics for EXPLAIN ANALYZE */
+	double		ntested;		/* outer rows tested against the filter */
+	double		nrejected;		/* ... and discarded by it */
+} HashBloomFilter;
+
 /*
  * HashJoinTableData
  */
@@ -176,6 +205,13 @@ typedef struct HashJoinTableData
 	struct HashJoinTupleData **buckets;
 	/* buckets array is per-batch storage, as are all the tuples */
 
+	/*
+	 * While set, inserted tuples are only added to the dense chunks, and are
+	 * linked into the buckets all at once, possibly by several threads, by
+	 * ExecHashLinkTuples().  See gp_hashjoin_build_threads.
+	 */
+	bool		linkDeferred;
+
 	bool		keepNulls;		/* true to store unmatchable NULL tuples */
 
 	bool		skewEnabled;	/* are we using skew optimization? */
@@ -192,6 +228,21 @@ typedef struct HashJoinTableData
 
 	bool		growEnabled;	/* flag to shut off nbatch increases */
 
+	/*
+	 * Nested-loop fallback.  When the inner side of a spilled batch does not
+	 * fit in memory and doubling nbatch cannot split it (its tuples share
+	 * few hash values), the inner batch file is loaded one chunk at a time,
+	 * and the outer batch file is read again for each chunk.  For joins that
+	 * must know whether an outer tuple matched in any chunk, a bitmap
+	 * indexed by the tuple's position in the outer batch file records that.
+	 */
+	bool		nlFallback;		/* current batch is joined chunk by chunk */
+	bool		nlLastChunk;	/* the chunk in memory is the last one */
+	int			nlChunkNo;		/* number of the chunk in memory, from 0 */
+	int64		nlOuterTupno;	/* position of current outer tuple in file */
+	uint64	   *nlOuterMatched; /* bitmap of matched outer tuples, or NULL */
+	int64		nlOuterMatchedWords;	/* allocated length of the bitmap */
+
 	uint64		totalTuples;	/* # tuples obtained from inner plan */
 	uint64		skewTuples;		/* # tuples inserted into skew tuples */
 
@@ -58,6 +58,12 @@ extern void ExecChooseHashTableSize(double ntuples, int tupwidth, bool useskew,
 						int *num_skew_mcvs);
 extern int	ExecHashGetSkewBucket(HashJoinTable hashtable, uint32 hashvalue);
 
+extern HashBloomFilter *ExecHashBloomFilterCreate(double ntuples,
+						  List *keyexprs, List *hashOperators);
+extern void ExecHashBloomFilterReset(HashBloomFilter *filter);
+extern void ExecHashBloomFilterFinish(HashBloomFilter *filter, uint64 ntuples);
+extern bool ExecHashBloomFilterTest(HashBloomFilter *filter, ExprContext *econtext);
+
 extern void ExecHashTableExplainInit(HashState *hashState, HashJoinState *hjstate,
                                      HashJoinTable  hashtable);
 extern void ExecHashTableExplainBatchEnd(HashState *hashState, HashJoinTable hashtable);
@@ -1723,6 +1723,14 @@ typedef struct SeqScanState
 	/* extra state for AOCS scans */
 	bool	   *ss_aocs_proj;
 	int			ss_aocs_ncol;
+	struct AOCSBatchData *ss_aocs_batch;	/* see gp_aocs_scan_batch_size */
+	int			ss_aocs_batch_row;	/* next row to return from the batch */
+	List	   *ss_aocs_late_qual;	/* quals checked before reading the
+									 * late columns; see nodeSeqscan.c */
+	int		   *ss_aocs_late_sel;	/* rows of the batch that passed them */
+
+	/* set when this scan is the outer side of a hash join; see nodeHash.c */
+	struct HashBloomFilter *ss_bloomfilter;
 } SeqScanState;
 
 /* ----------------
@@ -2474,6 +2482,7 @@ typedef struct HashJoinState
 	bool		prefetch_inner;
 	bool		prefetch_joinqual;
 	bool		hj_nonequijoin;
+	struct HashBloomFilter *hj_BloomFilter;	/* filter pushed to outer scan */
 
 	/* set if the operator created workfiles */
 	bool workfiles_created;
@@ -3036,6 +3045,9 @@ typedef struct MotionState
 	/* For motion send */
 	bool		sentEndOfStream;	/* set when end-of-stream has successfully been sent */
 	List	   *hashExprs;		/* state struct used for evaluating the hash expressions */
+	AttrNumber *hashAttnos;		/* if every hash expression is a plain Var of
+								 * the outer tuple, their attribute numbers;
+								 * else NULL */
 	struct CdbHash *cdbhash;	/* hash api object */
 	int			numHashSegments;	/* number of segments to use when calculating hash */
 
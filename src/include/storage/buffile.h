@@ -52,6 +52,7 @@ extern void BufFileTell(BufFile *file, int *fileno, off_t *offset);
 extern int	BufFileSeekBlock(BufFile *file, int64 blknum);
 extern void BufFileFlush(BufFile *file);
 extern int64 BufFileGetSize(BufFile *buffile);
+extern void BufFilePrefetch(BufFile *buffile, int64 nbytes);
 
 extern const char *BufFileGetFilename(BufFile *buffile);
 
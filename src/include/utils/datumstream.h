@@ -242,6 +242,23 @@ datumstreamread_nth(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Number of datums in the current block after the current position.
+ */
+inline static int
+datumstreamread_remaining(DatumStreamRead * acc)
+{
+	if (acc->largeObjectState == DatumStreamLargeObjectState_None)
+		return Max(acc->blockRead.logical_row_count - acc->blockRead.nth - 1, 0);
+	else if (acc->largeObjectState == DatumStreamLargeObjectState_HaveAoContent)
+		return 1;
+	else
+		return 0;
+}
+
+extern int	datumstreamread_get_batch(DatumStreamRead * acc, int maxvals,
+									  Datum *values, bool *nulls);
+
 /* ------------------------------------------------------------------------------ */
 
 extern int datumstreamwrite_put(
@@ -309,6 +326,10 @@ extern int64 datumstreamwrite_lob(DatumStreamWrite *ds,
 extern int	datumstreamread_block(DatumStreamRead * ds,
 								  AppendOnlyBlockDirectory *blockDirectory,
 								  int colGroupNo);
+extern int	datumstreamread_block_header(DatumStreamRead * ds);
+extern void datumstreamread_block_skip(DatumStreamRead * ds);
+extern void datumstreamread_block_discard(DatumStreamRead * ds);
+extern void datumstreamread_skip(DatumStreamRead * ds, int n);
 extern void datumstreamread_find(DatumStreamRead * datumStream,
 					 int32 rowNumInBlock);
 extern void datumstreamread_rewind_block(DatumStreamRead * datumStream);
@@ -196,6 +196,32 @@ typedef struct DatumStreamBlock_Delta_Extension
 	 */
 }	DatumStreamBlock_Delta_Extension;
 
+/*
+ * Datum Stream Block extension for dictionary encoding of variable-length
+ * items.  8 bytes more.
+ *
+ * When a block has DSB_HAS_DICTIONARY_COMPRESSION, the extension follows all
+ * the other meta-data (NULL bit-map, RLE_TYPE compress bit-map and repeat
+ * counts), and is followed by an index for each physical datum into the
+ * dictionary.  The datum area then holds only the distinct items (the
+ * dictionary entries), laid out just like the datums of a block without a
+ * dictionary, and physical_data_size is the size of the dictionary.
+ */
+typedef struct DatumStreamBlock_Dictionary_Extension
+{
+	int32		entry_count;
+	/*
+	 * Number of distinct items in the datum area.
+	 */
+
+	int32		index_width;
+	/*
+	 * Byte length of each index, 1 or 2.  2 byte indexes are stored
+	 * least significant byte first.
+	 */
+}	DatumStreamBlock_Dictionary_Extension;
+
+#define DICTIONARY_MAX_ENTRIES 0x10000
 
 /* Flags */
 enum
@@ -203,8 +229,13 @@ enum
 	DSB_HAS_NULLBITMAP = 0x1,
 	DSB_HAS_RLE_COMPRESSION = 0x2,
 	DSB_HAS_DELTA_COMPRESSION = 0x4,
+	DSB_HAS_DICTIONARY_COMPRESSION = 0x8,
 };
 
+#define DSB_KNOWN_FLAGS \
+	(DSB_HAS_NULLBITMAP | DSB_HAS_RLE_COMPRESSION | \
+	 DSB_HAS_DELTA_COMPRESSION | DSB_HAS_DICTIONARY_COMPRESSION)
+
 typedef struct DatumStreamBitMapWrite
 {
 	uint8	   *buffer;
@@ -1057,6 +1088,10 @@ typedef struct DatumStreamBlockWrite
 	int32		deltas_count;
 	int32		deltas_current_size;
 
+	/* Dictionary variables */
+	bool		dictionary_want_compression;
+	bool		dictionary_can_have_compression;	/* set per segfile */
+
 	/* Common buffers */
 	MemoryContext memctxt;
 
@@ -1082,6 +1117,10 @@ typedef struct DatumStreamBlockWrite
 	bool	   *delta_sign;
 	int32		deltas_maxcount;
 
+	/* Dictionary buffers */
+	uint8	   *dictionary_buffer;
+	int32		dictionary_buffer_size;
+
 	/* EOF of current file */
 	int64		savings;
 	int64		remember_savings;
@@ -1164,6 +1203,16 @@ typedef struct DatumStreamBlockRead
 	bool		delta_block_was_compressed;
 	DatumStreamBitMapRead delta_bitmap;
 
+	/* Dictionary variables */
+	bool		dictionary_can_have_compression;	/* set per segfile */
+	bool		dictionary_block_was_compressed;
+	int32		dictionary_entry_count;
+	int32		dictionary_index_width;
+	uint8	   *dictionary_indexesp;
+
+	uint8	  **dictionary_entries;
+	int32		dictionary_entries_maxcount;
+
 	/*
 	 * Keep less frequently accessed fields down here for possible better CPU data cache
 	 * performance.
@@ -1718,6 +1767,24 @@ DatumStreamBlockRead_AdvanceDenseDelta(DatumStreamBlockRead * dsr)
 	return DELTA_COMPRESSION_OK;
 }
 
+/*
+ * Dictionary entry of the physical datum 'index' of a dictionary encoded block.
+ */
+inline static uint8 *
+DatumStreamBlockRead_DictionaryItem(DatumStreamBlockRead * dsr, int32 index)
+{
+	int32		entry;
+
+	if (dsr->dictionary_index_width == 1)
+		entry = dsr->dictionary_indexesp[index];
+	else
+		entry = dsr->dictionary_indexesp[2 * index] |
+			((int32) dsr->dictionary_indexesp[2 * index + 1] << 8);
+
+	Assert(entry < dsr->dictionary_entry_count);
+	return dsr->dictionary_entries[entry];
+}
+
 inline static int
 DatumStreamBlockRead_AdvanceDense(DatumStreamBlockRead * dsr)
 {
@@ -1962,7 +2029,11 @@ DatumStreamBlockRead_AdvanceDense(DatumStreamBlockRead * dsr)
 		/*
 		 * Advance the item pointer.
 		 */
-		if (dsr->typeInfo.datumlen == -1)
+		if (dsr->dictionary_block_was_compressed)
+		{
+			dsr->datump = DatumStreamBlockRead_DictionaryItem(dsr, dsr->physical_datum_index);
+		}
+		else if (dsr->typeInfo.datumlen == -1)
 		{
 			struct varlena *s;
 
@@ -302,6 +302,44 @@ extern bool gp_appendonly_compaction;
  * 10% of the tuples are hidden.
  */
 extern int  gp_appendonly_compaction_threshold;
+
+/*
+ * Number of large reads beyond the current one that BufferedRead asks the
+ * kernel to start fetching while the caller works on the current one.
+ * 0 disables read-ahead advice.
+ */
+extern int  gp_appendonly_read_ahead;
+
+/*
+ * Number of threads that decompress the compressed blocks following the
+ * current one of an append-only scan.  1 decompresses one block at a time.
+ */
+extern int  gp_appendonly_decompress_threads;
+
+/*
+ * Number of rows a sequential scan of an AOCS table decodes from each
+ * column per call to aocs_getnext_batch().  0 disables batching.
+ */
+extern int  gp_aocs_scan_batch_size;
+
+/*
+ * Number of AOCS blocks whose min/max values a backend keeps for skipping
+ * blocks in batched scans.  0 disables that.
+ */
+extern int  gp_aocs_block_minmax_cache_size;
+
+/*
+ * Store the variable-length values of RLE_TYPE compressed AOCS blocks as a
+ * dictionary of the distinct values plus an index per value, when that is
+ * smaller.
+ */
+extern bool gp_aocs_dictionary_encoding;
+
+/*
+ * In batched AOCS scans, read the columns that the quals reference first,
+ * and read the other columns only for the rows that pass the quals.
+ */
+extern bool gp_aocs_late_materialization;
 extern bool gp_heap_require_relhasoids_match;
 extern bool	debug_xlog_record_read;
 extern bool Debug_cancel_print;
@@ -318,6 +356,8 @@ extern bool gp_create_table_random_default_distribution;
 extern bool gp_allow_non_uniform_partitioning_ddl;
 extern bool gp_enable_exchange_default_partition;
 extern int  dtx_phase2_retry_count;
+/* Collect the 'Commit Prepared' acknowledgements after answering the client */
+extern bool gp_dtx_async_commit_prepared;
 
 /* WAL replication debug gucs */
 extern bool debug_walrepl_snd;
@@ -592,6 +632,11 @@ extern char  *gp_default_storage_options;
 
 /* copy GUC */
 extern bool gp_enable_segment_copy_checking;
+/*
+ * Size of the per-segment batches in which the QD forwards COPY FROM rows,
+ * sent by a separate thread.  0 forwards each row as it is parsed.
+ */
+extern int	gp_copy_dispatch_batch_size;
 
 extern int writable_external_table_bufsize;
 
@@ -11,6 +11,12 @@
 		"force_parallel_mode",
 		"gin_fuzzy_search_limit",
 		"gin_pending_list_limit",
+		"gp_aocs_block_minmax_cache_size",
+		"gp_aocs_dictionary_encoding",
+		"gp_aocs_late_materialization",
+		"gp_aocs_scan_batch_size",
+		"gp_appendonly_decompress_threads",
+		"gp_appendonly_read_ahead",
 		"gp_blockdirectory_entry_min_range",
 		"gp_blockdirectory_minipage_size",
 		"gp_debug_linger",
@@ -22,25 +28,33 @@
 		"gp_gpperfmon_send_interval",
 		"gp_hashagg_default_nbatches",
 		"gp_hashagg_groups_per_bucket",
+		"gp_hashagg_open_addressing",
+		"gp_hashjoin_bloomfilter",
+		"gp_hashjoin_build_threads",
 		"gp_hashjoin_tuples_per_bucket",
 		"gp_ignore_error_table",
 		"gp_indexcheck_insert",
 		"gp_indexcheck_vacuum",
 		"gp_initial_bad_row_limit",
+		"gp_interconnect_compression",
 		"gp_interconnect_debug_retry_interval",
 		"gp_interconnect_default_rtt",
 		"gp_interconnect_fc_method",
 		"gp_interconnect_full_crc",
+		"gp_interconnect_local_transport",
 		"gp_interconnect_log_stats",
 		"gp_interconnect_min_retries_before_timeout",
 		"gp_interconnect_min_rto",
+		"gp_interconnect_mmsg_batch_size",
 		"gp_interconnect_queue_depth",
+		"gp_interconnect_rx_threads",
 		"gp_interconnect_setup_timeout",
 		"gp_interconnect_snd_queue_depth",
 		"gp_interconnect_tcp_listener_backlog",
 		"gp_interconnect_timer_checking_period",
 		"gp_interconnect_timer_period",
 		"gp_interconnect_transmit_timeout",
+		"gp_interconnect_tuple_batch_size",
 		"gp_interconnect_type",
 		"gp_log_interconnect",
 		"gp_log_resgroup_memory",
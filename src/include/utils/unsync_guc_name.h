@@ -152,6 +152,7 @@
 		"gp_command_count",
 		"gp_connection_send_timeout",
 		"gp_contentid",
+		"gp_copy_dispatch_batch_size",
 		"gp_cost_hashjoin_chainwalk",
 		"gp_create_table_random_default_distribution",
 		"gp_cte_sharing",
@@ -159,6 +160,7 @@
 		"gp_debug_pgproc",
 		"gp_debug_resqueue_priority",
 		"gp_distinct_grouping_sets_threshold",
+		"gp_dtx_async_commit_prepared",
 		"gp_dynamic_partition_pruning",
 		"gp_eager_agg_distinct_pruning",
 		"gp_eager_one_phase_agg",
@@ -167,6 +169,7 @@
 		"gp_enable_agg_distinct",
 		"gp_enable_agg_distinct_pruning",
 		"gp_enable_direct_dispatch",
+		"gp_enable_dispatch_plan_cache",
 		"gp_enable_exchange_default_partition",
 		"gp_enable_explain_allstat",
 		"gp_enable_fast_sri",
@@ -0,0 +1,25 @@
+--
+-- Compressed blocks of append-only tables can be decompressed ahead of the
+-- scan by several threads.  Scans must return the same rows either way.
+--
+CREATE TABLE ao_decompress_threads (id int, payload text)
+  WITH (appendonly=true, compresstype=zlib, compresslevel=1, blocksize=8192) DISTRIBUTED BY (id);
+CREATE TABLE aocs_decompress_threads (id int, payload text)
+  WITH (appendonly=true, orientation=column, compresstype=zlib, compresslevel=1, blocksize=8192) DISTRIBUTED BY (id);
+INSERT INTO ao_decompress_threads SELECT i, 'payload' || i FROM generate_series(1, 100000) i;
+INSERT INTO ao_decompress_threads SELECT i, repeat(md5(i::text), 1000) FROM generate_series(100001, 100010) i;
+INSERT INTO aocs_decompress_threads SELECT * FROM ao_decompress_threads;
+
+SET gp_appendonly_decompress_threads = 1;
+SELECT count(*), min(id), max(id), sum(length(payload)) FROM ao_decompress_threads;
+SELECT count(*), min(id), max(id), sum(length(payload)) FROM aocs_decompress_threads;
+
+SET gp_appendonly_decompress_threads = 4;
+SELECT count(*), min(id), max(id), sum(length(payload)) FROM ao_decompress_threads;
+SELECT count(*), min(id), max(id), sum(length(payload)) FROM aocs_decompress_threads;
+SELECT count(*) FROM ao_decompress_threads a JOIN aocs_decompress_threads c USING (id)
+  WHERE a.payload = c.payload;
+
+RESET gp_appendonly_decompress_threads;
+DROP TABLE ao_decompress_threads;
+DROP TABLE aocs_decompress_threads;
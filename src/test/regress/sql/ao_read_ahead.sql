@@ -0,0 +1,29 @@
+--
+-- Scans of append-only tables ask the kernel to read ahead of the current
+-- large read.  The advice must not change what the scans return, whether
+-- scanning sequentially or fetching through the block directory.
+--
+CREATE TABLE ao_read_ahead (id int, payload text)
+  WITH (appendonly=true, compresstype=zlib, blocksize=8192) DISTRIBUTED BY (id);
+CREATE TABLE aocs_read_ahead (id int, payload text)
+  WITH (appendonly=true, orientation=column, compresstype=zlib, blocksize=8192) DISTRIBUTED BY (id);
+INSERT INTO ao_read_ahead SELECT i, 'payload' || i FROM generate_series(1, 100000) i;
+INSERT INTO aocs_read_ahead SELECT * FROM ao_read_ahead;
+CREATE INDEX ao_read_ahead_id ON ao_read_ahead (id);
+
+SET gp_appendonly_read_ahead = 0;
+SELECT count(*), min(id), max(id), sum(length(payload)) FROM ao_read_ahead;
+SELECT count(*), min(id), max(id), sum(length(payload)) FROM aocs_read_ahead;
+
+SET gp_appendonly_read_ahead = 16;
+SELECT count(*), min(id), max(id), sum(length(payload)) FROM ao_read_ahead;
+SELECT count(*), min(id), max(id), sum(length(payload)) FROM aocs_read_ahead;
+
+SET enable_seqscan = off;
+SELECT payload FROM ao_read_ahead WHERE id = 77777;
+SELECT payload FROM ao_read_ahead WHERE id = 3;
+RESET enable_seqscan;
+
+RESET gp_appendonly_read_ahead;
+DROP TABLE ao_read_ahead;
+DROP TABLE aocs_read_ahead;
@@ -0,0 +1,28 @@
+--
+-- Sequential scans of AOCS tables that read batches of rows
+-- (gp_aocs_scan_batch_size) must return the same rows as row-at-a-time scans.
+--
+CREATE TABLE aocs_batch (a int, b text, c numeric, d text)
+  WITH (appendonly=true, orientation=column) DISTRIBUTED BY (a);
+INSERT INTO aocs_batch
+  SELECT i, 'row' || i, i * 1.5, CASE WHEN i % 3 = 0 THEN NULL ELSE repeat('x', i % 50) END
+  FROM generate_series(1, 10000) i;
+-- A value too wide for a regular block is stored in a block of its own
+INSERT INTO aocs_batch VALUES (10001, repeat('y', 2000000), 0, NULL);
+-- Invisible rows must be left out of the batches
+DELETE FROM aocs_batch WHERE a % 7 = 0;
+
+SET gp_aocs_scan_batch_size = 100;
+SELECT count(*), sum(a), sum(length(b)), sum(c), count(d), sum(length(d)) FROM aocs_batch;
+SELECT count(*) FROM aocs_batch WHERE c > 100 AND d IS NULL;
+SELECT a FROM aocs_batch WHERE a % 1000 = 1 ORDER BY a;
+
+-- Batches shorter than the blocks, and a single column
+SET gp_aocs_scan_batch_size = 7;
+SELECT count(*), sum(a), sum(length(b)), sum(c), count(d), sum(length(d)) FROM aocs_batch;
+SELECT count(*) FROM aocs_batch;
+
+RESET gp_aocs_scan_batch_size;
+SELECT count(*), sum(a), sum(length(b)), sum(c), count(d), sum(length(d)) FROM aocs_batch;
+
+DROP TABLE aocs_batch;
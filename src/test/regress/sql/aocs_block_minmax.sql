@@ -0,0 +1,39 @@
+--
+-- Batched scans of AOCS tables skip blocks whose remembered min/max values
+-- can't satisfy the quals.  The first scan of a block learns its range, later
+-- scans may skip it; both must return the same rows.
+--
+CREATE TABLE aocs_block_minmax (id int, day date, n int, payload text)
+  WITH (appendonly=true, orientation=column, blocksize=8192) DISTRIBUTED BY (id);
+INSERT INTO aocs_block_minmax
+  SELECT i, date '2019-01-01' + i / 100, CASE WHEN i > 10000 THEN i END, 'payload' || i
+  FROM generate_series(1, 20000) i;
+
+SET gp_aocs_scan_batch_size = 100;
+SELECT count(*), min(id), max(id) FROM aocs_block_minmax WHERE id BETWEEN 5001 AND 5100;
+SELECT count(*), min(id), max(id) FROM aocs_block_minmax WHERE id BETWEEN 5001 AND 5100;
+SELECT payload FROM aocs_block_minmax WHERE id = 12345;
+SELECT payload FROM aocs_block_minmax WHERE id = 12345;
+SELECT count(*), min(id), max(id) FROM aocs_block_minmax WHERE day >= '2019-07-01' AND day < '2019-07-02';
+SELECT count(*), min(id), max(id) FROM aocs_block_minmax WHERE day >= '2019-07-01' AND day < '2019-07-02';
+-- Blocks holding only NULLs never match
+SELECT count(*), min(n), max(n) FROM aocs_block_minmax WHERE n < 10005;
+SELECT count(*), min(n), max(n) FROM aocs_block_minmax WHERE n < 10005;
+SELECT count(*), min(id), max(id) FROM aocs_block_minmax WHERE 19990 < id;
+
+-- New blocks and deleted rows
+INSERT INTO aocs_block_minmax
+  SELECT i, date '2019-01-01' + i / 100, i, 'payload' || i
+  FROM generate_series(20001, 20010) i;
+DELETE FROM aocs_block_minmax WHERE id % 10 = 0;
+SELECT count(*), min(id), max(id) FROM aocs_block_minmax WHERE 19990 < id;
+SELECT count(*), min(id), max(id) FROM aocs_block_minmax WHERE id BETWEEN 5001 AND 5100;
+
+-- Same answers without block min/max
+SET gp_aocs_block_minmax_cache_size = 0;
+SELECT count(*), min(id), max(id) FROM aocs_block_minmax WHERE 19990 < id;
+SELECT count(*), min(id), max(id) FROM aocs_block_minmax WHERE id BETWEEN 5001 AND 5100;
+
+RESET gp_aocs_block_minmax_cache_size;
+RESET gp_aocs_scan_batch_size;
+DROP TABLE aocs_block_minmax;
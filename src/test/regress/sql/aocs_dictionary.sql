@@ -0,0 +1,46 @@
+--
+-- With gp_aocs_dictionary_encoding, RLE_TYPE compressed blocks of AOCS
+-- variable-length columns store each distinct value once, plus an index per
+-- row.  Batched scans evaluate the quals on the distinct values of a block,
+-- and skip the block if none of them passes.
+--
+SET gp_aocs_dictionary_encoding = on;
+CREATE TABLE aocs_dictionary (id int, color text, size varchar(10), note text)
+  WITH (appendonly=true, orientation=column, compresstype=rle_type, blocksize=8192)
+  DISTRIBUTED BY (id);
+INSERT INTO aocs_dictionary
+  SELECT i,
+         (ARRAY['red', 'green', 'blue', 'cyan'])[i % 4 + 1] || CASE WHEN i > 15000 THEN '-late' ELSE '' END,
+         (ARRAY['small', 'medium', 'large'])[i % 3 + 1],
+         CASE WHEN i % 7 <> 0 THEN 'note' || (i % 300) END
+  FROM generate_series(1, 20000) i;
+
+SET gp_aocs_dictionary_encoding = off;
+CREATE TABLE aocs_no_dictionary (LIKE aocs_dictionary)
+  WITH (appendonly=true, orientation=column, compresstype=rle_type, blocksize=8192)
+  DISTRIBUTED BY (id);
+INSERT INTO aocs_no_dictionary SELECT * FROM aocs_dictionary;
+SELECT pg_relation_size('aocs_dictionary') < pg_relation_size('aocs_no_dictionary') AS smaller;
+-- Only segment files created with dictionary encoding on need format version 4
+SELECT DISTINCT formatversion FROM gp_toolkit.__gp_aocsseg('aocs_dictionary');
+SELECT DISTINCT formatversion FROM gp_toolkit.__gp_aocsseg('aocs_no_dictionary');
+
+SELECT color, count(*) FROM aocs_dictionary GROUP BY color ORDER BY color;
+SELECT size, count(*) FROM aocs_dictionary GROUP BY size ORDER BY size;
+SELECT count(note), count(DISTINCT note) FROM aocs_dictionary;
+
+-- Quals on the distinct values, with and without batched scans
+SET gp_aocs_scan_batch_size = 100;
+SELECT count(*), min(id), max(id) FROM aocs_dictionary WHERE color = 'red-late';
+SELECT count(*), min(id), max(id) FROM aocs_dictionary WHERE color < 'c';
+SELECT count(*) FROM aocs_dictionary WHERE color > 'zzz';
+SELECT count(*), min(id), max(id) FROM aocs_dictionary WHERE size = 'small';
+SELECT count(*), min(id), max(id) FROM aocs_dictionary WHERE note = 'note5';
+SELECT count(*), min(id), max(id) FROM aocs_dictionary WHERE 'note5' = note AND color = 'green';
+RESET gp_aocs_scan_batch_size;
+SELECT count(*), min(id), max(id) FROM aocs_dictionary WHERE color = 'red-late';
+SELECT count(*), min(id), max(id) FROM aocs_dictionary WHERE note = 'note5';
+
+DROP TABLE aocs_dictionary;
+DROP TABLE aocs_no_dictionary;
+RESET gp_aocs_dictionary_encoding;
@@ -0,0 +1,30 @@
+--
+-- Batched scans of AOCS tables check the quals on the columns they reference
+-- first, and read the other projected columns only for the rows that pass.
+--
+CREATE TABLE aocs_late (id int, k int, a text, b text, big text)
+  WITH (appendonly=true, orientation=column, blocksize=8192) DISTRIBUTED BY (id);
+INSERT INTO aocs_late
+  SELECT i, i % 97, 'a' || i, 'b' || i * 7,
+         CASE WHEN i % 5000 = 0 THEN repeat('x', 20000) || i END
+  FROM generate_series(1, 20000) i;
+DELETE FROM aocs_late WHERE id % 10 = 3;
+
+SET gp_aocs_scan_batch_size = 64;
+SELECT id, a, b FROM aocs_late WHERE k = 5 AND id < 1000 ORDER BY id;
+SELECT count(*), sum(length(a || b)), max(b) FROM aocs_late WHERE k = 5;
+-- Values too large for a block
+SELECT id, length(big) FROM aocs_late WHERE id % 5000 = 0 ORDER BY id;
+-- No row passes
+SELECT count(b) FROM aocs_late WHERE k > 100;
+-- Every row passes
+SELECT count(b), count(big) FROM aocs_late WHERE k >= 0;
+
+-- Same answers reading every column up front
+SET gp_aocs_late_materialization = off;
+SELECT count(*), sum(length(a || b)), max(b) FROM aocs_late WHERE k = 5;
+SELECT id, length(big) FROM aocs_late WHERE id % 5000 = 0 ORDER BY id;
+
+RESET gp_aocs_late_materialization;
+RESET gp_aocs_scan_batch_size;
+DROP TABLE aocs_late;
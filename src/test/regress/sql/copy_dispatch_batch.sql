@@ -0,0 +1,55 @@
+--
+-- gp_copy_dispatch_batch_size: COPY FROM rows are forwarded to the segments
+-- in batches, by a sender thread.
+--
+create table copy_batch (a int, b text) distributed by (a);
+create table copy_batch_src (a int, b text) distributed by (a);
+insert into copy_batch_src select i, repeat('x', i % 100) from generate_series(1, 10000) i;
+-- a few rows larger than a batch
+insert into copy_batch_src select i, repeat('y', 3000) from generate_series(10001, 10005) i;
+copy copy_batch_src to '/tmp/copy_dispatch_batch.data';
+
+set gp_copy_dispatch_batch_size = '1kB';
+
+copy copy_batch from '/tmp/copy_dispatch_batch.data';
+select count(*), sum(length(b)) from copy_batch;
+-- every row landed on the segment it hashes to
+select count(*) from copy_batch b join copy_batch_src s using (a)
+  where b.gp_segment_id <> s.gp_segment_id or b.b <> s.b;
+
+-- from the client
+truncate copy_batch;
+copy copy_batch from stdin;
+1	one
+2	two
+3	three
+4	four
+5	five
+\.
+select * from copy_batch order by a;
+
+-- replicated tables get every batch on all segments
+create table copy_batch_rep (a int, b text) distributed replicated;
+copy copy_batch_rep from '/tmp/copy_dispatch_batch.data';
+select count(*), sum(length(b)) from gp_dist_random('copy_batch_rep');
+
+-- a bad row aborts the COPY, and the table is unchanged
+truncate copy_batch;
+copy copy_batch from stdin;
+1	one
+two	2
+\.
+select count(*) from copy_batch;
+
+-- single row error handling still counts the rejected rows
+copy copy_batch from stdin log errors segment reject limit 5;
+1	one
+two	2
+3	three
+\.
+select * from copy_batch order by a;
+
+reset gp_copy_dispatch_batch_size;
+drop table copy_batch;
+drop table copy_batch_src;
+drop table copy_batch_rep;
@@ -0,0 +1,39 @@
+--
+-- COPY FROM parsing skips over runs of ordinary bytes in blocks.  Check
+-- long fields with the special characters at different offsets.
+--
+create table copy_scan (a int, b text, c text) distributed by (a);
+
+copy copy_scan from stdin;
+1	abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijkl	x
+2	abcdefghijklmnop\tqrstuvwxyzabcdefghijklmnopqrstuvwxyz\\abcdefgh	y
+3	abcdefghijklmnopqrstuvwxyzabcdef\nghijklmnopqrstuvwxyzabcdefghijk	\N
+4	\N	abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijkl
+\.
+select a, length(b), md5(b), length(c), md5(c) from copy_scan order by a;
+
+truncate copy_scan;
+copy copy_scan from stdin csv;
+1,abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijkl,x
+2,"abcdefghijklmnopqrstuvwxyzabcdef,ghijklmnopqrstuvwxyz""abcdefgh",y
+3,"abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz
+abcdefghijklmnopqrstuvwxyz",
+4,,"abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijkl"
+\.
+select a, length(b), md5(b), length(c), md5(c) from copy_scan order by a;
+
+-- a different escape character in CSV mode
+truncate copy_scan;
+copy copy_scan from stdin csv escape '\';
+1,"abcdefghijklmnopqrstuvwxyzabcdefghijklmnop\"qrstuvwxyz\\abcdefghijkl",x
+\.
+select a, b, c from copy_scan order by a;
+
+-- multi-byte characters
+truncate copy_scan;
+copy copy_scan from stdin;
+1	ääääääääääääääääääääääääääääääääääääääääääääääääääää	é
+\.
+select a, length(b), c from copy_scan order by a;
+
+drop table copy_scan;
@@ -0,0 +1,72 @@
+--
+-- gp_enable_dispatch_plan_cache: plans dispatched again are taken from a
+-- cache, and segments that have them get only a handle.
+--
+set gp_enable_dispatch_plan_cache = on;
+
+create table dpc (a int, b int) distributed by (a);
+insert into dpc select i, i from generate_series(1, 100) i;
+
+-- the same plan with different parameters
+prepare dpc_q(int) as select count(*), sum(b) from dpc where b > $1;
+execute dpc_q(0);
+execute dpc_q(50);
+execute dpc_q(90);
+
+-- the same query, planned again each time
+select count(*) from dpc where a % 2 = 0;
+select count(*) from dpc where a % 2 = 0;
+select count(*) from dpc where a % 2 = 0;
+
+-- writes
+prepare dpc_u(int) as update dpc set b = b + 1 where a = $1;
+execute dpc_u(1);
+execute dpc_u(1);
+select b from dpc where a = 1;
+update dpc set b = 1 where a = 1;
+
+-- the plan changes after DDL
+alter table dpc add column c int default 1;
+execute dpc_q(50);
+
+-- initplans are dispatched with the same plan
+select count(*) from dpc where b > (select avg(b) from dpc);
+select count(*) from dpc where b > (select avg(b) from dpc);
+
+-- more plans than a segment keeps, twice over
+create function dpc_many() returns bigint as $$
+declare
+	total bigint := 0;
+	n bigint;
+begin
+	for r in 1..2 loop
+		for i in 1..40 loop
+			execute format('select count(*) from dpc where b > %s', i) into n;
+			total := total + n;
+		end loop;
+	end loop;
+	return total;
+end
+$$ language plpgsql;
+select dpc_many();
+execute dpc_q(90);
+
+-- plans with motions, where segments run a slice that only reads, run
+-- again from the plan that the segments have kept deserialized
+create table dpc2 (a int, b int) distributed by (b);
+prepare dpc_i(int) as insert into dpc2 select a, b from dpc where a <= $1;
+execute dpc_i(10);
+execute dpc_i(20);
+select count(*), sum(a) from dpc2;
+select count(*) from dpc x join dpc2 y on x.a = y.b;
+select count(*) from dpc x join dpc2 y on x.a = y.b;
+
+reset gp_enable_dispatch_plan_cache;
+execute dpc_q(90);
+
+deallocate dpc_q;
+deallocate dpc_u;
+deallocate dpc_i;
+drop function dpc_many();
+drop table dpc2;
+drop table dpc;
@@ -0,0 +1,35 @@
+--
+-- gp_dtx_async_commit_prepared: the 'Commit Prepared' acknowledgements of a
+-- two-phase commit are collected after the client has been answered.
+--
+set gp_dtx_async_commit_prepared = on;
+
+create table dtx_async_commit (a int, b int) distributed by (a);
+
+-- A multi-segment write with no changes on the QD commits in two phases,
+-- and the session sees its own changes in the next statement.
+begin;
+insert into dtx_async_commit select i, i from generate_series(1, 100) i;
+commit;
+select count(*), sum(b) from dtx_async_commit;
+
+-- The same with implicit transactions, several in one query string.
+update dtx_async_commit set b = b + 1; select sum(b) from dtx_async_commit;
+delete from dtx_async_commit where a <= 50; select count(*) from dtx_async_commit;
+
+-- Aborts are not affected.
+begin;
+insert into dtx_async_commit select i, i from generate_series(1, 100) i;
+rollback;
+select count(*) from dtx_async_commit;
+
+-- Changes on the QD take the synchronous path.
+begin;
+create table dtx_async_commit_ddl (a int) distributed by (a);
+insert into dtx_async_commit_ddl select generate_series(1, 10);
+commit;
+select count(*) from dtx_async_commit_ddl;
+
+reset gp_dtx_async_commit_prepared;
+drop table dtx_async_commit;
+drop table dtx_async_commit_ddl;
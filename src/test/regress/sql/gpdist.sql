@@ -531,3 +531,101 @@ CREATE TABLE "gp.dist.random.schema".gp_dist_random_table_with_schema
     AS SELECT * FROM gp_dist_random('"gp_dist_random_table"');
 SELECT * FROM gp_dist_random('"gp.dist.random.schema".gp_dist_random_table_with_schema');
 DROP SCHEMA "gp.dist.random.schema" CASCADE;
+
+--
+-- cdbhash() computes hashint4(), hashint8() and hashtext() inline. Check
+-- that rows still land on the segment that the hash support functions,
+-- called through fmgr, put them on, for those types and a few others.
+--
+-- cdbhash() rotates the hash left one bit per key column and XORs in the
+-- hash of each non-null value. The result is mapped to a segment with
+-- jump_consistent_hash().
+CREATE FUNCTION gpdist_cdbhash(hashes int4[]) RETURNS int8 AS $$
+DECLARE
+  h int8 := 0;
+  x int4;
+BEGIN
+  FOREACH x IN ARRAY hashes LOOP
+    h := ((h << 1) & 4294967295) | (h >> 31);
+    IF x IS NOT NULL THEN
+      h := h # (x::int8 & 4294967295);
+    END IF;
+  END LOOP;
+  RETURN h;
+END
+$$ LANGUAGE plpgsql IMMUTABLE STRICT;
+CREATE FUNCTION gpdist_jump_hash(hash int8, numsegments int) RETURNS int AS $$
+DECLARE
+  key numeric := hash;
+  b int8 := -1;
+  j int8 := 0;
+BEGIN
+  WHILE j < numsegments LOOP
+    b := j;
+    key := mod(key * 2862933555777941757 + 1, 18446744073709551616);
+    j := floor((b + 1)::float8 * (2147483648::float8 / (floor(key / 8589934592) + 1)::float8));
+  END LOOP;
+  RETURN b;
+END
+$$ LANGUAGE plpgsql IMMUTABLE STRICT;
+
+CREATE TABLE gpdist_hk_src (i2 int2, i4 int4, i8 int8, t text, v varchar, n numeric) DISTRIBUTED RANDOMLY;
+INSERT INTO gpdist_hk_src
+  SELECT i, i * 1000, i::int8 * 100000000000, 'key' || i, 'v' || i, i / 7.0
+  FROM generate_series(-500, 500) i;
+INSERT INTO gpdist_hk_src VALUES
+  (NULL, NULL, NULL, NULL, NULL, NULL),
+  (32767, 2147483647, 9223372036854775807, '', '', 1e100),
+  (-32768, -2147483648, -9223372036854775808, repeat('x', 3000), repeat('y', 3000), -0.000001);
+SELECT numsegments AS gpdist_hk_numsegs FROM gp_distribution_policy
+  WHERE localoid = 'gpdist_hk_src'::regclass \gset
+
+-- Each of these is filled through a Redistribute Motion on the key.
+CREATE TABLE gpdist_hk_int2 AS SELECT i2 AS k FROM gpdist_hk_src DISTRIBUTED BY (k);
+CREATE TABLE gpdist_hk_int4 AS SELECT i4 AS k FROM gpdist_hk_src DISTRIBUTED BY (k);
+CREATE TABLE gpdist_hk_int8 AS SELECT i8 AS k FROM gpdist_hk_src DISTRIBUTED BY (k);
+CREATE TABLE gpdist_hk_text AS SELECT t AS k FROM gpdist_hk_src DISTRIBUTED BY (k);
+CREATE TABLE gpdist_hk_varchar AS SELECT v AS k FROM gpdist_hk_src DISTRIBUTED BY (k);
+CREATE TABLE gpdist_hk_numeric AS SELECT n AS k FROM gpdist_hk_src DISTRIBUTED BY (k);
+CREATE TABLE gpdist_hk_multi AS SELECT i4 AS k1, t AS k2, i8 AS k3 FROM gpdist_hk_src DISTRIBUTED BY (k1, k2, k3);
+
+SELECT count(*) AS nrows, count(k) AS nnonnull,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hashint2(k)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_int2;
+SELECT count(*) AS nrows, count(k) AS nnonnull,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hashint4(k)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_int4;
+SELECT count(*) AS nrows, count(k) AS nnonnull,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hashint8(k)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_int8;
+SELECT count(*) AS nrows, count(k) AS nnonnull,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hashtext(k)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_text;
+SELECT count(*) AS nrows, count(k) AS nnonnull,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hashtext(k)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_varchar;
+SELECT count(*) AS nrows, count(k) AS nnonnull,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hash_numeric(k)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_numeric;
+SELECT count(*) AS nrows, count(k1) AS nnonnull,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hashint4(k1), hashtext(k2), hashint8(k3)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_multi;
+
+-- Rows inserted with INSERT ... VALUES are placed the same way.
+INSERT INTO gpdist_hk_int4 VALUES (12345), (-12345), (NULL);
+INSERT INTO gpdist_hk_int8 VALUES (12345), (-12345), (NULL);
+INSERT INTO gpdist_hk_text VALUES ('abc'), ('a longer key of several words'), (NULL);
+SELECT count(*) AS nrows,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hashint4(k)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_int4;
+SELECT count(*) AS nrows,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hashint8(k)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_int8;
+SELECT count(*) AS nrows,
+       count(*) FILTER (WHERE gp_segment_id <> gpdist_jump_hash(gpdist_cdbhash(ARRAY[hashtext(k)]), :gpdist_hk_numsegs)) AS misplaced
+  FROM gpdist_hk_text;
+
+DROP TABLE gpdist_hk_src, gpdist_hk_int2, gpdist_hk_int4, gpdist_hk_int8,
+  gpdist_hk_text, gpdist_hk_varchar, gpdist_hk_numeric, gpdist_hk_multi;
+DROP FUNCTION gpdist_cdbhash(int4[]);
+DROP FUNCTION gpdist_jump_hash(int8, int);
@@ -0,0 +1,60 @@
+--
+-- A hash join can push a Bloom filter of its inner keys down to the outer
+-- SeqScan, which then discards rows that cannot find a match.  Results must
+-- be the same with and without the filter.
+--
+CREATE TABLE bloom_outer (a int, b text, c varchar(10)) DISTRIBUTED BY (a);
+CREATE TABLE bloom_inner (a int, b text) DISTRIBUTED BY (a);
+INSERT INTO bloom_outer
+  SELECT i, 'b' || (i % 1000), 'b' || (i % 50) FROM generate_series(1, 100000) i;
+INSERT INTO bloom_outer VALUES (NULL, NULL, NULL);
+INSERT INTO bloom_inner
+  SELECT i * 97, 'b' || (i % 20) FROM generate_series(1, 500) i;
+INSERT INTO bloom_inner VALUES (NULL, NULL);
+ANALYZE bloom_outer;
+ANALYZE bloom_inner;
+
+create or replace function bloom_filter_used(query text) returns bool as
+$$
+declare
+  explainrow text;
+begin
+  for explainrow in execute 'EXPLAIN ANALYZE ' || query
+  loop
+    if explainrow like '%Bloom filter discarded%' then
+      return true;
+    end if;
+  end loop;
+  return false;
+end;
+$$ language plpgsql;
+
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+SET gp_hashjoin_bloomfilter = on;
+
+SELECT count(*), sum(o.a) FROM bloom_outer o JOIN bloom_inner i ON o.a = i.a;
+SELECT count(*) FROM bloom_outer o WHERE o.a IN (SELECT a FROM bloom_inner);
+SELECT count(*), count(o.a) FROM bloom_outer o RIGHT JOIN bloom_inner i ON o.a = i.a;
+SELECT count(*) FROM bloom_outer o JOIN bloom_inner i ON o.a = i.a AND o.b = i.b;
+SELECT count(*) FROM bloom_outer o JOIN bloom_inner i ON o.c = i.b AND o.a < 1000;
+-- Outer rows without a match are kept, so no filter here
+SELECT count(*), count(i.a) FROM bloom_outer o LEFT JOIN bloom_inner i ON o.a = i.a;
+SELECT bloom_filter_used('SELECT count(*) FROM bloom_outer o JOIN bloom_inner i ON o.a = i.a');
+
+SET gp_hashjoin_bloomfilter = off;
+
+SELECT count(*), sum(o.a) FROM bloom_outer o JOIN bloom_inner i ON o.a = i.a;
+SELECT count(*) FROM bloom_outer o WHERE o.a IN (SELECT a FROM bloom_inner);
+SELECT count(*), count(o.a) FROM bloom_outer o RIGHT JOIN bloom_inner i ON o.a = i.a;
+SELECT count(*) FROM bloom_outer o JOIN bloom_inner i ON o.a = i.a AND o.b = i.b;
+SELECT count(*) FROM bloom_outer o JOIN bloom_inner i ON o.c = i.b AND o.a < 1000;
+SELECT count(*), count(i.a) FROM bloom_outer o LEFT JOIN bloom_inner i ON o.a = i.a;
+SELECT bloom_filter_used('SELECT count(*) FROM bloom_outer o JOIN bloom_inner i ON o.a = i.a');
+
+RESET gp_hashjoin_bloomfilter;
+RESET enable_mergejoin;
+RESET enable_nestloop;
+DROP FUNCTION bloom_filter_used(text);
+DROP TABLE bloom_outer;
+DROP TABLE bloom_inner;
@@ -0,0 +1,32 @@
+--
+-- Build the in-memory hash table of a hash join with several threads.  The
+-- results must not change, also when the inner side spills to batch files.
+--
+CREATE TABLE hjbt_outer (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE hjbt_inner (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO hjbt_outer SELECT i, i % 1000 FROM generate_series(1, 600000) i;
+INSERT INTO hjbt_inner SELECT i, i % 7 FROM generate_series(1, 600000, 2) i;
+INSERT INTO hjbt_inner SELECT i, i % 7 FROM generate_series(1, 600000, 3) i;
+ANALYZE hjbt_outer;
+ANALYZE hjbt_inner;
+
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+SET gp_hashjoin_build_threads = 4;
+
+SELECT count(*), sum(o.b), sum(i.b) FROM hjbt_outer o JOIN hjbt_inner i ON o.a = i.a;
+SELECT count(*) FROM hjbt_outer o WHERE EXISTS (SELECT 1 FROM hjbt_inner i WHERE i.a = o.a);
+
+-- Spill to batch files
+SET statement_mem = '2MB';
+SELECT count(*), sum(o.b), sum(i.b) FROM hjbt_outer o JOIN hjbt_inner i ON o.a = i.a;
+
+RESET statement_mem;
+SET gp_hashjoin_build_threads = 1;
+SELECT count(*), sum(o.b), sum(i.b) FROM hjbt_outer o JOIN hjbt_inner i ON o.a = i.a;
+
+RESET gp_hashjoin_build_threads;
+RESET enable_mergejoin;
+RESET enable_nestloop;
+DROP TABLE hjbt_outer;
+DROP TABLE hjbt_inner;
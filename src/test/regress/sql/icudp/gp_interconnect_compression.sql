@@ -0,0 +1,37 @@
+--
+-- Interconnect test case: compressed Motion payloads
+--
+
+-- Create a table
+CREATE TEMP TABLE small_table(dkey INT, jkey INT, rval REAL, tval TEXT default 'abcdefghijklmnopqrstuvwxyz') DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO small_table VALUES(generate_series(1, 5000), generate_series(5001, 10000), sqrt(generate_series(5001, 10000)));
+SET gp_interconnect_compression = zlib;
+SHOW gp_interconnect_compression;
+
+-- Skew with gather+redistribute, using the default batch size
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+
+-- Redistribute wide, well compressible tuples, with nulls
+SET gp_interconnect_tuple_batch_size = 8192;
+CREATE TEMP TABLE wide_table AS
+  SELECT jkey, CASE WHEN dkey % 2 = 0 THEN NULL ELSE dkey END AS n, repeat(tval, 1000) AS w
+  FROM small_table DISTRIBUTED BY (jkey);
+SELECT COUNT(*) AS nrows, COUNT(n) AS nnotnull, SUM(length(w)) AS total_len FROM wide_table;
+
+-- Hashes compress much worse than repeated text, and must still arrive intact
+CREATE TEMP TABLE md5_table AS
+  SELECT jkey, md5(dkey::text) || md5(jkey::text) AS h
+  FROM small_table DISTRIBUTED BY (jkey);
+SELECT COUNT(*) AS nrows, COUNT(DISTINCT h) AS ndistinct FROM md5_table;
+
+-- Merge receive must still see each sender's tuples in order
+SELECT dkey FROM small_table ORDER BY dkey LIMIT 5;
+
+RESET gp_interconnect_tuple_batch_size;
+RESET gp_interconnect_compression;
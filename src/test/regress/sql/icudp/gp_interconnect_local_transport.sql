@@ -0,0 +1,49 @@
+--
+-- Interconnect test case: same-host traffic over AF_UNIX sockets
+--
+
+-- gp_interconnect_local_transport can only be set at connection start; the
+-- QEs get it from the QD.
+\setenv PGOPTIONS '-c gp_interconnect_local_transport=on'
+\c
+SHOW gp_interconnect_local_transport;
+SELECT DISTINCT current_setting('gp_interconnect_local_transport') AS qe_local_transport FROM gp_dist_random('gp_id');
+
+-- Create tables
+CREATE TEMP TABLE lt_big(dkey INT, jkey INT, tval TEXT) DISTRIBUTED BY (dkey);
+CREATE TEMP TABLE lt_small(dkey INT, jkey INT) DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO lt_big SELECT i, i % 1000, repeat('x', i % 100) FROM generate_series(1, 20000) i;
+INSERT INTO lt_small SELECT i, i FROM generate_series(1, 1000) i;
+
+-- Redistribute both sides of a join
+SELECT COUNT(*) AS nrows, SUM(length(b.tval)) AS total_len
+  FROM lt_big b JOIN lt_small s ON b.jkey = s.jkey;
+
+-- Two-stage aggregation
+SELECT jkey % 10 AS k, COUNT(*) AS count FROM lt_big GROUP BY 1 ORDER BY 1;
+
+-- Move only one side of a join
+SELECT COUNT(*) AS nrows FROM lt_big b JOIN lt_small s ON b.jkey = s.dkey;
+
+-- Stopped early: the senders get stop messages while they still have data
+SELECT dkey FROM lt_big ORDER BY dkey LIMIT 5;
+SELECT COUNT(*) AS nrows
+  FROM (SELECT b.dkey FROM lt_big b JOIN lt_small s ON b.jkey = s.jkey LIMIT 10) t;
+
+-- Cancelled while the Motions are busy
+SET statement_timeout = '2s';
+SELECT COUNT(*) AS nrows
+  FROM (SELECT * FROM lt_big WHERE pg_sleep(0.01) IS NOT NULL) b
+  JOIN lt_small s ON b.jkey = s.jkey;
+RESET statement_timeout;
+
+-- The interconnect is still usable afterwards
+SELECT COUNT(*) AS nrows, SUM(length(b.tval)) AS total_len
+  FROM lt_big b JOIN lt_small s ON b.jkey = s.jkey;
+
+-- Back to the default
+\setenv PGOPTIONS
+\c
+SHOW gp_interconnect_local_transport;
@@ -0,0 +1,49 @@
+--
+-- Interconnect test case: several packets per sendmmsg()/recvmmsg() call
+--
+
+-- gp_interconnect_mmsg_batch_size can only be set at connection start; the
+-- QEs get it from the QD.
+\setenv PGOPTIONS '-c gp_interconnect_mmsg_batch_size=16'
+\c
+SHOW gp_interconnect_mmsg_batch_size;
+SELECT DISTINCT current_setting('gp_interconnect_mmsg_batch_size') AS qe_mmsg_batch_size FROM gp_dist_random('gp_id');
+
+-- Create tables
+CREATE TEMP TABLE mmsg_big(dkey INT, jkey INT, tval TEXT) DISTRIBUTED BY (dkey);
+CREATE TEMP TABLE mmsg_small(dkey INT, jkey INT) DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO mmsg_big SELECT i, i % 1000, repeat('x', i % 100) FROM generate_series(1, 20000) i;
+INSERT INTO mmsg_small SELECT i, i FROM generate_series(1, 1000) i;
+
+-- Redistribute both sides of a join
+SELECT COUNT(*) AS nrows, SUM(length(b.tval)) AS total_len
+  FROM mmsg_big b JOIN mmsg_small s ON b.jkey = s.jkey;
+
+-- Two-stage aggregation
+SELECT jkey % 10 AS k, COUNT(*) AS count FROM mmsg_big GROUP BY 1 ORDER BY 1;
+
+-- Wide rows redistributed by value
+SELECT COUNT(DISTINCT tval) AS ndistinct, SUM(length(tval)) AS total_len FROM mmsg_big;
+
+-- Merge receive, stopped early
+SELECT dkey FROM mmsg_big ORDER BY dkey LIMIT 5;
+
+-- Let sendmmsg() take only part of a batch now and then (only in builds
+-- with assertions enabled); the rest goes out with the following calls.
+-- 4194304 is 1 << FINC_OS_SENDMMSG_SHORT.
+SET gp_udpic_fault_inject_percent = 50;
+SET gp_udpic_fault_inject_bitmap = 4194304;
+
+SELECT COUNT(*) AS nrows, SUM(length(b.tval)) AS total_len
+  FROM mmsg_big b JOIN mmsg_small s ON b.jkey = s.jkey;
+SELECT COUNT(DISTINCT tval) AS ndistinct, SUM(length(tval)) AS total_len FROM mmsg_big;
+
+RESET gp_udpic_fault_inject_percent;
+RESET gp_udpic_fault_inject_bitmap;
+
+-- Back to the default
+\setenv PGOPTIONS
+\c
+SHOW gp_interconnect_mmsg_batch_size;
@@ -0,0 +1,36 @@
+--
+-- Interconnect test case: several receive threads per backend
+--
+
+-- gp_interconnect_rx_threads can only be set at connection start; the QEs
+-- get it from the QD.
+\setenv PGOPTIONS '-c gp_interconnect_rx_threads=4'
+\c
+SHOW gp_interconnect_rx_threads;
+SELECT DISTINCT current_setting('gp_interconnect_rx_threads') AS qe_rx_threads FROM gp_dist_random('gp_id');
+
+-- Create tables
+CREATE TEMP TABLE rx_big(dkey INT, jkey INT, tval TEXT) DISTRIBUTED BY (dkey);
+CREATE TEMP TABLE rx_small(dkey INT, jkey INT) DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO rx_big SELECT i, i % 1000, repeat('x', i % 100) FROM generate_series(1, 20000) i;
+INSERT INTO rx_small SELECT i, i FROM generate_series(1, 1000) i;
+
+-- Redistribute both sides of a join
+SELECT COUNT(*) AS nrows, SUM(length(b.tval)) AS total_len
+  FROM rx_big b JOIN rx_small s ON b.jkey = s.jkey;
+
+-- Two-stage aggregation
+SELECT jkey % 10 AS k, COUNT(*) AS count FROM rx_big GROUP BY 1 ORDER BY 1;
+
+-- Wide rows redistributed by value
+SELECT COUNT(DISTINCT tval) AS ndistinct, SUM(length(tval)) AS total_len FROM rx_big;
+
+-- Merge receive, stopped early
+SELECT dkey FROM rx_big ORDER BY dkey LIMIT 5;
+
+-- Back to the default
+\setenv PGOPTIONS
+\c
+SHOW gp_interconnect_rx_threads;
@@ -0,0 +1,37 @@
+--
+-- Interconnect test case: Motion senders batching tuples per route
+--
+
+-- Create a table
+CREATE TEMP TABLE small_table(dkey INT, jkey INT, rval REAL, tval TEXT default 'abcdefghijklmnopqrstuvwxyz') DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO small_table VALUES(generate_series(1, 5000), generate_series(5001, 10000), sqrt(generate_series(5001, 10000)));
+SET gp_interconnect_tuple_batch_size = 8192;
+SHOW gp_interconnect_tuple_batch_size;
+
+-- Skew with gather+redistribute
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+
+-- Redistribute tuples with nulls, and tuples wider than a batch
+CREATE TEMP TABLE wide_table AS
+  SELECT jkey, CASE WHEN dkey % 2 = 0 THEN NULL ELSE dkey END AS n, repeat(tval, 1000) AS w
+  FROM small_table DISTRIBUTED BY (jkey);
+SELECT COUNT(*) AS nrows, COUNT(n) AS nnotnull, SUM(length(w)) AS total_len FROM wide_table;
+
+-- Merge receive must still see each sender's tuples in order
+SELECT dkey FROM small_table ORDER BY dkey LIMIT 5;
+
+-- Set GUC value to its max value
+SET gp_interconnect_tuple_batch_size = 1048576;
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+
+RESET gp_interconnect_tuple_batch_size;
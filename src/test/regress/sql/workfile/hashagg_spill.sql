@@ -129,4 +129,23 @@ RESET statement_mem;
 RESET gp_workfile_compression;
 
 
+-- Same spilling scenarios with an open-addressing hash table
+set gp_hashagg_open_addressing = on;
+set optimizer_force_multistage_agg = on;
+set statement_mem = '125MB';
+select count(*) from (select i, count(*) from aggspill group by i,j having count(*) = 1) g;
+set statement_mem = '10MB';
+select overflows >= 1 from hashagg_spill.num_hashagg_overflows('explain analyze
+select count(*) from (select i, count(*) from aggspill group by i,j having count(*) = 2) g') overflows;
+select count(*) from (select i, count(*) from aggspill group by i,j having count(*) = 2) g;
+set gp_hashagg_default_nbatches = 4;
+set statement_mem = '5MB';
+select overflows > 1 from hashagg_spill.num_hashagg_overflows('explain analyze
+select count(*) from (select i, count(*) from aggspill group by i,j,t having count(*) = 3) g') overflows;
+select count(*) from (select i, count(*) from aggspill group by i,j,t having count(*) = 3) g;
+reset gp_hashagg_default_nbatches;
+reset statement_mem;
+reset optimizer_force_multistage_agg;
+reset gp_hashagg_open_addressing;
+
 drop schema hashagg_spill cascade;
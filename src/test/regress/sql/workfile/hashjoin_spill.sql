@@ -59,4 +59,42 @@ select count(1) from generate_series(1, 1000000) t1 left join generate_series(1,
 set gp_workfile_compression = off;
 select count(1) from generate_series(1, 1000000) t1 left join generate_series(1, 50000) t2 on t1 = t2;
 
+-- A batch whose inner tuples all have the same key cannot be split by adding
+-- batches; it is joined by nested loop over chunks of the inner batch.
+-- joined_by_nested_loop() tells whether EXPLAIN ANALYZE shows that happened.
+create or replace function hashjoin_spill.joined_by_nested_loop(explain_query text)
+returns bool as
+$$
+import re
+rv = plpy.execute(explain_query)
+p = re.compile('Joined \d+ unsplittable batch(es)? by nested loop')
+for i in range(len(rv)):
+    if p.search(rv[i]['QUERY PLAN']):
+        return True
+return False
+$$
+language plpythonu;
+CREATE TABLE test_hj_skew_inner (a int, b int);
+CREATE TABLE test_hj_skew_outer (a int, b int);
+insert into test_hj_skew_inner select 1, i from generate_series(1, 200000) i;
+insert into test_hj_skew_inner select i, i from generate_series(2, 1001) i;
+insert into test_hj_skew_inner select i, i from generate_series(5000, 5099) i;
+insert into test_hj_skew_outer select i, i from generate_series(1, 1000000) i;
+insert into test_hj_skew_outer select 1, i from generate_series(1, 3) i;
+analyze test_hj_skew_inner;
+analyze test_hj_skew_outer;
+set enable_nestloop = off;
+set enable_mergejoin = off;
+select hashjoin_spill.joined_by_nested_loop('explain analyze select count(*) from test_hj_skew_outer o join test_hj_skew_inner i on o.a = i.a');
+select hashjoin_spill.joined_by_nested_loop('explain analyze select count(*) from test_hj_skew_outer o full join test_hj_skew_inner i on o.a = i.a');
+select count(*) from test_hj_skew_outer o join test_hj_skew_inner i on o.a = i.a;
+select count(*), count(i.a) from test_hj_skew_outer o left join test_hj_skew_inner i on o.a = i.a;
+select count(*), count(o.a) from test_hj_skew_outer o right join test_hj_skew_inner i on o.a = i.a;
+select count(*), count(o.a), count(i.a) from test_hj_skew_outer o full join test_hj_skew_inner i on o.a = i.a;
+select count(*) from test_hj_skew_outer o where exists (select 1 from test_hj_skew_inner i where i.a = o.a);
+select count(*) from test_hj_skew_outer o where not exists (select 1 from test_hj_skew_inner i where i.a = o.a);
+select count(*) from test_hj_skew_outer o where o.a not in (select a from test_hj_skew_inner);
+reset enable_nestloop;
+reset enable_mergejoin;
+
 drop schema hashjoin_spill cascade;